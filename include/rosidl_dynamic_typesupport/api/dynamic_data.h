@@ -90,6 +90,16 @@ rosidl_dynamic_typesupport_dynamic_data_get_item_count(
   const rosidl_dynamic_typesupport_dynamic_data_t * dynamic_data,
   size_t * item_count);  // OUT
 
+/// Get the memory held by the values of a dynamic data, including nested and sequence members
+/**
+ * The dynamic type of the dynamic data is not counted, since it is not owned by it.
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_data_get_memory_usage(
+  const rosidl_dynamic_typesupport_dynamic_data_t * dynamic_data,
+  rosidl_dynamic_typesupport_memory_usage_t * memory_usage);  // OUT
+
 ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
 rcutils_ret_t
 rosidl_dynamic_typesupport_dynamic_data_get_member_id_by_name(
@@ -22,11 +22,17 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #include <rcutils/allocator.h>
 #include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/type_hash.h>
 
 #include "rosidl_dynamic_typesupport/api/serialization_support.h"
 #include "rosidl_dynamic_typesupport/api/serialization_support_interface.h"
+#include "rosidl_dynamic_typesupport/interned_string.h"
 #include "rosidl_dynamic_typesupport/types.h"
 #include "rosidl_dynamic_typesupport/visibility_control.h"
 
@@ -72,17 +78,112 @@ struct rosidl_dynamic_typesupport_dynamic_type_s
   rosidl_dynamic_typesupport_dynamic_type_impl_t impl;
   // !!! Lifetime is NOT managed by this struct
   rosidl_dynamic_typesupport_serialization_support_t * serialization_support;
+
+  // Hash of the type description this was constructed from, if known (i.e. if the version is not
+  // ROSIDL_TYPE_HASH_VERSION_UNSET), as passed in by the caller
+  rosidl_type_hash_t type_hash;
+  // Nonzero if the library vouches for `type_hash`: the description was equal to the one it
+  // remembered for the type hash while validating. Dynamic types with the same type hash and the
+  // same nonzero value were built from equal descriptions, which lets equality checks skip the
+  // structural comparison. 0 for unverified type hashes (e.g. from snapshots, or if validation was
+  // skipped)
+  uint64_t type_hash_verification;
+
+  // Set if construction was deferred (see `defer_construction` in the construction options), in
+  // which case `impl` stays unset, and the type is built into here the first time it is used.
+  // Owned by this struct, unless this is a nested type of a deferred type
+  rosidl_dynamic_typesupport_dynamic_type_deferred_t * deferred;
 };
 
 ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
 rosidl_dynamic_typesupport_dynamic_type_t
 rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type(void);
 
+// Dynamic Type Construction Options
+/// Run `task(i, task_arg)` once for every `i` in `[0, task_count)`
+/**
+ * The calls may happen in any order, and on any thread (including the calling one). This function
+ * must only return once every call has returned.
+ */
+typedef void (* rosidl_dynamic_typesupport_parallel_for_t)(
+  size_t task_count,
+  void (* task)(size_t i, void * task_arg),
+  void * task_arg,
+  void * state);
+
+struct rosidl_dynamic_typesupport_dynamic_type_construction_options_s
+{
+  // Optional. If set, nested types that do not depend on each other are built concurrently
+  // through it, one dependency level at a time. Ignored (i.e. nested types are built serially) if
+  // the serialization support does not set `dynamic_type_construction_is_thread_safe`.
+  //
+  // NOTE: Only set this if the allocator passed for construction is safe to use from several
+  //       threads at once
+  rosidl_dynamic_typesupport_parallel_for_t parallel_for;
+  void * parallel_for_state;
+
+  // Limits checked before anything is built, so oversized descriptions fail fast. 0 means no limit
+  //
+  // Maximum number of nested type levels below the top level type
+  size_t max_depth;
+  // Maximum number of fields across the top level type and every distinct nested type
+  size_t max_total_fields;
+
+  // Optional. Used to look up whether the description was already found to be valid. If NULL (or
+  // unset), a structural digest of the description is used instead. Either way, validation is only
+  // skipped if the description found for it is equal to the one being validated
+  const rosidl_type_hash_t * type_hash;
+  // Skip validating the description entirely, e.g. if the caller already did
+  bool description_is_validated;
+
+  // Only used by `rosidl_dynamic_typesupport_dynamic_type_init_from_description_with_options()`.
+  // If true, the description is validated and copied, but the dynamic type is only built the first
+  // time it is used, e.g. to initialize dynamic data. Types that end up never being used are never
+  // built. Each nested type is deferred separately, and can be used on its own (see
+  // `rosidl_dynamic_typesupport_dynamic_type_get_nested_member_type()`), which only builds what it
+  // reaches. Serialization libraries need nested types built before the types referencing them, so
+  // building the top level type still builds every nested type it reaches that was not built yet.
+  //
+  // NOTE: Deferred types are built with these same options, so the serialization
+  //       support, allocator, and `parallel_for` must stay valid until then
+  bool defer_construction;
+};
+
+/// Get options that construct dynamic types serially (i.e. like the functions without options)
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rosidl_dynamic_typesupport_dynamic_type_construction_options_t
+rosidl_dynamic_typesupport_get_default_dynamic_type_construction_options(void);
+
+/// Forget every type description found to be valid while constructing dynamic types
+/**
+ * Valid descriptions are remembered process-wide (as packed copies), so constructing a dynamic
+ * type from an equal description later skips validating it again. This frees all of them.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_clear_type_description_validation_cache(void);
+
 // =================================================================================================
 // DYNAMIC TYPE
 // =================================================================================================
 
 // DYNAMIC TYPE UTILS ==============================================================================
+/// Check if two dynamic types are equal
+/**
+ * A dynamic type is equal to itself, and dynamic types carrying the same type hash are equal
+ * without comparing them further if the library vouched for both hashes (see
+ * `type_hash_verification`). Everything else, including types with different type hashes, falls
+ * back to the serialization library's structural comparison, since type hashes passed in by
+ * callers are not checked against their descriptions.
+ */
 ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
 rcutils_ret_t
 rosidl_dynamic_typesupport_dynamic_type_equals(
@@ -96,6 +197,66 @@ rosidl_dynamic_typesupport_dynamic_type_get_member_count(
   const rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type,
   size_t * member_count);  // OUT
 
+/// Get the memory held by a dynamic type, including its nested types
+/**
+ * Deferred dynamic types are not built for this, nor waited for while they are being built. They
+ * hold the copy of the description they are built from, which is counted as library bytes, and
+ * whichever of their nested types were built so far.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes (as long as the serialization library's slot is)
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes (as long as the serialization library's slot is)
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_get_memory_usage(
+  const rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type,
+  rosidl_dynamic_typesupport_memory_usage_t * memory_usage);  // OUT
+
+/// Get the dynamic type of a nested member of a deferred dynamic type, without building either
+/**
+ * The nested type is deferred as well, and can be used like any other dynamic type (e.g. to
+ * initialize dynamic data). Only it, and the nested types it references in turn, are built the
+ * first time it is used. Whatever was built is reused once the type it was got from is built.
+ *
+ * Returns RCUTILS_RET_UNSUPPORTED for dynamic types whose construction was not deferred, and
+ * RCUTILS_RET_NOT_FOUND if there is no member with that name.
+ *
+ * NOTE: The nested type is owned by the top level dynamic type (even if got through
+ *       one of its nested types), and stays valid until that is finalized. It MUST
+ *       NOT be finalized on its own
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_get_nested_member_type(
+  rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type,
+  const char * member_name,
+  size_t member_name_length,
+  rosidl_dynamic_typesupport_dynamic_type_t ** nested_type);  // OUT
+
+/// Get the memory held by a dynamic type builder, including its members
+/**
+ * Copy-on-write clones that still share the builder they were cloned from hold nothing of their
+ * own, so they report 0 bytes. The shared builder is only counted for itself.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_builder_get_memory_usage(
+  const rosidl_dynamic_typesupport_dynamic_type_builder_t * dynamic_type_builder,
+  rosidl_dynamic_typesupport_memory_usage_t * memory_usage);  // OUT
+
 
 // DYNAMIC TYPE CONSTRUCTION =======================================================================
 ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
@@ -121,6 +282,15 @@ rosidl_dynamic_typesupport_dynamic_type_builder_init_from_description(
   rcutils_allocator_t * allocator,
   rosidl_dynamic_typesupport_dynamic_type_builder_t * dynamic_type_builder);  // OUT
 
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_builder_init_from_description_with_options(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_runtime_c__type_description__TypeDescription * description,
+  const rosidl_dynamic_typesupport_dynamic_type_construction_options_t * options,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_dynamic_type_builder_t * dynamic_type_builder);  // OUT
+
 ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
 rcutils_ret_t
 rosidl_dynamic_typesupport_dynamic_type_builder_fini(
@@ -146,6 +316,15 @@ rosidl_dynamic_typesupport_dynamic_type_init_from_description(
   rcutils_allocator_t * allocator,
   rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type);  // OUT
 
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_init_from_description_with_options(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_runtime_c__type_description__TypeDescription * description,
+  const rosidl_dynamic_typesupport_dynamic_type_construction_options_t * options,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type);  // OUT
+
 ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
 rcutils_ret_t
 rosidl_dynamic_typesupport_dynamic_type_clone(
@@ -988,6 +1167,61 @@ rosidl_dynamic_typesupport_dynamic_type_builder_add_complex_bounded_sequence_mem
   rosidl_dynamic_typesupport_dynamic_type_builder_t * nested_struct_builder, size_t sequence_bound);
 
 
+// DYNAMIC TYPE BATCHED MEMBERS ====================================================================
+/// Everything needed to add one member of any type to a dynamic type builder
+/**
+ * Mirrors the arguments of the `rosidl_dynamic_typesupport_dynamic_type_builder_add_*_member()`
+ * functions, with the member's type picked by `type_id` instead of by function.
+ */
+struct rosidl_dynamic_typesupport_dynamic_type_member_spec_s
+{
+  rosidl_dynamic_typesupport_member_id_t id;
+  const char * name;
+  size_t name_length;
+  const char * default_value;
+  size_t default_value_length;
+  // Optional, may be NULL. If set, `name` and `name_length` are its data and length. It is only
+  // borrowed for the call: serialization libraries may keep it instead of copying the name, if they
+  // take their own reference (see `rosidl_dynamic_typesupport_interned_string_retain()`)
+  const rosidl_dynamic_typesupport_interned_string_t * interned_name;
+
+  // One of the ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_* constants
+  uint8_t type_id;
+  // Array length or sequence bound. Ignored by types that are neither arrays nor bounded sequences
+  size_t capacity;
+  // String length or string bound. Ignored by types that are not fixed or bounded strings
+  size_t string_capacity;
+
+  // Exactly one of these must be set for nested types, and both are ignored for any other type
+  rosidl_dynamic_typesupport_dynamic_type_t * nested_type;
+  rosidl_dynamic_typesupport_dynamic_type_builder_t * nested_type_builder;
+};
+
+/// Add several members to a dynamic type builder at once
+/**
+ * Members are added in order, as if by calling the matching
+ * `rosidl_dynamic_typesupport_dynamic_type_builder_add_*_member()` function for each of them.
+ *
+ * Serialization libraries that implement the batched interface slot get every member in one call,
+ * and can allocate member storage up front. Otherwise, members are added one at a time through the
+ * per-type interface slots.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_builder_add_members(
+  rosidl_dynamic_typesupport_dynamic_type_builder_t * dynamic_type_builder,
+  const rosidl_dynamic_typesupport_dynamic_type_member_spec_t * members,
+  size_t member_count);
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -48,8 +48,11 @@ rosidl_dynamic_typesupport_get_zero_initialized_serialization_support_impl(void)
 /// Serialization Support
 /// This is the main structure that encompasses:
 ///   - impl - The library-specific objects or implementation details
-///   - methods - The shared serialization support interface, populated with serialization
-///     library-specific function pointers
+///   - methods - The serialization support interface, populated with serialization
+///     library-specific function pointers. It is held by value, so every copy of the struct
+///     carries a copy of it. Share one with
+///     `rosidl_dynamic_typesupport_serialization_support_init_shared()` instead of copying it
+///     around
 struct rosidl_dynamic_typesupport_serialization_support_s
 {
   rcutils_allocator_t allocator;
@@ -83,6 +86,94 @@ rcutils_ret_t
 rosidl_dynamic_typesupport_serialization_support_fini(
   rosidl_dynamic_typesupport_serialization_support_t * serialization_support);
 
+
+// SHARED ==========================================================================================
+/// Move a serialization support into the reference counted one of its serialization library
+/**
+ * A serialization support is usually used by many objects at once (dynamic types, registry
+ * entries, dynamic message type support handles), and must outlive all of them. Instead of keeping
+ * track of that by hand, it can be moved into a shared serialization support, which is finalized
+ * when its last reference is released.
+ *
+ * There is at most one shared serialization support per serialization library identifier in the
+ * process, so its interface is only held once however many objects use it. If there already is
+ * one, the caller gets another reference to it, and `serialization_support` is finalized, since
+ * serialization supports of the same serialization library are expected to be interchangeable.
+ * Otherwise `serialization_support` is moved into a new shared serialization support with one
+ * reference.
+ *
+ * Either way, the caller owns one reference, and `serialization_support` is taken over and zero
+ * initialized, so it must NOT be used or finalized after this succeeds. If this fails, it is left
+ * untouched.
+ *
+ * To migrate, callers that kept a serialization support from
+ * `rosidl_dynamic_typesupport_serialization_support_init()` alive for as long as the objects using
+ * it can move it in here right after initializing it, hand the shared one out instead, and release
+ * their reference where they used to finalize it.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ *
+ * \param[inout] serialization_support The serialization support to move in
+ * \param[in] allocator The allocator for the shared serialization support, if a new one is needed
+ * \param[out] shared_serialization_support The shared serialization support
+ * \return RCUTILS_RET_OK if successful
+ * \return RCUTILS_RET_INVALID_ARGUMENT if an argument is invalid
+ * \return RCUTILS_RET_BAD_ALLOC if memory allocation failed
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_serialization_support_init_shared(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_serialization_support_t ** shared_serialization_support);  // OUT
+
+/// Take another reference to a shared serialization support
+/**
+ * `shared_serialization_support` must come from
+ * `rosidl_dynamic_typesupport_serialization_support_init_shared()`, and the caller must already
+ * hold a reference to it.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_serialization_support_acquire(
+  rosidl_dynamic_typesupport_serialization_support_t * shared_serialization_support);
+
+/// Release a reference to a shared serialization support
+/**
+ * Releasing the last reference finalizes the serialization support and deallocates it, so
+ * `shared_serialization_support` must not be used by the caller after this.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No (only for the last reference)
+ *
+ * \return RCUTILS_RET_OK if successful
+ * \return RCUTILS_RET_INVALID_ARGUMENT if an argument is invalid, or no references are left
+ * \return Whatever the serialization library returns if finalizing fails
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_serialization_support_release(
+  rosidl_dynamic_typesupport_serialization_support_t * shared_serialization_support);
+
 #ifdef __cplusplus
 }
 #endif
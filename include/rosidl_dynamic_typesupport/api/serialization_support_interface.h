@@ -22,6 +22,7 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -83,6 +84,12 @@ struct rosidl_dynamic_typesupport_serialization_support_interface_s
 
 
   // DYNAMIC TYPE CONSTRUCTION
+  // Set if the construction slots (and dynamic_type_fini) may be called from several threads at
+  // once, on different builders and types. If false (e.g. for interfaces that were zero
+  // initialized and never set it), nested types are always built one at a time, even if a
+  // `parallel_for` was passed in the construction options
+  bool dynamic_type_construction_is_thread_safe;
+
   rcutils_ret_t (* dynamic_type_builder_init)(
     rosidl_dynamic_typesupport_serialization_support_impl_t * serialization_support,
     const char * name, size_t name_length,
@@ -850,6 +857,63 @@ struct rosidl_dynamic_typesupport_serialization_support_interface_s
     size_t sequence_bound);
 
 
+  // DYNAMIC TYPE BATCHED MEMBERS
+  // Optional, may be NULL. If NULL, members are added one at a time through the slots above
+  rcutils_ret_t (* dynamic_type_builder_add_members)(
+    rosidl_dynamic_typesupport_serialization_support_impl_t * serialization_support,
+    rosidl_dynamic_typesupport_dynamic_type_builder_impl_t * dynamic_type_builder,
+    const rosidl_dynamic_typesupport_dynamic_type_member_spec_t * members, size_t member_count);
+
+  // DYNAMIC TYPE DEFAULT VALUES
+  // Optional, may be NULL. Called once all members were added to a builder constructed from a type
+  // description, with the default values of its members already parsed. Serialization libraries
+  // can prepare the initial values of new dynamic data from them, instead of parsing the default
+  // value strings they got when the members were added.
+  //
+  // The default values are finalized right after this returns, so anything needed must be copied.
+  rcutils_ret_t (* dynamic_type_builder_set_default_values)(
+    rosidl_dynamic_typesupport_serialization_support_impl_t * serialization_support,
+    rosidl_dynamic_typesupport_dynamic_type_builder_impl_t * dynamic_type_builder,
+    const rosidl_dynamic_typesupport_default_values_t * default_values);
+
+  // DYNAMIC TYPE SNAPSHOTS
+  // Optional, may be NULL. If either is NULL, dynamic types of this serialization library can't be
+  // exported to or loaded from type snapshots (see type_snapshot.h).
+  //
+  // The blob is opaque to everything but the serialization library, and must not contain pointers,
+  // since it is loaded by other processes. `blob` is zero initialized, and must be initialized with
+  // `allocator`.
+  rcutils_ret_t (* dynamic_type_export_snapshot_blob)(
+    rosidl_dynamic_typesupport_serialization_support_impl_t * serialization_support,
+    const rosidl_dynamic_typesupport_dynamic_type_impl_t * dynamic_type,
+    rcutils_allocator_t * allocator,
+    rcutils_uint8_array_t * blob);  // OUT
+
+  // The blob is read-only, and stays valid (at the same address) for as long as the dynamic type
+  // does, so it may be referenced instead of copied
+  rcutils_ret_t (* dynamic_type_init_from_snapshot_blob)(
+    rosidl_dynamic_typesupport_serialization_support_impl_t * serialization_support,
+    const uint8_t * blob, size_t blob_size,
+    rcutils_allocator_t * allocator,
+    rosidl_dynamic_typesupport_dynamic_type_impl_t * dynamic_type);  // OUT
+
+  // DYNAMIC TYPE MEMORY USAGE
+  // Optional, may be NULL. If NULL, memory usage reports leave out what the serialization library
+  // allocated (see rosidl_dynamic_typesupport_memory_usage_t).
+  //
+  // `bytes` must cover everything allocated for the type or builder, including its members and
+  // nested types, but not the impl struct itself.
+  rcutils_ret_t (* dynamic_type_get_memory_usage)(
+    rosidl_dynamic_typesupport_serialization_support_impl_t * serialization_support,
+    const rosidl_dynamic_typesupport_dynamic_type_impl_t * dynamic_type,
+    size_t * bytes);  // OUT
+
+  rcutils_ret_t (* dynamic_type_builder_get_memory_usage)(
+    rosidl_dynamic_typesupport_serialization_support_impl_t * serialization_support,
+    const rosidl_dynamic_typesupport_dynamic_type_builder_impl_t * dynamic_type_builder,
+    size_t * bytes);  // OUT
+
+
   // ===============================================================================================
   // DYNAMIC DATA
   // ===============================================================================================
@@ -1390,6 +1454,17 @@ struct rosidl_dynamic_typesupport_serialization_support_interface_s
     rosidl_dynamic_typesupport_dynamic_data_impl_t * dynamic_data,
     rosidl_dynamic_typesupport_dynamic_data_impl_t * value,
     rosidl_dynamic_typesupport_member_id_t * out_id);  // OUT
+
+
+  // DYNAMIC DATA MEMORY USAGE
+  // Optional, may be NULL. Like dynamic_type_get_memory_usage, `bytes` must cover all the values
+  // held, including those of nested and sequence members, but not the impl struct itself.
+  //
+  // NOTE: The dynamic type of the data is not part of it, so it must not be counted
+  rcutils_ret_t (* dynamic_data_get_memory_usage)(
+    rosidl_dynamic_typesupport_serialization_support_impl_t * serialization_support,
+    const rosidl_dynamic_typesupport_dynamic_data_impl_t * dynamic_data,
+    size_t * bytes);  // OUT
 };
 
 ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
@@ -0,0 +1,121 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSIDL_DYNAMIC_TYPESUPPORT__DEFAULT_VALUES_H_
+#define ROSIDL_DYNAMIC_TYPESUPPORT__DEFAULT_VALUES_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rcutils/allocator.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__struct.h>
+
+#include "rosidl_dynamic_typesupport/types.h"
+#include "rosidl_dynamic_typesupport/visibility_control.h"
+
+
+// DEFAULT VALUES ==================================================================================
+// The default values of the members of a type, parsed once from the strings in its type
+// description.
+//
+// Each parsed default is laid out as a contiguous C array of its elements, so serialization
+// libraries can copy it as is into the storage of new dynamic data instead of parsing the default
+// value string again.
+//
+// Elements are stored as their C types:
+//   - BOOLEAN: bool
+//   - BYTE, CHAR, UINT8: uint8_t
+//   - WCHAR: uint16_t
+//   - INT8 to UINT64: the matching int8_t to uint64_t
+//   - FLOAT32, FLOAT64, FLOAT128: float, double, long double
+//   - STRING and WSTRING (of any bound): rosidl_dynamic_typesupport_default_string_t, holding the
+//     unquoted and unescaped UTF-8 contents
+
+typedef struct rosidl_dynamic_typesupport_default_string_s
+{
+  // Null terminated
+  const char * data;
+  size_t length;
+} rosidl_dynamic_typesupport_default_string_t;
+
+typedef struct rosidl_dynamic_typesupport_member_default_value_s
+{
+  rosidl_dynamic_typesupport_member_id_t member_id;
+  // One of the ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_* constants, as in the type description
+  uint8_t type_id;
+  // False if the member has no default value, if it is a nested type, or if its default value could
+  // not be parsed. Serialization libraries should then use the raw default value string they got
+  // when the member was added instead
+  bool is_parsed;
+  // Number of elements, 1 for members that are not arrays or sequences
+  size_t element_count;
+  // Size of each element in `elements`
+  size_t element_size;
+  void * elements;
+} rosidl_dynamic_typesupport_member_default_value_t;
+
+struct rosidl_dynamic_typesupport_default_values_s
+{
+  // Indexed like the fields of the type description, which are also the member ids
+  size_t member_count;
+  rosidl_dynamic_typesupport_member_default_value_t * members;
+  rcutils_allocator_t allocator;
+};
+
+
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rosidl_dynamic_typesupport_default_values_t
+rosidl_dynamic_typesupport_get_zero_initialized_default_values(void);
+
+/// Parse the default values of every field of an individual type description
+/**
+ * Default values that can't be parsed are not errors, since serialization libraries may accept
+ * more than this does. Those members are left with `is_parsed` set to false instead.
+ *
+ * The default values do not borrow anything from `description`, so the description may be
+ * finalized as soon as this returns.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_default_values_init(
+  const rosidl_runtime_c__type_description__IndividualTypeDescription * description,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_default_values_t * default_values);  // OUT
+
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_default_values_fini(
+  rosidl_dynamic_typesupport_default_values_t * default_values);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ROSIDL_DYNAMIC_TYPESUPPORT__DEFAULT_VALUES_H_
@@ -0,0 +1,201 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSIDL_DYNAMIC_TYPESUPPORT__DYNAMIC_DATA_POOL_H_
+#define ROSIDL_DYNAMIC_TYPESUPPORT__DYNAMIC_DATA_POOL_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+
+#include <rcutils/allocator.h>
+#include <rcutils/types/rcutils_ret.h>
+
+#include "rosidl_dynamic_typesupport/api/dynamic_data.h"
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/types.h"
+#include "rosidl_dynamic_typesupport/visibility_control.h"
+
+
+// DYNAMIC DATA POOLS ==============================================================================
+// A pool of dynamic data of one dynamic type, recycled instead of being constructed and finalized
+// for every message.
+//
+// The pool has room for up to `max_size` dynamic data, of which the first `min_size` are
+// constructed up front, and the rest the first time they are needed. Released dynamic data have
+// their values cleared and are kept constructed, so once the pool is warm, acquiring and releasing
+// does not allocate (as long as the serialization library does not allocate to clear values).
+//
+// Dynamic data acquired while all `max_size` are in use are constructed and finalized on the spot,
+// like they would be without a pool. They are counted in the pool statistics, so `max_size` can be
+// tuned to avoid them.
+//
+// Free dynamic data are kept on a lock-free stack, so acquiring and releasing is safe from several
+// threads at once.
+
+typedef struct rosidl_dynamic_typesupport_dynamic_data_pool_impl_s
+  rosidl_dynamic_typesupport_dynamic_data_pool_impl_t;
+
+typedef struct rosidl_dynamic_typesupport_dynamic_data_pool_s
+{
+  // !!! Lifetime is NOT managed by this struct, and must outlive it
+  rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type;
+  size_t min_size;
+  size_t max_size;
+
+  rcutils_allocator_t allocator;
+  rosidl_dynamic_typesupport_dynamic_data_pool_impl_t * impl;
+} rosidl_dynamic_typesupport_dynamic_data_pool_t;
+
+typedef struct rosidl_dynamic_typesupport_dynamic_data_pool_stats_s
+{
+  // Dynamic data currently acquired
+  size_t in_use_count;
+  // Most dynamic data that were acquired at once
+  size_t high_water_mark;
+  // Dynamic data constructed for the pool so far, at most `max_size`
+  size_t constructed_count;
+  // Dynamic data constructed on the spot because all `max_size` were in use
+  size_t overflow_count;
+} rosidl_dynamic_typesupport_dynamic_data_pool_stats_t;
+
+
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rosidl_dynamic_typesupport_dynamic_data_pool_t
+rosidl_dynamic_typesupport_get_zero_initialized_dynamic_data_pool(void);
+
+/// Initialize a pool of dynamic data of `dynamic_type`, constructing the first `min_size` of them
+/**
+ * `max_size` must be at least 1, and at least `min_size`.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_data_pool_init(
+  rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type,
+  size_t min_size,
+  size_t max_size,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_dynamic_data_pool_t * pool);  // OUT
+
+/// Finalize a pool, along with every dynamic data it constructed
+/**
+ * Fails, without finalizing anything, if any dynamic data is still acquired.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_data_pool_fini(
+  rosidl_dynamic_typesupport_dynamic_data_pool_t * pool);
+
+/// Acquire a dynamic data with all of its values cleared
+/**
+ * The dynamic data is owned by the pool, and MUST be given back with
+ * `rosidl_dynamic_typesupport_dynamic_data_pool_release()` instead of being finalized.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Only if the dynamic data was not constructed yet, or all are in use
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_data_pool_acquire(
+  rosidl_dynamic_typesupport_dynamic_data_pool_t * pool,
+  rosidl_dynamic_typesupport_dynamic_data_t ** dynamic_data);  // OUT
+
+/// Give back a dynamic data acquired from the same pool, clearing its values
+/**
+ * The dynamic data is given back even if clearing its values fails, in which case it is finalized
+ * and constructed again the next time it is acquired.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_data_pool_release(
+  rosidl_dynamic_typesupport_dynamic_data_pool_t * pool,
+  rosidl_dynamic_typesupport_dynamic_data_t * dynamic_data);
+
+/// Get the usage statistics of a pool
+/**
+ * The statistics are read one at a time, so they might not agree with each other while other
+ * threads are acquiring or releasing dynamic data.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_data_pool_get_stats(
+  const rosidl_dynamic_typesupport_dynamic_data_pool_t * pool,
+  rosidl_dynamic_typesupport_dynamic_data_pool_stats_t * stats);  // OUT
+
+/// Get the memory held by a pool, including every dynamic data it constructed
+/**
+ * Dynamic data that are currently acquired are counted too, so none of them may be modified (nor
+ * acquired or released) until this returns. Dynamic data constructed past `max_size` are not
+ * counted, since the pool does not keep track of them.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_data_pool_get_memory_usage(
+  const rosidl_dynamic_typesupport_dynamic_data_pool_t * pool,
+  rosidl_dynamic_typesupport_memory_usage_t * memory_usage);  // OUT
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ROSIDL_DYNAMIC_TYPESUPPORT__DYNAMIC_DATA_POOL_H_
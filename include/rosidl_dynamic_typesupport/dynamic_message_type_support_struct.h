@@ -20,6 +20,8 @@ extern "C"
 {
 #endif
 
+#include <stdbool.h>
+
 #include <rcutils/types/rcutils_ret.h>
 #include <rosidl_runtime_c/message_type_support_struct.h>
 #include <rosidl_runtime_c/type_description/type_description__struct.h>
@@ -28,22 +30,47 @@ extern "C"
 #include "rosidl_dynamic_typesupport/api/dynamic_type.h"
 #include "rosidl_dynamic_typesupport/api/dynamic_data.h"
 #include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/dynamic_data_pool.h"
 #include "rosidl_dynamic_typesupport/identifier.h"
+#include "rosidl_dynamic_typesupport/type_plan.h"
 #include "rosidl_dynamic_typesupport/types.h"
 #include "rosidl_dynamic_typesupport/visibility_control.h"
 
 
 // RUNTIME INTERFACE REFLECTION TYPE SUPPORT =======================================================
-// Every field of this struct is expected to be populated.
+// Every field of this struct is expected to be populated, except for those that are constructed
+// on request (`dynamic_message`, `dynamic_data_pool`, and `type_plan`).
 //
 // NOTE(methylDragon): There is an opportunity to defer the population of the members by waiting
 //                     for discovery, but this path is currently not supported.
 //
 // Ownership:
-//   - The struct owns its `description` field. It is responsible for deallocating it.
-//   - The struct owns its `serialization_support` field. It is responsible for deallocating it.
-//   - The struct owns its `dynamic_message_type` field. It is responsible for deallocating it.
-//   - The struct owns its `dynamic_message` field. It is responsible for deallocating it.
+//   - The struct owns its `description` field. It is responsible for deallocating it (along with
+//     `type_description_storage` if it was copied, or with the struct itself if `is_compact` is
+//     set).
+//   - The struct owns the serialization support it was initialized with. It is moved into
+//     `shared_serialization_support`, the one shared serialization support of its serialization
+//     library (see `rosidl_dynamic_typesupport_serialization_support_init_shared()`), so every
+//     handle of the same serialization library holds a reference to the same one, which it
+//     releases on finalization. The dynamic type registry holds references of its own, so
+//     registered dynamic types keep the serialization support alive for as long as they need it.
+//     Once the arguments are checked, the serialization support is taken over whether or not
+//     initialization succeeds: if it fails, the serialization support is finalized as well.
+//   - The `serialization_support` field is a shallow copy of `shared_serialization_support`, kept
+//     for borrowing. It MUST NOT be finalized. Prefer borrowing `shared_serialization_support`.
+//   - The struct owns a reference to its `dynamic_message_type` field. If `type_hash` is set, the
+//     dynamic type is shared through the dynamic type registry (see dynamic_type_registry.h), and
+//     is released on finalization. Otherwise it is owned outright, and deallocated on finalization.
+//   - The struct owns its `dynamic_message` field, if it was constructed. It is responsible for
+//     deallocating it.
+//   - The struct owns its `dynamic_data_pool` field, if it was initialized. It is responsible for
+//     deallocating it, so every dynamic data acquired from it must be released first.
+//   - The struct owns its `type_plan` field, if it was built. It is responsible for deallocating
+//     it.
+//   - If `is_shared` is set, the struct is the handle's own view of an impl shared with other
+//     handles. It only owns its `dynamic_message`, `skip_dynamic_message`, and `dynamic_data_pool`
+//     fields. Everything else is borrowed from the shared impl, which is finalized once the last
+//     handle sharing it is.
 //
 // Downstream classes are expected to borrow the `serialization_support` field, and potentially the
 // `dynamic_message_type` and `dynamic_message` fields. As such, it is important that this struct
@@ -53,20 +80,64 @@ typedef struct rosidl_dynamic_message_type_support_impl_s
   rcutils_allocator_t allocator;
 
   rosidl_type_hash_t type_hash;
+
+  // NOTE: Unless adopted, type_description and type_description_sources are packed
+  //       copies, with every string and sequence in one block. They are read-only,
+  //       and MUST NOT be modified or finalized with the rosidl_runtime_c functions
   rosidl_runtime_c__type_description__TypeDescription type_description;
 
   // Unused for now, but placed here just in case
   rosidl_runtime_c__type_description__TypeSource__Sequence type_description_sources;
 
+  // Block the copies of type_description and type_description_sources are packed into. NULL if
+  // they were adopted, or if is_compact is set
+  void * type_description_storage;
+
   rosidl_dynamic_typesupport_serialization_support_t serialization_support;
 
+  // Reference to the shared serialization support that `serialization_support` is a copy of
+  rosidl_dynamic_typesupport_serialization_support_t * shared_serialization_support;
+
   // The dynamic_message_type allows us to do a one time alloc and reuse it for subscription
   // creation and data creation
+  //
+  // NOTE: If shared through the registry, it is immutable, and the registry entry holds its own
+  //       reference to the shared serialization support it was built with
   rosidl_dynamic_typesupport_dynamic_type_t * dynamic_message_type;
 
   // The dynamic_message allows us to either reuse it, or clone it, but it's technically redundant
   // because data can be created from dynamic_message_type
+  //
+  // NOTE: NULL until first requested with
+  //       `rosidl_dynamic_message_type_support_handle_get_dynamic_message()`, since most handles
+  //       never use it. Do not read it directly. This is an API break: it used to be constructed
+  //       when the handle was initialized
   rosidl_dynamic_typesupport_dynamic_data_t * dynamic_message;
+
+  // Set with `rosidl_dynamic_message_type_support_handle_skip_dynamic_message()`, so that
+  // dynamic_message is never constructed
+  bool skip_dynamic_message;
+
+  // Recycles dynamic data of dynamic_message_type, for handles that need one per message. NULL
+  // until initialized with `rosidl_dynamic_message_type_support_handle_init_dynamic_data_pool()`
+  rosidl_dynamic_typesupport_dynamic_data_pool_t * dynamic_data_pool;
+
+  // Compiled form of type_description for generic traversal of dynamic_message. NULL until built
+  // with `rosidl_dynamic_message_type_support_handle_init_type_plan()`
+  rosidl_dynamic_typesupport_type_plan_t * type_plan;
+
+  // Set if this struct is a view of the impl shared by every handle initialized with
+  // `rosidl_dynamic_message_type_support_handle_init_shared()` for the same type hash and
+  // serialization library. The type description, dynamic type, and type plan are then the shared
+  // impl's, and type_plan is always NULL here (use
+  // `rosidl_get_dynamic_message_type_support_type_plan_function()` instead)
+  bool is_shared;
+
+  // Set if this struct was allocated by
+  // `rosidl_dynamic_message_type_support_handle_init_compact()`, in which case type_description,
+  // type_description_sources, and dynamic_message_type (unless shared through the registry) live in
+  // the same allocation as it, and go along with it
+  bool is_compact;
 } rosidl_dynamic_message_type_support_impl_t;
 
 /// Initialize a dynamic type message type support with encapsulated message description
@@ -78,7 +149,7 @@ typedef struct rosidl_dynamic_message_type_support_impl_s
  * types.
  *
  * The `type_hash`, `type_description`, `type_description_sources`, and `allocator` arguments are
- * copied.
+ * copied. The descriptions are copied into a single block, and the copies are read-only.
  *
  * <hr>
  * Attribute          | Adherence
@@ -98,6 +169,99 @@ rosidl_dynamic_message_type_support_handle_init(
   rcutils_allocator_t * allocator,
   rosidl_message_type_support_t * ts);  // OUT
 
+/// Initialize a dynamic type message type support, taking ownership of the message description
+/**
+ * Same as `rosidl_dynamic_message_type_support_handle_init()`, except that `type_description` and
+ * `type_description_sources` are moved into the handle instead of being copied, which saves a deep
+ * copy of every nested description for callers that built them just to pass them in here.
+ *
+ * On success, `type_description` and `type_description_sources` are left zero initialized, and may
+ * be finalized or dropped by the caller. On failure, they are left as they were passed in, and
+ * remain the caller's to finalize. `serialization_support` is taken over either way, as with
+ * `rosidl_dynamic_message_type_support_handle_init()`.
+ *
+ * The adopted descriptions are finalized with the `rosidl_runtime_c` `__fini()` functions, so they
+ * must have been allocated the same way (e.g. with their `__init()` and `__copy()` functions).
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_message_type_support_handle_init_adopt(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_type_hash_t * type_hash,
+  rosidl_runtime_c__type_description__TypeDescription * type_description,
+  rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources,
+  rcutils_allocator_t * allocator,
+  rosidl_message_type_support_t * ts);  // OUT
+
+/// Initialize a dynamic type message type support in a single allocation
+/**
+ * Same as `rosidl_dynamic_message_type_support_handle_init()`, except that the impl, its copies of
+ * `type_description` and `type_description_sources`, and its dynamic type (unless it is shared
+ * through the dynamic type registry) are all laid out in one allocation, instead of up to three.
+ *
+ * The handle is finalized with `rosidl_dynamic_message_type_support_handle_fini()` as usual.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_message_type_support_handle_init_compact(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_type_hash_t * type_hash,
+  const rosidl_runtime_c__type_description__TypeDescription * type_description,
+  const rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources,
+  rcutils_allocator_t * allocator,
+  rosidl_message_type_support_t * ts);  // OUT
+
+/// Initialize a dynamic type message type support that shares its impl with every other handle
+/// initialized with this function for the same type hash and serialization library
+/**
+ * The shared `rosidl_dynamic_message_type_support_impl_t` is reference counted, and only built
+ * (i.e. the description copied, and its dynamic type constructed) by the first handle for the
+ * type. It is immutable, and is finalized along with the last of those handles. The type plan is
+ * shared too, but every handle still gets its own `dynamic_message` and dynamic data pool.
+ *
+ * The `type_hash` must be set, since it is the only thing used to tell types apart. It is up to
+ * the caller to make sure it matches `type_description`.
+ *
+ * Like with `rosidl_dynamic_message_type_support_handle_init()`, the handle takes ownership of
+ * `serialization_support` once the arguments are checked, whether or not initialization succeeds,
+ * so the caller MUST NOT finalize it afterwards. If the impl was already shared, the impl keeps
+ * using the serialization support it was built with, and `serialization_support` is finalized
+ * right away.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes, unless the impl was already shared
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_message_type_support_handle_init_shared(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_type_hash_t * type_hash,
+  const rosidl_runtime_c__type_description__TypeDescription * type_description,
+  const rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources,
+  rcutils_allocator_t * allocator,
+  rosidl_message_type_support_t * ts);  // OUT
+
 /// Finalize a rosidl_message_type_support_t obtained with
 /// `rosidl_dynamic_message_type_support_handle_init()`, which has dynamically allocated members
 ///
@@ -110,7 +274,7 @@ rosidl_dynamic_message_type_support_handle_fini(rosidl_message_type_support_t *
 /// Initialized a `rosidl_dynamic_message_type_support_impl_t` with encapsulated message description
 /**
  * The `type_hash`, `type_description`, `type_description_sources`, and `allocator` arguments are
- * copied.
+ * copied. The descriptions are copied into a single block, and the copies are read-only.
  *
  * <hr>
  * Attribute          | Adherence
@@ -130,12 +294,144 @@ rosidl_dynamic_message_type_support_handle_impl_init(
   rcutils_allocator_t * allocator,
   rosidl_dynamic_message_type_support_impl_t * ts_impl);  // OUT
 
+/// Initialize a `rosidl_dynamic_message_type_support_impl_t`, taking ownership of the message
+/// description
+/**
+ * See `rosidl_dynamic_message_type_support_handle_init_adopt()` for the ownership rules of
+ * `type_description` and `type_description_sources`.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_message_type_support_handle_impl_init_adopt(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_type_hash_t * type_hash,
+  rosidl_runtime_c__type_description__TypeDescription * type_description,
+  rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_message_type_support_impl_t * ts_impl);  // OUT
+
 /// Finalize a `rosidl_dynamic_message_type_support_impl_t`
+///
+/// NOTE: Shared impls are finalized by `rosidl_dynamic_message_type_support_handle_fini()` instead
 ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
 rcutils_ret_t
 rosidl_dynamic_message_type_support_handle_impl_fini(
   rosidl_dynamic_message_type_support_impl_t * ts_impl);
 
+/// Build the type plan of a rosidl_message_type_support_t obtained with
+/// `rosidl_dynamic_message_type_support_handle_init()`, if it was not built already
+/**
+ * The type plan is compiled from the handle's type description once, and lives as long as the
+ * handle. Get it with `rosidl_get_dynamic_message_type_support_type_plan_function()`.
+ *
+ * Only thread-safe for handles with a shared impl.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_message_type_support_handle_init_type_plan(rosidl_message_type_support_t * ts);
+
+/// Get the dynamic_message of a rosidl_message_type_support_t obtained with
+/// `rosidl_dynamic_message_type_support_handle_init()`, constructing it on the first call
+/**
+ * The dynamic message is owned by the handle, and lives as long as it does. Every call for the
+ * same handle gives back the same dynamic message. Handles sharing an impl each have their own.
+ *
+ * Fails if the dynamic message was skipped with
+ * `rosidl_dynamic_message_type_support_handle_skip_dynamic_message()`.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes, on the first call
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_message_type_support_handle_get_dynamic_message(
+  const rosidl_message_type_support_t * ts,
+  rosidl_dynamic_typesupport_dynamic_data_t ** dynamic_message);  // OUT
+
+/// Never construct the dynamic_message of a rosidl_message_type_support_t obtained with
+/// `rosidl_dynamic_message_type_support_handle_init()`
+/**
+ * For handles that only ever create their own dynamic data from the dynamic type. Fails if the
+ * dynamic message was already constructed.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_message_type_support_handle_skip_dynamic_message(rosidl_message_type_support_t * ts);
+
+/// Initialize the dynamic data pool of a rosidl_message_type_support_t obtained with
+/// `rosidl_dynamic_message_type_support_handle_init()`, if it was not initialized already
+/**
+ * See `rosidl_dynamic_typesupport_dynamic_data_pool_init()` for `min_size` and `max_size`, which
+ * are ignored if the pool was already initialized. Get the pool with
+ * `rosidl_get_dynamic_message_type_support_dynamic_data_pool_function()`.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_message_type_support_handle_init_dynamic_data_pool(
+  rosidl_message_type_support_t * ts,
+  size_t min_size,
+  size_t max_size);
+
+/// Get the memory held by a rosidl_message_type_support_t obtained with
+/// `rosidl_dynamic_message_type_support_handle_init()`
+/**
+ * Aggregates the impl and its type description, the dynamic type, and whichever of the dynamic
+ * message, dynamic data pool, and type plan were constructed, but not the handle struct itself.
+ *
+ * Impls and dynamic types shared with other handles are counted in full for each of them, so the
+ * usage of handles sharing them adds up to more than they actually hold.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_message_type_support_handle_get_memory_usage(
+  const rosidl_message_type_support_t * ts,
+  rosidl_dynamic_typesupport_memory_usage_t * memory_usage);  // OUT
+
 /// Return type_hash member in rosidl_dynamic_message_type_support_impl_t
 ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
 const rosidl_type_hash_t *
@@ -154,6 +450,19 @@ const rosidl_runtime_c__type_description__TypeSource__Sequence *
 rosidl_get_dynamic_message_type_support_type_description_sources_function(
   const rosidl_message_type_support_t * type_support);
 
+/// Return dynamic_data_pool member in rosidl_dynamic_message_type_support_impl_t (NULL if not
+/// initialized)
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rosidl_dynamic_typesupport_dynamic_data_pool_t *
+rosidl_get_dynamic_message_type_support_dynamic_data_pool_function(
+  const rosidl_message_type_support_t * type_support);
+
+/// Return type_plan member in rosidl_dynamic_message_type_support_impl_t (NULL if not built)
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+const rosidl_dynamic_typesupport_type_plan_t *
+rosidl_get_dynamic_message_type_support_type_plan_function(
+  const rosidl_message_type_support_t * type_support);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,250 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSIDL_DYNAMIC_TYPESUPPORT__DYNAMIC_TYPE_REGISTRY_H_
+#define ROSIDL_DYNAMIC_TYPESUPPORT__DYNAMIC_TYPE_REGISTRY_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+
+#include <rcutils/allocator.h>
+#include <rcutils/time.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/type_description/type_description__struct.h>
+#include <rosidl_runtime_c/type_hash.h>
+
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/type_snapshot.h"
+#include "rosidl_dynamic_typesupport/types.h"
+#include "rosidl_dynamic_typesupport/visibility_control.h"
+
+
+// DYNAMIC TYPE REGISTRY ===========================================================================
+// A process-wide cache of dynamic types, keyed by (serialization support, type hash). Since shared
+// serialization supports are one per serialization library, this amounts to one dynamic type per
+// serialization library and type hash.
+//
+// Every dynamic type in the registry is reference counted, and is shared by everyone that acquired
+// it. Shared dynamic types are immutable: do NOT finalize, modify, or delete them directly. Give
+// them back with `rosidl_dynamic_typesupport_dynamic_type_registry_release()` instead.
+//
+// Ownership:
+//   - Serialization supports passed to the registry MUST be shared ones (see
+//     `rosidl_dynamic_typesupport_serialization_support_init_shared()`).
+//   - Each registry entry holds a reference to the serialization support it was built with, and
+//     its dynamic type borrows it. The reference is released once the entry is, so the caller may
+//     release its own reference to the serialization support at any time.
+
+/// Get a shared dynamic type for a type hash, building it from the description if needed
+/**
+ * If another caller already acquired a dynamic type for the same serialization support and type
+ * hash, that dynamic type is returned and its reference count is incremented. Otherwise, a new
+ * dynamic type is loaded from the registry snapshot if it has one (see
+ * `rosidl_dynamic_typesupport_dynamic_type_registry_set_snapshot()`), or built from `description`,
+ * and registered.
+ *
+ * The `type_hash` must be set (i.e. not `ROSIDL_TYPE_HASH_VERSION_UNSET`). Type hashes are not
+ * verified against descriptions, so every entry keeps a copy of the description it was built from,
+ * and a registered dynamic type is only returned for an equal `description`. If a different one is
+ * already registered under `type_hash`, this fails with RCUTILS_RET_INVALID_ARGUMENT.
+ *
+ * `serialization_support` must be a shared serialization support. A new entry takes a reference
+ * to it.
+ *
+ * Registry entries are allocated with `allocator`, which must stay valid until the entry is
+ * released by every caller that acquired it.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_registry_acquire(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_type_hash_t * type_hash,
+  const rosidl_runtime_c__type_description__TypeDescription * description,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_dynamic_type_t ** dynamic_type);  // OUT
+
+/// Release a dynamic type obtained with
+/// `rosidl_dynamic_typesupport_dynamic_type_registry_acquire()`
+/**
+ * The dynamic type is finalized and deallocated once the last reference to it is released.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_registry_release(
+  rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type);
+
+/// Load dynamic types missing from the registry from a snapshot, before building them
+/**
+ * Types that are not in the snapshot, or that fail to load from it, are still built from their
+ * descriptions. Pass NULL to stop using a snapshot.
+ *
+ * The snapshot (and the data it wraps) must stay valid until every dynamic type acquired while it
+ * was set has been released.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_registry_set_snapshot(
+  const rosidl_dynamic_typesupport_type_snapshot_t * snapshot);
+
+
+// DYNAMIC TYPE REGISTRY PREWARM ===================================================================
+// Builds the dynamic types a process is known to need ahead of time, across any number of worker
+// threads, and keeps them in the registry. Dynamic message type support handles created later for
+// the same type hashes then find their dynamic type already built.
+//
+// The registry does not start threads of its own. Instead, every worker thread of the caller runs
+// `rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_run()` on the same prewarm, and each
+// run keeps claiming the next type that was not claimed yet until there are none left.
+//
+// Only dynamic types are built, not dynamic message type support handles: every handle takes over a
+// serialization support of its own, which only the caller can create. Building the dynamic type is
+// most of the work of initializing a handle, and that is what handles for prewarmed types skip.
+//
+// Descriptions are taken in memory. Loading serialized ones (e.g. from a directory) is left to the
+// caller, since this package has no reader for them.
+
+typedef struct \
+  rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_impl_s \
+  rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_impl_t;
+
+typedef struct rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_result_s
+{
+  // Result of acquiring the dynamic type from the registry
+  rcutils_ret_t ret;
+  // Steady time spent acquiring the dynamic type, in nanoseconds. This is the time it took to build
+  // it, unless it was already registered
+  rcutils_duration_value_t build_time;
+  // Registry reference, held until the prewarm is finalized. NULL if acquiring failed
+  rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type;
+} rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_result_t;
+
+typedef struct rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_s
+{
+  // Reference to a shared serialization support, released when the prewarm is finalized
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support;
+  // !!! Borrowed, must stay valid until every run returned
+  const rosidl_type_hash_t * type_hashes;
+  const rosidl_runtime_c__type_description__TypeDescription * const * descriptions;
+  size_t type_count;
+
+  // Indexed like `descriptions`. Only complete once every run returned
+  rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_result_t * results;
+
+  rcutils_allocator_t allocator;
+  rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_impl_t * impl;
+} rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_t;
+
+
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_t
+rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type_registry_prewarm(void);
+
+/// Prepare to prewarm the registry with one dynamic type per type hash and description
+/**
+ * Nothing is built until the prewarm is run. Every type hash must be set, and
+ * `serialization_support` must be a shared serialization support, as with
+ * `rosidl_dynamic_typesupport_dynamic_type_registry_acquire()`. The prewarm takes a reference to
+ * it.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_init(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_type_hash_t * type_hashes,
+  const rosidl_runtime_c__type_description__TypeDescription * const * descriptions,
+  size_t type_count,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_t * prewarm);  // OUT
+
+/// Acquire dynamic types from the registry until every type of the prewarm was claimed
+/**
+ * Meant to be called once from each worker thread, all on the same prewarm. Failing to acquire a
+ * type does not stop the run: it is recorded in the result of that type, and the run moves on.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_run(
+  rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_t * prewarm);
+
+/// Release every dynamic type the prewarm holds
+/**
+ * Dynamic types stay registered for as long as anything else (e.g. a dynamic message type support
+ * handle) still holds them, so finalize the prewarm once those were created, or at shutdown.
+ *
+ * MUST NOT be called while the prewarm is running.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_fini(
+  rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_t * prewarm);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ROSIDL_DYNAMIC_TYPESUPPORT__DYNAMIC_TYPE_REGISTRY_H_
@@ -0,0 +1,93 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSIDL_DYNAMIC_TYPESUPPORT__INTERNED_STRING_H_
+#define ROSIDL_DYNAMIC_TYPESUPPORT__INTERNED_STRING_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+
+#include <rcutils/types/rcutils_ret.h>
+
+#include "rosidl_dynamic_typesupport/visibility_control.h"
+
+
+// INTERNED STRINGS ================================================================================
+// A process-wide table of type and member names.
+//
+// Each distinct string is stored once, and interning the same string again gives back the same
+// interned string for as long as it is referenced. So interned strings can be compared by pointer,
+// and their precomputed hash used directly as a hash map key.
+//
+// Interning a string takes a reference to it, which MUST be released. Interned strings stay valid
+// (at the same address) while referenced, and are freed once the last reference is released.
+
+typedef struct rosidl_dynamic_typesupport_interned_string_s
+{
+  // Null terminated
+  const char * data;
+  size_t length;
+  size_t hash;
+} rosidl_dynamic_typesupport_interned_string_t;
+
+/// Get a reference to the interned string equal to the first `length` characters of `string`
+/**
+ * `string` does not have to be null terminated, and may contain null characters. The reference
+ * MUST be released with rosidl_dynamic_typesupport_interned_string_release().
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes, if the string is not interned yet
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_intern_string(
+  const char * string,
+  size_t length,
+  const rosidl_dynamic_typesupport_interned_string_t ** interned_string);  // OUT
+
+/// Take another reference to an interned string, e.g. to keep one that was borrowed
+/**
+ * The reference MUST be released with rosidl_dynamic_typesupport_interned_string_release().
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_interned_string_retain(
+  const rosidl_dynamic_typesupport_interned_string_t * interned_string);
+
+/// Release a reference to an interned string, freeing it if it was the last one
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_interned_string_release(
+  const rosidl_dynamic_typesupport_interned_string_t * interned_string);
+
+/// Get how many distinct strings are currently interned
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+size_t
+rosidl_dynamic_typesupport_get_interned_string_count(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ROSIDL_DYNAMIC_TYPESUPPORT__INTERNED_STRING_H_
@@ -0,0 +1,193 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSIDL_DYNAMIC_TYPESUPPORT__TYPE_PLAN_H_
+#define ROSIDL_DYNAMIC_TYPESUPPORT__TYPE_PLAN_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rcutils/allocator.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/type_description/type_description__struct.h>
+
+#include "rosidl_dynamic_typesupport/types.h"
+#include "rosidl_dynamic_typesupport/visibility_control.h"
+
+
+// TYPE PLAN =======================================================================================
+// A compiled, immutable, flattened form of a type description.
+//
+// Everything needed to decide how to access each member of dynamic data (which getter to call,
+// with which bounds, and which type to descend into) is laid out in contiguous tables, so generic
+// tools can traverse types without going back to the type description and its strings.
+//
+// Types are indexed from 0 to `type_count`, with the top level type always at index 0, followed by
+// the referenced types in description order. Fields are indexed from 0 to `field_count`, and the
+// fields of each type are contiguous and in member id order.
+
+// Field has no nested type
+#define ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_NO_NESTED_TYPE SIZE_MAX
+
+// Field flags
+//
+// Field is a nested type, or an array/sequence of them
+#define ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_NESTED (1u << 0)
+// Field is a string type, or an array/sequence of them
+#define ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_STRING (1u << 1)
+#define ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_ARRAY (1u << 2)
+#define ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_BOUNDED_SEQUENCE (1u << 3)
+#define ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_UNBOUNDED_SEQUENCE (1u << 4)
+// Field elements are plain old data: non-string primitives, or nested types that are entirely made
+// of fixed size fields. Such elements can be copied in bulk
+#define ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_POD (1u << 5)
+// Field always holds the same amount of data (i.e. it has POD elements and is not a sequence)
+#define ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_FIXED_SIZE (1u << 6)
+
+typedef struct rosidl_dynamic_typesupport_type_plan_s
+{
+  // TYPE TABLES (indexed by type index)
+  size_t type_count;
+  const char ** type_names;
+  size_t * type_name_lengths;
+  // The fields of type `t` are [type_first_fields[t], type_first_fields[t] + type_field_counts[t])
+  size_t * type_first_fields;
+  size_t * type_field_counts;
+  // Number of nested type levels below each type (0 if it has no nested fields)
+  size_t * type_depths;
+  bool * type_is_fixed_size;
+
+  // FIELD TABLES (indexed by field index)
+  size_t field_count;
+  const char ** field_names;
+  size_t * field_name_lengths;
+  rosidl_dynamic_typesupport_member_id_t * field_member_ids;
+  // One of the ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_* constants
+  uint8_t * field_type_ids;
+  // Type id of a single element, i.e. the field type id without the array/sequence part
+  uint8_t * field_element_type_ids;
+  // Array length or sequence bound, 0 otherwise
+  size_t * field_capacities;
+  // String length or string bound, 0 otherwise
+  size_t * field_string_capacities;
+  // Type index of nested fields, ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_NO_NESTED_TYPE otherwise
+  size_t * field_nested_types;
+  // ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_* flags
+  uint8_t * field_flags;
+
+  rcutils_allocator_t allocator;
+  // NOTE: Every table and string above lives in this single allocation, except for
+  //       plans loaded from a type snapshot, where it only holds the name tables
+  void * storage;
+  size_t storage_size;
+} rosidl_dynamic_typesupport_type_plan_t;
+
+/// Called for each field visited by `rosidl_dynamic_typesupport_type_plan_walk()`
+/**
+ * `depth` is 0 for the fields of the type the walk started from, and increases by one for every
+ * nested type descended into.
+ *
+ * `descend` is only meaningful for nested fields, and is set to true when called. Set it to false
+ * to skip the fields of the nested type.
+ *
+ * Returning anything other than RCUTILS_RET_OK stops the walk, and is returned from it.
+ */
+typedef rcutils_ret_t (* rosidl_dynamic_typesupport_type_plan_visit_field_t)(
+  const rosidl_dynamic_typesupport_type_plan_t * plan,
+  size_t field_index,
+  size_t depth,
+  bool * descend,  // IN/OUT
+  void * state);
+
+typedef struct rosidl_dynamic_typesupport_type_plan_visitor_s
+{
+  rosidl_dynamic_typesupport_type_plan_visit_field_t visit_field;
+
+  // Optional. Called with the nested field once every field of its type was visited
+  rcutils_ret_t (* leave_nested_field)(
+    const rosidl_dynamic_typesupport_type_plan_t * plan,
+    size_t field_index,
+    size_t depth,
+    void * state);
+
+  void * state;
+} rosidl_dynamic_typesupport_type_plan_visitor_t;
+
+
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rosidl_dynamic_typesupport_type_plan_t
+rosidl_dynamic_typesupport_get_zero_initialized_type_plan(void);
+
+/// Compile a type plan from a type description
+/**
+ * The plan does not borrow anything from `description`, so the description may be finalized
+ * as soon as this returns.
+ *
+ * Fails if a nested type is missing from the description's referenced types, or if types
+ * reference each other in a cycle.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_type_plan_init(
+  const rosidl_runtime_c__type_description__TypeDescription * description,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_type_plan_t * plan);  // OUT
+
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_type_plan_fini(rosidl_dynamic_typesupport_type_plan_t * plan);
+
+/// Visit every field of a type, depth first, descending into nested types
+/**
+ * Fields are visited in order, and the fields of a nested type are visited right after the field
+ * that contains it. Pass 0 as `type_index` to walk from the top level type.
+ *
+ * Nested types are visited once per field that contains them, no matter how many elements the
+ * field holds in any particular dynamic data.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | Yes
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_type_plan_walk(
+  const rosidl_dynamic_typesupport_type_plan_t * plan,
+  size_t type_index,
+  const rosidl_dynamic_typesupport_type_plan_visitor_t * visitor);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ROSIDL_DYNAMIC_TYPESUPPORT__TYPE_PLAN_H_
@@ -0,0 +1,183 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ROSIDL_DYNAMIC_TYPESUPPORT__TYPE_SNAPSHOT_H_
+#define ROSIDL_DYNAMIC_TYPESUPPORT__TYPE_SNAPSHOT_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rcutils/allocator.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rcutils/types/uint8_array.h>
+#include <rosidl_runtime_c/type_description/type_description__struct.h>
+#include <rosidl_runtime_c/type_hash.h>
+
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/type_plan.h"
+#include "rosidl_dynamic_typesupport/types.h"
+#include "rosidl_dynamic_typesupport/visibility_control.h"
+
+
+// TYPE SNAPSHOTS ==================================================================================
+// A versioned, position independent image of already built dynamic types, meant to be written to
+// a file once and mapped read-only by every process that needs those types at startup.
+//
+// Each entry of a snapshot is keyed by (serialization library identifier, type hash), like the
+// dynamic type registry, and holds:
+//   - The compiled type plan of the type, names included, laid out so its tables can be used in
+//     place without copying them (see `rosidl_dynamic_typesupport_type_snapshot_load_type_plan()`)
+//   - An opaque blob from the serialization library, that it can rebuild its dynamic type from
+//     without going through a dynamic type builder
+//
+// Snapshots are only loaded by processes with the same byte order and size_t width as the process
+// that exported them, and are rejected otherwise. Rebuild them whenever the format version changes.
+//
+// Snapshots are plain bytes, so writing them to disk and mapping them back is left to the caller.
+// Snapshot data must be aligned to at least ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_SNAPSHOT_ALIGNMENT
+// (which memory mappings always are), and must outlive everything loaded from it.
+
+#define ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_SNAPSHOT_FORMAT_VERSION 1
+#define ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_SNAPSHOT_ALIGNMENT 16
+
+typedef struct rosidl_dynamic_typesupport_type_snapshot_s
+{
+  // !!! Borrowed, lifetime is NOT managed by this struct
+  const uint8_t * data;
+  size_t size;
+  size_t entry_count;
+} rosidl_dynamic_typesupport_type_snapshot_t;
+
+
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rosidl_dynamic_typesupport_type_snapshot_t
+rosidl_dynamic_typesupport_get_zero_initialized_type_snapshot(void);
+
+/// Export dynamic types, and the descriptions they were built from, to a new snapshot
+/**
+ * `dynamic_types[i]` must have been built from `descriptions[i]`, and must have its type hash set.
+ * The serialization libraries of the dynamic types must implement the snapshot blob methods.
+ *
+ * `snapshot` is initialized with `allocator`, and must be finalized with
+ * `rcutils_uint8_array_fini()`. Its buffer is suitably aligned to be loaded as is.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_type_snapshot_export(
+  const rosidl_dynamic_typesupport_dynamic_type_t * const * dynamic_types,
+  const rosidl_runtime_c__type_description__TypeDescription * const * descriptions,
+  size_t type_count,
+  rcutils_allocator_t * allocator,
+  rcutils_uint8_array_t * snapshot);  // OUT
+
+/// Validate snapshot data and wrap it, without copying it
+/**
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_type_snapshot_init(
+  const void * data,
+  size_t size,
+  rosidl_dynamic_typesupport_type_snapshot_t * snapshot);  // OUT
+
+/// Find the entry for a serialization library and type hash
+/**
+ * Returns RCUTILS_RET_NOT_FOUND, without setting an error message, if there is no such entry.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_type_snapshot_find(
+  const rosidl_dynamic_typesupport_type_snapshot_t * snapshot,
+  const char * serialization_library_identifier,
+  const rosidl_type_hash_t * type_hash,
+  size_t * entry_index);  // OUT
+
+/// Initialize a dynamic type from a snapshot entry, without constructing it again
+/**
+ * The serialization library of `serialization_support` must be the one the entry was exported
+ * with. The dynamic type gets the type hash of the entry.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Depends on the serialization library
+ * Thread-Safe        | Yes
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_type_snapshot_load_dynamic_type(
+  const rosidl_dynamic_typesupport_type_snapshot_t * snapshot,
+  size_t entry_index,
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type);  // OUT
+
+/// Initialize a type plan from a snapshot entry
+/**
+ * Only the name tables are allocated. Every other table, and the names themselves, point into the
+ * snapshot data, so they must not be modified.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | Yes
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ */
+ROSIDL_DYNAMIC_TYPESUPPORT_PUBLIC
+rcutils_ret_t
+rosidl_dynamic_typesupport_type_snapshot_load_type_plan(
+  const rosidl_dynamic_typesupport_type_snapshot_t * snapshot,
+  size_t entry_index,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_type_plan_t * plan);  // OUT
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ROSIDL_DYNAMIC_TYPESUPPORT__TYPE_SNAPSHOT_H_
@@ -63,6 +63,18 @@ typedef struct \
 typedef struct \
   rosidl_dynamic_typesupport_dynamic_type_impl_s \
   rosidl_dynamic_typesupport_dynamic_type_impl_t;
+typedef struct \
+  rosidl_dynamic_typesupport_dynamic_type_deferred_s \
+  rosidl_dynamic_typesupport_dynamic_type_deferred_t;
+typedef struct \
+  rosidl_dynamic_typesupport_dynamic_type_construction_options_s \
+  rosidl_dynamic_typesupport_dynamic_type_construction_options_t;
+typedef struct \
+  rosidl_dynamic_typesupport_dynamic_type_member_spec_s \
+  rosidl_dynamic_typesupport_dynamic_type_member_spec_t;
+typedef struct \
+  rosidl_dynamic_typesupport_default_values_s \
+  rosidl_dynamic_typesupport_default_values_t;
 
 typedef struct \
   rosidl_dynamic_typesupport_dynamic_data_s \
@@ -71,6 +83,19 @@ typedef struct \
   rosidl_dynamic_typesupport_dynamic_data_impl_s \
   rosidl_dynamic_typesupport_dynamic_data_impl_t;
 
+// Memory Usage ====================================================================================
+// Bytes held by a handle, dynamic type, dynamic type builder, or dynamic data, for memory budgets
+typedef struct rosidl_dynamic_typesupport_memory_usage_s
+{
+  // Allocated by this library, not counting the struct passed in (which belongs to the caller)
+  size_t library_bytes;
+  // Reported by the serialization library, for everything it allocated (including nested members)
+  size_t serialization_library_bytes;
+  // False if the serialization library does not report its memory usage, for at least one of the
+  // objects counted, in which case serialization_library_bytes is only a lower bound
+  bool serialization_library_bytes_reported;
+} rosidl_dynamic_typesupport_memory_usage_t;
+
 
 // =================================================================================================
 // FIELD TYPE INDICES
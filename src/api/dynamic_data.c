@@ -27,6 +27,8 @@
 #include "rosidl_dynamic_typesupport/types.h"
 #include "rosidl_dynamic_typesupport/uchar.h"
 
+#include "deferred_dynamic_type.h"
+
 
 // =================================================================================================
 // DYNAMIC DATA
@@ -121,6 +123,31 @@ rosidl_dynamic_typesupport_dynamic_data_get_item_count(
 }
 
 
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_data_get_memory_usage(
+  const rosidl_dynamic_typesupport_dynamic_data_t * dynamic_data,
+  rosidl_dynamic_typesupport_memory_usage_t * memory_usage)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(dynamic_data, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(memory_usage, RCUTILS_RET_INVALID_ARGUMENT);
+
+  // Values are all held by the serialization library
+  memory_usage->library_bytes = 0;
+  memory_usage->serialization_library_bytes = 0;
+  memory_usage->serialization_library_bytes_reported = false;
+  if (dynamic_data->serialization_support->methods.dynamic_data_get_memory_usage == NULL) {
+    return RCUTILS_RET_OK;
+  }
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+    (dynamic_data->serialization_support->methods.dynamic_data_get_memory_usage)(
+      &dynamic_data->serialization_support->impl, &dynamic_data->impl,
+      &memory_usage->serialization_library_bytes)
+  );
+  memory_usage->serialization_library_bytes_reported = true;
+  return RCUTILS_RET_OK;
+}
+
+
 rcutils_ret_t
 rosidl_dynamic_typesupport_dynamic_data_get_member_id_by_name(
   const rosidl_dynamic_typesupport_dynamic_data_t * dynamic_data,
@@ -307,12 +334,16 @@ rosidl_dynamic_typesupport_dynamic_data_init_from_dynamic_type(
     );
   }
 
+  rosidl_dynamic_typesupport_dynamic_type_impl_t * type_impl = NULL;
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+    deferred_dynamic_type_materialize_mutable(dynamic_type, &type_impl));
+
   dynamic_data->serialization_support = dynamic_type->serialization_support;
   dynamic_data->allocator = *allocator;
   ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK_WITH_CLEANUP(
     (dynamic_data->serialization_support->methods.dynamic_data_init_from_dynamic_type)(
       &dynamic_data->serialization_support->impl,
-      &dynamic_type->impl,
+      type_impl,
       allocator,
       &dynamic_data->impl),
     rosidl_dynamic_typesupport_dynamic_data_fini(dynamic_data)  // Cleanup
@@ -15,10 +15,15 @@
 #include "rosidl_dynamic_typesupport/api/dynamic_type.h"
 
 #include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <rcutils/error_handling.h>
 #include <rcutils/logging_macros.h>
+#include <rcutils/stdatomic_helper.h>
+#include <rcutils/types/hash_map.h>
 #include <rcutils/types/rcutils_ret.h>
 
 #include <rosidl_runtime_c/type_description/field__functions.h>
@@ -29,12 +34,18 @@
 #include <rosidl_runtime_c/type_description/individual_type_description__struct.h>
 #include <rosidl_runtime_c/type_description/type_description__functions.h>
 #include <rosidl_runtime_c/type_description/type_description__struct.h>
-#include <rosidl_runtime_c/type_description_utils.h>
+#include <rosidl_runtime_c/type_hash.h>
 
 #include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/default_values.h"
 #include "rosidl_dynamic_typesupport/macros.h"
 #include "rosidl_dynamic_typesupport/types.h"
 
+#include "compact_type_description.h"
+#include "deferred_dynamic_type.h"
+#include "spin_lock.h"
+#include "type_description_validation_cache.h"
+
 
 // =================================================================================================
 // DYNAMIC TYPE
@@ -81,15 +92,34 @@ rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type(void)
   static rosidl_dynamic_typesupport_dynamic_type_t zero_dynamic_type = {
     // .allocator  = // Initialized later
     // .impl  = // Initialized later
-    .serialization_support = NULL
+    .serialization_support = NULL,
+    .type_hash_verification = 0,
+    .deferred = NULL
   };
   zero_dynamic_type.allocator = rcutils_get_zero_initialized_allocator();
   zero_dynamic_type.impl =
     rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type_impl();
+  zero_dynamic_type.type_hash = rosidl_get_zero_initialized_type_hash();
   return zero_dynamic_type;
 }
 
 
+rosidl_dynamic_typesupport_dynamic_type_construction_options_t
+rosidl_dynamic_typesupport_get_default_dynamic_type_construction_options(void)
+{
+  static rosidl_dynamic_typesupport_dynamic_type_construction_options_t default_options = {
+    .parallel_for = NULL,
+    .parallel_for_state = NULL,
+    .max_depth = 0,
+    .max_total_fields = 0,
+    .type_hash = NULL,
+    .description_is_validated = false,
+    .defer_construction = false
+  };
+  return default_options;
+}
+
+
 // DYNAMIC TYPE UTILS ==============================================================================
 rcutils_ret_t
 rosidl_dynamic_typesupport_dynamic_type_equals(
@@ -107,8 +137,35 @@ rosidl_dynamic_typesupport_dynamic_type_equals(
     RCUTILS_SET_ERROR_MSG("Library identifiers for dynamic types do not match");
     return RCUTILS_RET_INVALID_ARGUMENT;
   }
+
+  if (dynamic_type == other) {
+    *equals = true;
+    return RCUTILS_RET_OK;
+  }
+
+  // Type hashes passed in by callers are not checked against their descriptions, so they only
+  // tell types apart if the library vouched for them (see `type_hash_verification`). A mismatch
+  // proves nothing either way, since the same description may have been passed in under a wrong
+  // hash, so that still takes the structural comparison
+  if (dynamic_type->type_hash_verification != 0 &&
+    dynamic_type->type_hash_verification == other->type_hash_verification &&
+    dynamic_type->type_hash.version == other->type_hash.version &&
+    memcmp(
+      dynamic_type->type_hash.value, other->type_hash.value,
+      sizeof(dynamic_type->type_hash.value)) == 0)
+  {
+    *equals = true;
+    return RCUTILS_RET_OK;
+  }
+
+  const rosidl_dynamic_typesupport_dynamic_type_impl_t * type_impl = NULL;
+  const rosidl_dynamic_typesupport_dynamic_type_impl_t * other_impl = NULL;
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+    deferred_dynamic_type_materialize(dynamic_type, &type_impl));
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+    deferred_dynamic_type_materialize(other, &other_impl));
   return (dynamic_type->serialization_support->methods.dynamic_type_equals)(
-    &dynamic_type->serialization_support->impl, &dynamic_type->impl, &other->impl, equals);
+    &dynamic_type->serialization_support->impl, type_impl, other_impl, equals);
 }
 
 
@@ -118,8 +175,82 @@ rosidl_dynamic_typesupport_dynamic_type_get_member_count(
 {
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(dynamic_type, RCUTILS_RET_INVALID_ARGUMENT);
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(member_count, RCUTILS_RET_INVALID_ARGUMENT);
+  const rosidl_dynamic_typesupport_dynamic_type_impl_t * type_impl = NULL;
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+    deferred_dynamic_type_materialize(dynamic_type, &type_impl));
   return (dynamic_type->serialization_support->methods.dynamic_type_get_member_count)(
-    &dynamic_type->serialization_support->impl, &dynamic_type->impl, member_count);
+    &dynamic_type->serialization_support->impl, type_impl, member_count);
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_get_memory_usage(
+  const rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type,
+  rosidl_dynamic_typesupport_memory_usage_t * memory_usage)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(dynamic_type, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(memory_usage, RCUTILS_RET_INVALID_ARGUMENT);
+
+  const rosidl_dynamic_typesupport_dynamic_type_impl_t * type_impl = NULL;
+  deferred_dynamic_type_get_memory_usage(dynamic_type, &memory_usage->library_bytes, &type_impl);
+  memory_usage->serialization_library_bytes = 0;
+  memory_usage->serialization_library_bytes_reported = false;
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support =
+    dynamic_type->serialization_support;
+  if (serialization_support->methods.dynamic_type_get_memory_usage == NULL) {
+    return RCUTILS_RET_OK;
+  }
+
+  // Deferred types (and their nested types) that were not built yet hold nothing in the
+  // serialization library
+  const rosidl_dynamic_typesupport_dynamic_type_t * nested_types = NULL;
+  size_t nested_type_count = 0;
+  deferred_dynamic_type_get_nested_types(dynamic_type, &nested_types, &nested_type_count);
+  for (size_t i = 0; i <= nested_type_count; i++) {
+    if (i > 0) {
+      size_t nested_library_bytes = 0;
+      deferred_dynamic_type_get_memory_usage(
+        &nested_types[i - 1], &nested_library_bytes, &type_impl);
+    }
+    if (type_impl == NULL) {
+      continue;
+    }
+    size_t bytes = 0;
+    ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+      (serialization_support->methods.dynamic_type_get_memory_usage)(
+        &serialization_support->impl, type_impl, &bytes)
+    );
+    memory_usage->serialization_library_bytes += bytes;
+  }
+  memory_usage->serialization_library_bytes_reported = true;
+  return RCUTILS_RET_OK;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_builder_get_memory_usage(
+  const rosidl_dynamic_typesupport_dynamic_type_builder_t * dynamic_type_builder,
+  rosidl_dynamic_typesupport_memory_usage_t * memory_usage)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(dynamic_type_builder, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(memory_usage, RCUTILS_RET_INVALID_ARGUMENT);
+
+  memory_usage->library_bytes = 0;
+  memory_usage->serialization_library_bytes = 0;
+  memory_usage->serialization_library_bytes_reported = false;
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support =
+    dynamic_type_builder->serialization_support;
+  if (serialization_support->methods.dynamic_type_builder_get_memory_usage == NULL) {
+    return RCUTILS_RET_OK;
+  }
+
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+    (serialization_support->methods.dynamic_type_builder_get_memory_usage)(
+      &serialization_support->impl, &dynamic_type_builder->impl,
+      &memory_usage->serialization_library_bytes)
+  );
+  memory_usage->serialization_library_bytes_reported = true;
+  return RCUTILS_RET_OK;
 }
 
 
@@ -188,123 +319,859 @@ rosidl_dynamic_typesupport_dynamic_type_builder_clone(
 }
 
 
+// Nested types that have already been built during a single call to
+// rosidl_dynamic_typesupport_dynamic_type_builder_init_from_description(), keyed by type name.
+// Deferred types keep one for as long as they live, pointing at their deferred nested types
+//
+// NOTE: The keys borrow the type names from the top level description's
+//       referenced_type_descriptions, which outlive the cache.
+typedef struct nested_type_cache_s
+{
+  const rosidl_runtime_c__type_description__TypeDescription * description;
+  rcutils_allocator_t allocator;
+  // Index into description->referenced_type_descriptions, keyed by type name (const char *)
+  rcutils_hash_map_t referenced_type_indices;
+  // Types built so far, indexed like description->referenced_type_descriptions
+  rosidl_dynamic_typesupport_dynamic_type_t ** built_types;
+  // If set, built_types are the (not owned) deferred nested types of a deferred type instead, which
+  // are all there from the start, and are built in place
+  rosidl_dynamic_typesupport_dynamic_type_t * deferred_types;
+} nested_type_cache_t;
+
+
 static rcutils_ret_t
-handle_nested_type(
-  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+nested_type_cache_init(
   const rosidl_runtime_c__type_description__TypeDescription * description,
   rcutils_allocator_t * allocator,
-  rosidl_dynamic_typesupport_dynamic_type_builder_t * dynamic_type_builder,
-  rosidl_runtime_c__type_description__Field * field,
-  size_t field_offset)
+  nested_type_cache_t * cache)
 {
-  if (field->type.nested_type_name.data == NULL) {
-    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
-      "Nested type name from nested field [%s]", field->name.data);
-    return RCUTILS_RET_ERROR;
+  const rosidl_runtime_c__type_description__IndividualTypeDescription__Sequence * referenced =
+    &description->referenced_type_descriptions;
+
+  cache->description = description;
+  cache->allocator = *allocator;
+  cache->referenced_type_indices = rcutils_get_zero_initialized_hash_map();
+  cache->built_types = NULL;
+  cache->deferred_types = NULL;
+
+  if (referenced->size > 0) {
+    cache->built_types = allocator->zero_allocate(
+      referenced->size, sizeof(rosidl_dynamic_typesupport_dynamic_type_t *), allocator->state);
+    if (cache->built_types == NULL) {
+      RCUTILS_SET_ERROR_MSG("Could not allocate nested type cache");
+      return RCUTILS_RET_BAD_ALLOC;
+    }
+  }
+
+  // rcutils_hash_map needs a non-zero capacity, even for descriptions without nested types
+  size_t initial_capacity = referenced->size;
+  if (initial_capacity == 0) {
+    initial_capacity = 1;
+  }
+  rcutils_ret_t ret = rcutils_hash_map_init(
+    &cache->referenced_type_indices, initial_capacity, sizeof(const char *), sizeof(size_t),
+    rcutils_hash_map_string_hash_func, rcutils_hash_map_string_cmp_func, allocator);
+  if (ret != RCUTILS_RET_OK) {
+    RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR("Could not initialize nested type index");
+    goto fail;
   }
 
-  // Create a new type description to pass to the next layer
-  rosidl_runtime_c__type_description__TypeDescription * recurse_desc = NULL;
-  rosidl_runtime_c__type_description__IndividualTypeDescription * recurse_indiv_desc = NULL;
+  for (size_t i = 0; i < referenced->size; i++) {
+    const char * key = referenced->data[i].type_name.data;
+    if (key == NULL) {
+      continue;
+    }
+    // Keep the first match, like a linear search would
+    if (rcutils_hash_map_key_exists(&cache->referenced_type_indices, &key)) {
+      continue;
+    }
+    ret = rcutils_hash_map_set(&cache->referenced_type_indices, &key, &i);
+    if (ret != RCUTILS_RET_OK) {
+      RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR("Could not index referenced type description");
+      goto fail;
+    }
+  }
+  return RCUTILS_RET_OK;
 
-  // NOTE(methylDragon): recurse_indiv_desc borrows from
-  //                     description->referenced_type_descriptions.
-  //                     It is NOT a copy!! Do NOT finalize, modify, or delete it!
-  rcutils_ret_t ret = rosidl_runtime_c_type_description_utils_find_referenced_type_description(
-    &description->referenced_type_descriptions,
-    field->type.nested_type_name.data,
-    &recurse_indiv_desc);
-  if (ret != RCUTILS_RET_OK || recurse_indiv_desc == NULL) {
-    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
-      "Could not find referenced type description [%s]", field->type.nested_type_name.data);
-    return ret;
+fail:
+  if (rcutils_hash_map_fini(&cache->referenced_type_indices) != RCUTILS_RET_OK) {
+    RCUTILS_SAFE_FWRITE_TO_STDERR("While handling another error, could not finalize hash map");
   }
+  allocator->deallocate(cache->built_types, allocator->state);
+  cache->built_types = NULL;
+  return ret;
+}
 
-  ret = rosidl_runtime_c_type_description_utils_get_referenced_type_description_as_type_description(
-    &description->referenced_type_descriptions, recurse_indiv_desc, &recurse_desc,
-    true);  // Coerce to valid
-  if (ret != RCUTILS_RET_OK || recurse_desc == NULL) {
-    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
-      "Could not get referenced type description as full type description [%s]",
-      field->type.nested_type_name.data);
-    if (ret == RCUTILS_RET_OK) {
-      ret = RCUTILS_RET_ERROR;
+
+static rcutils_ret_t
+nested_type_cache_fini(nested_type_cache_t * cache)
+{
+  rcutils_ret_t ret = RCUTILS_RET_OK;
+
+  if (cache->built_types != NULL) {
+    for (size_t i = 0; i < cache->description->referenced_type_descriptions.size; i++) {
+      if (cache->built_types[i] == NULL || cache->deferred_types != NULL) {
+        continue;
+      }
+      if (rosidl_dynamic_typesupport_dynamic_type_destroy(cache->built_types[i]) !=
+        RCUTILS_RET_OK)
+      {
+        ret = RCUTILS_RET_ERROR;
+      }
     }
-    return ret;
+    cache->allocator.deallocate(cache->built_types, cache->allocator.state);
+    cache->built_types = NULL;
+  }
+
+  if (rcutils_hash_map_fini(&cache->referenced_type_indices) != RCUTILS_RET_OK) {
+    ret = RCUTILS_RET_ERROR;
   }
+  return ret;
+}
+
+
+static rcutils_ret_t
+builder_init_from_individual_description(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_runtime_c__type_description__IndividualTypeDescription * individual_description,
+  rcutils_allocator_t * allocator,
+  nested_type_cache_t * cache,
+  rosidl_dynamic_typesupport_dynamic_type_builder_t * dynamic_type_builder);
+
+static rcutils_ret_t
+deferred_dynamic_type_build_once(const rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type);
+
+
+// Look up the index of a nested type name in the cached description's referenced types
+static rcutils_ret_t
+find_nested_type_index(
+  const nested_type_cache_t * cache,
+  const char * nested_type_name,
+  size_t * referenced_index)  // OUT
+{
+  if (nested_type_name == NULL ||
+    rcutils_hash_map_get(
+      &cache->referenced_type_indices, &nested_type_name, referenced_index) != RCUTILS_RET_OK)
+  {
+    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+      "Could not find referenced type description [%s]",
+      nested_type_name ? nested_type_name : "<null>");
+    return RCUTILS_RET_ERROR;
+  }
+  return RCUTILS_RET_OK;
+}
+
+
+// Build the dynamic type of one referenced type, and store it in the cache (or build the deferred
+// nested type for it in place, unless that was already done)
+//
+// NOTE: Every type it references MUST already be built. This never recurses into
+//       nested types, that is left to the construction plan (see below)
+static rcutils_ret_t
+build_nested_type(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  rcutils_allocator_t * allocator,
+  nested_type_cache_t * cache,
+  size_t referenced_index)
+{
+  if (cache->deferred_types != NULL) {
+    return deferred_dynamic_type_build_once(&cache->deferred_types[referenced_index]);
+  }
+
+  // NOTE(methylDragon): nested_desc borrows from cache->description->referenced_type_descriptions.
+  //                     It is NOT a copy!! Do NOT finalize, modify, or delete it!
+  //
+  //                     The top level description is used for all lookups, since it references
+  //                     every type that any of its nested types reference. So there is no need to
+  //                     materialize a pruned TypeDescription for the nested type.
+  const rosidl_runtime_c__type_description__IndividualTypeDescription * nested_desc =
+    &cache->description->referenced_type_descriptions.data[referenced_index];
 
-  // Recurse
   rosidl_dynamic_typesupport_dynamic_type_builder_t nested_type_builder =
     rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type_builder();
   nested_type_builder.serialization_support = serialization_support;
   nested_type_builder.allocator = *allocator;
 
-  ret = rosidl_dynamic_typesupport_dynamic_type_builder_init_from_description(
-    serialization_support, recurse_desc, allocator, &nested_type_builder);
-  rosidl_runtime_c__type_description__TypeDescription__destroy(recurse_desc);
+  rcutils_ret_t ret = builder_init_from_individual_description(
+    serialization_support, nested_desc, allocator, cache, &nested_type_builder);
+  if (ret != RCUTILS_RET_OK) {
+    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+      "Could not construct nested type builder for type [%s]", nested_desc->type_name.data);
+    return ret;
+  }
+
+  rosidl_dynamic_typesupport_dynamic_type_t * built_type = allocator->zero_allocate(
+    1, sizeof(rosidl_dynamic_typesupport_dynamic_type_t), allocator->state);
+  if (built_type == NULL) {
+    RCUTILS_SET_ERROR_MSG("Could not allocate nested dynamic type");
+    rosidl_dynamic_typesupport_dynamic_type_builder_fini(&nested_type_builder);
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  *built_type = rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
 
+  ret = rosidl_dynamic_typesupport_dynamic_type_init_from_dynamic_type_builder(
+    &nested_type_builder, allocator, built_type);
+  rosidl_dynamic_typesupport_dynamic_type_builder_fini(&nested_type_builder);
   if (ret != RCUTILS_RET_OK) {
     RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
-      "Could not construct nested type builder for field [%s]", field->name.data);
-    if (ret == RCUTILS_RET_OK) {
-      ret = RCUTILS_RET_ERROR;
-    }
+      "Could not construct nested type [%s]", nested_desc->type_name.data);
+    allocator->deallocate(built_type, allocator->state);
     return ret;
   }
 
-  switch (field->type.type_id) {
-    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE:
-      ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_complex_member_builder(
-        dynamic_type_builder, field_offset,
-        field->name.data, field->name.size,
-        field->default_value.data, field->default_value.size,
-        &nested_type_builder);
-      break;
+  cache->built_types[referenced_index] = built_type;
+  return RCUTILS_RET_OK;
+}
 
-    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_ARRAY:
-      ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_complex_array_member_builder(
-        dynamic_type_builder, field_offset,
-        field->name.data, field->name.size,
-        field->default_value.data, field->default_value.size,
-        &nested_type_builder, field->type.capacity);
-      break;
 
-    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_UNBOUNDED_SEQUENCE:
-      ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_complex_unbounded_sequence_member_builder(  // NOLINT
-        dynamic_type_builder, field_offset,
-        field->name.data, field->name.size,
-        field->default_value.data, field->default_value.size,
-        &nested_type_builder);
-      break;
+// Look up the already built dynamic type a nested field refers to
+static rcutils_ret_t
+resolve_nested_type(
+  const nested_type_cache_t * cache,
+  const rosidl_runtime_c__type_description__Field * field,
+  rosidl_dynamic_typesupport_dynamic_type_t ** nested_type)  // OUT
+{
+  if (field->type.nested_type_name.data == NULL) {
+    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+      "Nested type name from nested field [%s]", field->name.data);
+    return RCUTILS_RET_ERROR;
+  }
 
-    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_BOUNDED_SEQUENCE:
-      ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_complex_bounded_sequence_member_builder(
-        dynamic_type_builder, field_offset,
-        field->name.data, field->name.size,
-        field->default_value.data, field->default_value.size,
-        &nested_type_builder, field->type.capacity);
-      break;
+  size_t referenced_index = 0;
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+    find_nested_type_index(cache, field->type.nested_type_name.data, &referenced_index));
 
-    default:
+  *nested_type = cache->built_types[referenced_index];
+  if (*nested_type == NULL) {
+    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+      "Nested type [%s] for field [%s] was not constructed before the type referencing it",
+      field->type.nested_type_name.data, field->name.data);
+    return RCUTILS_RET_ERROR;
+  }
+  return RCUTILS_RET_OK;
+}
+
+
+// NESTED TYPE CONSTRUCTION PLAN ===================================================================
+// Before anything is built, the nested types reachable from the top level type (or from one of
+// its nested types, when only that one is built) are walked
+// iteratively (with an explicit, bounded stack) to:
+//   - Enforce the construction limits in the options, so oversized descriptions fail fast
+//   - Reject cycles
+//   - Order the nested types so that every type comes after all the types it references
+//   - Group the nested types into levels: types with no nested fields are level 0, and every other
+//     type is one level above the highest level type it references
+//
+// Types in the same level do not reference each other, so they can be built concurrently once all
+// the levels below them are.
+#define NESTED_TYPE_LEVEL_UNVISITED SIZE_MAX
+#define NESTED_TYPE_LEVEL_VISITING (SIZE_MAX - 1)
+
+typedef struct nested_type_plan_s
+{
+  // Referenced type indices, ordered so every type comes after the types it references
+  size_t * build_order;
+  size_t build_count;
+
+  // Level of each referenced type (indexed like referenced_type_descriptions), or
+  // NESTED_TYPE_LEVEL_UNVISITED if the type is not reachable from the top level type
+  size_t * levels;
+
+  // One above the highest nested type level (i.e. the level of the top level type)
+  size_t top_level;
+} nested_type_plan_t;
+
+typedef struct nested_type_plan_frame_s
+{
+  const rosidl_runtime_c__type_description__IndividualTypeDescription * description;
+  size_t referenced_index;  // SIZE_MAX for the top level type
+  size_t next_field;
+  size_t level;
+} nested_type_plan_frame_t;
+
+
+static bool
+is_nested_field_type(uint8_t type_id)
+{
+  return type_id == ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE ||
+         type_id == ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_ARRAY ||
+         type_id == ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_BOUNDED_SEQUENCE ||
+         type_id == ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_UNBOUNDED_SEQUENCE;
+}
+
+
+static void
+nested_type_plan_fini(nested_type_plan_t * plan, rcutils_allocator_t * allocator)
+{
+  allocator->deallocate(plan->build_order, allocator->state);
+  allocator->deallocate(plan->levels, allocator->state);
+  plan->build_order = NULL;
+  plan->levels = NULL;
+}
+
+
+static rcutils_ret_t
+nested_type_plan_init(
+  nested_type_cache_t * cache,
+  const rosidl_runtime_c__type_description__IndividualTypeDescription * top_description,
+  const rosidl_dynamic_typesupport_dynamic_type_construction_options_t * options,
+  rcutils_allocator_t * allocator,
+  nested_type_plan_t * plan)  // OUT
+{
+  const rosidl_runtime_c__type_description__TypeDescription * description = cache->description;
+  size_t referenced_count = description->referenced_type_descriptions.size;
+
+  plan->build_order = NULL;
+  plan->build_count = 0;
+  plan->levels = NULL;
+  plan->top_level = 0;
+
+  // Without cycles, a path can visit every referenced type at most once, on top of the top level
+  // type. So the stack never needs to be any deeper than that, or the depth limit
+  size_t stack_capacity = referenced_count;
+  if (options->max_depth != 0 && options->max_depth < stack_capacity) {
+    stack_capacity = options->max_depth;
+  }
+  stack_capacity += 1;
+
+  rcutils_ret_t ret = RCUTILS_RET_ERROR;
+  nested_type_plan_frame_t * stack =
+    allocator->allocate(stack_capacity * sizeof(nested_type_plan_frame_t), allocator->state);
+  if (referenced_count > 0) {
+    plan->build_order = allocator->allocate(referenced_count * sizeof(size_t), allocator->state);
+    plan->levels = allocator->allocate(referenced_count * sizeof(size_t), allocator->state);
+  }
+  if (stack == NULL ||
+    (referenced_count > 0 && (plan->build_order == NULL || plan->levels == NULL)))
+  {
+    RCUTILS_SET_ERROR_MSG("Could not allocate nested type construction plan");
+    ret = RCUTILS_RET_BAD_ALLOC;
+    goto fail;
+  }
+  for (size_t i = 0; i < referenced_count; i++) {
+    plan->levels[i] = NESTED_TYPE_LEVEL_UNVISITED;
+  }
+
+  size_t total_fields = top_description->fields.size;
+  size_t stack_size = 1;
+  stack[0].description = top_description;
+  stack[0].referenced_index = SIZE_MAX;
+  stack[0].next_field = 0;
+  stack[0].level = 0;
+
+  while (stack_size > 0) {
+    nested_type_plan_frame_t * frame = &stack[stack_size - 1];
+
+    // All fields of this type were walked, so everything it references has a level by now
+    if (frame->next_field >= frame->description->fields.size) {
+      if (frame->referenced_index == SIZE_MAX) {
+        plan->top_level = frame->level;
+      } else {
+        plan->levels[frame->referenced_index] = frame->level;
+        plan->build_order[plan->build_count++] = frame->referenced_index;
+      }
+      stack_size--;
+      if (stack_size > 0 && frame->level + 1 > stack[stack_size - 1].level) {
+        stack[stack_size - 1].level = frame->level + 1;
+      }
+      continue;
+    }
+
+    const rosidl_runtime_c__type_description__Field * field =
+      &frame->description->fields.data[frame->next_field++];
+    if (!is_nested_field_type(field->type.type_id)) {
+      continue;
+    }
+
+    size_t referenced_index = 0;
+    ret = find_nested_type_index(cache, field->type.nested_type_name.data, &referenced_index);
+    if (ret != RCUTILS_RET_OK) {
+      goto fail;
+    }
+
+    size_t nested_level = plan->levels[referenced_index];
+    if (nested_level == NESTED_TYPE_LEVEL_VISITING) {
       RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
-        "Invalid field type id: %d !", field->type.type_id);
+        "Type description references itself through nested type [%s]",
+        field->type.nested_type_name.data);
       ret = RCUTILS_RET_INVALID_ARGUMENT;
-      break;
+      goto fail;
+    }
+    if (nested_level != NESTED_TYPE_LEVEL_UNVISITED) {
+      // Already walked through another field
+      if (nested_level + 1 > frame->level) {
+        frame->level = nested_level + 1;
+      }
+      continue;
+    }
+
+    // First time this type is reached, so walk its fields
+    if (options->max_depth != 0 && stack_size > options->max_depth) {
+      RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+        "Type description exceeds the maximum nesting depth of %zu at nested type [%s]",
+        options->max_depth, field->type.nested_type_name.data);
+      ret = RCUTILS_RET_INVALID_ARGUMENT;
+      goto fail;
+    }
+    const rosidl_runtime_c__type_description__IndividualTypeDescription * nested_desc =
+      &description->referenced_type_descriptions.data[referenced_index];
+    total_fields += nested_desc->fields.size;
+    if (options->max_total_fields != 0 && total_fields > options->max_total_fields) {
+      RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+        "Type description exceeds the maximum total field count of %zu at nested type [%s]",
+        options->max_total_fields, field->type.nested_type_name.data);
+      ret = RCUTILS_RET_INVALID_ARGUMENT;
+      goto fail;
+    }
+
+    plan->levels[referenced_index] = NESTED_TYPE_LEVEL_VISITING;
+    stack[stack_size].description = nested_desc;
+    stack[stack_size].referenced_index = referenced_index;
+    stack[stack_size].next_field = 0;
+    stack[stack_size].level = 0;
+    stack_size++;
   }
-  rosidl_dynamic_typesupport_dynamic_type_builder_fini(&nested_type_builder);
+
+  // Types reached again through a shorter path are not walked twice, so the stack depth alone does
+  // not bound the nesting depth
+  if (options->max_depth != 0 && plan->top_level > options->max_depth) {
+    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+      "Type description exceeds the maximum nesting depth of %zu", options->max_depth);
+    ret = RCUTILS_RET_INVALID_ARGUMENT;
+    goto fail;
+  }
+
+  allocator->deallocate(stack, allocator->state);
+  return RCUTILS_RET_OK;
+
+fail:
+  allocator->deallocate(stack, allocator->state);
+  nested_type_plan_fini(plan, allocator);
   return ret;
 }
 
 
+// Build every nested type in the plan, one at a time
+static rcutils_ret_t
+build_nested_types_serially(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  rcutils_allocator_t * allocator,
+  nested_type_cache_t * cache,
+  const nested_type_plan_t * plan)
+{
+  for (size_t i = 0; i < plan->build_count; i++) {
+    ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+      build_nested_type(serialization_support, allocator, cache, plan->build_order[i]));
+  }
+  return RCUTILS_RET_OK;
+}
+
+
+typedef struct nested_type_level_build_s
+{
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support;
+  rcutils_allocator_t * allocator;
+  nested_type_cache_t * cache;
+  const size_t * referenced_indices;  // Of the types in the level being built
+  rcutils_ret_t * rets;  // One per type in the level being built
+} nested_type_level_build_t;
+
+
+static void
+build_nested_type_task(size_t i, void * task_arg)
+{
+  nested_type_level_build_t * level_build = (nested_type_level_build_t *) task_arg;
+
+  // NOTE: Safe to run concurrently, since every type this one references was built
+  //       in a lower level, and this only ever writes its own built_types slot
+  level_build->rets[i] = build_nested_type(
+    level_build->serialization_support, level_build->allocator, level_build->cache,
+    level_build->referenced_indices[i]);
+}
+
+
+// Build every nested type in the plan, one level at a time, through parallel_for
+static rcutils_ret_t
+build_nested_types_in_parallel(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_dynamic_typesupport_dynamic_type_construction_options_t * options,
+  rcutils_allocator_t * allocator,
+  nested_type_cache_t * cache,
+  const nested_type_plan_t * plan)
+{
+  if (plan->build_count == 0) {
+    return RCUTILS_RET_OK;
+  }
+
+  rcutils_ret_t ret = RCUTILS_RET_ERROR;
+  size_t * referenced_indices =
+    allocator->allocate(plan->build_count * sizeof(size_t), allocator->state);
+  rcutils_ret_t * rets =
+    allocator->allocate(plan->build_count * sizeof(rcutils_ret_t), allocator->state);
+  if (referenced_indices == NULL || rets == NULL) {
+    RCUTILS_SET_ERROR_MSG("Could not allocate parallel nested type construction state");
+    ret = RCUTILS_RET_BAD_ALLOC;
+    goto end;
+  }
+
+  nested_type_level_build_t level_build;
+  level_build.serialization_support = serialization_support;
+  level_build.allocator = allocator;
+  level_build.cache = cache;
+  level_build.referenced_indices = referenced_indices;
+  level_build.rets = rets;
+
+  for (size_t level = 0; level < plan->top_level; level++) {
+    size_t level_count = 0;
+    for (size_t i = 0; i < plan->build_count; i++) {
+      if (plan->levels[plan->build_order[i]] == level) {
+        referenced_indices[level_count] = plan->build_order[i];
+        rets[level_count] = RCUTILS_RET_ERROR;
+        level_count++;
+      }
+    }
+
+    options->parallel_for(
+      level_count, build_nested_type_task, &level_build, options->parallel_for_state);
+
+    // NOTE: Errors set by tasks on other threads stay in those threads' error state,
+    //       so only the type that failed can be reported here
+    for (size_t i = 0; i < level_count; i++) {
+      if (rets[i] != RCUTILS_RET_OK) {
+        RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+          "Could not construct nested type [%s]",
+          cache->description->referenced_type_descriptions.data[
+            referenced_indices[i]].type_name.data);
+        ret = rets[i];
+        goto end;
+      }
+    }
+  }
+  ret = RCUTILS_RET_OK;
+
+end:
+  allocator->deallocate(referenced_indices, allocator->state);
+  allocator->deallocate(rets, allocator->state);
+  return ret;
+}
+
+
+// Check limits and order the nested types that top_description reaches, then build them
+static rcutils_ret_t
+build_nested_types(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_runtime_c__type_description__IndividualTypeDescription * top_description,
+  const rosidl_dynamic_typesupport_dynamic_type_construction_options_t * options,
+  rcutils_allocator_t * allocator,
+  nested_type_cache_t * cache)
+{
+  nested_type_plan_t plan;
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+    nested_type_plan_init(cache, top_description, options, allocator, &plan));
+
+  // Build all the nested types up front, so each type only needs to look up the ones it uses
+  rcutils_ret_t ret = RCUTILS_RET_OK;
+  if (options->parallel_for != NULL &&
+    serialization_support->methods.dynamic_type_construction_is_thread_safe)
+  {
+    ret = build_nested_types_in_parallel(serialization_support, options, allocator, cache, &plan);
+  } else {
+    ret = build_nested_types_serially(serialization_support, allocator, cache, &plan);
+  }
+  nested_type_plan_fini(&plan, allocator);
+  return ret;
+}
+
+#undef NESTED_TYPE_LEVEL_VISITING
+#undef NESTED_TYPE_LEVEL_UNVISITED
+
+
+// FIELD MEMBER DISPATCH ===========================================================================
+// Every non-nested field type id maps to a function that adds a member of that type, straight
+// through the serialization support interface slot for it.
+//
+// This skips the per-type wrappers: their argument checks were already done for every member by
+// rosidl_dynamic_typesupport_dynamic_type_builder_add_members(), before any member is added.
+typedef rcutils_ret_t (* field_member_adder_t)(
+  rosidl_dynamic_typesupport_dynamic_type_builder_t * dynamic_type_builder,
+  const rosidl_dynamic_typesupport_dynamic_type_member_spec_t * member);
+
+static rcutils_ret_t
+field_member_method_unsupported(
+  const rosidl_dynamic_typesupport_dynamic_type_builder_t * dynamic_type_builder,
+  const rosidl_dynamic_typesupport_dynamic_type_member_spec_t * member)
+{
+  RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+    "Field type id %d is not supported by serialization library [%s]",
+    member->type_id, dynamic_type_builder->serialization_support->serialization_library_identifier);
+  return RCUTILS_RET_ERROR;
+}
+
+// Which of the member's bounds go after its default value, for each kind of slot
+#define FIELD_MEMBER_BOUNDS_NONE
+#define FIELD_MEMBER_BOUNDS_CAPACITY , member->capacity
+#define FIELD_MEMBER_BOUNDS_STRING_CAPACITY , member->string_capacity
+#define FIELD_MEMBER_BOUNDS_STRING_CAPACITY_AND_CAPACITY \
+  , member->string_capacity, member->capacity
+
+#define FIELD_MEMBER_ADDER_FN(ADDER, METHOD, BOUNDS) \
+  static rcutils_ret_t \
+  ADDER( \
+    rosidl_dynamic_typesupport_dynamic_type_builder_t * dynamic_type_builder, \
+    const rosidl_dynamic_typesupport_dynamic_type_member_spec_t * member) \
+  { \
+    rosidl_dynamic_typesupport_serialization_support_t * serialization_support = \
+      dynamic_type_builder->serialization_support; \
+    if (serialization_support->methods.METHOD == NULL) { \
+      return field_member_method_unsupported(dynamic_type_builder, member); \
+    } \
+    return (serialization_support->methods.METHOD)( \
+      &serialization_support->impl, &dynamic_type_builder->impl, member->id, \
+      member->name, member->name_length, \
+      member->default_value, member->default_value_length BOUNDS); \
+  }
+
+// Adders for single values, fixed size arrays, bounded sequences, and unbounded sequences of one
+// element type
+//
+// NOTE: ELEMENT must only ever be an operand of ##, otherwise `bool` gets expanded
+#define PRIMITIVE_FIELD_MEMBER_ADDER_FNS(ELEMENT) \
+  FIELD_MEMBER_ADDER_FN( \
+    add_ ## ELEMENT ## _field_member, \
+    dynamic_type_builder_add_ ## ELEMENT ## _member, FIELD_MEMBER_BOUNDS_NONE) \
+  FIELD_MEMBER_ADDER_FN( \
+    add_ ## ELEMENT ## _array_field_member, \
+    dynamic_type_builder_add_ ## ELEMENT ## _array_member, FIELD_MEMBER_BOUNDS_CAPACITY) \
+  FIELD_MEMBER_ADDER_FN( \
+    add_ ## ELEMENT ## _bounded_sequence_field_member, \
+    dynamic_type_builder_add_ ## ELEMENT ## _bounded_sequence_member, \
+    FIELD_MEMBER_BOUNDS_CAPACITY) \
+  FIELD_MEMBER_ADDER_FN( \
+    add_ ## ELEMENT ## _unbounded_sequence_field_member, \
+    dynamic_type_builder_add_ ## ELEMENT ## _unbounded_sequence_member, FIELD_MEMBER_BOUNDS_NONE)
+
+// Same as above, for the string types with a length or bound, which every one of them takes
+#define STRING_FIELD_MEMBER_ADDER_FNS(ELEMENT) \
+  FIELD_MEMBER_ADDER_FN( \
+    add_ ## ELEMENT ## _field_member, \
+    dynamic_type_builder_add_ ## ELEMENT ## _member, FIELD_MEMBER_BOUNDS_STRING_CAPACITY) \
+  FIELD_MEMBER_ADDER_FN( \
+    add_ ## ELEMENT ## _array_field_member, \
+    dynamic_type_builder_add_ ## ELEMENT ## _array_member, \
+    FIELD_MEMBER_BOUNDS_STRING_CAPACITY_AND_CAPACITY) \
+  FIELD_MEMBER_ADDER_FN( \
+    add_ ## ELEMENT ## _bounded_sequence_field_member, \
+    dynamic_type_builder_add_ ## ELEMENT ## _bounded_sequence_member, \
+    FIELD_MEMBER_BOUNDS_STRING_CAPACITY_AND_CAPACITY) \
+  FIELD_MEMBER_ADDER_FN( \
+    add_ ## ELEMENT ## _unbounded_sequence_field_member, \
+    dynamic_type_builder_add_ ## ELEMENT ## _unbounded_sequence_member, \
+    FIELD_MEMBER_BOUNDS_STRING_CAPACITY)
+
+PRIMITIVE_FIELD_MEMBER_ADDER_FNS(bool)
+PRIMITIVE_FIELD_MEMBER_ADDER_FNS(byte)
+PRIMITIVE_FIELD_MEMBER_ADDER_FNS(char)
+PRIMITIVE_FIELD_MEMBER_ADDER_FNS(wchar)
+PRIMITIVE_FIELD_MEMBER_ADDER_FNS(float32)
+PRIMITIVE_FIELD_MEMBER_ADDER_FNS(float64)
+PRIMITIVE_FIELD_MEMBER_ADDER_FNS(float128)
+PRIMITIVE_FIELD_MEMBER_ADDER_FNS(int8)
+PRIMITIVE_FIELD_MEMBER_ADDER_FNS(uint8)
+PRIMITIVE_FIELD_MEMBER_ADDER_FNS(int16)
+PRIMITIVE_FIELD_MEMBER_ADDER_FNS(uint16)
+PRIMITIVE_FIELD_MEMBER_ADDER_FNS(int32)
+PRIMITIVE_FIELD_MEMBER_ADDER_FNS(uint32)
+PRIMITIVE_FIELD_MEMBER_ADDER_FNS(int64)
+PRIMITIVE_FIELD_MEMBER_ADDER_FNS(uint64)
+PRIMITIVE_FIELD_MEMBER_ADDER_FNS(string)
+PRIMITIVE_FIELD_MEMBER_ADDER_FNS(wstring)
+STRING_FIELD_MEMBER_ADDER_FNS(fixed_string)
+STRING_FIELD_MEMBER_ADDER_FNS(fixed_wstring)
+STRING_FIELD_MEMBER_ADDER_FNS(bounded_string)
+STRING_FIELD_MEMBER_ADDER_FNS(bounded_wstring)
+
+#define FIELD_MEMBER_ADDERS(TYPE_ID, ELEMENT) \
+  [TYPE_ID] = add_ ## ELEMENT ## _field_member, \
+  [TYPE_ID ## _ARRAY] = add_ ## ELEMENT ## _array_field_member, \
+  [TYPE_ID ## _BOUNDED_SEQUENCE] = add_ ## ELEMENT ## _bounded_sequence_field_member, \
+  [TYPE_ID ## _UNBOUNDED_SEQUENCE] = add_ ## ELEMENT ## _unbounded_sequence_field_member
+
+// Type ids left out of the table are NULL, so they are rejected
+static const field_member_adder_t field_member_adders[UINT8_MAX + 1] = {
+  FIELD_MEMBER_ADDERS(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOOLEAN, bool),
+  FIELD_MEMBER_ADDERS(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BYTE, byte),
+  FIELD_MEMBER_ADDERS(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_CHAR, char),
+  FIELD_MEMBER_ADDERS(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_WCHAR, wchar),
+  FIELD_MEMBER_ADDERS(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT32, float32),
+  FIELD_MEMBER_ADDERS(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT64, float64),
+  FIELD_MEMBER_ADDERS(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT128, float128),
+  FIELD_MEMBER_ADDERS(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT8, int8),
+  FIELD_MEMBER_ADDERS(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT8, uint8),
+  FIELD_MEMBER_ADDERS(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT16, int16),
+  FIELD_MEMBER_ADDERS(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT16, uint16),
+  FIELD_MEMBER_ADDERS(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, int32),
+  FIELD_MEMBER_ADDERS(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT32, uint32),
+  FIELD_MEMBER_ADDERS(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT64, int64),
+  FIELD_MEMBER_ADDERS(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT64, uint64),
+  FIELD_MEMBER_ADDERS(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_STRING, string),
+  FIELD_MEMBER_ADDERS(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_WSTRING, wstring),
+  FIELD_MEMBER_ADDERS(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FIXED_STRING, fixed_string),
+  FIELD_MEMBER_ADDERS(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FIXED_WSTRING, fixed_wstring),
+  FIELD_MEMBER_ADDERS(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_STRING, bounded_string),
+  FIELD_MEMBER_ADDERS(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_WSTRING, bounded_wstring),
+};
+
+#undef FIELD_MEMBER_ADDERS
+#undef STRING_FIELD_MEMBER_ADDER_FNS
+#undef PRIMITIVE_FIELD_MEMBER_ADDER_FNS
+#undef FIELD_MEMBER_ADDER_FN
+#undef FIELD_MEMBER_BOUNDS_STRING_CAPACITY_AND_CAPACITY
+#undef FIELD_MEMBER_BOUNDS_STRING_CAPACITY
+#undef FIELD_MEMBER_BOUNDS_CAPACITY
+#undef FIELD_MEMBER_BOUNDS_NONE
+
+
+// Add a member of a nested type, from either its dynamic type or its dynamic type builder
+//
+// NOTE: Expects dynamic_type_builder to be initialized, and member to be non-NULL
+static rcutils_ret_t
+add_nested_member_from_spec(
+  rosidl_dynamic_typesupport_dynamic_type_builder_t * dynamic_type_builder,
+  const rosidl_dynamic_typesupport_dynamic_type_member_spec_t * member)
+{
+  if ((member->nested_type == NULL) == (member->nested_type_builder == NULL)) {
+    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+      "Exactly one of nested_type or nested_type_builder must be set for nested member [%.*s]",
+      (int) member->name_length, member->name);
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support =
+    dynamic_type_builder->serialization_support;
+  const rosidl_dynamic_typesupport_serialization_support_interface_t * methods =
+    &serialization_support->methods;
+
+  if (member->nested_type != NULL) {
+    rosidl_dynamic_typesupport_dynamic_type_impl_t * nested_impl = NULL;
+    ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+      deferred_dynamic_type_materialize_mutable(member->nested_type, &nested_impl));
+    switch (member->type_id) {
+      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE:
+        return (methods->dynamic_type_builder_add_complex_member)(
+          &serialization_support->impl, &dynamic_type_builder->impl, member->id,
+          member->name, member->name_length,
+          member->default_value, member->default_value_length,
+          nested_impl);
+      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_ARRAY:
+        return (methods->dynamic_type_builder_add_complex_array_member)(
+          &serialization_support->impl, &dynamic_type_builder->impl, member->id,
+          member->name, member->name_length,
+          member->default_value, member->default_value_length,
+          nested_impl, member->capacity);
+      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_UNBOUNDED_SEQUENCE:
+        return (methods->dynamic_type_builder_add_complex_unbounded_sequence_member)(
+          &serialization_support->impl, &dynamic_type_builder->impl, member->id,
+          member->name, member->name_length,
+          member->default_value, member->default_value_length,
+          nested_impl);
+      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_BOUNDED_SEQUENCE:
+        return (methods->dynamic_type_builder_add_complex_bounded_sequence_member)(
+          &serialization_support->impl, &dynamic_type_builder->impl, member->id,
+          member->name, member->name_length,
+          member->default_value, member->default_value_length,
+          nested_impl, member->capacity);
+      default:
+        break;
+    }
+  } else {
+    switch (member->type_id) {
+      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE:
+        return (methods->dynamic_type_builder_add_complex_member_builder)(
+          &serialization_support->impl, &dynamic_type_builder->impl, member->id,
+          member->name, member->name_length,
+          member->default_value, member->default_value_length,
+          &member->nested_type_builder->impl);
+      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_ARRAY:
+        return (methods->dynamic_type_builder_add_complex_array_member_builder)(
+          &serialization_support->impl, &dynamic_type_builder->impl, member->id,
+          member->name, member->name_length,
+          member->default_value, member->default_value_length,
+          &member->nested_type_builder->impl, member->capacity);
+      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_UNBOUNDED_SEQUENCE:
+        return (methods->dynamic_type_builder_add_complex_unbounded_sequence_member_builder)(
+          &serialization_support->impl, &dynamic_type_builder->impl, member->id,
+          member->name, member->name_length,
+          member->default_value, member->default_value_length,
+          &member->nested_type_builder->impl);
+      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_BOUNDED_SEQUENCE:
+        return (methods->dynamic_type_builder_add_complex_bounded_sequence_member_builder)(
+          &serialization_support->impl, &dynamic_type_builder->impl, member->id,
+          member->name, member->name_length,
+          member->default_value, member->default_value_length,
+          &member->nested_type_builder->impl, member->capacity);
+      default:
+        break;
+    }
+  }
+
+  RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING("Invalid field type id: %d !", member->type_id);
+  return RCUTILS_RET_INVALID_ARGUMENT;
+}
+
+
+// Add one member through the per-type serialization support interface slots
+//
+// NOTE: Expects dynamic_type_builder to be initialized, and member to be non-NULL
+static rcutils_ret_t
+add_member_from_spec(
+  rosidl_dynamic_typesupport_dynamic_type_builder_t * dynamic_type_builder,
+  const rosidl_dynamic_typesupport_dynamic_type_member_spec_t * member)
+{
+  switch (member->type_id) {
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_ARRAY:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_UNBOUNDED_SEQUENCE:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_BOUNDED_SEQUENCE:
+      return add_nested_member_from_spec(dynamic_type_builder, member);
+    default:
+      break;
+  }
+
+  // type_id is a uint8_t, so it is always in range
+  field_member_adder_t adder = field_member_adders[member->type_id];
+  if (adder == NULL) {
+    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING("Invalid field type id: %d !", member->type_id);
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  return adder(dynamic_type_builder, member);
+}
+
+
 rcutils_ret_t
 rosidl_dynamic_typesupport_dynamic_type_builder_init_from_description(
   rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
   const rosidl_runtime_c__type_description__TypeDescription * description,
   rcutils_allocator_t * allocator,
   rosidl_dynamic_typesupport_dynamic_type_builder_t * dynamic_type_builder)
+{
+  rosidl_dynamic_typesupport_dynamic_type_construction_options_t options =
+    rosidl_dynamic_typesupport_get_default_dynamic_type_construction_options();
+  return rosidl_dynamic_typesupport_dynamic_type_builder_init_from_description_with_options(
+    serialization_support, description, &options, allocator, dynamic_type_builder);
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_builder_init_from_description_with_options(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_runtime_c__type_description__TypeDescription * description,
+  const rosidl_dynamic_typesupport_dynamic_type_construction_options_t * options,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_dynamic_type_builder_t * dynamic_type_builder)
 {
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(serialization_support, RCUTILS_RET_INVALID_ARGUMENT);
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(description, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(options, RCUTILS_RET_INVALID_ARGUMENT);
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(allocator, RCUTILS_RET_INVALID_ARGUMENT);
   if (!rcutils_allocator_is_valid(allocator)) {
     RCUTILS_SET_ERROR_MSG("allocator is invalid");
@@ -312,559 +1179,204 @@ rosidl_dynamic_typesupport_dynamic_type_builder_init_from_description(
   }
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(dynamic_type_builder, RCUTILS_RET_INVALID_ARGUMENT);
 
-  if (rosidl_runtime_c_type_description_utils_type_description_is_valid(description) !=
-    RCUTILS_RET_OK)
-  {
-    rcutils_error_string_t error_string = rcutils_get_error_string();
-    rcutils_reset_error();
-    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING("Type description is not valid: %s", error_string.str);
-    return RCUTILS_RET_INVALID_ARGUMENT;
+  // NOTE: Validating the top level description also covers every nested type, since
+  //       they are all resolved against its referenced_type_descriptions
+  if (!options->description_is_validated) {
+    ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+      type_description_validation_cache_check(description, options->type_hash, NULL));
   }
 
-  // NOTE(methylDragon): This was a potential place to do string replacements for type descriptions
-  //                     from "/" delimiters to "::" delimiters to support DDS IDL names.
-  //
-  //                     But since this is meant to be middleware agnostic (potentially supporting
-  //                     non-DDS middlewares), replacements should happen in the support libraries
-  //                     on an as-needed basis.
+  // Every referenced type is built at most once per call, and reused for every field (at any
+  // nesting level) that references it
+  nested_type_cache_t cache;
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+    nested_type_cache_init(description, allocator, &cache));
+
+  // Limits are checked and the nested types ordered before anything is built
+  rcutils_ret_t ret = build_nested_types(
+    serialization_support, &description->type_description, options, allocator, &cache);
+  if (ret == RCUTILS_RET_OK) {
+    ret = builder_init_from_individual_description(
+      serialization_support, &description->type_description, allocator, &cache,
+      dynamic_type_builder);
+  }
 
-  if (dynamic_type_builder->impl.handle != NULL) {
-    ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
-      rosidl_dynamic_typesupport_dynamic_type_builder_fini(dynamic_type_builder)
-    );
+  if (nested_type_cache_fini(&cache) != RCUTILS_RET_OK) {
+    RCUTILS_SAFE_FWRITE_TO_STDERR("Could not finalize nested type cache");
   }
+  return ret;
+}
 
-  const rosidl_runtime_c__type_description__IndividualTypeDescription * main_description =
-    &description->type_description;
-  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
-    rosidl_dynamic_typesupport_dynamic_type_builder_init(
-      serialization_support,
-      main_description->type_name.data,
-      main_description->type_name.size,
-      allocator,
-      dynamic_type_builder)
-  );
 
-  rcutils_ret_t ret = RCUTILS_RET_ERROR;
+// Hand the parsed default values of a type's members to serialization libraries that take them
+//
+// NOTE: Default values are only parsed when the slot is set, so serialization
+//       libraries that parse them on their own pay nothing for this
+static rcutils_ret_t
+set_default_values(
+  const rosidl_runtime_c__type_description__IndividualTypeDescription * individual_description,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_dynamic_type_builder_t * dynamic_type_builder)
+{
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support =
+    dynamic_type_builder->serialization_support;
+  if (serialization_support->methods.dynamic_type_builder_set_default_values == NULL) {
+    return RCUTILS_RET_OK;
+  }
 
-  for (size_t i = 0; i < main_description->fields.size; i++) {
-    rosidl_runtime_c__type_description__Field * field = &main_description->fields.data[i];
+  rosidl_dynamic_typesupport_default_values_t default_values =
+    rosidl_dynamic_typesupport_get_zero_initialized_default_values();
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+    rosidl_dynamic_typesupport_default_values_init(
+      individual_description, allocator, &default_values));
 
-    switch (field->type.type_id) {
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NOT_SET:
-        RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
-          "Field type id not set for field [%s]", field->name.data);
-        ret = RCUTILS_RET_ERROR;
-        goto fail;
+  rcutils_ret_t ret = (serialization_support->methods.dynamic_type_builder_set_default_values)(
+    &serialization_support->impl, &dynamic_type_builder->impl, &default_values);
+  if (ret != RCUTILS_RET_OK) {
+    RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR("Could not set default values");
+  }
+  if (rosidl_dynamic_typesupport_default_values_fini(&default_values) != RCUTILS_RET_OK) {
+    RCUTILS_SAFE_FWRITE_TO_STDERR("Could not finalize default values");
+  }
+  return ret;
+}
 
-      // PRIMITIVES
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOOLEAN:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_bool_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BYTE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_byte_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_CHAR:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_char_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT32:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_float32_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT64:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_float64_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT8:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_int8_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT8:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_uint8_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT16:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_int16_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT16:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_uint16_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_int32_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT32:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_uint32_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT64:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_int64_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT64:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_uint64_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_STRING:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_string_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_WSTRING:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_wstring_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FIXED_STRING:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_fixed_string_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FIXED_WSTRING:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_fixed_wstring_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_STRING:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_bounded_string_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_WSTRING:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_bounded_wstring_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
 
-      // STATIC ARRAYS
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOOLEAN_ARRAY:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_bool_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BYTE_ARRAY:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_byte_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_CHAR_ARRAY:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_char_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT32_ARRAY:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_float32_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT64_ARRAY:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_float64_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT8_ARRAY:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_int8_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT8_ARRAY:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_uint8_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT16_ARRAY:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_int16_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT16_ARRAY:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_uint16_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32_ARRAY:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_int32_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT32_ARRAY:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_uint32_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT64_ARRAY:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_int64_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT64_ARRAY:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_uint64_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_STRING_ARRAY:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_string_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_WSTRING_ARRAY:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_wstring_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FIXED_STRING_ARRAY:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_fixed_string_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.string_capacity, field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FIXED_WSTRING_ARRAY:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_fixed_wstring_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.string_capacity, field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_STRING_ARRAY:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_bounded_string_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.string_capacity, field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_WSTRING_ARRAY:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_bounded_wstring_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.string_capacity, field->type.capacity);
-        break;
+// Release the interned names of members, once the serialization library is done with them
+static void
+release_member_names(
+  rosidl_dynamic_typesupport_dynamic_type_member_spec_t * members, size_t member_count)
+{
+  for (size_t i = 0; i < member_count; i++) {
+    if (members[i].interned_name != NULL &&
+      rosidl_dynamic_typesupport_interned_string_release(members[i].interned_name) !=
+      RCUTILS_RET_OK)
+    {
+      RCUTILS_SAFE_FWRITE_TO_STDERR("Could not release interned member name");
+    }
+    members[i].interned_name = NULL;
+  }
+}
 
-      // UNBOUNDED SEQUENCES
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOOLEAN_UNBOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_bool_unbounded_sequence_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BYTE_UNBOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_byte_unbounded_sequence_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_CHAR_UNBOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_char_unbounded_sequence_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT32_UNBOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_float32_unbounded_sequence_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT64_UNBOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_float64_unbounded_sequence_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT8_UNBOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_int8_unbounded_sequence_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT8_UNBOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_uint8_unbounded_sequence_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT16_UNBOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_int16_unbounded_sequence_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT16_UNBOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_uint16_unbounded_sequence_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32_UNBOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_int32_unbounded_sequence_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT32_UNBOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_uint32_unbounded_sequence_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT64_UNBOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_int64_unbounded_sequence_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT64_UNBOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_uint64_unbounded_sequence_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_STRING_UNBOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_string_unbounded_sequence_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_WSTRING_UNBOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_wstring_unbounded_sequence_member(
-          dynamic_type_builder, i, field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size);
-        break;
-        /* *INDENT-OFF* */
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FIXED_STRING_UNBOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_fixed_string_unbounded_sequence_member(  // NOLINT
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.string_capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FIXED_WSTRING_UNBOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_fixed_wstring_unbounded_sequence_member(  // NOLINT
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.string_capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_STRING_UNBOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_bounded_string_unbounded_sequence_member(  // NOLINT
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.string_capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_WSTRING_UNBOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_bounded_wstring_unbounded_sequence_member(  // NOLINT
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.string_capacity);
-        break;
-        /* *INDENT-ON* */
-
-      // BOUNDED SEQUENCES
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOOLEAN_BOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_bool_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BYTE_BOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_byte_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_CHAR_BOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_char_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT32_BOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_float32_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT64_BOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_float64_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT8_BOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_int8_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT8_BOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_uint8_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT16_BOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_int16_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT16_BOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_uint16_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32_BOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_int32_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT32_BOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_uint32_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT64_BOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_int64_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT64_BOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_uint64_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_STRING_BOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_string_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_WSTRING_BOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_wstring_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FIXED_STRING_BOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_fixed_string_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.string_capacity, field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FIXED_WSTRING_BOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_fixed_wstring_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.string_capacity, field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_STRING_BOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_bounded_string_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.string_capacity, field->type.capacity);
-        break;
-      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_WSTRING_BOUNDED_SEQUENCE:
-        ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_bounded_wstring_array_member(
-          dynamic_type_builder, i,
-          field->name.data, field->name.size,
-          field->default_value.data, field->default_value.size,
-          field->type.string_capacity, field->type.capacity);
-        break;
+
+static rcutils_ret_t
+builder_init_from_individual_description(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_runtime_c__type_description__IndividualTypeDescription * individual_description,
+  rcutils_allocator_t * allocator,
+  nested_type_cache_t * cache,
+  rosidl_dynamic_typesupport_dynamic_type_builder_t * dynamic_type_builder)
+{
+  // NOTE(methylDragon): This was a potential place to do string replacements for type descriptions
+  //                     from "/" delimiters to "::" delimiters to support DDS IDL names.
+  //
+  //                     But since this is meant to be middleware agnostic (potentially supporting
+  //                     non-DDS middlewares), replacements should happen in the support libraries
+  //                     on an as-needed basis.
+
+  if (dynamic_type_builder->impl.handle != NULL) {
+    ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+      rosidl_dynamic_typesupport_dynamic_type_builder_fini(dynamic_type_builder)
+    );
+  }
+
+  const rosidl_runtime_c__type_description__IndividualTypeDescription * main_description =
+    individual_description;
+
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+    rosidl_dynamic_typesupport_dynamic_type_builder_init(
+      serialization_support,
+      main_description->type_name.data,
+      main_description->type_name.size,
+      allocator,
+      dynamic_type_builder)
+  );
+
+  rcutils_ret_t ret = RCUTILS_RET_ERROR;
+  size_t member_count = main_description->fields.size;
+  if (member_count == 0) {
+    return RCUTILS_RET_OK;
+  }
+
+  // All the members are added in one go, so backends that support it can build them in one pass
+  rosidl_dynamic_typesupport_dynamic_type_member_spec_t * members = allocator->zero_allocate(
+    member_count, sizeof(rosidl_dynamic_typesupport_dynamic_type_member_spec_t), allocator->state);
+  if (members == NULL) {
+    RCUTILS_SET_ERROR_MSG("Could not allocate dynamic type member specs");
+    ret = RCUTILS_RET_BAD_ALLOC;
+    goto fail;
+  }
+
+  // Member names are interned for serialization libraries taking all members at once, which can
+  // compare (or keep) them by pointer. The others copy each name anyway, so it would only cost time
+  bool intern_member_names =
+    serialization_support->methods.dynamic_type_builder_add_members != NULL;
+
+  for (size_t i = 0; i < member_count; i++) {
+    const rosidl_runtime_c__type_description__Field * field = &main_description->fields.data[i];
+    rosidl_dynamic_typesupport_dynamic_type_member_spec_t * member = &members[i];
+
+    member->id = i;
+    member->name = field->name.data;
+    member->name_length = field->name.size;
+    if (intern_member_names) {
+      ret = rosidl_dynamic_typesupport_intern_string(
+        field->name.data, field->name.size, &member->interned_name);
+      if (ret != RCUTILS_RET_OK) {
+        goto fail;  // error already set
+      }
+      member->name = member->interned_name->data;
+    }
+    member->default_value = field->default_value.data;
+    member->default_value_length = field->default_value.size;
+    member->type_id = field->type.type_id;
+    member->capacity = field->type.capacity;
+    member->string_capacity = field->type.string_capacity;
+
+    switch (field->type.type_id) {
+      case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NOT_SET:
+        RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+          "Field type id not set for field [%s]", field->name.data);
+        ret = RCUTILS_RET_ERROR;
+        goto fail;
 
       // NESTED
       case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE:
       case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_ARRAY:
       case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_UNBOUNDED_SEQUENCE:
       case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_BOUNDED_SEQUENCE:
-        ret = handle_nested_type(serialization_support, description, allocator, dynamic_type_builder, field, i);
+        ret = resolve_nested_type(cache, field, &member->nested_type);
         if (ret != RCUTILS_RET_OK) {
           goto fail;  // error already set
         }
         break;
 
+      // PRIMITIVES, STRINGS, AND ARRAYS/SEQUENCES OF THEM
       default:
-        RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
-          "Invalid field type id: %d !", field->type.type_id);
-        ret = RCUTILS_RET_INVALID_ARGUMENT;
         break;
-    }  // end nested case
-
-    if (ret != RCUTILS_RET_OK) {
-      goto fail;
     }
   }  // looping over fields
 
+  ret = rosidl_dynamic_typesupport_dynamic_type_builder_add_members(
+    dynamic_type_builder, members, member_count);
+  if (ret != RCUTILS_RET_OK) {
+    goto fail;
+  }
+
+  ret = set_default_values(main_description, allocator, dynamic_type_builder);
+  if (ret != RCUTILS_RET_OK) {
+    goto fail;
+  }
+
+  release_member_names(members, member_count);
+  allocator->deallocate(members, allocator->state);
   return RCUTILS_RET_OK;
 
 fail:
+  if (members != NULL) {
+    release_member_names(members, member_count);
+    allocator->deallocate(members, allocator->state);
+  }
   if (rosidl_dynamic_typesupport_dynamic_type_builder_fini(dynamic_type_builder) !=
     RCUTILS_RET_OK)
   {
@@ -872,7 +1384,7 @@ fail:
       "While handling another error, could not fini dynamic type builder");
   }
   return ret;
-}  // NOLINT(readability/fn_size)
+}
 
 
 rcutils_ret_t
@@ -916,7 +1428,7 @@ rosidl_dynamic_typesupport_dynamic_type_init_from_dynamic_type_builder(
   }
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(dynamic_type, RCUTILS_RET_INVALID_ARGUMENT);
 
-  if (dynamic_type->impl.handle != NULL) {
+  if (dynamic_type->impl.handle != NULL || dynamic_type->deferred != NULL) {
     ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
       rosidl_dynamic_typesupport_dynamic_type_fini(dynamic_type)
     );
@@ -924,6 +1436,8 @@ rosidl_dynamic_typesupport_dynamic_type_init_from_dynamic_type_builder(
 
   dynamic_type->serialization_support = dynamic_type_builder->serialization_support;
   dynamic_type->allocator = *allocator;
+  dynamic_type->type_hash = rosidl_get_zero_initialized_type_hash();
+  dynamic_type->type_hash_verification = 0;
   ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK_WITH_CLEANUP(
     (dynamic_type_builder->serialization_support->methods
     .dynamic_type_init_from_dynamic_type_builder)(
@@ -937,15 +1451,453 @@ rosidl_dynamic_typesupport_dynamic_type_init_from_dynamic_type_builder(
 }
 
 
+// DEFERRED DYNAMIC TYPES ==========================================================================
+// A deferred type gets a deferred nested type for every type its description references. Each of
+// them is built on its own, the first time it is needed: to build a type referencing it, or to be
+// used directly (see rosidl_dynamic_typesupport_dynamic_type_get_nested_member_type()). Nested
+// types stay built once they are, and are reused by everything that needs them afterwards.
+//
+// States of a deferred type. Whoever moves it out of DEFERRED_UNBUILT owns building it until it is
+// moved back (e.g. if building failed) or on to DEFERRED_BUILT, after which it is read-only
+#define DEFERRED_UNBUILT 0
+#define DEFERRED_BUSY 1
+#define DEFERRED_BUILT 2
+
+// What a deferred type and its deferred nested types are built from, owned by the top level type
+typedef struct deferred_dynamic_type_tree_s
+{
+  // Owned copy of the description. Kept for as long as the type lives, since nested member types
+  // are looked up in it by name
+  rosidl_runtime_c__type_description__TypeDescription description;
+  size_t description_bytes;
+  rosidl_dynamic_typesupport_dynamic_type_construction_options_t options;
+
+  // Resolves nested type names to nested_types
+  nested_type_cache_t cache;
+  bool cache_is_initialized;
+
+  // One per referenced type description, whether or not the top level type reaches it
+  rosidl_dynamic_typesupport_dynamic_type_t * nested_types;
+  rosidl_dynamic_typesupport_dynamic_type_deferred_t * nested_deferred;
+
+  // The deferred state of the top level type
+  rosidl_dynamic_typesupport_dynamic_type_deferred_t * top;
+} deferred_dynamic_type_tree_t;
+
+struct rosidl_dynamic_typesupport_dynamic_type_deferred_s
+{
+  deferred_dynamic_type_tree_t * tree;
+  // Index into the referenced type descriptions, or SIZE_MAX for the top level type
+  size_t referenced_index;
+
+  // The built serialization library type, set once DEFERRED_BUILT. Kept here instead of in the
+  // dynamic type's own `impl`, since deferred types are built through const dynamic types
+  rosidl_dynamic_typesupport_dynamic_type_impl_t impl;
+  atomic_uint_least64_t state;
+};
+
+
+// Returns true if the caller now owns the (unbuilt) deferred state, false if it is already built
+static bool
+deferred_dynamic_type_claim(rosidl_dynamic_typesupport_dynamic_type_deferred_t * deferred)
+{
+  while (true) {
+    uint64_t state = DEFERRED_UNBUILT;
+    if (rcutils_atomic_compare_exchange_strong_uint_least64_t(
+        &deferred->state, &state, DEFERRED_BUSY))
+    {
+      return true;
+    }
+    if (state == DEFERRED_BUILT) {
+      return false;
+    }
+    // Building can take a while, so let whoever is doing it run instead of spinning
+    spin_lock_yield();
+  }
+}
+
+
+static const rosidl_runtime_c__type_description__IndividualTypeDescription *
+deferred_dynamic_type_get_description(
+  const rosidl_dynamic_typesupport_dynamic_type_deferred_t * deferred)
+{
+  if (deferred->referenced_index == SIZE_MAX) {
+    return &deferred->tree->description.type_description;
+  }
+  return &deferred->tree->description.referenced_type_descriptions.data[deferred->referenced_index];
+}
+
+
+static void
+deferred_dynamic_type_state_init(
+  deferred_dynamic_type_tree_t * tree,
+  size_t referenced_index,
+  rosidl_dynamic_typesupport_dynamic_type_deferred_t * deferred)
+{
+  deferred->tree = tree;
+  deferred->referenced_index = referenced_index;
+  deferred->impl = rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type_impl();
+  rcutils_atomic_store(&deferred->state, DEFERRED_UNBUILT);
+}
+
+
+// Finalize whatever was built, and free the tree
+static rcutils_ret_t
+deferred_dynamic_type_tree_fini(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  rcutils_allocator_t * allocator,
+  deferred_dynamic_type_tree_t * tree)
+{
+  rcutils_ret_t ret = RCUTILS_RET_OK;
+
+  // Types referencing nested types go first
+  if (rcutils_atomic_load_uint64_t(&tree->top->state) == DEFERRED_BUILT &&
+    (serialization_support->methods.dynamic_type_fini)(
+      &serialization_support->impl, &tree->top->impl) != RCUTILS_RET_OK)
+  {
+    ret = RCUTILS_RET_ERROR;
+  }
+  if (tree->nested_deferred != NULL) {
+    for (size_t i = tree->description.referenced_type_descriptions.size; i > 0; i--) {
+      rosidl_dynamic_typesupport_dynamic_type_deferred_t * nested = &tree->nested_deferred[i - 1];
+      if (rcutils_atomic_load_uint64_t(&nested->state) == DEFERRED_BUILT &&
+        (serialization_support->methods.dynamic_type_fini)(
+          &serialization_support->impl, &nested->impl) != RCUTILS_RET_OK)
+      {
+        ret = RCUTILS_RET_ERROR;
+      }
+    }
+  }
+
+  if (tree->cache_is_initialized && nested_type_cache_fini(&tree->cache) != RCUTILS_RET_OK) {
+    ret = RCUTILS_RET_ERROR;
+  }
+  rosidl_runtime_c__type_description__TypeDescription__fini(&tree->description);
+  allocator->deallocate(tree->nested_types, allocator->state);
+  allocator->deallocate(tree->nested_deferred, allocator->state);
+  allocator->deallocate(tree->top, allocator->state);
+  allocator->deallocate(tree, allocator->state);
+  return ret;
+}
+
+
+static rcutils_ret_t
+deferred_dynamic_type_init(
+  const rosidl_runtime_c__type_description__TypeDescription * description,
+  const rosidl_dynamic_typesupport_dynamic_type_construction_options_t * options,
+  rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type)
+{
+  // Invalid descriptions should still fail here, and not on first use
+  uint64_t type_hash_verification = 0;
+  if (!options->description_is_validated) {
+    ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+      type_description_validation_cache_check(
+        description, options->type_hash, &type_hash_verification));
+  }
+
+  rcutils_allocator_t * allocator = &dynamic_type->allocator;
+  deferred_dynamic_type_tree_t * tree =
+    allocator->zero_allocate(1, sizeof(deferred_dynamic_type_tree_t), allocator->state);
+  if (tree == NULL) {
+    RCUTILS_SET_ERROR_MSG("Could not allocate deferred dynamic type");
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  tree->top = allocator->zero_allocate(
+    1, sizeof(rosidl_dynamic_typesupport_dynamic_type_deferred_t), allocator->state);
+  if (tree->top == NULL) {
+    RCUTILS_SET_ERROR_MSG("Could not allocate deferred dynamic type");
+    allocator->deallocate(tree, allocator->state);
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  deferred_dynamic_type_state_init(tree, SIZE_MAX, tree->top);
+
+  rcutils_ret_t ret = RCUTILS_RET_BAD_ALLOC;
+  if (!rosidl_runtime_c__type_description__TypeDescription__init(&tree->description) ||
+    !rosidl_runtime_c__type_description__TypeDescription__copy(description, &tree->description))
+  {
+    RCUTILS_SET_ERROR_MSG("Could not copy deferred type description");
+    goto fail;
+  }
+  tree->description_bytes = compact_type_description_get_unpacked_size(&tree->description, NULL);
+
+  // The type hash is kept by the dynamic type itself, and may not outlive this call
+  tree->options = *options;
+  tree->options.type_hash = NULL;
+  tree->options.description_is_validated = true;
+  tree->options.defer_construction = false;
+
+  size_t referenced_count = tree->description.referenced_type_descriptions.size;
+  if (referenced_count > 0) {
+    tree->nested_types = allocator->zero_allocate(
+      referenced_count, sizeof(rosidl_dynamic_typesupport_dynamic_type_t), allocator->state);
+    tree->nested_deferred = allocator->zero_allocate(
+      referenced_count, sizeof(rosidl_dynamic_typesupport_dynamic_type_deferred_t),
+      allocator->state);
+    if (tree->nested_types == NULL || tree->nested_deferred == NULL) {
+      RCUTILS_SET_ERROR_MSG("Could not allocate deferred nested types");
+      goto fail;
+    }
+  }
+  for (size_t i = 0; i < referenced_count; i++) {
+    deferred_dynamic_type_state_init(tree, i, &tree->nested_deferred[i]);
+    rosidl_dynamic_typesupport_dynamic_type_t * nested_type = &tree->nested_types[i];
+    *nested_type = rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+    nested_type->serialization_support = dynamic_type->serialization_support;
+    nested_type->allocator = *allocator;
+    nested_type->deferred = &tree->nested_deferred[i];
+  }
+
+  ret = nested_type_cache_init(&tree->description, allocator, &tree->cache);
+  if (ret != RCUTILS_RET_OK) {
+    goto fail;  // error already set
+  }
+  tree->cache_is_initialized = true;
+  tree->cache.deferred_types = tree->nested_types;
+  for (size_t i = 0; i < referenced_count; i++) {
+    tree->cache.built_types[i] = &tree->nested_types[i];
+  }
+
+  // Limits, cycles, and missing referenced types should also fail here. Every type the top level
+  // type reaches is within the limits then, so they need not be checked again when building
+  nested_type_plan_t plan;
+  ret = nested_type_plan_init(
+    &tree->cache, &tree->description.type_description, options, allocator, &plan);
+  if (ret != RCUTILS_RET_OK) {
+    goto fail;  // error already set
+  }
+  nested_type_plan_fini(&plan, allocator);
+
+  dynamic_type->impl = rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type_impl();
+  dynamic_type->type_hash = options->type_hash != NULL ?
+    *options->type_hash : rosidl_get_zero_initialized_type_hash();
+  dynamic_type->type_hash_verification = type_hash_verification;
+  dynamic_type->deferred = tree->top;
+  return RCUTILS_RET_OK;
+
+fail:
+  if (deferred_dynamic_type_tree_fini(dynamic_type->serialization_support, allocator, tree) !=
+    RCUTILS_RET_OK)
+  {
+    RCUTILS_SAFE_FWRITE_TO_STDERR("While handling another error, could not finalize deferred type");
+  }
+  return ret;
+}
+
+
+// Build a deferred type, unless someone already did
+//
+// NOTE: Every type it references MUST already be built
+static rcutils_ret_t
+deferred_dynamic_type_build_once(const rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type)
+{
+  rosidl_dynamic_typesupport_dynamic_type_deferred_t * deferred = dynamic_type->deferred;
+  if (!deferred_dynamic_type_claim(deferred)) {
+    return RCUTILS_RET_OK;
+  }
+
+  const rosidl_runtime_c__type_description__IndividualTypeDescription * individual_description =
+    deferred_dynamic_type_get_description(deferred);
+  rcutils_allocator_t allocator = dynamic_type->allocator;
+  rosidl_dynamic_typesupport_dynamic_type_builder_t builder =
+    rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type_builder();
+  builder.serialization_support = dynamic_type->serialization_support;
+  builder.allocator = allocator;
+
+  rcutils_ret_t ret = builder_init_from_individual_description(
+    dynamic_type->serialization_support, individual_description, &allocator,
+    &deferred->tree->cache, &builder);
+  if (ret == RCUTILS_RET_OK) {
+    rosidl_dynamic_typesupport_dynamic_type_t built =
+      rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+    ret = rosidl_dynamic_typesupport_dynamic_type_init_from_dynamic_type_builder(
+      &builder, &allocator, &built);
+    rosidl_dynamic_typesupport_dynamic_type_builder_fini(&builder);
+    deferred->impl = built.impl;
+  }
+  if (ret != RCUTILS_RET_OK) {
+    RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR("Could not construct deferred dynamic type");
+    // Leave it unbuilt, so it can be retried
+    rcutils_atomic_store(&deferred->state, DEFERRED_UNBUILT);
+    return ret;
+  }
+  rcutils_atomic_store(&deferred->state, DEFERRED_BUILT);
+  return RCUTILS_RET_OK;
+}
+
+
+rcutils_ret_t
+deferred_dynamic_type_materialize(
+  const rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type,
+  const rosidl_dynamic_typesupport_dynamic_type_impl_t ** impl)
+{
+  rosidl_dynamic_typesupport_dynamic_type_deferred_t * deferred = dynamic_type->deferred;
+  if (deferred == NULL) {
+    *impl = &dynamic_type->impl;
+    return RCUTILS_RET_OK;
+  }
+
+  if (rcutils_atomic_load_uint64_t(&deferred->state) != DEFERRED_BUILT) {
+    // Only the nested types this one reaches are built, and only if they were not built yet
+    deferred_dynamic_type_tree_t * tree = deferred->tree;
+    rcutils_allocator_t allocator = dynamic_type->allocator;
+    ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+      build_nested_types(
+        dynamic_type->serialization_support, deferred_dynamic_type_get_description(deferred),
+        &tree->options, &allocator, &tree->cache));
+    ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+      deferred_dynamic_type_build_once(dynamic_type));
+  }
+  *impl = &deferred->impl;
+  return RCUTILS_RET_OK;
+}
+
+
+rcutils_ret_t
+deferred_dynamic_type_materialize_mutable(
+  rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type,
+  rosidl_dynamic_typesupport_dynamic_type_impl_t ** impl)
+{
+  const rosidl_dynamic_typesupport_dynamic_type_impl_t * built_impl = NULL;
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+    deferred_dynamic_type_materialize(dynamic_type, &built_impl));
+  *impl = dynamic_type->deferred != NULL ? &dynamic_type->deferred->impl : &dynamic_type->impl;
+  return RCUTILS_RET_OK;
+}
+
+
+void
+deferred_dynamic_type_get_memory_usage(
+  const rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type,
+  size_t * bytes,
+  const rosidl_dynamic_typesupport_dynamic_type_impl_t ** impl)
+{
+  rosidl_dynamic_typesupport_dynamic_type_deferred_t * deferred = dynamic_type->deferred;
+  *bytes = 0;
+  *impl = &dynamic_type->impl;
+  if (deferred == NULL) {
+    return;
+  }
+
+  // Whatever is building it meanwhile is not waited for, so it is reported as not built yet
+  *impl = rcutils_atomic_load_uint64_t(&deferred->state) == DEFERRED_BUILT ? &deferred->impl : NULL;
+
+  // Everything else belongs to the top level type, and never changes after initialization
+  if (deferred->referenced_index != SIZE_MAX) {
+    return;
+  }
+  const deferred_dynamic_type_tree_t * tree = deferred->tree;
+  size_t nested_type_count = tree->description.referenced_type_descriptions.size;
+  *bytes = sizeof(deferred_dynamic_type_tree_t) +
+    sizeof(rosidl_dynamic_typesupport_dynamic_type_deferred_t) + tree->description_bytes +
+    nested_type_count * (sizeof(rosidl_dynamic_typesupport_dynamic_type_t) +
+    sizeof(rosidl_dynamic_typesupport_dynamic_type_deferred_t) +
+    sizeof(rosidl_dynamic_typesupport_dynamic_type_t *));
+}
+
+
+void
+deferred_dynamic_type_get_nested_types(
+  const rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type,
+  const rosidl_dynamic_typesupport_dynamic_type_t ** nested_types,
+  size_t * nested_type_count)
+{
+  *nested_types = NULL;
+  *nested_type_count = 0;
+  const rosidl_dynamic_typesupport_dynamic_type_deferred_t * deferred = dynamic_type->deferred;
+  if (deferred == NULL || deferred->referenced_index != SIZE_MAX) {
+    return;
+  }
+  *nested_types = deferred->tree->nested_types;
+  *nested_type_count = deferred->tree->description.referenced_type_descriptions.size;
+}
+
+
+static rcutils_ret_t
+deferred_dynamic_type_fini(rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type)
+{
+  rosidl_dynamic_typesupport_dynamic_type_deferred_t * deferred = dynamic_type->deferred;
+  if (deferred->referenced_index != SIZE_MAX) {
+    RCUTILS_SET_ERROR_MSG("Nested member types are finalized along with the type they belong to");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+    deferred_dynamic_type_tree_fini(
+      dynamic_type->serialization_support, &dynamic_type->allocator, deferred->tree));
+  dynamic_type->deferred = NULL;
+  return RCUTILS_RET_OK;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_get_nested_member_type(
+  rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type,
+  const char * member_name,
+  size_t member_name_length,
+  rosidl_dynamic_typesupport_dynamic_type_t ** nested_type)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(dynamic_type, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(member_name, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(nested_type, RCUTILS_RET_INVALID_ARGUMENT);
+  if (dynamic_type->deferred == NULL) {
+    RCUTILS_SET_ERROR_MSG("Nested member types can only be got from deferred dynamic types");
+    return RCUTILS_RET_UNSUPPORTED;
+  }
+
+  deferred_dynamic_type_tree_t * tree = dynamic_type->deferred->tree;
+  const rosidl_runtime_c__type_description__IndividualTypeDescription * individual_description =
+    deferred_dynamic_type_get_description(dynamic_type->deferred);
+  for (size_t i = 0; i < individual_description->fields.size; i++) {
+    const rosidl_runtime_c__type_description__Field * field =
+      &individual_description->fields.data[i];
+    if (field->name.size != member_name_length ||
+      memcmp(field->name.data, member_name, member_name_length) != 0)
+    {
+      continue;
+    }
+    if (!is_nested_field_type(field->type.type_id)) {
+      RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+        "Member [%.*s] is not of a nested type", (int) member_name_length, member_name);
+      return RCUTILS_RET_INVALID_ARGUMENT;
+    }
+    size_t referenced_index = 0;
+    ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+      find_nested_type_index(&tree->cache, field->type.nested_type_name.data, &referenced_index));
+    *nested_type = &tree->nested_types[referenced_index];
+    return RCUTILS_RET_OK;
+  }
+
+  RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+    "No member named [%.*s]", (int) member_name_length, member_name);
+  return RCUTILS_RET_NOT_FOUND;
+}
+
+
 rcutils_ret_t
 rosidl_dynamic_typesupport_dynamic_type_init_from_description(
   rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
   const rosidl_runtime_c__type_description__TypeDescription * description,
   rcutils_allocator_t * allocator,
   rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type)
+{
+  rosidl_dynamic_typesupport_dynamic_type_construction_options_t options =
+    rosidl_dynamic_typesupport_get_default_dynamic_type_construction_options();
+  return rosidl_dynamic_typesupport_dynamic_type_init_from_description_with_options(
+    serialization_support, description, &options, allocator, dynamic_type);
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_init_from_description_with_options(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_runtime_c__type_description__TypeDescription * description,
+  const rosidl_dynamic_typesupport_dynamic_type_construction_options_t * options,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type)
 {
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(serialization_support, RCUTILS_RET_INVALID_ARGUMENT);
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(description, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(options, RCUTILS_RET_INVALID_ARGUMENT);
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(allocator, RCUTILS_RET_INVALID_ARGUMENT);
   if (!rcutils_allocator_is_valid(allocator)) {
     RCUTILS_SET_ERROR_MSG("allocator is invalid");
@@ -953,7 +1905,7 @@ rosidl_dynamic_typesupport_dynamic_type_init_from_description(
   }
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(dynamic_type, RCUTILS_RET_INVALID_ARGUMENT);
 
-  if (dynamic_type->impl.handle != NULL) {
+  if (dynamic_type->impl.handle != NULL || dynamic_type->deferred != NULL) {
     ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
       rosidl_dynamic_typesupport_dynamic_type_fini(dynamic_type)
     );
@@ -961,14 +1913,28 @@ rosidl_dynamic_typesupport_dynamic_type_init_from_description(
   dynamic_type->serialization_support = serialization_support;
   dynamic_type->allocator = *allocator;
 
+  if (options->defer_construction) {
+    return deferred_dynamic_type_init(description, options, dynamic_type);
+  }
+
+  // Validated here rather than by the builder, to find out whether the type hash can be vouched for
+  uint64_t type_hash_verification = 0;
+  rosidl_dynamic_typesupport_dynamic_type_construction_options_t builder_options = *options;
+  if (!options->description_is_validated) {
+    ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+      type_description_validation_cache_check(
+        description, options->type_hash, &type_hash_verification));
+    builder_options.description_is_validated = true;
+  }
+
   rosidl_dynamic_typesupport_dynamic_type_builder_t builder =
     rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type_builder();
   builder.serialization_support = serialization_support;
   builder.allocator = *allocator;
 
   ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
-    rosidl_dynamic_typesupport_dynamic_type_builder_init_from_description(
-      serialization_support, description, allocator, &builder)
+    rosidl_dynamic_typesupport_dynamic_type_builder_init_from_description_with_options(
+      serialization_support, description, &builder_options, allocator, &builder)
   );
 
   ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK_WITH_CLEANUP(
@@ -977,6 +1943,11 @@ rosidl_dynamic_typesupport_dynamic_type_init_from_description(
     rosidl_dynamic_typesupport_dynamic_type_builder_fini(&builder)  // Cleanup
   );
   rosidl_dynamic_typesupport_dynamic_type_builder_fini(&builder);
+
+  if (options->type_hash != NULL) {
+    dynamic_type->type_hash = *options->type_hash;
+    dynamic_type->type_hash_verification = type_hash_verification;
+  }
   return RCUTILS_RET_OK;
 }
 
@@ -995,17 +1966,23 @@ rosidl_dynamic_typesupport_dynamic_type_clone(
   }
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(dynamic_type, RCUTILS_RET_INVALID_ARGUMENT);
 
-  if (dynamic_type->impl.handle != NULL) {
+  if (dynamic_type->impl.handle != NULL || dynamic_type->deferred != NULL) {
     ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
       rosidl_dynamic_typesupport_dynamic_type_fini(dynamic_type)
     );
   }
 
+  const rosidl_dynamic_typesupport_dynamic_type_impl_t * other_impl = NULL;
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+    deferred_dynamic_type_materialize(other, &other_impl));
+
   dynamic_type->serialization_support = other->serialization_support;
   dynamic_type->allocator = *allocator;
+  dynamic_type->type_hash = other->type_hash;
+  dynamic_type->type_hash_verification = other->type_hash_verification;
   ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK_WITH_CLEANUP(
     (other->serialization_support->methods.dynamic_type_clone)(
-      &other->serialization_support->impl, &other->impl, allocator, &dynamic_type->impl),
+      &other->serialization_support->impl, other_impl, allocator, &dynamic_type->impl),
     rosidl_dynamic_typesupport_dynamic_type_fini(dynamic_type) // Cleanup
   );
   return RCUTILS_RET_OK;
@@ -1017,6 +1994,10 @@ rosidl_dynamic_typesupport_dynamic_type_fini(
   rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type)
 {
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(dynamic_type, RCUTILS_RET_INVALID_ARGUMENT);
+  if (dynamic_type->deferred != NULL) {
+    // Deferred types keep whatever was built in their deferred state
+    return deferred_dynamic_type_fini(dynamic_type);
+  }
   ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
     (dynamic_type->serialization_support->methods.dynamic_type_fini)(
       &dynamic_type->serialization_support->impl, &dynamic_type->impl);
@@ -1047,8 +2028,11 @@ rosidl_dynamic_typesupport_dynamic_type_get_name(
 {
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(dynamic_type, RCUTILS_RET_INVALID_ARGUMENT);
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(name, RCUTILS_RET_INVALID_ARGUMENT);
+  const rosidl_dynamic_typesupport_dynamic_type_impl_t * type_impl = NULL;
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+    deferred_dynamic_type_materialize(dynamic_type, &type_impl));
   return (dynamic_type->serialization_support->methods.dynamic_type_get_name)(
-    &dynamic_type->serialization_support->impl, &dynamic_type->impl, name, name_length);
+    &dynamic_type->serialization_support->impl, type_impl, name, name_length);
 }
 
 
@@ -1599,13 +2583,16 @@ rosidl_dynamic_typesupport_dynamic_type_builder_add_complex_member(
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(name, RCUTILS_RET_INVALID_ARGUMENT);
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(default_value, RCUTILS_RET_INVALID_ARGUMENT);
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(nested_struct, RCUTILS_RET_INVALID_ARGUMENT);
+  rosidl_dynamic_typesupport_dynamic_type_impl_t * nested_impl = NULL;
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+    deferred_dynamic_type_materialize_mutable(nested_struct, &nested_impl));
   return (dynamic_type_builder->serialization_support->methods.
          dynamic_type_builder_add_complex_member)(
     &dynamic_type_builder->serialization_support->impl, &dynamic_type_builder->impl,
     id,
     name, name_length,
     default_value, default_value_length,
-    &nested_struct->impl);
+    nested_impl);
 }
 
 
@@ -1621,13 +2608,16 @@ rosidl_dynamic_typesupport_dynamic_type_builder_add_complex_array_member(
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(name, RCUTILS_RET_INVALID_ARGUMENT);
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(default_value, RCUTILS_RET_INVALID_ARGUMENT);
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(nested_struct, RCUTILS_RET_INVALID_ARGUMENT);
+  rosidl_dynamic_typesupport_dynamic_type_impl_t * nested_impl = NULL;
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+    deferred_dynamic_type_materialize_mutable(nested_struct, &nested_impl));
   return (dynamic_type_builder->serialization_support->methods.
          dynamic_type_builder_add_complex_array_member)(
     &dynamic_type_builder->serialization_support->impl, &dynamic_type_builder->impl,
     id,
     name, name_length,
     default_value, default_value_length,
-    &nested_struct->impl, sequence_bound);
+    nested_impl, sequence_bound);
 }
 
 
@@ -1643,13 +2633,16 @@ rosidl_dynamic_typesupport_dynamic_type_builder_add_complex_unbounded_sequence_m
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(name, RCUTILS_RET_INVALID_ARGUMENT);
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(default_value, RCUTILS_RET_INVALID_ARGUMENT);
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(nested_struct, RCUTILS_RET_INVALID_ARGUMENT);
+  rosidl_dynamic_typesupport_dynamic_type_impl_t * nested_impl = NULL;
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+    deferred_dynamic_type_materialize_mutable(nested_struct, &nested_impl));
   return (dynamic_type_builder->serialization_support->methods.
          dynamic_type_builder_add_complex_unbounded_sequence_member)(
     &dynamic_type_builder->serialization_support->impl, &dynamic_type_builder->impl,
     id,
     name, name_length,
     default_value, default_value_length,
-    &nested_struct->impl);
+    nested_impl);
 }
 
 
@@ -1665,13 +2658,16 @@ rosidl_dynamic_typesupport_dynamic_type_builder_add_complex_bounded_sequence_mem
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(name, RCUTILS_RET_INVALID_ARGUMENT);
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(default_value, RCUTILS_RET_INVALID_ARGUMENT);
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(nested_struct, RCUTILS_RET_INVALID_ARGUMENT);
+  rosidl_dynamic_typesupport_dynamic_type_impl_t * nested_impl = NULL;
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+    deferred_dynamic_type_materialize_mutable(nested_struct, &nested_impl));
   return (dynamic_type_builder->serialization_support->methods.
          dynamic_type_builder_add_complex_bounded_sequence_member)(
     &dynamic_type_builder->serialization_support->impl, &dynamic_type_builder->impl,
     id,
     name, name_length,
     default_value, default_value_length,
-    &nested_struct->impl, sequence_bound);
+    nested_impl, sequence_bound);
 }
 
 
@@ -1761,3 +2757,96 @@ rosidl_dynamic_typesupport_dynamic_type_builder_add_complex_bounded_sequence_mem
     default_value, default_value_length,
     &nested_struct_builder->impl, sequence_bound);
 }
+
+
+// DYNAMIC TYPE BATCHED MEMBERS ====================================================================
+// Hand members to the batched slot with their deferred nested types swapped for built copies
+static rcutils_ret_t
+add_members_with_deferred_nested_types(
+  rosidl_dynamic_typesupport_dynamic_type_builder_t * dynamic_type_builder,
+  const rosidl_dynamic_typesupport_dynamic_type_member_spec_t * members,
+  size_t member_count)
+{
+  rcutils_allocator_t * allocator = &dynamic_type_builder->allocator;
+  rosidl_dynamic_typesupport_dynamic_type_member_spec_t * built_members = allocator->allocate(
+    member_count * sizeof(rosidl_dynamic_typesupport_dynamic_type_member_spec_t),
+    allocator->state);
+  rosidl_dynamic_typesupport_dynamic_type_t * built_nested_types = allocator->allocate(
+    member_count * sizeof(rosidl_dynamic_typesupport_dynamic_type_t), allocator->state);
+  rcutils_ret_t ret = RCUTILS_RET_BAD_ALLOC;
+  if (built_members == NULL || built_nested_types == NULL) {
+    RCUTILS_SET_ERROR_MSG("Could not allocate dynamic type member specs");
+    goto end;
+  }
+
+  // NOTE: The copies only borrow the built type, and are never finalized
+  for (size_t i = 0; i < member_count; i++) {
+    built_members[i] = members[i];
+    if (members[i].nested_type == NULL || members[i].nested_type->deferred == NULL) {
+      continue;
+    }
+    const rosidl_dynamic_typesupport_dynamic_type_impl_t * nested_impl = NULL;
+    ret = deferred_dynamic_type_materialize(members[i].nested_type, &nested_impl);
+    if (ret != RCUTILS_RET_OK) {
+      goto end;  // error already set
+    }
+    built_nested_types[i] = *members[i].nested_type;
+    built_nested_types[i].impl = *nested_impl;
+    built_nested_types[i].deferred = NULL;
+    built_members[i].nested_type = &built_nested_types[i];
+  }
+
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support =
+    dynamic_type_builder->serialization_support;
+  ret = (serialization_support->methods.dynamic_type_builder_add_members)(
+    &serialization_support->impl, &dynamic_type_builder->impl, built_members, member_count);
+
+end:
+  allocator->deallocate(built_members, allocator->state);
+  allocator->deallocate(built_nested_types, allocator->state);
+  return ret;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_builder_add_members(
+  rosidl_dynamic_typesupport_dynamic_type_builder_t * dynamic_type_builder,
+  const rosidl_dynamic_typesupport_dynamic_type_member_spec_t * members,
+  size_t member_count)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(dynamic_type_builder, RCUTILS_RET_INVALID_ARGUMENT);
+  if (member_count == 0) {
+    return RCUTILS_RET_OK;
+  }
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(members, RCUTILS_RET_INVALID_ARGUMENT);
+
+  for (size_t i = 0; i < member_count; i++) {
+    RCUTILS_CHECK_ARGUMENT_FOR_NULL(members[i].name, RCUTILS_RET_INVALID_ARGUMENT);
+    RCUTILS_CHECK_ARGUMENT_FOR_NULL(members[i].default_value, RCUTILS_RET_INVALID_ARGUMENT);
+  }
+
+  // The batched slot reads nested types' `impl` directly, which deferred types leave unset
+  bool has_deferred_nested_type = false;
+  for (size_t i = 0; i < member_count; i++) {
+    if (members[i].nested_type != NULL && members[i].nested_type->deferred != NULL) {
+      has_deferred_nested_type = true;
+    }
+  }
+
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support =
+    dynamic_type_builder->serialization_support;
+  if (serialization_support->methods.dynamic_type_builder_add_members != NULL) {
+    if (!has_deferred_nested_type) {
+      return (serialization_support->methods.dynamic_type_builder_add_members)(
+        &serialization_support->impl, &dynamic_type_builder->impl, members, member_count);
+    }
+    return add_members_with_deferred_nested_types(dynamic_type_builder, members, member_count);
+  }
+
+  // Fall back to adding members one at a time, for backends without the batched slot
+  for (size_t i = 0; i < member_count; i++) {
+    ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+      add_member_from_spec(dynamic_type_builder, &members[i]));
+  }
+  return RCUTILS_RET_OK;
+}
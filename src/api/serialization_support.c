@@ -13,7 +13,9 @@
 // limitations under the License.
 
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <rosidl_dynamic_typesupport/api/serialization_support.h>
 #include <rosidl_dynamic_typesupport/api/serialization_support_interface.h>
@@ -22,8 +24,30 @@
 
 #include <rcutils/allocator.h>
 #include <rcutils/error_handling.h>
+#include <rcutils/stdatomic_helper.h>
 #include <rcutils/types/rcutils_ret.h>
 
+#include "spin_lock.h"
+
+
+// A serialization support with a reference count, handed out as a pointer to its first member
+typedef struct shared_serialization_support_s
+{
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support;  // Must be first
+  rcutils_allocator_t allocator;
+  atomic_uint_least64_t ref_count;
+
+  // Next in shared_serialization_supports. Guarded by shared_serialization_supports_lock
+  struct shared_serialization_support_s * next;
+} shared_serialization_support_t;
+
+
+// Every shared serialization support with references left, at most one per serialization library
+// (there are only ever a handful, so a list is plenty)
+static shared_serialization_support_t * shared_serialization_supports;
+static atomic_bool shared_serialization_supports_lock;
+
+
 rosidl_dynamic_typesupport_serialization_support_impl_t
 rosidl_dynamic_typesupport_get_zero_initialized_serialization_support_impl(void)
 {
@@ -122,3 +146,126 @@ rosidl_dynamic_typesupport_serialization_support_fini(
   );
   return RCUTILS_RET_OK;
 }
+
+
+// SHARED ==========================================================================================
+// Take a reference to a shared serialization support, unless its last one was already released
+static bool
+shared_serialization_support_acquire_if_referenced(shared_serialization_support_t * shared)
+{
+  uint64_t ref_count = rcutils_atomic_load_uint64_t(&shared->ref_count);
+  do {
+    if (ref_count == 0) {
+      // Being finalized, it just was not unlisted yet
+      return false;
+    }
+  } while (!rcutils_atomic_compare_exchange_strong_uint_least64_t(
+    &shared->ref_count, &ref_count, ref_count + 1));
+  return true;
+}
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_serialization_support_init_shared(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_serialization_support_t ** shared_serialization_support)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(serialization_support, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(
+    serialization_support->serialization_library_identifier, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(allocator, RCUTILS_RET_INVALID_ARGUMENT);
+  if (!rcutils_allocator_is_valid(allocator)) {
+    RCUTILS_SET_ERROR_MSG("allocator is invalid");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(shared_serialization_support, RCUTILS_RET_INVALID_ARGUMENT);
+
+  spin_lock_acquire(&shared_serialization_supports_lock);
+  shared_serialization_support_t * shared = shared_serialization_supports;
+  for (; shared != NULL; shared = shared->next) {
+    if (strcmp(
+        shared->serialization_support.serialization_library_identifier,
+        serialization_support->serialization_library_identifier) == 0 &&
+      shared_serialization_support_acquire_if_referenced(shared))
+    {
+      break;
+    }
+  }
+  if (shared == NULL) {
+    shared = allocator->allocate(sizeof(shared_serialization_support_t), allocator->state);
+    if (shared == NULL) {
+      spin_lock_release(&shared_serialization_supports_lock);
+      RCUTILS_SET_ERROR_MSG("Could not allocate shared serialization support");
+      return RCUTILS_RET_BAD_ALLOC;
+    }
+    shared->serialization_support = *serialization_support;
+    shared->allocator = *allocator;
+    rcutils_atomic_store(&shared->ref_count, 1);
+    shared->next = shared_serialization_supports;
+    shared_serialization_supports = shared;
+    spin_lock_release(&shared_serialization_supports_lock);
+  } else {
+    spin_lock_release(&shared_serialization_supports_lock);
+
+    // NOTE: Serialization supports of the same serialization library are interchangeable, so the
+    //       one that was moved in is finalized instead of being shared as well
+    if (rosidl_dynamic_typesupport_serialization_support_fini(serialization_support) !=
+      RCUTILS_RET_OK)
+    {
+      RCUTILS_SAFE_FWRITE_TO_STDERR("Could not finalize serialization support that was moved in");
+      rcutils_reset_error();
+    }
+  }
+
+  *serialization_support = rosidl_dynamic_typesupport_get_zero_initialized_serialization_support();
+  *shared_serialization_support = &shared->serialization_support;
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_serialization_support_acquire(
+  rosidl_dynamic_typesupport_serialization_support_t * shared_serialization_support)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(shared_serialization_support, RCUTILS_RET_INVALID_ARGUMENT);
+  shared_serialization_support_t * shared =
+    (shared_serialization_support_t *) shared_serialization_support;
+  rcutils_atomic_fetch_add_uint64_t(&shared->ref_count, 1);
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_serialization_support_release(
+  rosidl_dynamic_typesupport_serialization_support_t * shared_serialization_support)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(shared_serialization_support, RCUTILS_RET_INVALID_ARGUMENT);
+  shared_serialization_support_t * shared =
+    (shared_serialization_support_t *) shared_serialization_support;
+
+  uint64_t ref_count = rcutils_atomic_load_uint64_t(&shared->ref_count);
+  do {
+    if (ref_count == 0) {
+      RCUTILS_SET_ERROR_MSG("Shared serialization support has no references left to release");
+      return RCUTILS_RET_INVALID_ARGUMENT;
+    }
+  } while (!rcutils_atomic_compare_exchange_strong_uint_least64_t(
+    &shared->ref_count, &ref_count, ref_count - 1));
+  if (ref_count > 1) {
+    return RCUTILS_RET_OK;
+  }
+
+  // That was the last reference. Lookups skip it from now on, but might still be looking at it
+  // until it is unlisted
+  spin_lock_acquire(&shared_serialization_supports_lock);
+  shared_serialization_support_t ** link = &shared_serialization_supports;
+  while (*link != shared) {
+    link = &(*link)->next;
+  }
+  *link = shared->next;
+  spin_lock_release(&shared_serialization_supports_lock);
+
+  rcutils_ret_t ret =
+    rosidl_dynamic_typesupport_serialization_support_fini(&shared->serialization_support);
+  rcutils_allocator_t allocator = shared->allocator;
+  allocator.deallocate(shared, allocator.state);
+  return ret;
+}
@@ -0,0 +1,219 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <rosidl_runtime_c/string.h>
+#include <rosidl_runtime_c/type_description/field__struct.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__struct.h>
+#include <rosidl_runtime_c/type_description/type_description__struct.h>
+#include <rosidl_runtime_c/type_description/type_source__struct.h>
+
+#include "compact_type_description.h"
+
+
+// Sizing and packing go through the same functions, so they can't disagree on the layout. While
+// sizing, `storage` is NULL and nothing is written
+typedef struct packer_s
+{
+  uint8_t * storage;
+  size_t size;
+} packer_t;
+
+
+// Returns NULL while sizing
+static void *
+pack_reserve(packer_t * packer, size_t size, size_t alignment)
+{
+  size_t offset = (packer->size + alignment - 1) & ~(alignment - 1);
+  packer->size = offset + size;
+  return packer->storage == NULL ? NULL : packer->storage + offset;
+}
+
+
+static void
+pack_string(
+  packer_t * packer, const rosidl_runtime_c__String * string, rosidl_runtime_c__String * packed)
+{
+  char * data = pack_reserve(packer, string->size + 1, 1);
+  if (data == NULL) {
+    return;
+  }
+  if (string->size > 0) {
+    memcpy(data, string->data, string->size);
+  }
+  data[string->size] = '\0';
+  packed->data = data;
+  packed->size = string->size;
+  packed->capacity = string->size + 1;
+}
+
+
+static void
+pack_individual_type_description(
+  packer_t * packer,
+  const rosidl_runtime_c__type_description__IndividualTypeDescription * individual_description,
+  rosidl_runtime_c__type_description__IndividualTypeDescription * packed)
+{
+  bool is_packing = packer->storage != NULL;
+  pack_string(packer, &individual_description->type_name, is_packing ? &packed->type_name : NULL);
+
+  size_t field_count = individual_description->fields.size;
+  rosidl_runtime_c__type_description__Field * fields = pack_reserve(
+    packer, field_count * sizeof(rosidl_runtime_c__type_description__Field),
+    _Alignof(rosidl_runtime_c__type_description__Field));
+  for (size_t i = 0; i < field_count; i++) {
+    const rosidl_runtime_c__type_description__Field * field =
+      &individual_description->fields.data[i];
+    if (is_packing) {
+      fields[i].type.type_id = field->type.type_id;
+      fields[i].type.capacity = field->type.capacity;
+      fields[i].type.string_capacity = field->type.string_capacity;
+    }
+    pack_string(packer, &field->name, is_packing ? &fields[i].name : NULL);
+    pack_string(
+      packer, &field->type.nested_type_name, is_packing ? &fields[i].type.nested_type_name : NULL);
+    pack_string(packer, &field->default_value, is_packing ? &fields[i].default_value : NULL);
+  }
+  if (is_packing) {
+    packed->fields.data = field_count > 0 ? fields : NULL;
+    packed->fields.size = field_count;
+    packed->fields.capacity = field_count;
+  }
+}
+
+
+static void
+pack(
+  packer_t * packer,
+  const rosidl_runtime_c__type_description__TypeDescription * type_description,
+  const rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources,
+  rosidl_runtime_c__type_description__TypeDescription * packed_description,
+  rosidl_runtime_c__type_description__TypeSource__Sequence * packed_sources)
+{
+  bool is_packing = packer->storage != NULL;
+  pack_individual_type_description(
+    packer, &type_description->type_description,
+    is_packing ? &packed_description->type_description : NULL);
+
+  // referenced_type_descriptions
+  size_t referenced_count = type_description->referenced_type_descriptions.size;
+  rosidl_runtime_c__type_description__IndividualTypeDescription * referenced = pack_reserve(
+    packer,
+    referenced_count * sizeof(rosidl_runtime_c__type_description__IndividualTypeDescription),
+    _Alignof(rosidl_runtime_c__type_description__IndividualTypeDescription));
+  for (size_t i = 0; i < referenced_count; i++) {
+    pack_individual_type_description(
+      packer, &type_description->referenced_type_descriptions.data[i],
+      is_packing ? &referenced[i] : NULL);
+  }
+  if (is_packing) {
+    packed_description->referenced_type_descriptions.data =
+      referenced_count > 0 ? referenced : NULL;
+    packed_description->referenced_type_descriptions.size = referenced_count;
+    packed_description->referenced_type_descriptions.capacity = referenced_count;
+  }
+
+  // type_description_sources
+  size_t source_count = type_description_sources == NULL ? 0 : type_description_sources->size;
+  rosidl_runtime_c__type_description__TypeSource * sources = pack_reserve(
+    packer, source_count * sizeof(rosidl_runtime_c__type_description__TypeSource),
+    _Alignof(rosidl_runtime_c__type_description__TypeSource));
+  for (size_t i = 0; i < source_count; i++) {
+    const rosidl_runtime_c__type_description__TypeSource * source =
+      &type_description_sources->data[i];
+    pack_string(packer, &source->type_name, is_packing ? &sources[i].type_name : NULL);
+    pack_string(packer, &source->encoding, is_packing ? &sources[i].encoding : NULL);
+    pack_string(
+      packer, &source->raw_file_contents, is_packing ? &sources[i].raw_file_contents : NULL);
+  }
+  if (is_packing) {
+    packed_sources->data = source_count > 0 ? sources : NULL;
+    packed_sources->size = source_count;
+    packed_sources->capacity = source_count;
+  }
+}
+
+
+size_t
+compact_type_description_get_size(
+  const rosidl_runtime_c__type_description__TypeDescription * type_description,
+  const rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources)
+{
+  packer_t packer = {.storage = NULL, .size = 0};
+  pack(&packer, type_description, type_description_sources, NULL, NULL);
+  return packer.size;
+}
+
+
+void
+compact_type_description_pack(
+  const rosidl_runtime_c__type_description__TypeDescription * type_description,
+  const rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources,
+  void * storage,
+  rosidl_runtime_c__type_description__TypeDescription * packed_description,
+  rosidl_runtime_c__type_description__TypeSource__Sequence * packed_sources)
+{
+  packer_t packer = {.storage = storage, .size = 0};
+  pack(&packer, type_description, type_description_sources, packed_description, packed_sources);
+}
+
+
+static size_t
+get_unpacked_individual_type_description_size(
+  const rosidl_runtime_c__type_description__IndividualTypeDescription * individual_description)
+{
+  size_t size = individual_description->type_name.capacity;
+  size += individual_description->fields.capacity *
+    sizeof(rosidl_runtime_c__type_description__Field);
+  for (size_t i = 0; i < individual_description->fields.size; i++) {
+    const rosidl_runtime_c__type_description__Field * field =
+      &individual_description->fields.data[i];
+    size += field->name.capacity + field->type.nested_type_name.capacity +
+      field->default_value.capacity;
+  }
+  return size;
+}
+
+
+size_t
+compact_type_description_get_unpacked_size(
+  const rosidl_runtime_c__type_description__TypeDescription * type_description,
+  const rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources)
+{
+  size_t size = get_unpacked_individual_type_description_size(
+    &type_description->type_description);
+
+  size += type_description->referenced_type_descriptions.capacity *
+    sizeof(rosidl_runtime_c__type_description__IndividualTypeDescription);
+  for (size_t i = 0; i < type_description->referenced_type_descriptions.size; i++) {
+    size += get_unpacked_individual_type_description_size(
+      &type_description->referenced_type_descriptions.data[i]);
+  }
+
+  if (type_description_sources != NULL) {
+    size += type_description_sources->capacity *
+      sizeof(rosidl_runtime_c__type_description__TypeSource);
+    for (size_t i = 0; i < type_description_sources->size; i++) {
+      const rosidl_runtime_c__type_description__TypeSource * source =
+        &type_description_sources->data[i];
+      size += source->type_name.capacity + source->encoding.capacity +
+        source->raw_file_contents.capacity;
+    }
+  }
+  return size;
+}
@@ -0,0 +1,81 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COMPACT_TYPE_DESCRIPTION_H_
+#define COMPACT_TYPE_DESCRIPTION_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+
+#include <rosidl_runtime_c/type_description/type_description__struct.h>
+#include <rosidl_runtime_c/type_description/type_source__struct.h>
+
+
+// COMPACT TYPE DESCRIPTIONS =======================================================================
+// Copies of type descriptions (and their sources) with every string and sequence packed into one
+// caller-provided block, instead of one allocation each.
+//
+// Packed copies are plain `rosidl_runtime_c` structs that can be read like any other, but MUST NOT
+// be modified or finalized with the `rosidl_runtime_c` functions. Deallocating the block frees all
+// of them at once.
+
+// Packed copies only need the block to be aligned like this
+#define COMPACT_TYPE_DESCRIPTION_ALIGNMENT _Alignof(max_align_t)
+
+/// Get the size of the block needed to pack `type_description` and `type_description_sources`
+/**
+ * `type_description_sources` may be NULL.
+ */
+size_t
+compact_type_description_get_size(
+  const rosidl_runtime_c__type_description__TypeDescription * type_description,
+  const rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources);
+
+/// Pack copies of `type_description` and `type_description_sources` into `storage`
+/**
+ * `storage` must be at least `compact_type_description_get_size()` bytes, and aligned to
+ * COMPACT_TYPE_DESCRIPTION_ALIGNMENT. Packing can't fail.
+ *
+ * If `type_description_sources` is NULL, the packed sources are left empty.
+ */
+void
+compact_type_description_pack(
+  const rosidl_runtime_c__type_description__TypeDescription * type_description,
+  const rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources,
+  void * storage,
+  rosidl_runtime_c__type_description__TypeDescription * packed_description,  // OUT
+  rosidl_runtime_c__type_description__TypeSource__Sequence * packed_sources);  // OUT
+
+/// Get the bytes allocated for a description and its sources owned by `rosidl_runtime_c`
+/**
+ * Counts the capacity of every string and sequence, but not the structs passed in.
+ * `type_description_sources` may be NULL.
+ *
+ * MUST NOT be used for packed copies, whose size is `compact_type_description_get_size()`.
+ */
+size_t
+compact_type_description_get_unpacked_size(
+  const rosidl_runtime_c__type_description__TypeDescription * type_description,
+  const rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // COMPACT_TYPE_DESCRIPTION_H_
@@ -0,0 +1,589 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/type_description/field__struct.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__struct.h>
+
+#include "rosidl_dynamic_typesupport/default_values.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+
+// Longest number that will be parsed, including the null terminator
+#define MAX_NUMBER_LENGTH 128
+
+
+rosidl_dynamic_typesupport_default_values_t
+rosidl_dynamic_typesupport_get_zero_initialized_default_values(void)
+{
+  static rosidl_dynamic_typesupport_default_values_t zero_default_values = {
+    .member_count = 0,
+    .members = NULL,
+    // .allocator = // Initialized later
+  };
+  zero_default_values.allocator = rcutils_get_zero_initialized_allocator();
+  return zero_default_values;
+}
+
+
+// UTILS ===========================================================================================
+// Strip the array/sequence part of a field type id, leaving the type id of a single element
+static uint8_t
+get_element_type_id(uint8_t type_id, bool * is_collection)
+{
+  // Arrays, bounded sequences, and unbounded sequences of each element type are offset from the
+  // single element type ids by the same amount as the nested type ones are
+  const uint8_t nested = ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE;
+  const uint8_t nested_array = ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_ARRAY;
+  const uint8_t nested_bounded_sequence =
+    ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_BOUNDED_SEQUENCE;
+  const uint8_t nested_unbounded_sequence =
+    ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_UNBOUNDED_SEQUENCE;
+
+  *is_collection = true;
+  if (type_id >= nested_unbounded_sequence) {
+    return type_id - (nested_unbounded_sequence - nested);
+  } else if (type_id >= nested_bounded_sequence) {
+    return type_id - (nested_bounded_sequence - nested);
+  } else if (type_id >= nested_array) {
+    return type_id - (nested_array - nested);
+  }
+  *is_collection = false;
+  return type_id;
+}
+
+
+// Size of a parsed element, or 0 if default values of that type are not parsed
+static size_t
+get_element_size(uint8_t element_type_id)
+{
+  switch (element_type_id) {
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOOLEAN:
+      return sizeof(bool);
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BYTE:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_CHAR:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT8:
+      return sizeof(uint8_t);
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_WCHAR:
+      return sizeof(uint16_t);
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT8:
+      return sizeof(int8_t);
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT16:
+      return sizeof(int16_t);
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT16:
+      return sizeof(uint16_t);
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32:
+      return sizeof(int32_t);
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT32:
+      return sizeof(uint32_t);
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT64:
+      return sizeof(int64_t);
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT64:
+      return sizeof(uint64_t);
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT32:
+      return sizeof(float);
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT64:
+      return sizeof(double);
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT128:
+      return sizeof(long double);
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_STRING:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_WSTRING:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FIXED_STRING:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FIXED_WSTRING:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_STRING:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_WSTRING:
+      return sizeof(rosidl_dynamic_typesupport_default_string_t);
+    default:  // Nested types, or unknown type ids
+      return 0;
+  }
+}
+
+
+static bool
+is_string_type(uint8_t type_id)
+{
+  bool is_collection = false;
+  switch (get_element_type_id(type_id, &is_collection)) {
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_STRING:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_WSTRING:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FIXED_STRING:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FIXED_WSTRING:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_STRING:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_WSTRING:
+      return true;
+    default:
+      return false;
+  }
+}
+
+
+static bool
+is_space(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+
+static void
+trim(const char ** begin, size_t * length)
+{
+  while (*length > 0 && is_space(**begin)) {
+    (*begin)++;
+    (*length)--;
+  }
+  while (*length > 0 && is_space((*begin)[*length - 1])) {
+    (*length)--;
+  }
+}
+
+
+static bool
+is_quoted(const char * token, size_t length)
+{
+  return length >= 2 && (token[0] == '"' || token[0] == '\'') && token[length - 1] == token[0];
+}
+
+
+// Get the next comma separated element of a list, skipping over commas in quoted strings
+//
+// Returns false once there are no elements left. A trailing comma does not count as an element
+static bool
+next_list_element(
+  const char ** cursor, const char * end,
+  const char ** element, size_t * element_length)  // OUT
+{
+  const char * begin = *cursor;
+  while (begin < end && is_space(*begin)) {
+    begin++;
+  }
+  if (begin >= end) {
+    return false;
+  }
+
+  const char * it = begin;
+  char quote = '\0';
+  for (; it < end; it++) {
+    if (quote != '\0') {
+      if (*it == '\\' && it + 1 < end) {
+        it++;
+      } else if (*it == quote) {
+        quote = '\0';
+      }
+    } else if (*it == '"' || *it == '\'') {
+      quote = *it;
+    } else if (*it == ',') {
+      break;
+    }
+  }
+
+  *element = begin;
+  *element_length = (size_t)(it - begin);
+  trim(element, element_length);
+  *cursor = it < end ? it + 1 : end;
+  return true;
+}
+
+
+// PARSING =========================================================================================
+static bool
+parse_bool(const char * token, size_t length, bool * value)
+{
+  static const char * true_values[] = {"true", "True", "TRUE", "1"};
+  static const char * false_values[] = {"false", "False", "FALSE", "0"};
+  for (size_t i = 0; i < sizeof(true_values) / sizeof(true_values[0]); i++) {
+    if (strlen(true_values[i]) == length && strncmp(token, true_values[i], length) == 0) {
+      *value = true;
+      return true;
+    }
+    if (strlen(false_values[i]) == length && strncmp(token, false_values[i], length) == 0) {
+      *value = false;
+      return true;
+    }
+  }
+  return false;
+}
+
+
+// Parse an integer into the range [min, max], in decimal, or in hexadecimal with a 0x prefix
+//
+// NOTE: Chars can also be given as a quoted single ASCII character
+static bool
+parse_integer(const char * token, size_t length, int64_t min, uint64_t max, uint64_t * value)
+{
+  if (is_quoted(token, length)) {
+    if (length != 3 || (unsigned char)token[1] > 127) {
+      return false;
+    }
+    *value = (unsigned char)token[1];
+    return *value <= max;
+  }
+
+  char buffer[MAX_NUMBER_LENGTH];
+  if (length == 0 || length >= sizeof(buffer)) {
+    return false;
+  }
+  memcpy(buffer, token, length);
+  buffer[length] = '\0';
+
+  const char * digits = buffer;
+  bool negative = false;
+  if (*digits == '-' || *digits == '+') {
+    negative = *digits == '-';
+    digits++;
+  }
+  int base = 10;
+  if (digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X')) {
+    base = 16;
+  }
+  // strtoull() would otherwise accept (and negate) another sign after ours
+  if (*digits == '-' || *digits == '+' || is_space(*digits)) {
+    return false;
+  }
+
+  char * end = NULL;
+  errno = 0;
+  unsigned long long magnitude = strtoull(digits, &end, base);  // NOLINT(runtime/int)
+  if (end == digits || *end != '\0' || errno == ERANGE) {
+    return false;
+  }
+
+  if (negative) {
+    // -(min + 1) + 1 avoids overflowing when negating INT64_MIN
+    if (min >= 0 || magnitude > (uint64_t)(-(min + 1)) + 1) {
+      return false;
+    }
+    *value = (uint64_t)0 - magnitude;  // Two's complement, truncated to size by the caller
+    return true;
+  }
+  if (magnitude > max) {
+    return false;
+  }
+  *value = magnitude;
+  return true;
+}
+
+
+static bool
+parse_floating_point(
+  const char * token, size_t length, uint8_t element_type_id, void * element)
+{
+  char buffer[MAX_NUMBER_LENGTH];
+  if (length == 0 || length >= sizeof(buffer)) {
+    return false;
+  }
+  memcpy(buffer, token, length);
+  buffer[length] = '\0';
+
+  char * end = NULL;
+  switch (element_type_id) {
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT32:
+      *(float *)element = strtof(buffer, &end);
+      break;
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT64:
+      *(double *)element = strtod(buffer, &end);
+      break;
+    default:
+      *(long double *)element = strtold(buffer, &end);
+      break;
+  }
+  return end != buffer && *end == '\0';
+}
+
+
+// Copy a string default value, removing its quotes and escapes if it is quoted
+static rcutils_ret_t
+parse_string(
+  const char * token, size_t length, rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_default_string_t * element)  // OUT
+{
+  bool quoted = is_quoted(token, length);
+  if (quoted) {
+    token++;
+    length -= 2;
+  }
+
+  char * data = allocator->allocate(length + 1, allocator->state);
+  if (data == NULL) {
+    RCUTILS_SET_ERROR_MSG("Could not allocate default string value");
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+
+  size_t out = 0;
+  for (size_t i = 0; i < length; i++) {
+    char c = token[i];
+    if (quoted && c == '\\' && i + 1 < length) {
+      c = token[++i];
+      switch (c) {
+        case 'n':
+          c = '\n';
+          break;
+        case 't':
+          c = '\t';
+          break;
+        case 'r':
+          c = '\r';
+          break;
+        case '0':
+          c = '\0';
+          break;
+        default:  // Quotes and backslashes are kept as is
+          break;
+      }
+    }
+    data[out++] = c;
+  }
+  data[out] = '\0';
+
+  element->data = data;
+  element->length = out;
+  return RCUTILS_RET_OK;
+}
+
+
+// Parse a single element of a default value
+//
+// Sets `parsed` to false if it could not be parsed, failing only if it could not allocate
+static rcutils_ret_t
+parse_element(
+  const char * token, size_t length, uint8_t element_type_id, rcutils_allocator_t * allocator,
+  void * element, bool * parsed)  // OUT
+{
+  uint64_t integer = 0;
+  *parsed = true;
+
+  switch (element_type_id) {
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOOLEAN:
+      *parsed = parse_bool(token, length, (bool *)element);
+      return RCUTILS_RET_OK;
+
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BYTE:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_CHAR:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT8:
+      *parsed = parse_integer(token, length, 0, UINT8_MAX, &integer);
+      *(uint8_t *)element = (uint8_t)integer;
+      return RCUTILS_RET_OK;
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_WCHAR:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT16:
+      *parsed = parse_integer(token, length, 0, UINT16_MAX, &integer);
+      *(uint16_t *)element = (uint16_t)integer;
+      return RCUTILS_RET_OK;
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT32:
+      *parsed = parse_integer(token, length, 0, UINT32_MAX, &integer);
+      *(uint32_t *)element = (uint32_t)integer;
+      return RCUTILS_RET_OK;
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT64:
+      *parsed = parse_integer(token, length, 0, UINT64_MAX, &integer);
+      *(uint64_t *)element = integer;
+      return RCUTILS_RET_OK;
+
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT8:
+      *parsed = parse_integer(token, length, INT8_MIN, INT8_MAX, &integer);
+      *(int8_t *)element = (int8_t)integer;
+      return RCUTILS_RET_OK;
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT16:
+      *parsed = parse_integer(token, length, INT16_MIN, INT16_MAX, &integer);
+      *(int16_t *)element = (int16_t)integer;
+      return RCUTILS_RET_OK;
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32:
+      *parsed = parse_integer(token, length, INT32_MIN, INT32_MAX, &integer);
+      *(int32_t *)element = (int32_t)integer;
+      return RCUTILS_RET_OK;
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT64:
+      *parsed = parse_integer(token, length, INT64_MIN, INT64_MAX, &integer);
+      *(int64_t *)element = (int64_t)integer;
+      return RCUTILS_RET_OK;
+
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT32:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT64:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT128:
+      *parsed = parse_floating_point(token, length, element_type_id, element);
+      return RCUTILS_RET_OK;
+
+    default:  // Strings, see get_element_size()
+      return parse_string(
+        token, length, allocator, (rosidl_dynamic_typesupport_default_string_t *)element);
+  }
+}
+
+
+// Free the elements of a parsed default value, leaving it unparsed
+static void
+member_default_value_fini(
+  rosidl_dynamic_typesupport_member_default_value_t * member, rcutils_allocator_t * allocator)
+{
+  if (member->elements != NULL && is_string_type(member->type_id)) {
+    rosidl_dynamic_typesupport_default_string_t * strings = member->elements;
+    for (size_t i = 0; i < member->element_count; i++) {
+      allocator->deallocate((char *)strings[i].data, allocator->state);
+    }
+  }
+  allocator->deallocate(member->elements, allocator->state);
+  member->elements = NULL;
+  member->element_count = 0;
+  member->is_parsed = false;
+}
+
+
+static rcutils_ret_t
+member_default_value_init(
+  const rosidl_runtime_c__type_description__Field * field,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_member_default_value_t * member)  // OUT
+{
+  bool is_collection = false;
+  uint8_t element_type_id = get_element_type_id(field->type.type_id, &is_collection);
+  member->type_id = field->type.type_id;
+  member->element_size = get_element_size(element_type_id);
+
+  const char * value = field->default_value.data;
+  size_t value_length = field->default_value.size;
+  if (value != NULL) {
+    trim(&value, &value_length);
+  }
+  if (member->element_size == 0 || value == NULL || value_length == 0) {
+    return RCUTILS_RET_OK;  // Nothing to parse
+  }
+
+  // Collections are bracketed lists, as in "[1, 2, 3]" or "(1, 2, 3)"
+  const char * cursor = value;
+  const char * end = value + value_length;
+  if (is_collection) {
+    char close = value[0] == '[' ? ']' : (value[0] == '(' ? ')' : '\0');
+    if (close == '\0' || value_length < 2 || value[value_length - 1] != close) {
+      return RCUTILS_RET_OK;
+    }
+    cursor++;
+    end--;
+
+    const char * element = NULL;
+    size_t element_length = 0;
+    for (const char * it = cursor; next_list_element(&it, end, &element, &element_length); ) {
+      member->element_count++;
+    }
+  } else {
+    member->element_count = 1;
+  }
+
+  if (member->element_count > 0) {
+    member->elements = allocator->zero_allocate(
+      member->element_count, member->element_size, allocator->state);
+    if (member->elements == NULL) {
+      RCUTILS_SET_ERROR_MSG("Could not allocate default value elements");
+      member->element_count = 0;
+      return RCUTILS_RET_BAD_ALLOC;
+    }
+  }
+
+  // Strings are counted as they are parsed, so only those parsed are freed on failure
+  size_t element_count = member->element_count;
+  member->element_count = 0;
+  member->is_parsed = true;
+  for (size_t i = 0; i < element_count; i++) {
+    const char * element = value;
+    size_t element_length = value_length;
+    if (is_collection) {
+      next_list_element(&cursor, end, &element, &element_length);
+    }
+
+    bool parsed = element_length > 0 || is_string_type(element_type_id);
+    if (parsed) {
+      rcutils_ret_t ret = parse_element(
+        element, element_length, element_type_id, allocator,
+        (uint8_t *)member->elements + i * member->element_size, &parsed);
+      if (ret != RCUTILS_RET_OK) {
+        member_default_value_fini(member, allocator);
+        return ret;
+      }
+    }
+    if (!parsed) {
+      member_default_value_fini(member, allocator);
+      return RCUTILS_RET_OK;
+    }
+    member->element_count++;
+  }
+  return RCUTILS_RET_OK;
+}
+
+
+// DEFAULT VALUES ==================================================================================
+rcutils_ret_t
+rosidl_dynamic_typesupport_default_values_init(
+  const rosidl_runtime_c__type_description__IndividualTypeDescription * description,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_default_values_t * default_values)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(description, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(allocator, RCUTILS_RET_INVALID_ARGUMENT);
+  if (!rcutils_allocator_is_valid(allocator)) {
+    RCUTILS_SET_ERROR_MSG("allocator is invalid");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(default_values, RCUTILS_RET_INVALID_ARGUMENT);
+
+  *default_values = rosidl_dynamic_typesupport_get_zero_initialized_default_values();
+  default_values->allocator = *allocator;
+
+  size_t member_count = description->fields.size;
+  if (member_count == 0) {
+    return RCUTILS_RET_OK;
+  }
+  default_values->members = allocator->zero_allocate(
+    member_count, sizeof(rosidl_dynamic_typesupport_member_default_value_t), allocator->state);
+  if (default_values->members == NULL) {
+    RCUTILS_SET_ERROR_MSG("Could not allocate default values");
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  default_values->member_count = member_count;
+
+  for (size_t i = 0; i < member_count; i++) {
+    default_values->members[i].member_id = i;
+    rcutils_ret_t ret = member_default_value_init(
+      &description->fields.data[i], allocator, &default_values->members[i]);
+    if (ret != RCUTILS_RET_OK) {
+      RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR("Could not parse default values");
+      rosidl_dynamic_typesupport_default_values_fini(default_values);
+      return ret;
+    }
+  }
+  return RCUTILS_RET_OK;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_default_values_fini(
+  rosidl_dynamic_typesupport_default_values_t * default_values)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(default_values, RCUTILS_RET_INVALID_ARGUMENT);
+  if (default_values->members == NULL) {
+    return RCUTILS_RET_OK;
+  }
+
+  rcutils_allocator_t * allocator = &default_values->allocator;
+  for (size_t i = 0; i < default_values->member_count; i++) {
+    member_default_value_fini(&default_values->members[i], allocator);
+  }
+  allocator->deallocate(default_values->members, allocator->state);
+  default_values->members = NULL;
+  default_values->member_count = 0;
+  return RCUTILS_RET_OK;
+}
@@ -0,0 +1,84 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DEFERRED_DYNAMIC_TYPE_H_
+#define DEFERRED_DYNAMIC_TYPE_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+
+#include <rcutils/types/rcutils_ret.h>
+
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+
+
+// DEFERRED DYNAMIC TYPES ==========================================================================
+// Dynamic types initialized from a description with `defer_construction` set only keep a copy of
+// the description, and are built the first time their serialization library type is needed. So are
+// each of their nested types, separately.
+
+/// Build a deferred dynamic type if it was not built yet, and get its serialization library type
+/**
+ * Dynamic types that were not deferred get their own `impl`. Deferred types keep what was built
+ * in their deferred state instead, and leave `impl` unset. Only the nested types that the dynamic
+ * type reaches are built along with it, if they were not built yet.
+ *
+ * Safe to call from several threads at once on the same dynamic type (or on deferred types sharing
+ * nested types), in which case each type is only built once, and the others wait for it.
+ *
+ * MUST be used to get the type handed to the serialization library, instead of `impl`.
+ */
+rcutils_ret_t
+deferred_dynamic_type_materialize(
+  const rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type,
+  const rosidl_dynamic_typesupport_dynamic_type_impl_t ** impl);  // OUT
+
+/// Same as deferred_dynamic_type_materialize(), for serialization library slots taking mutable ones
+rcutils_ret_t
+deferred_dynamic_type_materialize_mutable(
+  rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type,
+  rosidl_dynamic_typesupport_dynamic_type_impl_t ** impl);  // OUT
+
+/// Get the bytes held by the deferred state of a dynamic type, without building it
+/**
+ * Never waits for the type to be built. `bytes` is 0 for dynamic types that were not deferred, and
+ * for deferred nested types, which are counted with the top level type owning them. `impl` is the
+ * serialization library type if it was built (or was never deferred), and NULL otherwise.
+ */
+void
+deferred_dynamic_type_get_memory_usage(
+  const rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type,
+  size_t * bytes,  // OUT
+  const rosidl_dynamic_typesupport_dynamic_type_impl_t ** impl);  // OUT
+
+/// Get the deferred nested types owned by a top level deferred type
+/**
+ * Their serialization library types are separate from the one of the type referencing them.
+ * `nested_type_count` is 0 for anything but top level deferred types.
+ */
+void
+deferred_dynamic_type_get_nested_types(
+  const rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type,
+  const rosidl_dynamic_typesupport_dynamic_type_t ** nested_types,  // OUT
+  size_t * nested_type_count);  // OUT
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // DEFERRED_DYNAMIC_TYPE_H_
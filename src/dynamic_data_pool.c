@@ -0,0 +1,375 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/stdatomic_helper.h>
+#include <rcutils/types/rcutils_ret.h>
+
+#include "rosidl_dynamic_typesupport/api/dynamic_data.h"
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/dynamic_data_pool.h"
+
+
+// The freelist head packs the index of the top slot (plus one, so zero means empty) in the low
+// bits, and a tag bumped on every push and pop in the high bits. The tag keeps a pop from
+// succeeding if the top slot was popped and pushed back between reading it and swapping it out.
+#define FREELIST_INDEX_BITS 32
+#define FREELIST_INDEX_MASK ((UINT64_C(1) << FREELIST_INDEX_BITS) - 1)
+#define MAX_POOL_SIZE (FREELIST_INDEX_MASK - 1)
+
+
+typedef struct dynamic_data_pool_slot_s
+{
+  // NOTE: This MUST be the first member, so released dynamic data can be mapped back
+  //       to their slot
+  rosidl_dynamic_typesupport_dynamic_data_t dynamic_data;
+
+  // Only touched by whoever holds the slot, so it needs no synchronization of its own
+  bool is_constructed;
+
+  // Index (plus one) of the slot below this one on the freelist, while this one is on it
+  atomic_uint_least64_t next;
+} dynamic_data_pool_slot_t;
+
+struct rosidl_dynamic_typesupport_dynamic_data_pool_impl_s
+{
+  // max_size slots, which never move, so slots can be read even after losing them to a race
+  dynamic_data_pool_slot_t * slots;
+
+  atomic_uint_least64_t free_head;
+
+  atomic_uint_least64_t in_use_count;
+  atomic_uint_least64_t high_water_mark;
+  atomic_uint_least64_t constructed_count;
+  atomic_uint_least64_t overflow_count;
+};
+
+
+static void
+push_slot(rosidl_dynamic_typesupport_dynamic_data_pool_impl_t * impl, uint64_t index)
+{
+  uint64_t head = rcutils_atomic_load_uint64_t(&impl->free_head);
+  bool is_pushed = false;
+  while (!is_pushed) {
+    rcutils_atomic_store(&impl->slots[index].next, head & FREELIST_INDEX_MASK);
+    uint64_t tag = (head >> FREELIST_INDEX_BITS) + 1;
+    uint64_t new_head = (tag << FREELIST_INDEX_BITS) | (index + 1);
+    rcutils_atomic_compare_exchange_strong(&impl->free_head, is_pushed, &head, new_head);
+  }
+}
+
+
+// Returns NULL if the freelist is empty
+static dynamic_data_pool_slot_t *
+pop_slot(rosidl_dynamic_typesupport_dynamic_data_pool_impl_t * impl)
+{
+  uint64_t head = rcutils_atomic_load_uint64_t(&impl->free_head);
+  while ((head & FREELIST_INDEX_MASK) != 0) {
+    dynamic_data_pool_slot_t * slot = &impl->slots[(head & FREELIST_INDEX_MASK) - 1];
+    uint64_t tag = (head >> FREELIST_INDEX_BITS) + 1;
+    uint64_t new_head = (tag << FREELIST_INDEX_BITS) | rcutils_atomic_load_uint64_t(&slot->next);
+    bool is_popped = false;
+    rcutils_atomic_compare_exchange_strong(&impl->free_head, is_popped, &head, new_head);
+    if (is_popped) {
+      return slot;
+    }
+  }
+  return NULL;
+}
+
+
+static rcutils_ret_t
+construct_slot(
+  rosidl_dynamic_typesupport_dynamic_data_pool_t * pool, dynamic_data_pool_slot_t * slot)
+{
+  rcutils_ret_t ret = rosidl_dynamic_typesupport_dynamic_data_init_from_dynamic_type(
+    pool->dynamic_type, &pool->allocator, &slot->dynamic_data);
+  if (ret != RCUTILS_RET_OK) {
+    memset(&slot->dynamic_data, 0, sizeof(slot->dynamic_data));
+    RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR("Could not construct pooled dynamic data");
+    return ret;
+  }
+  slot->is_constructed = true;
+  rcutils_atomic_fetch_add_uint64_t(&pool->impl->constructed_count, 1);
+  return RCUTILS_RET_OK;
+}
+
+
+static void
+deconstruct_slot(dynamic_data_pool_slot_t * slot)
+{
+  if (rosidl_dynamic_typesupport_dynamic_data_fini(&slot->dynamic_data) != RCUTILS_RET_OK) {
+    RCUTILS_SAFE_FWRITE_TO_STDERR_AND_APPEND_PREV_ERROR("Could not finalize pooled dynamic data");
+  }
+  memset(&slot->dynamic_data, 0, sizeof(slot->dynamic_data));
+  slot->is_constructed = false;
+}
+
+
+rosidl_dynamic_typesupport_dynamic_data_pool_t
+rosidl_dynamic_typesupport_get_zero_initialized_dynamic_data_pool(void)
+{
+  rosidl_dynamic_typesupport_dynamic_data_pool_t zero_pool;
+  memset(&zero_pool, 0, sizeof(zero_pool));
+  zero_pool.allocator = rcutils_get_zero_initialized_allocator();
+  return zero_pool;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_data_pool_init(
+  rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type,
+  size_t min_size,
+  size_t max_size,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_dynamic_data_pool_t * pool)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(dynamic_type, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(allocator, RCUTILS_RET_INVALID_ARGUMENT);
+  if (!rcutils_allocator_is_valid(allocator)) {
+    RCUTILS_SET_ERROR_MSG("allocator is invalid");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(pool, RCUTILS_RET_INVALID_ARGUMENT);
+  if (max_size == 0 || min_size > max_size || max_size > MAX_POOL_SIZE) {
+    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+      "Invalid dynamic data pool sizes (min %zu, max %zu)", min_size, max_size);
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+
+  *pool = rosidl_dynamic_typesupport_get_zero_initialized_dynamic_data_pool();
+  pool->dynamic_type = dynamic_type;
+  pool->min_size = min_size;
+  pool->max_size = max_size;
+  pool->allocator = *allocator;
+
+  pool->impl = allocator->allocate(
+    sizeof(rosidl_dynamic_typesupport_dynamic_data_pool_impl_t), allocator->state);
+  if (pool->impl == NULL) {
+    RCUTILS_SET_ERROR_MSG("Could not allocate dynamic data pool");
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  pool->impl->slots = allocator->zero_allocate(
+    max_size, sizeof(dynamic_data_pool_slot_t), allocator->state);
+  if (pool->impl->slots == NULL) {
+    allocator->deallocate(pool->impl, allocator->state);
+    *pool = rosidl_dynamic_typesupport_get_zero_initialized_dynamic_data_pool();
+    RCUTILS_SET_ERROR_MSG("Could not allocate dynamic data pool slots");
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  rcutils_atomic_store(&pool->impl->free_head, 0);
+  rcutils_atomic_store(&pool->impl->in_use_count, 0);
+  rcutils_atomic_store(&pool->impl->high_water_mark, 0);
+  rcutils_atomic_store(&pool->impl->constructed_count, 0);
+  rcutils_atomic_store(&pool->impl->overflow_count, 0);
+
+  for (size_t i = 0; i < min_size; i++) {
+    rcutils_ret_t ret = construct_slot(pool, &pool->impl->slots[i]);
+    if (ret != RCUTILS_RET_OK) {
+      for (size_t j = 0; j < i; j++) {
+        deconstruct_slot(&pool->impl->slots[j]);
+      }
+      allocator->deallocate(pool->impl->slots, allocator->state);
+      allocator->deallocate(pool->impl, allocator->state);
+      *pool = rosidl_dynamic_typesupport_get_zero_initialized_dynamic_data_pool();
+      return ret;
+    }
+  }
+
+  // Pushed last to first, so the constructed slots end up at the top
+  for (size_t i = max_size; i > 0; i--) {
+    push_slot(pool->impl, i - 1);
+  }
+  return RCUTILS_RET_OK;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_data_pool_fini(
+  rosidl_dynamic_typesupport_dynamic_data_pool_t * pool)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(pool, RCUTILS_RET_INVALID_ARGUMENT);
+  if (pool->impl == NULL) {
+    return RCUTILS_RET_OK;
+  }
+
+  uint64_t in_use_count = rcutils_atomic_load_uint64_t(&pool->impl->in_use_count);
+  if (in_use_count != 0) {
+    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+      "Cannot finalize dynamic data pool, %llu dynamic data are still acquired",
+      (unsigned long long) in_use_count);
+    return RCUTILS_RET_ERROR;
+  }
+
+  for (size_t i = 0; i < pool->max_size; i++) {
+    if (pool->impl->slots[i].is_constructed) {
+      deconstruct_slot(&pool->impl->slots[i]);
+    }
+  }
+  pool->allocator.deallocate(pool->impl->slots, pool->allocator.state);
+  pool->allocator.deallocate(pool->impl, pool->allocator.state);
+  *pool = rosidl_dynamic_typesupport_get_zero_initialized_dynamic_data_pool();
+  return RCUTILS_RET_OK;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_data_pool_acquire(
+  rosidl_dynamic_typesupport_dynamic_data_pool_t * pool,
+  rosidl_dynamic_typesupport_dynamic_data_t ** dynamic_data)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(pool, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(pool->impl, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(dynamic_data, RCUTILS_RET_INVALID_ARGUMENT);
+
+  rosidl_dynamic_typesupport_dynamic_data_pool_impl_t * impl = pool->impl;
+  dynamic_data_pool_slot_t * slot = pop_slot(impl);
+  if (slot != NULL) {
+    if (!slot->is_constructed) {
+      rcutils_ret_t ret = construct_slot(pool, slot);
+      if (ret != RCUTILS_RET_OK) {
+        push_slot(impl, (uint64_t) (slot - impl->slots));
+        return ret;
+      }
+    }
+    *dynamic_data = &slot->dynamic_data;
+  } else {
+    // Every slot is in use, so fall back to dynamic data of its own
+    rosidl_dynamic_typesupport_dynamic_data_t * overflow = pool->allocator.zero_allocate(
+      1, sizeof(rosidl_dynamic_typesupport_dynamic_data_t), pool->allocator.state);
+    if (overflow == NULL) {
+      RCUTILS_SET_ERROR_MSG("Could not allocate dynamic data past the dynamic data pool size");
+      return RCUTILS_RET_BAD_ALLOC;
+    }
+    rcutils_ret_t ret = rosidl_dynamic_typesupport_dynamic_data_init_from_dynamic_type(
+      pool->dynamic_type, &pool->allocator, overflow);
+    if (ret != RCUTILS_RET_OK) {
+      pool->allocator.deallocate(overflow, pool->allocator.state);
+      RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR(
+        "Could not construct dynamic data past the dynamic data pool size");
+      return ret;
+    }
+    rcutils_atomic_fetch_add_uint64_t(&impl->overflow_count, 1);
+    *dynamic_data = overflow;
+  }
+
+  uint64_t in_use_count = rcutils_atomic_fetch_add_uint64_t(&impl->in_use_count, 1) + 1;
+  uint64_t high_water_mark = rcutils_atomic_load_uint64_t(&impl->high_water_mark);
+  while (high_water_mark < in_use_count) {
+    bool is_raised = false;
+    rcutils_atomic_compare_exchange_strong(
+      &impl->high_water_mark, is_raised, &high_water_mark, in_use_count);
+    if (is_raised) {
+      break;
+    }
+  }
+  return RCUTILS_RET_OK;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_data_pool_release(
+  rosidl_dynamic_typesupport_dynamic_data_pool_t * pool,
+  rosidl_dynamic_typesupport_dynamic_data_t * dynamic_data)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(pool, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(pool->impl, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(dynamic_data, RCUTILS_RET_INVALID_ARGUMENT);
+
+  rosidl_dynamic_typesupport_dynamic_data_pool_impl_t * impl = pool->impl;
+  rcutils_ret_t ret = RCUTILS_RET_OK;
+
+  // Before the slot goes back, so the next acquire can't count it twice in the high-water mark
+  rcutils_atomic_fetch_add_uint64_t(&impl->in_use_count, UINT64_MAX);  // Decrement
+
+  // NOTE: Comparing addresses as integers, since dynamic data past the pool size
+  //       point outside of the slots
+  uintptr_t address = (uintptr_t) dynamic_data;
+  uintptr_t slots_begin = (uintptr_t) impl->slots;
+  uintptr_t slots_end = (uintptr_t) (impl->slots + pool->max_size);
+  if (address >= slots_begin && address < slots_end) {
+    dynamic_data_pool_slot_t * slot = (dynamic_data_pool_slot_t *) dynamic_data;
+    ret = rosidl_dynamic_typesupport_dynamic_data_clear_all_values(dynamic_data);
+    if (ret != RCUTILS_RET_OK) {
+      deconstruct_slot(slot);
+      RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR("Could not clear pooled dynamic data");
+    }
+    push_slot(impl, (uint64_t) (slot - impl->slots));
+  } else {
+    ret = rosidl_dynamic_typesupport_dynamic_data_destroy(dynamic_data);
+    if (ret != RCUTILS_RET_OK) {
+      RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR(
+        "Could not destroy dynamic data past the dynamic data pool size");
+    }
+  }
+  return ret;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_data_pool_get_stats(
+  const rosidl_dynamic_typesupport_dynamic_data_pool_t * pool,
+  rosidl_dynamic_typesupport_dynamic_data_pool_stats_t * stats)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(pool, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(pool->impl, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(stats, RCUTILS_RET_INVALID_ARGUMENT);
+
+  stats->in_use_count = (size_t) rcutils_atomic_load_uint64_t(&pool->impl->in_use_count);
+  stats->high_water_mark = (size_t) rcutils_atomic_load_uint64_t(&pool->impl->high_water_mark);
+  stats->constructed_count =
+    (size_t) rcutils_atomic_load_uint64_t(&pool->impl->constructed_count);
+  stats->overflow_count = (size_t) rcutils_atomic_load_uint64_t(&pool->impl->overflow_count);
+  return RCUTILS_RET_OK;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_data_pool_get_memory_usage(
+  const rosidl_dynamic_typesupport_dynamic_data_pool_t * pool,
+  rosidl_dynamic_typesupport_memory_usage_t * memory_usage)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(pool, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(pool->impl, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(memory_usage, RCUTILS_RET_INVALID_ARGUMENT);
+
+  memory_usage->library_bytes = sizeof(rosidl_dynamic_typesupport_dynamic_data_pool_impl_t) +
+    pool->max_size * sizeof(dynamic_data_pool_slot_t);
+  memory_usage->serialization_library_bytes = 0;
+  memory_usage->serialization_library_bytes_reported =
+    pool->dynamic_type->serialization_support->methods.dynamic_data_get_memory_usage != NULL;
+
+  for (size_t i = 0; i < pool->max_size; i++) {
+    if (!pool->impl->slots[i].is_constructed) {
+      continue;
+    }
+    rosidl_dynamic_typesupport_memory_usage_t slot_memory_usage;
+    rcutils_ret_t ret = rosidl_dynamic_typesupport_dynamic_data_get_memory_usage(
+      &pool->impl->slots[i].dynamic_data, &slot_memory_usage);
+    if (ret != RCUTILS_RET_OK) {
+      RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR(
+        "Could not get memory usage of pooled dynamic data");
+      return ret;
+    }
+    memory_usage->library_bytes += slot_memory_usage.library_bytes;
+    memory_usage->serialization_library_bytes += slot_memory_usage.serialization_library_bytes;
+  }
+  return RCUTILS_RET_OK;
+}
@@ -12,24 +12,378 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <stdint.h>
+#include <string.h>
+
 #include <rcutils/allocator.h>
 #include <rcutils/error_handling.h>
 #include <rcutils/logging_macros.h>
+#include <rcutils/stdatomic_helper.h>
+#include <rcutils/strdup.h>
+#include <rcutils/types/hash_map.h>
 #include <rcutils/types/rcutils_ret.h>
 #include <rosidl_runtime_c/message_type_support_struct.h>
 #include <rosidl_runtime_c/type_description/type_description__struct.h>
 #include <rosidl_runtime_c/type_description/type_description__functions.h>
 #include <rosidl_runtime_c/type_description/type_source__functions.h>
+#include <rosidl_runtime_c/type_hash.h>
 
 #include "rosidl_dynamic_typesupport/dynamic_message_type_support_struct.h"
+#include "rosidl_dynamic_typesupport/dynamic_type_registry.h"
 #include "rosidl_dynamic_typesupport/identifier.h"
+#include "rosidl_dynamic_typesupport/macros.h"
+#include "rosidl_dynamic_typesupport/type_plan.h"
 
-rcutils_ret_t
-rosidl_dynamic_message_type_support_handle_init(
-  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+#include "compact_type_description.h"
+#include "spin_lock.h"
+
+
+// SPARE DYNAMIC MESSAGES ==========================================================================
+// Guard the `dynamic_message`, `skip_dynamic_message`, and `dynamic_data_pool` members of impls,
+// which are the only ones still written to after initialization (besides the type plan of shared
+// impls, which shared_impls_lock guards)
+//
+// NOTE: Impls are spread over the locks by address, so handles of different types rarely wait on
+//       each other. Dynamic messages and pools are constructed outside the locks
+#define DYNAMIC_MESSAGES_LOCK_COUNT 64
+static atomic_bool dynamic_messages_locks[DYNAMIC_MESSAGES_LOCK_COUNT];
+
+
+static atomic_bool *
+get_dynamic_messages_lock(const rosidl_dynamic_message_type_support_impl_t * ts_impl)
+{
+  // Impls are hundreds of bytes large, so the low bits of their addresses barely differ
+  uintptr_t address = (uintptr_t) ts_impl;
+  return &dynamic_messages_locks[(address / 64) % DYNAMIC_MESSAGES_LOCK_COUNT];
+}
+
+
+static void
+lock_dynamic_messages(const rosidl_dynamic_message_type_support_impl_t * ts_impl)
+{
+  spin_lock_acquire(get_dynamic_messages_lock(ts_impl));
+}
+
+
+static void
+unlock_dynamic_messages(const rosidl_dynamic_message_type_support_impl_t * ts_impl)
+{
+  spin_lock_release(get_dynamic_messages_lock(ts_impl));
+}
+
+
+// SHARED TYPE SUPPORT IMPLS =======================================================================
+typedef struct shared_impl_key_s
+{
+  const char * serialization_library_identifier;
+  rosidl_type_hash_t type_hash;
+} shared_impl_key_t;
+
+typedef struct shared_impl_s
+{
+  // NOTE: This MUST be the first member, so the impls handed out as `ts->data` can be
+  //       mapped back to their shared impl on finalization
+  rosidl_dynamic_message_type_support_impl_t ts_impl;
+
+  // Owns its serialization_library_identifier string
+  shared_impl_key_t key;
+
+  // Guarded by shared_impls_lock
+  size_t ref_count;
+} shared_impl_t;
+
+
+// What `ts->data` of a handle sharing an impl points to. Only the type description, dynamic type,
+// and type plan are shared. The spare dynamic message, its skip flag, and the dynamic data pool
+// are mutable, so every handle keeps its own in `ts_impl`
+typedef struct shared_impl_view_s
+{
+  // NOTE: This MUST be the first member, so `ts->data` can be mapped back to the view
+  rosidl_dynamic_message_type_support_impl_t ts_impl;
+
+  // Reference to the shared impl `ts_impl` borrows its descriptions and dynamic type from
+  shared_impl_t * shared_impl;
+} shared_impl_view_t;
+
+
+// shared_impl_key_t -> shared_impl_t *
+// Lazily initialized on first insertion, and finalized again once it is empty
+static rcutils_hash_map_t shared_impls;
+static atomic_bool shared_impls_lock;
+
+
+// NOTE: Impls are built outside the lock
+static void
+lock_shared_impls(void)
+{
+  spin_lock_acquire(&shared_impls_lock);
+}
+
+
+static void
+unlock_shared_impls(void)
+{
+  spin_lock_release(&shared_impls_lock);
+}
+
+
+static size_t
+shared_impl_key_hash(const void * key)
+{
+  const shared_impl_key_t * shared_impl_key = (const shared_impl_key_t *) key;
+
+  // The type hash is already a cryptographic hash, so its leading bytes are as good as any
+  size_t hash = 0;
+  memcpy(&hash, shared_impl_key->type_hash.value, sizeof(hash));
+  hash ^= rcutils_hash_map_string_hash_func(&shared_impl_key->serialization_library_identifier);
+  return hash;
+}
+
+
+static int
+shared_impl_key_cmp(const void * key_a, const void * key_b)
+{
+  const shared_impl_key_t * a = (const shared_impl_key_t *) key_a;
+  const shared_impl_key_t * b = (const shared_impl_key_t *) key_b;
+
+  if (a->type_hash.version != b->type_hash.version) {
+    return a->type_hash.version < b->type_hash.version ? -1 : 1;
+  }
+  int cmp = memcmp(a->type_hash.value, b->type_hash.value, sizeof(a->type_hash.value));
+  if (cmp != 0) {
+    return cmp;
+  }
+  return strcmp(a->serialization_library_identifier, b->serialization_library_identifier);
+}
+
+
+static void
+shared_impl_destroy(shared_impl_t * shared_impl)
+{
+  rcutils_allocator_t allocator = shared_impl->ts_impl.allocator;
+
+  if (rosidl_dynamic_message_type_support_handle_impl_fini(&shared_impl->ts_impl) !=
+    RCUTILS_RET_OK)
+  {
+    RCUTILS_SAFE_FWRITE_TO_STDERR("Could not finalize shared dynamic message type support impl");
+  }
+  allocator.deallocate((char *) shared_impl->key.serialization_library_identifier, allocator.state);
+  allocator.deallocate(shared_impl, allocator.state);
+}
+
+
+// Drop a reference to a shared impl, and destroy it if it was the last one
+static rcutils_ret_t
+shared_impl_release(shared_impl_t * shared_impl)
+{
+  lock_shared_impls();
+  shared_impl->ref_count--;
+  if (shared_impl->ref_count > 0) {
+    unlock_shared_impls();
+    return RCUTILS_RET_OK;
+  }
+
+  rcutils_ret_t ret = rcutils_hash_map_unset(&shared_impls, &shared_impl->key);
+  if (ret != RCUTILS_RET_OK) {
+    shared_impl->ref_count++;
+    unlock_shared_impls();
+    RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR(
+      "Could not unshare dynamic message type support impl");
+    return ret;
+  }
+
+  size_t shared_impl_count = 0;
+  if (rcutils_hash_map_get_size(&shared_impls, &shared_impl_count) == RCUTILS_RET_OK &&
+    shared_impl_count == 0)
+  {
+    if (rcutils_hash_map_fini(&shared_impls) != RCUTILS_RET_OK) {
+      RCUTILS_SAFE_FWRITE_TO_STDERR("Could not finalize shared dynamic message type support impls");
+    }
+    shared_impls = rcutils_get_zero_initialized_hash_map();
+  }
+  unlock_shared_impls();
+
+  shared_impl_destroy(shared_impl);
+  return RCUTILS_RET_OK;
+}
+
+
+// Give a handle its own view of a shared impl it holds a reference to, which the view takes over.
+// The reference is released if this fails
+static rcutils_ret_t
+shared_impl_view_init(
+  shared_impl_t * shared_impl,
+  rcutils_allocator_t * allocator,
+  rosidl_message_type_support_t * ts)
+{
+  shared_impl_view_t * view = allocator->zero_allocate(
+    1, sizeof(shared_impl_view_t), allocator->state);
+  if (view == NULL) {
+    if (shared_impl_release(shared_impl) != RCUTILS_RET_OK) {
+      rcutils_reset_error();
+    }
+    RCUTILS_SET_ERROR_MSG("Could not allocate shared dynamic message type support impl view");
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+
+  // Borrowed from the shared impl. The view never finalizes them
+  const rosidl_dynamic_message_type_support_impl_t * shared_ts_impl = &shared_impl->ts_impl;
+  view->ts_impl.allocator = *allocator;
+  view->ts_impl.type_hash = shared_ts_impl->type_hash;
+  view->ts_impl.type_description = shared_ts_impl->type_description;
+  view->ts_impl.type_description_sources = shared_ts_impl->type_description_sources;
+  view->ts_impl.serialization_support = shared_ts_impl->serialization_support;
+  view->ts_impl.dynamic_message_type = shared_ts_impl->dynamic_message_type;
+  view->ts_impl.is_shared = true;
+  view->shared_impl = shared_impl;
+
+  ts->data = &view->ts_impl;
+  return RCUTILS_RET_OK;
+}
+
+
+// Finalize the handle's own members of a view, then release the shared impl it borrows from
+static rcutils_ret_t
+shared_impl_view_fini(shared_impl_view_t * view)
+{
+  rosidl_dynamic_message_type_support_impl_t * ts_impl = &view->ts_impl;
+  rcutils_allocator_t allocator = ts_impl->allocator;
+
+  if (ts_impl->dynamic_data_pool) {
+    rcutils_ret_t ret = rosidl_dynamic_typesupport_dynamic_data_pool_fini(
+      ts_impl->dynamic_data_pool);
+    if (ret != RCUTILS_RET_OK) {
+      RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR(
+        "Could not finalize dynamic data pool of dynamic message type support");
+      return ret;
+    }
+    allocator.deallocate(ts_impl->dynamic_data_pool, allocator.state);
+    ts_impl->dynamic_data_pool = NULL;
+  }
+  if (ts_impl->dynamic_message) {
+    rosidl_dynamic_typesupport_dynamic_data_destroy(ts_impl->dynamic_message);
+    ts_impl->dynamic_message = NULL;
+  }
+
+  rcutils_ret_t ret = shared_impl_release(view->shared_impl);
+  allocator.deallocate(view, allocator.state);
+  return ret;
+}
+
+
+// The impl that owns the type plan of a handle impl, which is the shared impl for views
+static rosidl_dynamic_message_type_support_impl_t *
+get_type_plan_owner(rosidl_dynamic_message_type_support_impl_t * ts_impl)
+{
+  if (ts_impl->is_shared) {
+    return &((shared_impl_view_t *) ts_impl)->shared_impl->ts_impl;
+  }
+  return ts_impl;
+}
+
+
+static void
+set_handle_functions(rosidl_message_type_support_t * ts)
+{
+  ts->typesupport_identifier = rosidl_dynamic_typesupport_c__identifier;
+  ts->func = get_message_typesupport_handle_function;
+  ts->get_type_hash_func =
+    rosidl_get_dynamic_message_type_support_type_hash_function;
+  ts->get_type_description_func =
+    rosidl_get_dynamic_message_type_support_type_description_function;
+  ts->get_type_description_sources_func =
+    rosidl_get_dynamic_message_type_support_type_description_sources_function;
+}
+
+
+// HANDLES =========================================================================================
+// How a handle impl gets its own type description and sources
+typedef enum description_storage_e
+{
+  // Packed into an allocation of its own (see compact_type_description.h)
+  DESCRIPTION_STORAGE_COPY,
+  // Moved in from the caller
+  DESCRIPTION_STORAGE_ADOPT,
+  // Packed into the same allocation as the impl (see `get_compact_layout()`)
+  DESCRIPTION_STORAGE_COMPACT,
+} description_storage_t;
+
+// Layout of the single allocation of a compact handle: the impl, then its dynamic type (unless it
+// is shared through the registry), then its packed type description and sources
+typedef struct compact_layout_s
+{
+  // 0 if the dynamic type is shared through the registry
+  size_t dynamic_type_offset;
+  size_t description_offset;
+  size_t size;
+} compact_layout_t;
+
+
+static size_t
+align_up(size_t offset, size_t alignment)
+{
+  return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+
+static compact_layout_t
+get_compact_layout(
   const rosidl_type_hash_t * type_hash,
   const rosidl_runtime_c__type_description__TypeDescription * type_description,
-  const rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources,
+  const rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources)
+{
+  compact_layout_t layout;
+  size_t offset = sizeof(rosidl_dynamic_message_type_support_impl_t);
+  layout.dynamic_type_offset = 0;
+  if (type_hash->version == ROSIDL_TYPE_HASH_VERSION_UNSET) {
+    layout.dynamic_type_offset =
+      align_up(offset, _Alignof(rosidl_dynamic_typesupport_dynamic_type_t));
+    offset = layout.dynamic_type_offset + sizeof(rosidl_dynamic_typesupport_dynamic_type_t);
+  }
+  layout.description_offset = align_up(offset, COMPACT_TYPE_DESCRIPTION_ALIGNMENT);
+  layout.size = layout.description_offset +
+    compact_type_description_get_size(type_description, type_description_sources);
+  return layout;
+}
+
+
+// Handles own the serialization support they are given once their arguments are checked, so it
+// is finalized if they fail to initialize before they could move it in
+static void
+serialization_support_discard(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support)
+{
+  if (rosidl_dynamic_typesupport_serialization_support_fini(serialization_support) !=
+    RCUTILS_RET_OK)
+  {
+    RCUTILS_SAFE_FWRITE_TO_STDERR("Could not finalize serialization support of failed handle");
+    rcutils_reset_error();
+  }
+  *serialization_support = rosidl_dynamic_typesupport_get_zero_initialized_serialization_support();
+}
+
+
+// Descriptions are only read from unless they are adopted. `compact_layout` must be set (and
+// `ts_impl` be at the start of an allocation laid out like it) if, and only if, they are compact
+static rcutils_ret_t
+handle_impl_init(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_type_hash_t * type_hash,
+  rosidl_runtime_c__type_description__TypeDescription * type_description,
+  rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources,
+  description_storage_t description_storage,
+  const compact_layout_t * compact_layout,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_message_type_support_impl_t * ts_impl);
+
+
+static rcutils_ret_t
+handle_init(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_type_hash_t * type_hash,
+  rosidl_runtime_c__type_description__TypeDescription * type_description,
+  rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources,
+  description_storage_t description_storage,
   rcutils_allocator_t * allocator,
   rosidl_message_type_support_t * ts)
 {
@@ -48,29 +402,33 @@ rosidl_dynamic_message_type_support_handle_init(
 
   rcutils_ret_t ret = RCUTILS_RET_ERROR;
 
-  ts->typesupport_identifier = rosidl_dynamic_typesupport_c__identifier;
-  ts->func = get_message_typesupport_handle_function;
-  ts->get_type_hash_func =
-    rosidl_get_dynamic_message_type_support_type_hash_function;
-  ts->get_type_description_func =
-    rosidl_get_dynamic_message_type_support_type_description_function;
-  ts->get_type_description_sources_func =
-    rosidl_get_dynamic_message_type_support_type_description_sources_function;
+  set_handle_functions(ts);
 
-  ts->data = allocator->zero_allocate(
-    1, sizeof(rosidl_dynamic_message_type_support_impl_t), allocator->state);
-  if (!ts) {
+  compact_layout_t compact_layout;
+  rosidl_dynamic_message_type_support_impl_t * ts_impl = NULL;
+  if (description_storage == DESCRIPTION_STORAGE_COMPACT) {
+    compact_layout = get_compact_layout(type_hash, type_description, type_description_sources);
+    ts_impl = allocator->allocate(compact_layout.size, allocator->state);
+    if (ts_impl != NULL) {
+      // The packed description is written over anyway
+      memset(ts_impl, 0, compact_layout.description_offset);
+    }
+  } else {
+    ts_impl = allocator->zero_allocate(
+      1, sizeof(rosidl_dynamic_message_type_support_impl_t), allocator->state);
+  }
+  if (ts_impl == NULL) {
+    serialization_support_discard(serialization_support);
     RCUTILS_SET_ERROR_MSG("Could not allocate dynamic message type support impl");
-    ret = RCUTILS_RET_BAD_ALLOC;
-    goto fail;
+    return RCUTILS_RET_BAD_ALLOC;
   }
+  ts->data = ts_impl;
 
-  rosidl_dynamic_message_type_support_impl_t * ts_impl =
-    (rosidl_dynamic_message_type_support_impl_t *) ts->data;
-
-  ret = rosidl_dynamic_message_type_support_handle_impl_init(
-    serialization_support, type_hash, type_description, type_description_sources, allocator,
-    ts_impl);
+  ret = handle_impl_init(
+    serialization_support, type_hash, type_description, type_description_sources,
+    description_storage,
+    description_storage == DESCRIPTION_STORAGE_COMPACT ? &compact_layout : NULL,
+    allocator, ts_impl);
   if (ret != RCUTILS_RET_OK)
   {
     RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR("Could not init dynamic message type support impl");
@@ -87,6 +445,171 @@ fail:
   return ret;
 }
 
+rcutils_ret_t
+rosidl_dynamic_message_type_support_handle_init(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_type_hash_t * type_hash,
+  const rosidl_runtime_c__type_description__TypeDescription * type_description,
+  const rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources,
+  rcutils_allocator_t * allocator,
+  rosidl_message_type_support_t * ts)
+{
+  // NOTE: Casting away the const is fine, descriptions are only packed from here
+  return handle_init(
+    serialization_support, type_hash,
+    (rosidl_runtime_c__type_description__TypeDescription *) type_description,
+    (rosidl_runtime_c__type_description__TypeSource__Sequence *) type_description_sources,
+    DESCRIPTION_STORAGE_COPY, allocator, ts);
+}
+
+rcutils_ret_t
+rosidl_dynamic_message_type_support_handle_init_adopt(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_type_hash_t * type_hash,
+  rosidl_runtime_c__type_description__TypeDescription * type_description,
+  rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources,
+  rcutils_allocator_t * allocator,
+  rosidl_message_type_support_t * ts)
+{
+  return handle_init(
+    serialization_support, type_hash, type_description, type_description_sources,
+    DESCRIPTION_STORAGE_ADOPT, allocator, ts);
+}
+
+rcutils_ret_t
+rosidl_dynamic_message_type_support_handle_init_compact(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_type_hash_t * type_hash,
+  const rosidl_runtime_c__type_description__TypeDescription * type_description,
+  const rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources,
+  rcutils_allocator_t * allocator,
+  rosidl_message_type_support_t * ts)
+{
+  // NOTE: Casting away the const is fine, descriptions are only packed from here
+  return handle_init(
+    serialization_support, type_hash,
+    (rosidl_runtime_c__type_description__TypeDescription *) type_description,
+    (rosidl_runtime_c__type_description__TypeSource__Sequence *) type_description_sources,
+    DESCRIPTION_STORAGE_COMPACT, allocator, ts);
+}
+
+rcutils_ret_t
+rosidl_dynamic_message_type_support_handle_init_shared(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_type_hash_t * type_hash,
+  const rosidl_runtime_c__type_description__TypeDescription * type_description,
+  const rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources,
+  rcutils_allocator_t * allocator,
+  rosidl_message_type_support_t * ts)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(serialization_support, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(type_hash, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(type_description, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(allocator, RCUTILS_RET_INVALID_ARGUMENT);
+  if (!rcutils_allocator_is_valid(allocator)) {
+    RCUTILS_SET_ERROR_MSG("allocator is invalid");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(ts, RCUTILS_RET_INVALID_ARGUMENT);
+
+  if (type_hash->version == ROSIDL_TYPE_HASH_VERSION_UNSET) {
+    RCUTILS_SET_ERROR_MSG("Type hash must be set to share dynamic message type support impls");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+
+  const char * serialization_library_identifier =
+    rosidl_dynamic_typesupport_serialization_support_get_library_identifier(serialization_support);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(serialization_library_identifier, RCUTILS_RET_INVALID_ARGUMENT);
+
+  shared_impl_key_t key;
+  key.serialization_library_identifier = serialization_library_identifier;
+  key.type_hash = *type_hash;
+
+  set_handle_functions(ts);
+
+  // Fast path: another handle already built it
+  shared_impl_t * shared_impl = NULL;
+  lock_shared_impls();
+  if (shared_impls.impl != NULL &&
+    rcutils_hash_map_get(&shared_impls, &key, &shared_impl) == RCUTILS_RET_OK)
+  {
+    shared_impl->ref_count++;
+    unlock_shared_impls();
+
+    // The handle owns the serialization support it was given, but the shared impl has its own
+    serialization_support_discard(serialization_support);
+    return shared_impl_view_init(shared_impl, allocator, ts);
+  }
+  unlock_shared_impls();
+
+  // Slow path: build the impl outside of the lock, since this is the expensive part
+  shared_impl_t * new_shared_impl = allocator->zero_allocate(
+    1, sizeof(shared_impl_t), allocator->state);
+  if (new_shared_impl == NULL) {
+    serialization_support_discard(serialization_support);
+    RCUTILS_SET_ERROR_MSG("Could not allocate shared dynamic message type support impl");
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  new_shared_impl->ref_count = 1;
+  new_shared_impl->key.type_hash = *type_hash;
+  new_shared_impl->key.serialization_library_identifier =
+    rcutils_strdup(serialization_library_identifier, *allocator);
+  if (new_shared_impl->key.serialization_library_identifier == NULL) {
+    allocator->deallocate(new_shared_impl, allocator->state);
+    serialization_support_discard(serialization_support);
+    RCUTILS_SET_ERROR_MSG("Could not copy serialization library identifier");
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+
+  rcutils_ret_t ret = rosidl_dynamic_message_type_support_handle_impl_init(
+    serialization_support, type_hash, type_description, type_description_sources, allocator,
+    &new_shared_impl->ts_impl);
+  if (ret != RCUTILS_RET_OK) {
+    // The impl is already finalized on failure, along with the serialization support
+    allocator->deallocate(
+      (char *) new_shared_impl->key.serialization_library_identifier, allocator->state);
+    allocator->deallocate(new_shared_impl, allocator->state);
+    RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR(
+      "Could not init shared dynamic message type support impl");
+    return ret;
+  }
+
+  lock_shared_impls();
+  if (shared_impls.impl == NULL) {
+    rcutils_allocator_t shared_impls_allocator = rcutils_get_default_allocator();
+    ret = rcutils_hash_map_init(
+      &shared_impls, 16, sizeof(shared_impl_key_t), sizeof(shared_impl_t *),
+      shared_impl_key_hash, shared_impl_key_cmp, &shared_impls_allocator);
+    if (ret != RCUTILS_RET_OK) {
+      unlock_shared_impls();
+      shared_impl_destroy(new_shared_impl);
+      RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR(
+        "Could not initialize shared dynamic message type support impls");
+      return ret;
+    }
+  }
+
+  // Someone else might have built and shared the same impl while we were building ours. Ours owns
+  // the serialization support, so it goes with it
+  if (rcutils_hash_map_get(&shared_impls, &key, &shared_impl) == RCUTILS_RET_OK) {
+    shared_impl->ref_count++;
+    unlock_shared_impls();
+    shared_impl_destroy(new_shared_impl);
+    return shared_impl_view_init(shared_impl, allocator, ts);
+  }
+
+  ret = rcutils_hash_map_set(&shared_impls, &new_shared_impl->key, &new_shared_impl);
+  unlock_shared_impls();
+  if (ret != RCUTILS_RET_OK) {
+    shared_impl_destroy(new_shared_impl);
+    RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR(
+      "Could not share dynamic message type support impl");
+    return ret;
+  }
+
+  return shared_impl_view_init(new_shared_impl, allocator, ts);
+}
+
 rcutils_ret_t
 rosidl_dynamic_message_type_support_handle_fini(rosidl_message_type_support_t * ts)
 {
@@ -100,6 +623,9 @@ rosidl_dynamic_message_type_support_handle_fini(rosidl_message_type_support_t *
   // NOTE(methylDragon): Ignores const...
   rosidl_dynamic_message_type_support_impl_t * ts_impl =
     (rosidl_dynamic_message_type_support_impl_t *)ts->data;
+  if (ts_impl->is_shared) {
+    return shared_impl_view_fini((shared_impl_view_t *) ts_impl);
+  }
   rcutils_allocator_t allocator = ts_impl->allocator;
 
   rcutils_ret_t ret = rosidl_dynamic_message_type_support_handle_impl_fini(ts_impl);
@@ -113,12 +639,14 @@ rosidl_dynamic_message_type_support_handle_fini(rosidl_message_type_support_t *
   return RCUTILS_RET_OK;
 }
 
-rcutils_ret_t
-rosidl_dynamic_message_type_support_handle_impl_init(
+static rcutils_ret_t
+handle_impl_init(
   rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
   const rosidl_type_hash_t * type_hash,
-  const rosidl_runtime_c__type_description__TypeDescription * type_description,
-  const rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources,
+  rosidl_runtime_c__type_description__TypeDescription * type_description,
+  rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources,
+  description_storage_t description_storage,
+  const compact_layout_t * compact_layout,
   rcutils_allocator_t * allocator,
   rosidl_dynamic_message_type_support_impl_t * ts_impl)
 {
@@ -140,83 +668,134 @@ rosidl_dynamic_message_type_support_handle_impl_init(
   // allocator
   ts_impl->allocator = *allocator;
 
+  // shared_serialization_support and dynamic_message_type (set below)
+  ts_impl->shared_serialization_support = NULL;
+  ts_impl->dynamic_message_type = NULL;
+
+  // dynamic_message (constructed on request)
+  ts_impl->dynamic_message = NULL;
+  ts_impl->skip_dynamic_message = false;
+
+  // dynamic_data_pool (initialized on request)
+  ts_impl->dynamic_data_pool = NULL;
+
+  // type_plan (built on request)
+  ts_impl->type_plan = NULL;
+
+  // is_shared (only set for views of shared impls, which are not initialized here)
+  ts_impl->is_shared = false;
+
+  // is_compact
+  ts_impl->is_compact = description_storage == DESCRIPTION_STORAGE_COMPACT;
+
+  // type_description_storage (only allocated for copied descriptions)
+  ts_impl->type_description_storage = NULL;
+
+  // type_description and type_description_sources (set below)
+  memset(&ts_impl->type_description, 0, sizeof(ts_impl->type_description));
+  memset(&ts_impl->type_description_sources, 0, sizeof(ts_impl->type_description_sources));
+  bool description_adopted = false;
+
   // type_hash
   ts_impl->type_hash.version = type_hash->version;
   memcpy(ts_impl->type_hash.value, type_hash->value, sizeof(type_hash->value));
 
-  // type_description
-  if (!rosidl_runtime_c__type_description__TypeDescription__init(&ts_impl->type_description)) {
-    RCUTILS_SET_ERROR_MSG("Could not init type description");
-    ret = RCUTILS_RET_NOT_INITIALIZED;
-    goto fail;
-  }
-  if (!rosidl_runtime_c__type_description__TypeDescription__copy(
-      type_description, &ts_impl->type_description))
-  {
-    RCUTILS_SET_ERROR_MSG("Could not copy type description");
-    ret = RCUTILS_RET_ERROR;
+  // serialization_support (moved into a shared one, so registry entries can hold on to it)
+  // NOTE: This goes before anything else that can fail, so that the impl owns it from here on, and
+  //       finalizes it along with itself on failure
+  rosidl_dynamic_typesupport_serialization_support_t moved_serialization_support =
+    *serialization_support;
+  ret = rosidl_dynamic_typesupport_serialization_support_init_shared(
+    &moved_serialization_support, allocator, &ts_impl->shared_serialization_support);
+  if (ret != RCUTILS_RET_OK) {
+    serialization_support_discard(serialization_support);
+    RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR(
+      "Could not share serialization support of dynamic message type support");
     goto fail;
   }
+  ts_impl->serialization_support = *ts_impl->shared_serialization_support;
 
-  // type_description_sources
-  if (!rosidl_runtime_c__type_description__TypeSource__Sequence__init(
-      &ts_impl->type_description_sources, 0))
-  {
-    RCUTILS_SET_ERROR_MSG("Could not init type description sources");
-    ret = RCUTILS_RET_NOT_INITIALIZED;
-    goto fail;
-  }
-  if (type_description_sources != NULL) {
-    if (!rosidl_runtime_c__type_description__TypeSource__Sequence__copy(
-        type_description_sources, &ts_impl->type_description_sources))
-    {
-      RCUTILS_SET_ERROR_MSG("Could not copy type description sources");
-      ret = RCUTILS_RET_ERROR;
+  // type_description and type_description_sources
+  if (description_storage == DESCRIPTION_STORAGE_COMPACT) {
+    compact_type_description_pack(
+      type_description, type_description_sources,
+      (uint8_t *) ts_impl + compact_layout->description_offset,
+      &ts_impl->type_description, &ts_impl->type_description_sources);
+  } else if (description_storage == DESCRIPTION_STORAGE_ADOPT) {
+    // NOTE: Adopted descriptions are moved in, and the caller's structs are left zero
+    //       initialized, which is still a valid (empty) state to finalize them from
+    ts_impl->type_description = *type_description;
+    memset(type_description, 0, sizeof(*type_description));
+    if (type_description_sources != NULL) {
+      ts_impl->type_description_sources = *type_description_sources;
+      memset(type_description_sources, 0, sizeof(*type_description_sources));
+    }
+    description_adopted = true;
+  } else {
+    // NOTE: Packing the copy into one block takes one allocation instead of several
+    //       per field, and keeps the whole description together in memory
+    ts_impl->type_description_storage = allocator->allocate(
+      compact_type_description_get_size(type_description, type_description_sources),
+      allocator->state);
+    if (ts_impl->type_description_storage == NULL) {
+      RCUTILS_SET_ERROR_MSG("Could not allocate type description storage");
+      ret = RCUTILS_RET_BAD_ALLOC;
       goto fail;
     }
-  }
-
-  ts_impl->serialization_support = *serialization_support;
-
-  ts_impl->dynamic_message_type = allocator->zero_allocate(
-    1, sizeof(rosidl_dynamic_typesupport_dynamic_type_t), allocator->state);
-  if (ts_impl->dynamic_message_type == NULL) {
-    RCUTILS_SET_ERROR_MSG(
-      "Could not allocate dynamic type for rosidl_dynamic_message_type_support_impl_t struct");
-    ret = RCUTILS_RET_BAD_ALLOC;
-    goto fail;
-  }
-
-  ts_impl->dynamic_message = allocator->zero_allocate(
-    1, sizeof(rosidl_dynamic_typesupport_dynamic_data_t), allocator->state);
-  if (ts_impl->dynamic_message == NULL) {
-    RCUTILS_SET_ERROR_MSG(
-      "Could not allocate dynamic data for rosidl_dynamic_message_type_support_impl_t struct");
-    ret = RCUTILS_RET_BAD_ALLOC;
-    goto fail;
+    compact_type_description_pack(
+      type_description, type_description_sources, ts_impl->type_description_storage,
+      &ts_impl->type_description, &ts_impl->type_description_sources);
   }
 
   // dynamic_message_type
-  ret = rosidl_dynamic_typesupport_dynamic_type_init_from_description(
-    &ts_impl->serialization_support, type_description, allocator, ts_impl->dynamic_message_type);
-  if (ret != RCUTILS_RET_OK) {
-    RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR(
-      "Could not construct dynamic type for rosidl_dynamic_message_type_support_impl_t struct");
-    goto fail;
+  if (type_hash->version == ROSIDL_TYPE_HASH_VERSION_UNSET) {
+    // Without a type hash there is no telling whether the type was built before, so build it here
+    if (description_storage == DESCRIPTION_STORAGE_COMPACT) {
+      ts_impl->dynamic_message_type = (rosidl_dynamic_typesupport_dynamic_type_t *)
+        ((uint8_t *) ts_impl + compact_layout->dynamic_type_offset);
+    } else {
+      ts_impl->dynamic_message_type = allocator->zero_allocate(
+        1, sizeof(rosidl_dynamic_typesupport_dynamic_type_t), allocator->state);
+    }
+    if (ts_impl->dynamic_message_type == NULL) {
+      RCUTILS_SET_ERROR_MSG(
+        "Could not allocate dynamic type for rosidl_dynamic_message_type_support_impl_t struct");
+      ret = RCUTILS_RET_BAD_ALLOC;
+      goto fail;
+    }
+    ret = rosidl_dynamic_typesupport_dynamic_type_init_from_description(
+      ts_impl->shared_serialization_support, &ts_impl->type_description, allocator,
+      ts_impl->dynamic_message_type);
+    if (ret != RCUTILS_RET_OK) {
+      if (description_storage != DESCRIPTION_STORAGE_COMPACT) {
+        allocator->deallocate(ts_impl->dynamic_message_type, allocator->state);
+      }
+      ts_impl->dynamic_message_type = NULL;
+    }
+  } else {
+    // Share the dynamic type with every other handle for the same type in this process
+    ret = rosidl_dynamic_typesupport_dynamic_type_registry_acquire(
+      ts_impl->shared_serialization_support, type_hash, &ts_impl->type_description, allocator,
+      &ts_impl->dynamic_message_type);
   }
-
-  // dynamic_message
-  ret = rosidl_dynamic_typesupport_dynamic_data_init_from_dynamic_type(
-    ts_impl->dynamic_message_type, allocator, ts_impl->dynamic_message);
   if (ret != RCUTILS_RET_OK) {
     RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR(
-      "Could not construct dynamic data for rosidl_dynamic_message_type_support_impl_t struct");
+      "Could not construct dynamic type for rosidl_dynamic_message_type_support_impl_t struct");
     goto fail;
   }
 
   return RCUTILS_RET_OK;
 
 fail:
+  // Give adopted descriptions back, so the caller is left with what it passed in
+  if (description_adopted) {
+    *type_description = ts_impl->type_description;
+    memset(&ts_impl->type_description, 0, sizeof(ts_impl->type_description));
+    if (type_description_sources != NULL) {
+      *type_description_sources = ts_impl->type_description_sources;
+    }
+    memset(&ts_impl->type_description_sources, 0, sizeof(ts_impl->type_description_sources));
+  }
   if (rosidl_dynamic_message_type_support_handle_impl_fini(ts_impl) != RCUTILS_RET_OK) {
     RCUTILS_SAFE_FWRITE_TO_STDERR(
       "While handling another error, could not finalize dynamic message type support handle impl");
@@ -224,24 +803,403 @@ fail:
   return ret;
 }
 
+rcutils_ret_t
+rosidl_dynamic_message_type_support_handle_impl_init(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_type_hash_t * type_hash,
+  const rosidl_runtime_c__type_description__TypeDescription * type_description,
+  const rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_message_type_support_impl_t * ts_impl)
+{
+  // NOTE: Casting away the const is fine, descriptions are only packed from here
+  return handle_impl_init(
+    serialization_support, type_hash,
+    (rosidl_runtime_c__type_description__TypeDescription *) type_description,
+    (rosidl_runtime_c__type_description__TypeSource__Sequence *) type_description_sources,
+    DESCRIPTION_STORAGE_COPY, NULL, allocator, ts_impl);
+}
+
+rcutils_ret_t
+rosidl_dynamic_message_type_support_handle_impl_init_adopt(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_type_hash_t * type_hash,
+  rosidl_runtime_c__type_description__TypeDescription * type_description,
+  rosidl_runtime_c__type_description__TypeSource__Sequence * type_description_sources,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_message_type_support_impl_t * ts_impl)
+{
+  return handle_impl_init(
+    serialization_support, type_hash, type_description, type_description_sources,
+    DESCRIPTION_STORAGE_ADOPT, NULL, allocator, ts_impl);
+}
+
 rcutils_ret_t
 rosidl_dynamic_message_type_support_handle_impl_fini(
   rosidl_dynamic_message_type_support_impl_t * ts_impl)
 {
   RCUTILS_CHECK_ARGUMENT_FOR_NULL(ts_impl, RCUTILS_RET_INVALID_ARGUMENT);
 
-  rosidl_dynamic_typesupport_serialization_support_fini(&ts_impl->serialization_support);
-
-  rosidl_runtime_c__type_description__TypeDescription__fini(&ts_impl->type_description);
-  rosidl_runtime_c__type_description__TypeSource__Sequence__fini(
-    &ts_impl->type_description_sources);
-  if (ts_impl->dynamic_message_type) {
-    rosidl_dynamic_typesupport_dynamic_type_fini(ts_impl->dynamic_message_type);
+  // NOTE: The dynamic data and type go first, since finalizing them (or the last
+  //       registry reference to the type) still needs the serialization support
+  if (ts_impl->dynamic_data_pool) {
+    rcutils_ret_t ret = rosidl_dynamic_typesupport_dynamic_data_pool_fini(
+      ts_impl->dynamic_data_pool);
+    if (ret != RCUTILS_RET_OK) {
+      RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR(
+        "Could not finalize dynamic data pool of dynamic message type support");
+      return ret;
+    }
+    ts_impl->allocator.deallocate(ts_impl->dynamic_data_pool, ts_impl->allocator.state);
+    ts_impl->dynamic_data_pool = NULL;
   }
   if (ts_impl->dynamic_message) {
-    rosidl_dynamic_typesupport_dynamic_data_fini(ts_impl->dynamic_message);
+    rosidl_dynamic_typesupport_dynamic_data_destroy(ts_impl->dynamic_message);
+    ts_impl->dynamic_message = NULL;
+  }
+  if (ts_impl->dynamic_message_type) {
+    if (ts_impl->type_hash.version == ROSIDL_TYPE_HASH_VERSION_UNSET && ts_impl->is_compact) {
+      rosidl_dynamic_typesupport_dynamic_type_fini(ts_impl->dynamic_message_type);
+    } else if (ts_impl->type_hash.version == ROSIDL_TYPE_HASH_VERSION_UNSET) {
+      rosidl_dynamic_typesupport_dynamic_type_destroy(ts_impl->dynamic_message_type);
+    } else {
+      rosidl_dynamic_typesupport_dynamic_type_registry_release(ts_impl->dynamic_message_type);
+    }
+    ts_impl->dynamic_message_type = NULL;
+  }
+
+  if (ts_impl->type_plan) {
+    rosidl_dynamic_typesupport_type_plan_fini(ts_impl->type_plan);
+    ts_impl->allocator.deallocate(ts_impl->type_plan, ts_impl->allocator.state);
+    ts_impl->type_plan = NULL;
+  }
+
+  // Packed descriptions go along with the allocation they are packed into. Only adopted ones are
+  // owned by rosidl_runtime_c
+  if (ts_impl->type_description_storage != NULL) {
+    ts_impl->allocator.deallocate(ts_impl->type_description_storage, ts_impl->allocator.state);
+    ts_impl->type_description_storage = NULL;
+  } else if (!ts_impl->is_compact) {
+    rosidl_runtime_c__type_description__TypeDescription__fini(&ts_impl->type_description);
+    rosidl_runtime_c__type_description__TypeSource__Sequence__fini(
+      &ts_impl->type_description_sources);
+  }
+  memset(&ts_impl->type_description, 0, sizeof(ts_impl->type_description));
+  memset(&ts_impl->type_description_sources, 0, sizeof(ts_impl->type_description_sources));
+
+  // Registry entries hold their own references, so this only finalizes the serialization support
+  // if none of them still need it
+  if (ts_impl->shared_serialization_support != NULL) {
+    rcutils_ret_t ret = rosidl_dynamic_typesupport_serialization_support_release(
+      ts_impl->shared_serialization_support);
+    if (ret != RCUTILS_RET_OK) {
+      RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR(
+        "Could not release serialization support of dynamic message type support");
+      return ret;
+    }
+    ts_impl->shared_serialization_support = NULL;
+  }
+  ts_impl->serialization_support =
+    rosidl_dynamic_typesupport_get_zero_initialized_serialization_support();
+
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+rosidl_dynamic_message_type_support_handle_init_type_plan(rosidl_message_type_support_t * ts)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(ts, RCUTILS_RET_INVALID_ARGUMENT);
+
+  if (ts->typesupport_identifier != rosidl_dynamic_typesupport_c__identifier) {
+    RCUTILS_SET_ERROR_MSG("Type support not from this implementation");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+
+  rosidl_dynamic_message_type_support_impl_t * handle_ts_impl =
+    (rosidl_dynamic_message_type_support_impl_t *)ts->data;
+  bool is_shared = handle_ts_impl->is_shared;
+  rosidl_dynamic_message_type_support_impl_t * ts_impl = get_type_plan_owner(handle_ts_impl);
+  if (is_shared) {
+    lock_shared_impls();
+  }
+  bool is_built = ts_impl->type_plan != NULL;
+  if (is_shared) {
+    unlock_shared_impls();
+  }
+  if (is_built) {
+    return RCUTILS_RET_OK;
+  }
+
+  rcutils_allocator_t * allocator = &ts_impl->allocator;
+  rosidl_dynamic_typesupport_type_plan_t * type_plan = allocator->zero_allocate(
+    1, sizeof(rosidl_dynamic_typesupport_type_plan_t), allocator->state);
+  if (type_plan == NULL) {
+    RCUTILS_SET_ERROR_MSG("Could not allocate type plan for dynamic message type support");
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+
+  rcutils_ret_t ret = rosidl_dynamic_typesupport_type_plan_init(
+    &ts_impl->type_description, allocator, type_plan);
+  if (ret != RCUTILS_RET_OK) {
+    allocator->deallocate(type_plan, allocator->state);
+    RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR(
+      "Could not build type plan for dynamic message type support");
+    return ret;
+  }
+
+  // Another handle sharing the impl might have built it in the meantime, in which case ours goes
+  if (is_shared) {
+    lock_shared_impls();
+    if (ts_impl->type_plan == NULL) {
+      ts_impl->type_plan = type_plan;
+      type_plan = NULL;
+    }
+    unlock_shared_impls();
+    if (type_plan != NULL) {
+      rosidl_dynamic_typesupport_type_plan_fini(type_plan);
+      allocator->deallocate(type_plan, allocator->state);
+    }
+    return RCUTILS_RET_OK;
+  }
+
+  ts_impl->type_plan = type_plan;
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+rosidl_dynamic_message_type_support_handle_get_dynamic_message(
+  const rosidl_message_type_support_t * ts,
+  rosidl_dynamic_typesupport_dynamic_data_t ** dynamic_message)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(ts, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(dynamic_message, RCUTILS_RET_INVALID_ARGUMENT);
+
+  if (ts->typesupport_identifier != rosidl_dynamic_typesupport_c__identifier) {
+    RCUTILS_SET_ERROR_MSG("Type support not from this implementation");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+
+  rosidl_dynamic_message_type_support_impl_t * ts_impl =
+    (rosidl_dynamic_message_type_support_impl_t *)ts->data;
+  lock_dynamic_messages(ts_impl);
+  *dynamic_message = ts_impl->dynamic_message;
+  bool is_skipped = ts_impl->skip_dynamic_message;
+  unlock_dynamic_messages(ts_impl);
+  if (*dynamic_message != NULL) {
+    return RCUTILS_RET_OK;
+  }
+  if (is_skipped) {
+    RCUTILS_SET_ERROR_MSG("Dynamic message was skipped for this dynamic message type support");
+    return RCUTILS_RET_ERROR;
+  }
+
+  rcutils_allocator_t * allocator = &ts_impl->allocator;
+  rosidl_dynamic_typesupport_dynamic_data_t * created = allocator->zero_allocate(
+    1, sizeof(rosidl_dynamic_typesupport_dynamic_data_t), allocator->state);
+  if (created == NULL) {
+    RCUTILS_SET_ERROR_MSG("Could not allocate dynamic data for dynamic message type support");
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  rcutils_ret_t ret = rosidl_dynamic_typesupport_dynamic_data_init_from_dynamic_type(
+    ts_impl->dynamic_message_type, allocator, created);
+  if (ret != RCUTILS_RET_OK) {
+    allocator->deallocate(created, allocator->state);
+    RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR(
+      "Could not construct dynamic data for dynamic message type support");
+    return ret;
+  }
+
+  // Another thread might have constructed it in the meantime, in which case ours goes
+  lock_dynamic_messages(ts_impl);
+  if (ts_impl->dynamic_message == NULL) {
+    ts_impl->dynamic_message = created;
+    created = NULL;
+  }
+  *dynamic_message = ts_impl->dynamic_message;
+  unlock_dynamic_messages(ts_impl);
+  if (created != NULL) {
+    rosidl_dynamic_typesupport_dynamic_data_destroy(created);
+  }
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+rosidl_dynamic_message_type_support_handle_skip_dynamic_message(rosidl_message_type_support_t * ts)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(ts, RCUTILS_RET_INVALID_ARGUMENT);
+
+  if (ts->typesupport_identifier != rosidl_dynamic_typesupport_c__identifier) {
+    RCUTILS_SET_ERROR_MSG("Type support not from this implementation");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+
+  rosidl_dynamic_message_type_support_impl_t * ts_impl =
+    (rosidl_dynamic_message_type_support_impl_t *)ts->data;
+  lock_dynamic_messages(ts_impl);
+  bool is_constructed = ts_impl->dynamic_message != NULL;
+  if (!is_constructed) {
+    ts_impl->skip_dynamic_message = true;
+  }
+  unlock_dynamic_messages(ts_impl);
+  if (is_constructed) {
+    RCUTILS_SET_ERROR_MSG("Dynamic message was already constructed, so it cannot be skipped");
+    return RCUTILS_RET_ERROR;
+  }
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+rosidl_dynamic_message_type_support_handle_init_dynamic_data_pool(
+  rosidl_message_type_support_t * ts,
+  size_t min_size,
+  size_t max_size)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(ts, RCUTILS_RET_INVALID_ARGUMENT);
+
+  if (ts->typesupport_identifier != rosidl_dynamic_typesupport_c__identifier) {
+    RCUTILS_SET_ERROR_MSG("Type support not from this implementation");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+
+  rosidl_dynamic_message_type_support_impl_t * ts_impl =
+    (rosidl_dynamic_message_type_support_impl_t *)ts->data;
+  lock_dynamic_messages(ts_impl);
+  bool is_initialized = ts_impl->dynamic_data_pool != NULL;
+  unlock_dynamic_messages(ts_impl);
+  if (is_initialized) {
+    return RCUTILS_RET_OK;
+  }
+
+  rcutils_allocator_t * allocator = &ts_impl->allocator;
+  rosidl_dynamic_typesupport_dynamic_data_pool_t * pool = allocator->allocate(
+    sizeof(rosidl_dynamic_typesupport_dynamic_data_pool_t), allocator->state);
+  if (pool == NULL) {
+    RCUTILS_SET_ERROR_MSG("Could not allocate dynamic data pool for dynamic message type support");
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  rcutils_ret_t ret = rosidl_dynamic_typesupport_dynamic_data_pool_init(
+    ts_impl->dynamic_message_type, min_size, max_size, allocator, pool);
+  if (ret != RCUTILS_RET_OK) {
+    allocator->deallocate(pool, allocator->state);
+    RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR(
+      "Could not initialize dynamic data pool for dynamic message type support");
+    return ret;
   }
 
+  // Another thread might have initialized it in the meantime, in which case ours goes
+  lock_dynamic_messages(ts_impl);
+  if (ts_impl->dynamic_data_pool == NULL) {
+    ts_impl->dynamic_data_pool = pool;
+    pool = NULL;
+  }
+  unlock_dynamic_messages(ts_impl);
+  if (pool != NULL) {
+    rosidl_dynamic_typesupport_dynamic_data_pool_fini(pool);
+    allocator->deallocate(pool, allocator->state);
+  }
+  return RCUTILS_RET_OK;
+}
+
+static void
+add_memory_usage(
+  rosidl_dynamic_typesupport_memory_usage_t * memory_usage,
+  const rosidl_dynamic_typesupport_memory_usage_t * other)
+{
+  memory_usage->library_bytes += other->library_bytes;
+  memory_usage->serialization_library_bytes += other->serialization_library_bytes;
+  memory_usage->serialization_library_bytes_reported =
+    memory_usage->serialization_library_bytes_reported &&
+    other->serialization_library_bytes_reported;
+}
+
+rcutils_ret_t
+rosidl_dynamic_message_type_support_handle_get_memory_usage(
+  const rosidl_message_type_support_t * ts,
+  rosidl_dynamic_typesupport_memory_usage_t * memory_usage)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(ts, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(memory_usage, RCUTILS_RET_INVALID_ARGUMENT);
+
+  if (ts->typesupport_identifier != rosidl_dynamic_typesupport_c__identifier) {
+    RCUTILS_SET_ERROR_MSG("Type support not from this implementation");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+
+  rosidl_dynamic_message_type_support_impl_t * handle_ts_impl =
+    (rosidl_dynamic_message_type_support_impl_t *)ts->data;
+  const rosidl_dynamic_message_type_support_impl_t * ts_impl =
+    get_type_plan_owner(handle_ts_impl);
+  rosidl_dynamic_typesupport_memory_usage_t part_memory_usage;
+
+  // impl, and the type description it holds (the shared impl's, for views)
+  memory_usage->serialization_library_bytes = 0;
+  memory_usage->serialization_library_bytes_reported = true;
+  if (ts_impl->is_compact) {
+    // The dynamic type struct (if not shared through the registry) is part of the layout too
+    compact_layout_t compact_layout = get_compact_layout(
+      &ts_impl->type_hash, &ts_impl->type_description, &ts_impl->type_description_sources);
+    memory_usage->library_bytes = compact_layout.size;
+  } else {
+    memory_usage->library_bytes = sizeof(rosidl_dynamic_message_type_support_impl_t);
+    if (ts_impl->type_description_storage != NULL) {
+      memory_usage->library_bytes += compact_type_description_get_size(
+        &ts_impl->type_description, &ts_impl->type_description_sources);
+    } else {
+      memory_usage->library_bytes += compact_type_description_get_unpacked_size(
+        &ts_impl->type_description, &ts_impl->type_description_sources);
+    }
+    if (ts_impl->type_hash.version == ROSIDL_TYPE_HASH_VERSION_UNSET) {
+      memory_usage->library_bytes += sizeof(rosidl_dynamic_typesupport_dynamic_type_t);
+    }
+  }
+  if (handle_ts_impl->is_shared) {
+    const shared_impl_t * shared_impl = ((const shared_impl_view_t *) handle_ts_impl)->shared_impl;
+    memory_usage->library_bytes += sizeof(shared_impl_t) - sizeof(*ts_impl) +
+      strlen(shared_impl->key.serialization_library_identifier) + 1 + sizeof(shared_impl_view_t);
+  }
+
+  // dynamic_message_type
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+    rosidl_dynamic_typesupport_dynamic_type_get_memory_usage(
+      ts_impl->dynamic_message_type, &part_memory_usage)
+  );
+  add_memory_usage(memory_usage, &part_memory_usage);
+
+  lock_dynamic_messages(handle_ts_impl);
+  rosidl_dynamic_typesupport_dynamic_data_t * dynamic_message = handle_ts_impl->dynamic_message;
+  rosidl_dynamic_typesupport_dynamic_data_pool_t * pool = handle_ts_impl->dynamic_data_pool;
+  unlock_dynamic_messages(handle_ts_impl);
+
+  // dynamic_message
+  if (dynamic_message != NULL) {
+    ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+      rosidl_dynamic_typesupport_dynamic_data_get_memory_usage(dynamic_message, &part_memory_usage)
+    );
+    part_memory_usage.library_bytes += sizeof(rosidl_dynamic_typesupport_dynamic_data_t);
+    add_memory_usage(memory_usage, &part_memory_usage);
+  }
+
+  // dynamic_data_pool
+  if (pool != NULL) {
+    ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+      rosidl_dynamic_typesupport_dynamic_data_pool_get_memory_usage(pool, &part_memory_usage)
+    );
+    part_memory_usage.library_bytes += sizeof(rosidl_dynamic_typesupport_dynamic_data_pool_t);
+    add_memory_usage(memory_usage, &part_memory_usage);
+  }
+
+  // type_plan
+  if (handle_ts_impl->is_shared) {
+    lock_shared_impls();
+  }
+  const rosidl_dynamic_typesupport_type_plan_t * type_plan = ts_impl->type_plan;
+  if (handle_ts_impl->is_shared) {
+    unlock_shared_impls();
+  }
+  if (type_plan != NULL) {
+    memory_usage->library_bytes +=
+      sizeof(rosidl_dynamic_typesupport_type_plan_t) + type_plan->storage_size;
+  }
   return RCUTILS_RET_OK;
 }
 
@@ -287,3 +1245,41 @@ rosidl_get_dynamic_message_type_support_type_description_sources_function(
     (rosidl_dynamic_message_type_support_impl_t *) ts->data;
   return &ts_impl->type_description_sources;
 }
+
+const rosidl_dynamic_typesupport_type_plan_t *
+rosidl_get_dynamic_message_type_support_type_plan_function(
+  const rosidl_message_type_support_t * type_support)
+{
+  const rosidl_message_type_support_t * ts = get_message_typesupport_handle(
+    type_support, rosidl_dynamic_typesupport_c__identifier);
+  if (ts == NULL) {
+    return NULL;
+  }
+  rosidl_dynamic_message_type_support_impl_t * ts_impl =
+    (rosidl_dynamic_message_type_support_impl_t *) ts->data;
+  if (!ts_impl->is_shared) {
+    return ts_impl->type_plan;
+  }
+  lock_shared_impls();
+  const rosidl_dynamic_typesupport_type_plan_t * type_plan =
+    get_type_plan_owner(ts_impl)->type_plan;
+  unlock_shared_impls();
+  return type_plan;
+}
+
+rosidl_dynamic_typesupport_dynamic_data_pool_t *
+rosidl_get_dynamic_message_type_support_dynamic_data_pool_function(
+  const rosidl_message_type_support_t * type_support)
+{
+  const rosidl_message_type_support_t * ts = get_message_typesupport_handle(
+    type_support, rosidl_dynamic_typesupport_c__identifier);
+  if (ts == NULL) {
+    return NULL;
+  }
+  rosidl_dynamic_message_type_support_impl_t * ts_impl =
+    (rosidl_dynamic_message_type_support_impl_t *) ts->data;
+  lock_dynamic_messages(ts_impl);
+  rosidl_dynamic_typesupport_dynamic_data_pool_t * pool = ts_impl->dynamic_data_pool;
+  unlock_dynamic_messages(ts_impl);
+  return pool;
+}
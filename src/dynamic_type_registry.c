@@ -0,0 +1,554 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdint.h>
+#include <string.h>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/stdatomic_helper.h>
+#include <rcutils/strdup.h>
+#include <rcutils/time.h>
+#include <rcutils/types/hash_map.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+#include <rosidl_runtime_c/type_hash.h>
+
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/dynamic_type_registry.h"
+#include "rosidl_dynamic_typesupport/macros.h"
+#include "rosidl_dynamic_typesupport/type_snapshot.h"
+
+#include "compact_type_description.h"
+#include "spin_lock.h"
+
+
+// NOTE: Shared serialization supports are one per serialization library, and every entry holds a
+//       reference to its own, so the serialization support only tells entries apart if a caller
+//       passes one that is not shared. The identifier is kept for looking types up in snapshots
+typedef struct registry_key_s
+{
+  const rosidl_dynamic_typesupport_serialization_support_t * serialization_support;
+  const char * serialization_library_identifier;
+  rosidl_type_hash_t type_hash;
+} registry_key_t;
+
+typedef struct registry_entry_s
+{
+  // NOTE: This MUST be the first member, so the dynamic types handed out by the
+  //       registry can be mapped back to their entry on release
+  rosidl_dynamic_typesupport_dynamic_type_t dynamic_type;
+
+  // Reference to the shared serialization support the dynamic type was built with, which the
+  // dynamic type borrows. Released after the dynamic type is finalized
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support;
+
+  // Owns its serialization_library_identifier string
+  registry_key_t key;
+
+  // Guarded by registry_lock
+  size_t ref_count;
+
+  rcutils_allocator_t allocator;
+
+  // The description the dynamic type was built from, packed into the same allocation as the entry.
+  // Type hashes are not verified against descriptions, so hits are only handed out for equal ones
+  rosidl_runtime_c__type_description__TypeDescription description;
+  rosidl_runtime_c__type_description__TypeSource__Sequence unused_sources;
+} registry_entry_t;
+
+
+// registry_key_t -> registry_entry_t *
+// Lazily initialized on first insertion, and finalized again once it is empty
+static rcutils_hash_map_t registry;
+static atomic_bool registry_lock;
+
+// Guarded by registry_lock. Consulted before building dynamic types from their descriptions
+static const rosidl_dynamic_typesupport_type_snapshot_t * registry_snapshot;
+
+
+// NOTE: Everything done under the lock is short, dynamic type construction and description
+//       comparisons happen outside it
+static void
+lock_registry(void)
+{
+  spin_lock_acquire(&registry_lock);
+}
+
+
+static void
+unlock_registry(void)
+{
+  spin_lock_release(&registry_lock);
+}
+
+
+static size_t
+registry_key_hash(const void * key)
+{
+  const registry_key_t * registry_key = (const registry_key_t *) key;
+
+  // Type hashes are already uniformly distributed, so any slice of them will do
+  size_t type_hash_bits = 0;
+  memcpy(&type_hash_bits, registry_key->type_hash.value, sizeof(type_hash_bits));
+
+  // Entries of different serialization supports are rare, so their address is as good as any
+  return (size_t) (uintptr_t) registry_key->serialization_support ^
+         type_hash_bits ^ registry_key->type_hash.version;
+}
+
+
+static int
+registry_key_cmp(const void * key_a, const void * key_b)
+{
+  const registry_key_t * a = (const registry_key_t *) key_a;
+  const registry_key_t * b = (const registry_key_t *) key_b;
+
+  if (a->type_hash.version != b->type_hash.version) {
+    return a->type_hash.version < b->type_hash.version ? -1 : 1;
+  }
+  int ret = memcmp(a->type_hash.value, b->type_hash.value, sizeof(a->type_hash.value));
+  if (ret != 0) {
+    return ret;
+  }
+  if (a->serialization_support != b->serialization_support) {
+    return (uintptr_t) a->serialization_support < (uintptr_t) b->serialization_support ? -1 : 1;
+  }
+  return 0;
+}
+
+
+static void
+registry_entry_destroy(registry_entry_t * entry)
+{
+  rcutils_allocator_t allocator = entry->allocator;
+
+  if (entry->dynamic_type.serialization_support != NULL) {
+    if (rosidl_dynamic_typesupport_dynamic_type_fini(&entry->dynamic_type) != RCUTILS_RET_OK) {
+      RCUTILS_SAFE_FWRITE_TO_STDERR("Could not finalize registered dynamic type");
+    }
+  }
+  if (entry->serialization_support != NULL) {
+    if (rosidl_dynamic_typesupport_serialization_support_release(entry->serialization_support) !=
+      RCUTILS_RET_OK)
+    {
+      RCUTILS_SAFE_FWRITE_TO_STDERR("Could not release serialization support of registered type");
+    }
+  }
+  allocator.deallocate((char *) entry->key.serialization_library_identifier, allocator.state);
+  allocator.deallocate(entry, allocator.state);
+}
+
+
+static size_t
+get_registry_entry_description_offset(void)
+{
+  return (sizeof(registry_entry_t) + COMPACT_TYPE_DESCRIPTION_ALIGNMENT - 1) &
+         ~(COMPACT_TYPE_DESCRIPTION_ALIGNMENT - 1);
+}
+
+
+// Hand out a reference to an entry that was just taken under the lock, if it was built from the
+// same description. The description is immutable, so it is compared outside the lock
+static rcutils_ret_t
+registry_entry_hand_out(
+  registry_entry_t * entry,
+  const rosidl_runtime_c__type_description__TypeDescription * description,
+  rosidl_dynamic_typesupport_dynamic_type_t ** dynamic_type)
+{
+  if (!rosidl_runtime_c__type_description__TypeDescription__are_equal(
+      &entry->description, description))
+  {
+    if (rosidl_dynamic_typesupport_dynamic_type_registry_release(&entry->dynamic_type) !=
+      RCUTILS_RET_OK)
+    {
+      RCUTILS_SAFE_FWRITE_TO_STDERR("Could not release mismatched registered dynamic type");
+    }
+    RCUTILS_SET_ERROR_MSG(
+      "A different type description is already registered under the same type hash");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  *dynamic_type = &entry->dynamic_type;
+  return RCUTILS_RET_OK;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_registry_acquire(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_type_hash_t * type_hash,
+  const rosidl_runtime_c__type_description__TypeDescription * description,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_dynamic_type_t ** dynamic_type)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(serialization_support, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(type_hash, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(description, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(allocator, RCUTILS_RET_INVALID_ARGUMENT);
+  if (!rcutils_allocator_is_valid(allocator)) {
+    RCUTILS_SET_ERROR_MSG("allocator is invalid");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(dynamic_type, RCUTILS_RET_INVALID_ARGUMENT);
+
+  if (type_hash->version == ROSIDL_TYPE_HASH_VERSION_UNSET) {
+    RCUTILS_SET_ERROR_MSG("Type hash must be set to use the dynamic type registry");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+
+  const char * serialization_library_identifier =
+    rosidl_dynamic_typesupport_serialization_support_get_library_identifier(serialization_support);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(serialization_library_identifier, RCUTILS_RET_INVALID_ARGUMENT);
+
+  registry_key_t key;
+  key.serialization_support = serialization_support;
+  key.serialization_library_identifier = serialization_library_identifier;
+  key.type_hash = *type_hash;
+
+  // Fast path: someone already built it
+  registry_entry_t * entry = NULL;
+  lock_registry();
+  if (registry.impl != NULL && rcutils_hash_map_get(&registry, &key, &entry) == RCUTILS_RET_OK) {
+    entry->ref_count++;
+    unlock_registry();
+    return registry_entry_hand_out(entry, description, dynamic_type);
+  }
+  unlock_registry();
+
+  // Slow path: build the dynamic type outside of the lock, since this is the expensive part
+  rcutils_ret_t ret = RCUTILS_RET_ERROR;
+  size_t description_offset = get_registry_entry_description_offset();
+  registry_entry_t * new_entry = allocator->allocate(
+    description_offset + compact_type_description_get_size(description, NULL), allocator->state);
+  if (new_entry == NULL) {
+    RCUTILS_SET_ERROR_MSG("Could not allocate dynamic type registry entry");
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  // The packed description is written over anyway
+  memset(new_entry, 0, sizeof(registry_entry_t));
+  compact_type_description_pack(
+    description, NULL, (uint8_t *) new_entry + description_offset,
+    &new_entry->description, &new_entry->unused_sources);
+  new_entry->allocator = *allocator;
+  new_entry->ref_count = 1;
+  new_entry->dynamic_type = rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+  ret = rosidl_dynamic_typesupport_serialization_support_acquire(serialization_support);
+  if (ret != RCUTILS_RET_OK) {
+    RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR(
+      "Could not acquire serialization support for registered dynamic type");
+    goto fail;
+  }
+  new_entry->serialization_support = serialization_support;
+  new_entry->key.serialization_support = serialization_support;
+  new_entry->key.type_hash = *type_hash;
+  new_entry->key.serialization_library_identifier =
+    rcutils_strdup(serialization_library_identifier, *allocator);
+  if (new_entry->key.serialization_library_identifier == NULL) {
+    RCUTILS_SET_ERROR_MSG("Could not copy serialization library identifier");
+    ret = RCUTILS_RET_BAD_ALLOC;
+    goto fail;
+  }
+
+  // Loading from a snapshot skips constructing the dynamic type altogether
+  lock_registry();
+  const rosidl_dynamic_typesupport_type_snapshot_t * snapshot = registry_snapshot;
+  unlock_registry();
+  size_t snapshot_entry_index = 0;
+  ret = RCUTILS_RET_NOT_FOUND;
+  if (snapshot != NULL &&
+    rosidl_dynamic_typesupport_type_snapshot_find(
+      snapshot, serialization_library_identifier, type_hash,
+      &snapshot_entry_index) == RCUTILS_RET_OK)
+  {
+    ret = rosidl_dynamic_typesupport_type_snapshot_load_dynamic_type(
+      snapshot, snapshot_entry_index, new_entry->serialization_support, allocator,
+      &new_entry->dynamic_type);
+    if (ret != RCUTILS_RET_OK) {
+      // Not fatal, the description is still there to build it from
+      rcutils_reset_error();
+      new_entry->dynamic_type = rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+    }
+  }
+
+  if (ret != RCUTILS_RET_OK) {
+    // The type hash is already known, so use it to skip validating descriptions seen before
+    rosidl_dynamic_typesupport_dynamic_type_construction_options_t options =
+      rosidl_dynamic_typesupport_get_default_dynamic_type_construction_options();
+    options.type_hash = type_hash;
+
+    ret = rosidl_dynamic_typesupport_dynamic_type_init_from_description_with_options(
+      new_entry->serialization_support, description, &options, allocator,
+      &new_entry->dynamic_type);
+  }
+  if (ret != RCUTILS_RET_OK) {
+    RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR("Could not construct registered dynamic type");
+    new_entry->dynamic_type.serialization_support = NULL;
+    goto fail;
+  }
+
+  lock_registry();
+  if (registry.impl == NULL) {
+    rcutils_allocator_t registry_allocator = rcutils_get_default_allocator();
+    ret = rcutils_hash_map_init(
+      &registry, 16, sizeof(registry_key_t), sizeof(registry_entry_t *),
+      registry_key_hash, registry_key_cmp, &registry_allocator);
+    if (ret != RCUTILS_RET_OK) {
+      unlock_registry();
+      RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR("Could not initialize dynamic type registry");
+      goto fail;
+    }
+  }
+
+  // Someone else might have built and registered the same type while we were building ours
+  if (rcutils_hash_map_get(&registry, &key, &entry) == RCUTILS_RET_OK) {
+    entry->ref_count++;
+    unlock_registry();
+    registry_entry_destroy(new_entry);
+    return registry_entry_hand_out(entry, description, dynamic_type);
+  }
+
+  ret = rcutils_hash_map_set(&registry, &new_entry->key, &new_entry);
+  unlock_registry();
+  if (ret != RCUTILS_RET_OK) {
+    RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR("Could not register dynamic type");
+    goto fail;
+  }
+
+  *dynamic_type = &new_entry->dynamic_type;
+  return RCUTILS_RET_OK;
+
+fail:
+  registry_entry_destroy(new_entry);
+  return ret;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_registry_release(
+  rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(dynamic_type, RCUTILS_RET_INVALID_ARGUMENT);
+
+  // NOTE: Using this on a dynamic type that was not acquired from the registry is
+  //       undefined behavior, since it is assumed to be the head of an entry
+  registry_entry_t * entry = (registry_entry_t *) dynamic_type;
+  registry_entry_t * registered_entry = NULL;
+
+  lock_registry();
+  if (registry.impl == NULL ||
+    rcutils_hash_map_get(&registry, &entry->key, &registered_entry) != RCUTILS_RET_OK ||
+    registered_entry != entry)
+  {
+    unlock_registry();
+    RCUTILS_SET_ERROR_MSG("Dynamic type was not acquired from the dynamic type registry");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+
+  entry->ref_count--;
+  if (entry->ref_count > 0) {
+    unlock_registry();
+    return RCUTILS_RET_OK;
+  }
+
+  rcutils_ret_t ret = rcutils_hash_map_unset(&registry, &entry->key);
+  if (ret != RCUTILS_RET_OK) {
+    entry->ref_count++;
+    unlock_registry();
+    RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR("Could not unregister dynamic type");
+    return ret;
+  }
+
+  size_t registry_size = 0;
+  if (rcutils_hash_map_get_size(&registry, &registry_size) == RCUTILS_RET_OK &&
+    registry_size == 0)
+  {
+    if (rcutils_hash_map_fini(&registry) != RCUTILS_RET_OK) {
+      RCUTILS_SAFE_FWRITE_TO_STDERR("Could not finalize empty dynamic type registry");
+    }
+    registry = rcutils_get_zero_initialized_hash_map();
+  }
+  unlock_registry();
+
+  registry_entry_destroy(entry);
+  return RCUTILS_RET_OK;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_registry_set_snapshot(
+  const rosidl_dynamic_typesupport_type_snapshot_t * snapshot)
+{
+  lock_registry();
+  registry_snapshot = snapshot;
+  unlock_registry();
+  return RCUTILS_RET_OK;
+}
+
+
+// DYNAMIC TYPE REGISTRY PREWARM ===================================================================
+struct rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_impl_s
+{
+  // Index of the next type to claim. Runs stop once it reaches the type count
+  atomic_uint_least64_t next_type;
+};
+
+
+rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_t
+rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type_registry_prewarm(void)
+{
+  rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_t zero_prewarm;
+  memset(&zero_prewarm, 0, sizeof(zero_prewarm));
+  zero_prewarm.allocator = rcutils_get_zero_initialized_allocator();
+  return zero_prewarm;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_init(
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  const rosidl_type_hash_t * type_hashes,
+  const rosidl_runtime_c__type_description__TypeDescription * const * descriptions,
+  size_t type_count,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_t * prewarm)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(serialization_support, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(type_hashes, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(descriptions, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(allocator, RCUTILS_RET_INVALID_ARGUMENT);
+  if (!rcutils_allocator_is_valid(allocator)) {
+    RCUTILS_SET_ERROR_MSG("allocator is invalid");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(prewarm, RCUTILS_RET_INVALID_ARGUMENT);
+
+  for (size_t i = 0; i < type_count; i++) {
+    RCUTILS_CHECK_ARGUMENT_FOR_NULL(descriptions[i], RCUTILS_RET_INVALID_ARGUMENT);
+    if (type_hashes[i].version == ROSIDL_TYPE_HASH_VERSION_UNSET) {
+      RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+        "Type hash %zu must be set to use the dynamic type registry", i);
+      return RCUTILS_RET_INVALID_ARGUMENT;
+    }
+  }
+
+  *prewarm = rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type_registry_prewarm();
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+    rosidl_dynamic_typesupport_serialization_support_acquire(serialization_support)
+  );
+  prewarm->impl = allocator->allocate(
+    sizeof(rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_impl_t), allocator->state);
+  if (prewarm->impl == NULL) {
+    rosidl_dynamic_typesupport_serialization_support_release(serialization_support);
+    RCUTILS_SET_ERROR_MSG("Could not allocate dynamic type registry prewarm");
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  if (type_count > 0) {
+    prewarm->results = allocator->zero_allocate(
+      type_count, sizeof(rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_result_t),
+      allocator->state);
+    if (prewarm->results == NULL) {
+      allocator->deallocate(prewarm->impl, allocator->state);
+      prewarm->impl = NULL;
+      rosidl_dynamic_typesupport_serialization_support_release(serialization_support);
+      RCUTILS_SET_ERROR_MSG("Could not allocate dynamic type registry prewarm results");
+      return RCUTILS_RET_BAD_ALLOC;
+    }
+  }
+  for (size_t i = 0; i < type_count; i++) {
+    prewarm->results[i].ret = RCUTILS_RET_NOT_INITIALIZED;
+  }
+  rcutils_atomic_store(&prewarm->impl->next_type, 0);
+
+  prewarm->serialization_support = serialization_support;
+  prewarm->type_hashes = type_hashes;
+  prewarm->descriptions = descriptions;
+  prewarm->type_count = type_count;
+  prewarm->allocator = *allocator;
+  return RCUTILS_RET_OK;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_run(
+  rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_t * prewarm)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(prewarm, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(prewarm->impl, RCUTILS_RET_INVALID_ARGUMENT);
+
+  while (true) {
+    uint64_t i = rcutils_atomic_fetch_add_uint64_t(&prewarm->impl->next_type, 1);
+    if (i >= prewarm->type_count) {
+      return RCUTILS_RET_OK;
+    }
+
+    // NOTE: Each result is only ever written by the run that claimed it
+    rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_result_t * result =
+      &prewarm->results[i];
+    rcutils_time_point_value_t start = 0;
+    rcutils_time_point_value_t end = 0;
+    if (rcutils_steady_time_now(&start) != RCUTILS_RET_OK) {
+      rcutils_reset_error();
+    }
+    result->ret = rosidl_dynamic_typesupport_dynamic_type_registry_acquire(
+      prewarm->serialization_support, &prewarm->type_hashes[i], prewarm->descriptions[i],
+      &prewarm->allocator, &result->dynamic_type);
+    if (rcutils_steady_time_now(&end) != RCUTILS_RET_OK) {
+      rcutils_reset_error();
+      end = start;
+    }
+    result->build_time = end - start;
+
+    if (result->ret != RCUTILS_RET_OK) {
+      // Failures are reported through the result, so don't leave the error to the next type
+      result->dynamic_type = NULL;
+      rcutils_reset_error();
+    }
+  }
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_fini(
+  rosidl_dynamic_typesupport_dynamic_type_registry_prewarm_t * prewarm)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(prewarm, RCUTILS_RET_INVALID_ARGUMENT);
+
+  rcutils_ret_t ret = RCUTILS_RET_OK;
+  for (size_t i = 0; prewarm->results != NULL && i < prewarm->type_count; i++) {
+    if (prewarm->results[i].dynamic_type == NULL) {
+      continue;
+    }
+    if (rosidl_dynamic_typesupport_dynamic_type_registry_release(
+        prewarm->results[i].dynamic_type) != RCUTILS_RET_OK)
+    {
+      RCUTILS_SAFE_FWRITE_TO_STDERR("Could not release prewarmed dynamic type");
+      ret = RCUTILS_RET_ERROR;
+    }
+  }
+  if (prewarm->impl != NULL || prewarm->results != NULL) {
+    prewarm->allocator.deallocate(prewarm->results, prewarm->allocator.state);
+    prewarm->allocator.deallocate(prewarm->impl, prewarm->allocator.state);
+  }
+  if (prewarm->serialization_support != NULL) {
+    if (rosidl_dynamic_typesupport_serialization_support_release(
+        prewarm->serialization_support) != RCUTILS_RET_OK)
+    {
+      RCUTILS_SAFE_FWRITE_TO_STDERR("Could not release serialization support of prewarm");
+      ret = RCUTILS_RET_ERROR;
+    }
+  }
+  *prewarm = rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type_registry_prewarm();
+  return ret;
+}
@@ -0,0 +1,219 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/stdatomic_helper.h>
+#include <rcutils/types/hash_map.h>
+#include <rcutils/types/rcutils_ret.h>
+
+#include "rosidl_dynamic_typesupport/interned_string.h"
+
+#include "spin_lock.h"
+
+
+// FNV-1a
+#define HASH_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define HASH_PRIME 0x100000001b3ULL
+
+
+// An interned string, with its characters right after it
+typedef struct interned_string_entry_s
+{
+  // MUST be first, interned strings are cast back to their entry
+  rosidl_dynamic_typesupport_interned_string_t interned_string;
+  // Guarded by interned_strings_lock. The entry is removed and freed when it drops to 0
+  size_t ref_count;
+} interned_string_entry_t;
+
+// const rosidl_dynamic_typesupport_interned_string_t * -> (same)
+//
+// NOTE: Keys point at interned strings, so lookups can use a key on the stack that
+//       was never interned
+static rcutils_hash_map_t interned_strings;
+static atomic_bool interned_strings_lock;
+
+
+static size_t
+interned_string_key_hash(const void * key)
+{
+  return (*(const rosidl_dynamic_typesupport_interned_string_t * const *) key)->hash;
+}
+
+
+static int
+interned_string_key_cmp(const void * key_a, const void * key_b)
+{
+  const rosidl_dynamic_typesupport_interned_string_t * a =
+    *(const rosidl_dynamic_typesupport_interned_string_t * const *) key_a;
+  const rosidl_dynamic_typesupport_interned_string_t * b =
+    *(const rosidl_dynamic_typesupport_interned_string_t * const *) key_b;
+
+  if (a->length != b->length) {
+    return a->length < b->length ? -1 : 1;
+  }
+  return memcmp(a->data, b->data, a->length);
+}
+
+
+static size_t
+hash_string(const char * string, size_t length)
+{
+  uint64_t hash = HASH_OFFSET_BASIS;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (unsigned char) string[i];
+    hash *= HASH_PRIME;
+  }
+  return (size_t) hash;
+}
+
+
+// Allocate an interned string with one reference, and its characters right after it
+static interned_string_entry_t *
+interned_string_create(const char * string, size_t length, size_t hash)
+{
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  interned_string_entry_t * entry =
+    allocator.allocate(sizeof(interned_string_entry_t) + length + 1, allocator.state);
+  if (entry == NULL) {
+    return NULL;
+  }
+
+  char * data = (char *) (entry + 1);
+  memcpy(data, string, length);
+  data[length] = '\0';
+
+  entry->interned_string.data = data;
+  entry->interned_string.length = length;
+  entry->interned_string.hash = hash;
+  entry->ref_count = 1;
+  return entry;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_intern_string(
+  const char * string,
+  size_t length,
+  const rosidl_dynamic_typesupport_interned_string_t ** interned_string)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(string, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(interned_string, RCUTILS_RET_INVALID_ARGUMENT);
+
+  rosidl_dynamic_typesupport_interned_string_t lookup = {
+    .data = string,
+    .length = length,
+    .hash = hash_string(string, length)
+  };
+  const rosidl_dynamic_typesupport_interned_string_t * key = &lookup;
+
+  spin_lock_acquire(&interned_strings_lock);
+  if (interned_strings.impl == NULL) {
+    rcutils_allocator_t allocator = rcutils_get_default_allocator();
+    rcutils_ret_t ret = rcutils_hash_map_init(
+      &interned_strings, 256,
+      sizeof(const rosidl_dynamic_typesupport_interned_string_t *),
+      sizeof(const rosidl_dynamic_typesupport_interned_string_t *),
+      interned_string_key_hash, interned_string_key_cmp, &allocator);
+    if (ret != RCUTILS_RET_OK) {
+      interned_strings = rcutils_get_zero_initialized_hash_map();
+      spin_lock_release(&interned_strings_lock);
+      RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR("Could not initialize interned strings");
+      return ret;
+    }
+  }
+
+  if (rcutils_hash_map_get(&interned_strings, &key, interned_string) == RCUTILS_RET_OK) {
+    ((interned_string_entry_t *) *interned_string)->ref_count++;
+    spin_lock_release(&interned_strings_lock);
+    return RCUTILS_RET_OK;
+  }
+
+  interned_string_entry_t * created = interned_string_create(string, length, lookup.hash);
+  if (created == NULL) {
+    spin_lock_release(&interned_strings_lock);
+    RCUTILS_SET_ERROR_MSG("Could not allocate interned string");
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+
+  key = &created->interned_string;
+  rcutils_ret_t ret = rcutils_hash_map_set(&interned_strings, &key, &key);
+  spin_lock_release(&interned_strings_lock);
+  if (ret != RCUTILS_RET_OK) {
+    rcutils_allocator_t allocator = rcutils_get_default_allocator();
+    allocator.deallocate(created, allocator.state);
+    RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR("Could not store interned string");
+    return ret;
+  }
+
+  *interned_string = &created->interned_string;
+  return RCUTILS_RET_OK;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_interned_string_retain(
+  const rosidl_dynamic_typesupport_interned_string_t * interned_string)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(interned_string, RCUTILS_RET_INVALID_ARGUMENT);
+  spin_lock_acquire(&interned_strings_lock);
+  ((interned_string_entry_t *) interned_string)->ref_count++;
+  spin_lock_release(&interned_strings_lock);
+  return RCUTILS_RET_OK;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_interned_string_release(
+  const rosidl_dynamic_typesupport_interned_string_t * interned_string)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(interned_string, RCUTILS_RET_INVALID_ARGUMENT);
+  interned_string_entry_t * entry = (interned_string_entry_t *) interned_string;
+
+  spin_lock_acquire(&interned_strings_lock);
+  if (--entry->ref_count > 0) {
+    spin_lock_release(&interned_strings_lock);
+    return RCUTILS_RET_OK;
+  }
+  rcutils_ret_t ret = rcutils_hash_map_unset(&interned_strings, &interned_string);
+  spin_lock_release(&interned_strings_lock);
+  if (ret != RCUTILS_RET_OK) {
+    // Still in the table, so it is kept (unreferenced) for whoever interns it next
+    RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR("Could not remove interned string");
+    return ret;
+  }
+
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  allocator.deallocate(entry, allocator.state);
+  return RCUTILS_RET_OK;
+}
+
+
+size_t
+rosidl_dynamic_typesupport_get_interned_string_count(void)
+{
+  size_t count = 0;
+  spin_lock_acquire(&interned_strings_lock);
+  if (interned_strings.impl != NULL &&
+    rcutils_hash_map_get_size(&interned_strings, &count) != RCUTILS_RET_OK)
+  {
+    count = 0;
+  }
+  spin_lock_release(&interned_strings_lock);
+  return count;
+}
@@ -0,0 +1,69 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SPIN_LOCK_H_
+#define SPIN_LOCK_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+#include <rcutils/stdatomic_helper.h>
+
+
+// SPIN LOCKS ======================================================================================
+// The process-wide tables of this library are guarded by an `atomic_bool` each, since rcutils has
+// no portable mutex. They are only held for table lookups and insertions, never while building.
+
+/// Give up the rest of the time slice, so whoever holds what we are waiting on can run
+static inline void
+spin_lock_yield(void)
+{
+#ifdef _WIN32
+  SwitchToThread();
+#else
+  sched_yield();
+#endif
+}
+
+/// Take a spin lock, yielding while someone else holds it
+static inline void
+spin_lock_acquire(atomic_bool * lock)
+{
+  while (rcutils_atomic_exchange_bool(lock, true)) {
+    // The holder might have been preempted, and spinning would only keep it from running
+    spin_lock_yield();
+  }
+}
+
+static inline void
+spin_lock_release(atomic_bool * lock)
+{
+  rcutils_atomic_store(lock, false);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SPIN_LOCK_H_
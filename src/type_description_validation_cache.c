@@ -0,0 +1,372 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/stdatomic_helper.h>
+#include <rcutils/types/hash_map.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/type_description/field__struct.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__struct.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+#include <rosidl_runtime_c/type_description/type_description__struct.h>
+#include <rosidl_runtime_c/type_description_utils.h>
+#include <rosidl_runtime_c/type_hash.h>
+
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+
+#include "compact_type_description.h"
+#include "spin_lock.h"
+#include "type_description_validation_cache.h"
+
+
+// Once full, new verdicts are simply not remembered. This only bounds memory use, since a process
+// rarely sees anywhere near this many distinct types
+#define VALIDATION_CACHE_MAX_ENTRIES 4096
+
+// FNV-1a
+#define DIGEST_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define DIGEST_PRIME 0x100000001b3ULL
+
+
+// A description that passed validation, packed into the same allocation as this struct
+typedef struct validated_description_s
+{
+  rosidl_runtime_c__type_description__TypeDescription description;
+  rosidl_runtime_c__type_description__TypeSource__Sequence unused_sources;
+
+  // One for the cache, plus one for every lookup still comparing against it. Guarded by
+  // validation_cache_lock
+  size_t ref_count;
+} validated_description_t;
+
+
+// rosidl_type_hash_t -> validated_description_t *
+//
+// Keys only narrow the lookup down. A description is only considered valid if it is equal to the
+// one stored for its key, since neither caller type hashes nor digests are verified against it.
+//
+// NOTE: Structural digests are stored as type hashes with an unset version, so they can never
+//       collide with a real type hash
+static rcutils_hash_map_t validation_cache;
+static atomic_bool validation_cache_lock;
+
+// Bumped whenever the cache is cleared, since keys may be taken by different descriptions after
+// that. Guarded by validation_cache_lock
+static uint64_t validation_cache_generation = 1;
+
+
+// NOTE: Only lookups, insertions and reference counting are done under the lock. Validation and
+//       comparisons against stored descriptions happen outside it
+static void
+lock_validation_cache(void)
+{
+  spin_lock_acquire(&validation_cache_lock);
+}
+
+
+static void
+unlock_validation_cache(void)
+{
+  spin_lock_release(&validation_cache_lock);
+}
+
+
+static size_t
+validation_cache_key_hash(const void * key)
+{
+  const rosidl_type_hash_t * type_hash = (const rosidl_type_hash_t *) key;
+
+  // Both type hashes and digests are already uniformly distributed
+  size_t bits = 0;
+  memcpy(&bits, type_hash->value, sizeof(bits));
+  return bits ^ type_hash->version;
+}
+
+
+static int
+validation_cache_key_cmp(const void * key_a, const void * key_b)
+{
+  const rosidl_type_hash_t * a = (const rosidl_type_hash_t *) key_a;
+  const rosidl_type_hash_t * b = (const rosidl_type_hash_t *) key_b;
+
+  if (a->version != b->version) {
+    return a->version < b->version ? -1 : 1;
+  }
+  return memcmp(a->value, b->value, sizeof(a->value));
+}
+
+
+// STRUCTURAL DIGEST ===============================================================================
+// FNV-1a over 8 byte words instead of single bytes. Digests are only compared within a process
+//
+// NOTE: This runs for every field of every description looked up, so it is kept cheap rather than
+//       well mixed. Colliding digests only cost a failed comparison against the stored description
+static uint64_t
+digest_bytes(uint64_t digest, const void * bytes, size_t size)
+{
+  const unsigned char * it = (const unsigned char *) bytes;
+  for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), it += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, it, sizeof(word));
+    digest ^= word;
+    digest *= DIGEST_PRIME;
+  }
+  for (; size > 0; size--, it++) {
+    digest ^= *it;
+    digest *= DIGEST_PRIME;
+  }
+  return digest;
+}
+
+
+static uint64_t
+digest_string(uint64_t digest, const rosidl_runtime_c__String * string)
+{
+  // Length first, so adjacent strings can't be shifted into each other
+  uint64_t size = string->size;
+  digest = digest_bytes(digest, &size, sizeof(size));
+  if (string->data == NULL) {
+    return digest;
+  }
+  return digest_bytes(digest, string->data, string->size);
+}
+
+
+static uint64_t
+digest_individual_description(
+  uint64_t digest,
+  const rosidl_runtime_c__type_description__IndividualTypeDescription * individual_description)
+{
+  digest = digest_string(digest, &individual_description->type_name);
+
+  uint64_t field_count = individual_description->fields.size;
+  digest = digest_bytes(digest, &field_count, sizeof(field_count));
+
+  for (size_t i = 0; i < individual_description->fields.size; i++) {
+    const rosidl_runtime_c__type_description__Field * field =
+      &individual_description->fields.data[i];
+    digest = digest_string(digest, &field->name);
+    digest = digest_bytes(digest, &field->type.type_id, sizeof(field->type.type_id));
+    digest = digest_bytes(digest, &field->type.capacity, sizeof(field->type.capacity));
+    digest = digest_bytes(
+      digest, &field->type.string_capacity, sizeof(field->type.string_capacity));
+    digest = digest_string(digest, &field->type.nested_type_name);
+    digest = digest_string(digest, &field->default_value);
+  }
+  return digest;
+}
+
+
+static rosidl_type_hash_t
+get_structural_digest(const rosidl_runtime_c__type_description__TypeDescription * description)
+{
+  uint64_t digest = digest_individual_description(
+    DIGEST_OFFSET_BASIS, &description->type_description);
+
+  uint64_t referenced_count = description->referenced_type_descriptions.size;
+  digest = digest_bytes(digest, &referenced_count, sizeof(referenced_count));
+  for (size_t i = 0; i < description->referenced_type_descriptions.size; i++) {
+    digest = digest_individual_description(
+      digest, &description->referenced_type_descriptions.data[i]);
+  }
+
+  // Words only carry their bits upwards, so fold the high bits into the low ones the key hash uses
+  digest ^= digest >> 32;
+
+  rosidl_type_hash_t key;
+  memset(&key, 0, sizeof(key));
+  key.version = ROSIDL_TYPE_HASH_VERSION_UNSET;
+  memcpy(key.value, &digest, sizeof(digest));
+  return key;
+}
+
+
+// VALIDATION CACHE ================================================================================
+static size_t
+get_validated_description_offset(void)
+{
+  return (sizeof(validated_description_t) + COMPACT_TYPE_DESCRIPTION_ALIGNMENT - 1) &
+         ~(COMPACT_TYPE_DESCRIPTION_ALIGNMENT - 1);
+}
+
+
+static void
+validated_description_release(validated_description_t * validated)
+{
+  lock_validation_cache();
+  bool last = --validated->ref_count == 0;
+  unlock_validation_cache();
+
+  if (last) {
+    rcutils_allocator_t allocator = rcutils_get_default_allocator();
+    allocator.deallocate(validated, allocator.state);
+  }
+}
+
+
+// Sets `generation` to the generation the description was found in
+static bool
+validation_cache_contains(
+  const rosidl_type_hash_t * key,
+  const rosidl_runtime_c__type_description__TypeDescription * description,
+  uint64_t * generation)
+{
+  validated_description_t * validated = NULL;
+
+  lock_validation_cache();
+  if (validation_cache.impl == NULL ||
+    rcutils_hash_map_get(&validation_cache, key, &validated) != RCUTILS_RET_OK)
+  {
+    unlock_validation_cache();
+    return false;
+  }
+  validated->ref_count++;
+  *generation = validation_cache_generation;
+  unlock_validation_cache();
+
+  // Stored descriptions are immutable, and the reference keeps this one alive even if the cache
+  // is cleared meanwhile, so other threads don't have to wait for the comparison
+  bool found = rosidl_runtime_c__type_description__TypeDescription__are_equal(
+    &validated->description, description);
+  validated_description_release(validated);
+  return found;
+}
+
+
+// Returns the generation the description was inserted in, or 0 if it was not
+static uint64_t
+validation_cache_insert(
+  const rosidl_type_hash_t * key,
+  const rosidl_runtime_c__type_description__TypeDescription * description)
+{
+  // Not remembering a verdict is harmless, the description just gets validated again next time
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  size_t offset = get_validated_description_offset();
+  validated_description_t * validated = allocator.allocate(
+    offset + compact_type_description_get_size(description, NULL), allocator.state);
+  if (validated == NULL) {
+    return 0;
+  }
+  compact_type_description_pack(
+    description, NULL, (uint8_t *) validated + offset,
+    &validated->description, &validated->unused_sources);
+  validated->ref_count = 1;
+
+  lock_validation_cache();
+  if (validation_cache.impl == NULL) {
+    if (rcutils_hash_map_init(
+        &validation_cache, 64, sizeof(rosidl_type_hash_t), sizeof(validated_description_t *),
+        validation_cache_key_hash, validation_cache_key_cmp, &allocator) != RCUTILS_RET_OK)
+    {
+      rcutils_reset_error();
+      validation_cache = rcutils_get_zero_initialized_hash_map();
+      unlock_validation_cache();
+      allocator.deallocate(validated, allocator.state);
+      return 0;
+    }
+  }
+
+  // Keys already taken (by a different description with the same key, or by another thread that
+  // validated the same one) keep their description
+  uint64_t generation = 0;
+  size_t size = 0;
+  if (!rcutils_hash_map_key_exists(&validation_cache, key) &&
+    rcutils_hash_map_get_size(&validation_cache, &size) == RCUTILS_RET_OK &&
+    size < VALIDATION_CACHE_MAX_ENTRIES)
+  {
+    if (rcutils_hash_map_set(&validation_cache, key, &validated) == RCUTILS_RET_OK) {
+      validated = NULL;
+      generation = validation_cache_generation;
+    } else {
+      rcutils_reset_error();
+    }
+  }
+  unlock_validation_cache();
+  allocator.deallocate(validated, allocator.state);
+  return generation;
+}
+
+
+rcutils_ret_t
+type_description_validation_cache_check(
+  const rosidl_runtime_c__type_description__TypeDescription * description,
+  const rosidl_type_hash_t * type_hash,
+  uint64_t * type_hash_verification)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(description, RCUTILS_RET_INVALID_ARGUMENT);
+
+  rosidl_type_hash_t key;
+  bool key_is_type_hash =
+    type_hash != NULL && type_hash->version != ROSIDL_TYPE_HASH_VERSION_UNSET;
+  if (key_is_type_hash) {
+    key = *type_hash;
+  } else {
+    key = get_structural_digest(description);
+  }
+
+  uint64_t generation = 0;
+  if (validation_cache_contains(&key, description, &generation)) {
+    if (type_hash_verification != NULL) {
+      *type_hash_verification = key_is_type_hash ? generation : 0;
+    }
+    return RCUTILS_RET_OK;
+  }
+
+  if (rosidl_runtime_c_type_description_utils_type_description_is_valid(description) !=
+    RCUTILS_RET_OK)
+  {
+    rcutils_error_string_t error_string = rcutils_get_error_string();
+    rcutils_reset_error();
+    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING("Type description is not valid: %s", error_string.str);
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+
+  generation = validation_cache_insert(&key, description);
+  if (type_hash_verification != NULL) {
+    *type_hash_verification = key_is_type_hash ? generation : 0;
+  }
+  return RCUTILS_RET_OK;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_clear_type_description_validation_cache(void)
+{
+  lock_validation_cache();
+  rcutils_hash_map_t cleared = validation_cache;
+  validation_cache = rcutils_get_zero_initialized_hash_map();
+  validation_cache_generation++;
+  unlock_validation_cache();
+
+  if (cleared.impl == NULL) {
+    return RCUTILS_RET_OK;
+  }
+
+  // Descriptions still being compared against are deallocated once their lookups are done
+  rosidl_type_hash_t key;
+  rosidl_type_hash_t previous_key;
+  validated_description_t * validated = NULL;
+  rcutils_ret_t ret = rcutils_hash_map_get_next_key_and_data(&cleared, NULL, &key, &validated);
+  while (ret == RCUTILS_RET_OK) {
+    validated_description_release(validated);
+    previous_key = key;
+    ret = rcutils_hash_map_get_next_key_and_data(&cleared, &previous_key, &key, &validated);
+  }
+  return rcutils_hash_map_fini(&cleared);
+}
@@ -0,0 +1,64 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TYPE_DESCRIPTION_VALIDATION_CACHE_H_
+#define TYPE_DESCRIPTION_VALIDATION_CACHE_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/type_description/type_description__struct.h>
+#include <rosidl_runtime_c/type_hash.h>
+
+
+// TYPE DESCRIPTION VALIDATION CACHE ===============================================================
+// A process-wide record of type descriptions that already passed
+// `rosidl_runtime_c_type_description_utils_type_description_is_valid()`.
+//
+// Only successful verdicts are remembered, so invalid descriptions always get a fresh error
+// message. Every remembered description is kept as a packed copy until the cache is cleared with
+// `rosidl_dynamic_typesupport_clear_type_description_validation_cache()`.
+
+/// Validate a type description, unless an equal one was already found to be valid
+/**
+ * Descriptions are looked up by `type_hash` if it is set, or by a structural digest of
+ * `description` otherwise. Neither is trusted: validation is only skipped if the description
+ * remembered for the key is equal to `description`, field by field.
+ *
+ * If `type_hash_verification` is not NULL, it is set to a nonzero value if `description` is equal
+ * to the one remembered for `type_hash`. Every description verified under the same type hash and
+ * the same value is equal, so dynamic types built from them are too. It is set to 0 if there is
+ * nothing to vouch for that (no type hash, a full cache, or another description remembered for
+ * the type hash).
+ *
+ * Returns RCUTILS_RET_INVALID_ARGUMENT with the validation error message if the description is not
+ * valid.
+ */
+rcutils_ret_t
+type_description_validation_cache_check(
+  const rosidl_runtime_c__type_description__TypeDescription * description,
+  const rosidl_type_hash_t * type_hash,  // Nullable
+  uint64_t * type_hash_verification);  // Nullable, OUT
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TYPE_DESCRIPTION_VALIDATION_CACHE_H_
@@ -0,0 +1,526 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/types/hash_map.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/type_description/field__struct.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__struct.h>
+#include <rosidl_runtime_c/type_description/type_description__struct.h>
+
+#include "rosidl_dynamic_typesupport/type_plan.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+
+// Type states while ordering types, see compute_type_properties()
+#define TYPE_STATE_UNVISITED 0
+#define TYPE_STATE_VISITING 1
+#define TYPE_STATE_DONE 2
+
+#define FIELD_SEQUENCE_FLAGS \
+  (ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_BOUNDED_SEQUENCE | \
+  ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_UNBOUNDED_SEQUENCE)
+
+
+rosidl_dynamic_typesupport_type_plan_t
+rosidl_dynamic_typesupport_get_zero_initialized_type_plan(void)
+{
+  rosidl_dynamic_typesupport_type_plan_t zero_type_plan;
+  memset(&zero_type_plan, 0, sizeof(zero_type_plan));
+  zero_type_plan.allocator = rcutils_get_zero_initialized_allocator();
+  return zero_type_plan;
+}
+
+
+// TYPE PLAN CONSTRUCTION ==========================================================================
+static const rosidl_runtime_c__type_description__IndividualTypeDescription *
+get_individual_description(
+  const rosidl_runtime_c__type_description__TypeDescription * description, size_t type_index)
+{
+  if (type_index == 0) {
+    return &description->type_description;
+  }
+  return &description->referenced_type_descriptions.data[type_index - 1];
+}
+
+
+// Reserve space for a table in the plan's storage, and return its offset into the storage
+static size_t
+reserve_table(size_t * storage_size, size_t count, size_t element_size, size_t alignment)
+{
+  size_t offset = (*storage_size + alignment - 1) / alignment * alignment;
+  *storage_size = offset + count * element_size;
+  return offset;
+}
+
+
+// Copy a (possibly NULL) string into the plan's string storage, NULL terminated
+static const char *
+copy_name(char ** string_storage, const rosidl_runtime_c__String * name, size_t * name_length)
+{
+  char * copy = *string_storage;
+  *name_length = name->data == NULL ? 0 : name->size;
+  if (*name_length > 0) {
+    memcpy(copy, name->data, *name_length);
+  }
+  copy[*name_length] = '\0';
+  *string_storage += *name_length + 1;
+  return copy;
+}
+
+
+// Split a field type id into its element type id and container flags, and flag the element kind
+//
+// NOTE: Nested elements only get their POD and FIXED_SIZE flags once the type they
+//       refer to is known to be fixed size (see compute_type_properties())
+static rcutils_ret_t
+get_field_layout(uint8_t type_id, uint8_t * element_type_id, uint8_t * flags)
+{
+  // Arrays, bounded sequences, and unbounded sequences of each element type are offset from the
+  // single element type ids by the same amount as the nested type ones are
+  const uint8_t nested = ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE;
+  const uint8_t nested_array = ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_ARRAY;
+  const uint8_t nested_bounded_sequence =
+    ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_BOUNDED_SEQUENCE;
+  const uint8_t nested_unbounded_sequence =
+    ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_UNBOUNDED_SEQUENCE;
+
+  if (type_id >= nested_unbounded_sequence) {
+    *element_type_id = type_id - (nested_unbounded_sequence - nested);
+    *flags = ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_UNBOUNDED_SEQUENCE;
+  } else if (type_id >= nested_bounded_sequence) {
+    *element_type_id = type_id - (nested_bounded_sequence - nested);
+    *flags = ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_BOUNDED_SEQUENCE;
+  } else if (type_id >= nested_array) {
+    *element_type_id = type_id - (nested_array - nested);
+    *flags = ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_ARRAY;
+  } else {
+    *element_type_id = type_id;
+    *flags = 0;
+  }
+
+  switch (*element_type_id) {
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE:
+      *flags |= ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_NESTED;
+      return RCUTILS_RET_OK;
+
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_STRING:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_WSTRING:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FIXED_STRING:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FIXED_WSTRING:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_STRING:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_WSTRING:
+      *flags |= ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_STRING;
+      return RCUTILS_RET_OK;
+
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOOLEAN:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BYTE:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_CHAR:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_WCHAR:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT32:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT64:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT128:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT8:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT8:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT16:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT16:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT32:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT64:
+    case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT64:
+      *flags |= ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_POD;
+      if (!(*flags & FIELD_SEQUENCE_FLAGS)) {
+        *flags |= ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_FIXED_SIZE;
+      }
+      return RCUTILS_RET_OK;
+
+    default:
+      RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING("Invalid field type id: %d !", type_id);
+      return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+}
+
+
+// Compute the depth and fixed size-ness of every type, and finish the flags of nested fields
+//
+// Types are visited depth first (iteratively, with an explicit stack) so every type is handled
+// after all of the types it refers to, which also catches any cycles.
+static rcutils_ret_t
+compute_type_properties(
+  rosidl_dynamic_typesupport_type_plan_t * plan, rcutils_allocator_t * allocator)
+{
+  typedef struct type_plan_frame_s
+  {
+    size_t type_index;
+    size_t next_field;
+  } type_plan_frame_t;
+
+  // A chain of nested types can't be longer than the number of types without a cycle
+  type_plan_frame_t * stack = allocator->allocate(
+    plan->type_count * sizeof(type_plan_frame_t), allocator->state);
+  uint8_t * states = allocator->zero_allocate(plan->type_count, sizeof(uint8_t), allocator->state);
+  if (stack == NULL || states == NULL) {
+    RCUTILS_SET_ERROR_MSG("Could not allocate type plan construction state");
+    allocator->deallocate(stack, allocator->state);
+    allocator->deallocate(states, allocator->state);
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+
+  rcutils_ret_t ret = RCUTILS_RET_OK;
+  for (size_t root = 0; root < plan->type_count && ret == RCUTILS_RET_OK; root++) {
+    if (states[root] != TYPE_STATE_UNVISITED) {
+      continue;
+    }
+
+    size_t stack_size = 1;
+    stack[0].type_index = root;
+    stack[0].next_field = plan->type_first_fields[root];
+    states[root] = TYPE_STATE_VISITING;
+
+    while (stack_size > 0) {
+      type_plan_frame_t * frame = &stack[stack_size - 1];
+      size_t type_index = frame->type_index;
+      size_t first_field = plan->type_first_fields[type_index];
+      size_t end_field = first_field + plan->type_field_counts[type_index];
+
+      if (frame->next_field < end_field) {
+        size_t nested_type = plan->field_nested_types[frame->next_field++];
+        if (nested_type == ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_NO_NESTED_TYPE) {
+          continue;
+        }
+        if (states[nested_type] == TYPE_STATE_VISITING) {
+          RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+            "Type description references itself through nested type [%s]",
+            plan->type_names[nested_type]);
+          ret = RCUTILS_RET_INVALID_ARGUMENT;
+          break;
+        }
+        if (states[nested_type] == TYPE_STATE_UNVISITED) {
+          states[nested_type] = TYPE_STATE_VISITING;
+          stack[stack_size].type_index = nested_type;
+          stack[stack_size].next_field = plan->type_first_fields[nested_type];
+          stack_size++;
+        }
+        continue;
+      }
+
+      // Every type this one refers to is done, so it can be finished
+      size_t depth = 0;
+      bool is_fixed_size = true;
+      for (size_t i = first_field; i < end_field; i++) {
+        size_t nested_type = plan->field_nested_types[i];
+        if (nested_type != ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_NO_NESTED_TYPE) {
+          if (plan->type_depths[nested_type] + 1 > depth) {
+            depth = plan->type_depths[nested_type] + 1;
+          }
+          if (plan->type_is_fixed_size[nested_type]) {
+            plan->field_flags[i] |= ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_POD;
+            if (!(plan->field_flags[i] & FIELD_SEQUENCE_FLAGS)) {
+              plan->field_flags[i] |= ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_FIXED_SIZE;
+            }
+          }
+        }
+        if (!(plan->field_flags[i] & ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_FIXED_SIZE)) {
+          is_fixed_size = false;
+        }
+      }
+      plan->type_depths[type_index] = depth;
+      plan->type_is_fixed_size[type_index] = is_fixed_size;
+      states[type_index] = TYPE_STATE_DONE;
+      stack_size--;
+    }
+  }
+
+  allocator->deallocate(stack, allocator->state);
+  allocator->deallocate(states, allocator->state);
+  return ret;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_type_plan_init(
+  const rosidl_runtime_c__type_description__TypeDescription * description,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_type_plan_t * plan)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(description, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(allocator, RCUTILS_RET_INVALID_ARGUMENT);
+  if (!rcutils_allocator_is_valid(allocator)) {
+    RCUTILS_SET_ERROR_MSG("allocator is invalid");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(plan, RCUTILS_RET_INVALID_ARGUMENT);
+
+  *plan = rosidl_dynamic_typesupport_get_zero_initialized_type_plan();
+  plan->allocator = *allocator;
+  plan->type_count = 1 + description->referenced_type_descriptions.size;
+
+  size_t string_size = 0;
+  for (size_t t = 0; t < plan->type_count; t++) {
+    const rosidl_runtime_c__type_description__IndividualTypeDescription * individual_description =
+      get_individual_description(description, t);
+    string_size += individual_description->type_name.size + 1;
+    plan->field_count += individual_description->fields.size;
+    for (size_t i = 0; i < individual_description->fields.size; i++) {
+      string_size += individual_description->fields.data[i].name.size + 1;
+    }
+  }
+
+  // Lay out every table (and then the strings) in one allocation
+  size_t types = plan->type_count;
+  size_t fields = plan->field_count;
+  size_t storage_size = 0;
+#define RESERVE_TABLE(COUNT, TYPE) \
+  reserve_table(&storage_size, COUNT, sizeof(TYPE), _Alignof(TYPE))
+  size_t type_names = RESERVE_TABLE(types, const char *);
+  size_t type_name_lengths = RESERVE_TABLE(types, size_t);
+  size_t type_first_fields = RESERVE_TABLE(types, size_t);
+  size_t type_field_counts = RESERVE_TABLE(types, size_t);
+  size_t type_depths = RESERVE_TABLE(types, size_t);
+  size_t type_is_fixed_size = RESERVE_TABLE(types, bool);
+  size_t field_names = RESERVE_TABLE(fields, const char *);
+  size_t field_name_lengths = RESERVE_TABLE(fields, size_t);
+  size_t field_member_ids = RESERVE_TABLE(fields, rosidl_dynamic_typesupport_member_id_t);
+  size_t field_type_ids = RESERVE_TABLE(fields, uint8_t);
+  size_t field_element_type_ids = RESERVE_TABLE(fields, uint8_t);
+  size_t field_capacities = RESERVE_TABLE(fields, size_t);
+  size_t field_string_capacities = RESERVE_TABLE(fields, size_t);
+  size_t field_nested_types = RESERVE_TABLE(fields, size_t);
+  size_t field_flags = RESERVE_TABLE(fields, uint8_t);
+  size_t strings = RESERVE_TABLE(string_size, char);
+#undef RESERVE_TABLE
+
+  char * storage = allocator->zero_allocate(1, storage_size, allocator->state);
+  if (storage == NULL) {
+    RCUTILS_SET_ERROR_MSG("Could not allocate type plan");
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  plan->storage = storage;
+  plan->storage_size = storage_size;
+  plan->type_names = (const char **) (storage + type_names);
+  plan->type_name_lengths = (size_t *) (storage + type_name_lengths);
+  plan->type_first_fields = (size_t *) (storage + type_first_fields);
+  plan->type_field_counts = (size_t *) (storage + type_field_counts);
+  plan->type_depths = (size_t *) (storage + type_depths);
+  plan->type_is_fixed_size = (bool *) (storage + type_is_fixed_size);
+  plan->field_names = (const char **) (storage + field_names);
+  plan->field_name_lengths = (size_t *) (storage + field_name_lengths);
+  plan->field_member_ids =
+    (rosidl_dynamic_typesupport_member_id_t *) (storage + field_member_ids);
+  plan->field_type_ids = (uint8_t *) (storage + field_type_ids);
+  plan->field_element_type_ids = (uint8_t *) (storage + field_element_type_ids);
+  plan->field_capacities = (size_t *) (storage + field_capacities);
+  plan->field_string_capacities = (size_t *) (storage + field_string_capacities);
+  plan->field_nested_types = (size_t *) (storage + field_nested_types);
+  plan->field_flags = (uint8_t *) (storage + field_flags);
+  char * string_storage = storage + strings;
+
+  // Type names first, so nested type names can be resolved to type indices while adding fields
+  rcutils_hash_map_t type_indices = rcutils_get_zero_initialized_hash_map();
+  rcutils_ret_t ret = rcutils_hash_map_init(
+    &type_indices, plan->type_count, sizeof(const char *), sizeof(size_t),
+    rcutils_hash_map_string_hash_func, rcutils_hash_map_string_cmp_func, allocator);
+  if (ret != RCUTILS_RET_OK) {
+    RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR("Could not initialize type plan type index");
+    goto fail;
+  }
+
+  size_t next_field = 0;
+  for (size_t t = 0; t < plan->type_count; t++) {
+    const rosidl_runtime_c__type_description__IndividualTypeDescription * individual_description =
+      get_individual_description(description, t);
+    plan->type_names[t] = copy_name(
+      &string_storage, &individual_description->type_name, &plan->type_name_lengths[t]);
+    plan->type_first_fields[t] = next_field;
+    plan->type_field_counts[t] = individual_description->fields.size;
+    next_field += individual_description->fields.size;
+
+    // Top level type is never nested, and the first of duplicated names wins
+    if (t > 0 && !rcutils_hash_map_key_exists(&type_indices, &plan->type_names[t])) {
+      ret = rcutils_hash_map_set(&type_indices, &plan->type_names[t], &t);
+      if (ret != RCUTILS_RET_OK) {
+        RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR("Could not index type plan type");
+        goto fail;
+      }
+    }
+  }
+
+  for (size_t t = 0; t < plan->type_count; t++) {
+    const rosidl_runtime_c__type_description__IndividualTypeDescription * individual_description =
+      get_individual_description(description, t);
+
+    for (size_t i = 0; i < individual_description->fields.size; i++) {
+      const rosidl_runtime_c__type_description__Field * field =
+        &individual_description->fields.data[i];
+      size_t f = plan->type_first_fields[t] + i;
+
+      plan->field_names[f] = copy_name(&string_storage, &field->name, &plan->field_name_lengths[f]);
+      plan->field_member_ids[f] = i;
+      plan->field_type_ids[f] = field->type.type_id;
+      plan->field_nested_types[f] = ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_NO_NESTED_TYPE;
+
+      ret = get_field_layout(
+        field->type.type_id, &plan->field_element_type_ids[f], &plan->field_flags[f]);
+      if (ret != RCUTILS_RET_OK) {
+        RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR("Could not compile type plan field");
+        goto fail;
+      }
+
+      if (plan->field_flags[f] & (ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_ARRAY |
+        ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_BOUNDED_SEQUENCE))
+      {
+        plan->field_capacities[f] = field->type.capacity;
+      }
+      switch (plan->field_element_type_ids[f]) {
+        case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FIXED_STRING:
+        case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FIXED_WSTRING:
+        case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_STRING:
+        case ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_WSTRING:
+          plan->field_string_capacities[f] = field->type.string_capacity;
+          break;
+        default:
+          break;
+      }
+
+      if (plan->field_flags[f] & ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_NESTED) {
+        const char * nested_type_name = field->type.nested_type_name.data;
+        if (nested_type_name == NULL ||
+          rcutils_hash_map_get(
+            &type_indices, &nested_type_name, &plan->field_nested_types[f]) != RCUTILS_RET_OK)
+        {
+          RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+            "Could not find referenced type description [%s]",
+            nested_type_name ? nested_type_name : "<null>");
+          ret = RCUTILS_RET_ERROR;
+          goto fail;
+        }
+      }
+    }
+  }
+
+  ret = compute_type_properties(plan, allocator);
+  if (ret != RCUTILS_RET_OK) {
+    goto fail;  // error already set
+  }
+
+  if (rcutils_hash_map_fini(&type_indices) != RCUTILS_RET_OK) {
+    RCUTILS_SAFE_FWRITE_TO_STDERR("Could not finalize type plan type index");
+  }
+  return RCUTILS_RET_OK;
+
+fail:
+  if (type_indices.impl != NULL && rcutils_hash_map_fini(&type_indices) != RCUTILS_RET_OK) {
+    RCUTILS_SAFE_FWRITE_TO_STDERR(
+      "While handling another error, could not finalize type plan type index");
+  }
+  allocator->deallocate(plan->storage, allocator->state);
+  *plan = rosidl_dynamic_typesupport_get_zero_initialized_type_plan();
+  return ret;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_type_plan_fini(rosidl_dynamic_typesupport_type_plan_t * plan)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(plan, RCUTILS_RET_INVALID_ARGUMENT);
+  if (plan->storage != NULL) {
+    plan->allocator.deallocate(plan->storage, plan->allocator.state);
+  }
+  *plan = rosidl_dynamic_typesupport_get_zero_initialized_type_plan();
+  return RCUTILS_RET_OK;
+}
+
+
+// TYPE PLAN WALK ==================================================================================
+rcutils_ret_t
+rosidl_dynamic_typesupport_type_plan_walk(
+  const rosidl_dynamic_typesupport_type_plan_t * plan,
+  size_t type_index,
+  const rosidl_dynamic_typesupport_type_plan_visitor_t * visitor)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(plan, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(visitor, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(visitor->visit_field, RCUTILS_RET_INVALID_ARGUMENT);
+  if (type_index >= plan->type_count) {
+    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+      "Type index %zu is out of range for a type plan with %zu types",
+      type_index, plan->type_count);
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+
+  typedef struct type_plan_walk_frame_s
+  {
+    size_t next_field;
+    size_t end_field;
+    size_t parent_field;  // The nested field this frame's type belongs to, SIZE_MAX at the start
+  } type_plan_walk_frame_t;
+
+  // The plan knows how deep every type goes, so the stack never has to grow
+  rcutils_allocator_t allocator = plan->allocator;
+  size_t stack_capacity = plan->type_depths[type_index] + 1;
+  type_plan_walk_frame_t * stack = allocator.allocate(
+    stack_capacity * sizeof(type_plan_walk_frame_t), allocator.state);
+  if (stack == NULL) {
+    RCUTILS_SET_ERROR_MSG("Could not allocate type plan walk stack");
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+
+  size_t stack_size = 1;
+  stack[0].next_field = plan->type_first_fields[type_index];
+  stack[0].end_field = stack[0].next_field + plan->type_field_counts[type_index];
+  stack[0].parent_field = SIZE_MAX;
+
+  rcutils_ret_t ret = RCUTILS_RET_OK;
+  while (stack_size > 0 && ret == RCUTILS_RET_OK) {
+    type_plan_walk_frame_t * frame = &stack[stack_size - 1];
+
+    if (frame->next_field == frame->end_field) {
+      size_t parent_field = frame->parent_field;
+      stack_size--;
+      if (parent_field != SIZE_MAX && visitor->leave_nested_field != NULL) {
+        ret = visitor->leave_nested_field(plan, parent_field, stack_size - 1, visitor->state);
+      }
+      continue;
+    }
+
+    size_t field_index = frame->next_field++;
+    size_t nested_type = plan->field_nested_types[field_index];
+    bool descend = nested_type != ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_NO_NESTED_TYPE;
+
+    ret = visitor->visit_field(plan, field_index, stack_size - 1, &descend, visitor->state);
+    if (ret == RCUTILS_RET_OK && descend &&
+      nested_type != ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_NO_NESTED_TYPE)
+    {
+      type_plan_walk_frame_t * nested_frame = &stack[stack_size++];
+      nested_frame->next_field = plan->type_first_fields[nested_type];
+      nested_frame->end_field = nested_frame->next_field + plan->type_field_counts[nested_type];
+      nested_frame->parent_field = field_index;
+    }
+  }
+
+  allocator.deallocate(stack, allocator.state);
+  return ret;
+}
+
+
+#undef FIELD_SEQUENCE_FLAGS
+#undef TYPE_STATE_DONE
+#undef TYPE_STATE_VISITING
+#undef TYPE_STATE_UNVISITED
@@ -0,0 +1,675 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rcutils/types/uint8_array.h>
+#include <rosidl_runtime_c/type_description/type_description__struct.h>
+#include <rosidl_runtime_c/type_hash.h>
+
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/macros.h"
+#include "rosidl_dynamic_typesupport/type_plan.h"
+#include "rosidl_dynamic_typesupport/type_snapshot.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "deferred_dynamic_type.h"
+
+
+// SNAPSHOT FORMAT =================================================================================
+// [header][entry table][chunks...]
+//
+// Chunks (identifier strings, type plans and serialization library blobs) are referenced by offset
+// from the start of the snapshot, and each start at a multiple of the snapshot alignment.
+//
+// NOTE: Integers are native, so loading a snapshot is only a bounds check away from
+//       using it. The header records enough to reject snapshots from other platforms
+
+#define SNAPSHOT_MAGIC "RDTSNAP"
+#define SNAPSHOT_BYTE_ORDER_MARK 0x01020304u
+
+typedef struct snapshot_header_s
+{
+  char magic[8];
+  uint32_t format_version;
+  uint32_t byte_order_mark;
+  uint32_t size_t_size;
+  uint32_t entry_count;
+  uint64_t size;
+} snapshot_header_t;
+
+typedef struct snapshot_entry_s
+{
+  uint64_t identifier_offset;
+  uint64_t identifier_length;
+  uint64_t plan_offset;
+  uint64_t plan_size;
+  uint64_t blob_offset;
+  uint64_t blob_size;
+  uint8_t type_hash_version;
+  uint8_t type_hash_value[ROSIDL_TYPE_HASH_SIZE];
+} snapshot_entry_t;
+
+// A type plan chunk is this header, followed by every plan table that holds no pointers (in the
+// order of plan_chunk_layout_t), then the type names and field names, each null terminated
+typedef struct snapshot_plan_header_s
+{
+  uint64_t type_count;
+  uint64_t field_count;
+  uint64_t names_size;
+} snapshot_plan_header_t;
+
+typedef struct plan_chunk_layout_s
+{
+  size_t type_name_lengths;
+  size_t type_first_fields;
+  size_t type_field_counts;
+  size_t type_depths;
+  size_t type_is_fixed_size;
+  size_t field_name_lengths;
+  size_t field_member_ids;
+  size_t field_type_ids;
+  size_t field_element_type_ids;
+  size_t field_capacities;
+  size_t field_string_capacities;
+  size_t field_nested_types;
+  size_t field_flags;
+  size_t names;
+  size_t size;
+} plan_chunk_layout_t;
+
+
+static size_t
+align_offset(size_t offset, size_t alignment)
+{
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+
+// Reserve space for a table in a plan chunk, and return its offset into the chunk
+static size_t
+reserve_table(size_t * chunk_size, size_t count, size_t element_size, size_t alignment)
+{
+  size_t offset = align_offset(*chunk_size, alignment);
+  *chunk_size = offset + count * element_size;
+  return offset;
+}
+
+
+static void
+get_plan_chunk_layout(
+  size_t types, size_t fields, size_t names_size, plan_chunk_layout_t * layout)
+{
+  size_t chunk_size = sizeof(snapshot_plan_header_t);
+#define RESERVE_TABLE(COUNT, TYPE) \
+  reserve_table(&chunk_size, COUNT, sizeof(TYPE), _Alignof(TYPE))
+  layout->type_name_lengths = RESERVE_TABLE(types, size_t);
+  layout->type_first_fields = RESERVE_TABLE(types, size_t);
+  layout->type_field_counts = RESERVE_TABLE(types, size_t);
+  layout->type_depths = RESERVE_TABLE(types, size_t);
+  layout->type_is_fixed_size = RESERVE_TABLE(types, bool);
+  layout->field_name_lengths = RESERVE_TABLE(fields, size_t);
+  layout->field_member_ids = RESERVE_TABLE(fields, rosidl_dynamic_typesupport_member_id_t);
+  layout->field_type_ids = RESERVE_TABLE(fields, uint8_t);
+  layout->field_element_type_ids = RESERVE_TABLE(fields, uint8_t);
+  layout->field_capacities = RESERVE_TABLE(fields, size_t);
+  layout->field_string_capacities = RESERVE_TABLE(fields, size_t);
+  layout->field_nested_types = RESERVE_TABLE(fields, size_t);
+  layout->field_flags = RESERVE_TABLE(fields, uint8_t);
+  layout->names = RESERVE_TABLE(names_size, char);
+#undef RESERVE_TABLE
+  layout->size = chunk_size;
+}
+
+
+static size_t
+get_plan_names_size(const rosidl_dynamic_typesupport_type_plan_t * plan)
+{
+  size_t names_size = 0;
+  for (size_t t = 0; t < plan->type_count; t++) {
+    names_size += plan->type_name_lengths[t] + 1;
+  }
+  for (size_t f = 0; f < plan->field_count; f++) {
+    names_size += plan->field_name_lengths[f] + 1;
+  }
+  return names_size;
+}
+
+
+static void
+write_plan_chunk(
+  const rosidl_dynamic_typesupport_type_plan_t * plan, const plan_chunk_layout_t * layout,
+  size_t names_size, uint8_t * chunk)
+{
+  snapshot_plan_header_t plan_header;
+  plan_header.type_count = plan->type_count;
+  plan_header.field_count = plan->field_count;
+  plan_header.names_size = names_size;
+  memcpy(chunk, &plan_header, sizeof(plan_header));
+
+  size_t types = plan->type_count;
+  size_t fields = plan->field_count;
+#define WRITE_TABLE(NAME, COUNT) \
+  memcpy(chunk + layout->NAME, plan->NAME, (COUNT) * sizeof(*plan->NAME))
+  WRITE_TABLE(type_name_lengths, types);
+  WRITE_TABLE(type_first_fields, types);
+  WRITE_TABLE(type_field_counts, types);
+  WRITE_TABLE(type_depths, types);
+  WRITE_TABLE(type_is_fixed_size, types);
+  WRITE_TABLE(field_name_lengths, fields);
+  WRITE_TABLE(field_member_ids, fields);
+  WRITE_TABLE(field_type_ids, fields);
+  WRITE_TABLE(field_element_type_ids, fields);
+  WRITE_TABLE(field_capacities, fields);
+  WRITE_TABLE(field_string_capacities, fields);
+  WRITE_TABLE(field_nested_types, fields);
+  WRITE_TABLE(field_flags, fields);
+#undef WRITE_TABLE
+
+  char * names = (char *) (chunk + layout->names);
+  for (size_t t = 0; t < types; t++) {
+    memcpy(names, plan->type_names[t], plan->type_name_lengths[t] + 1);
+    names += plan->type_name_lengths[t] + 1;
+  }
+  for (size_t f = 0; f < fields; f++) {
+    memcpy(names, plan->field_names[f], plan->field_name_lengths[f] + 1);
+    names += plan->field_name_lengths[f] + 1;
+  }
+}
+
+
+// Whether [offset, offset + size) is within the snapshot, and offset is suitably aligned
+static bool
+is_chunk_valid(uint64_t offset, uint64_t size, uint64_t snapshot_size)
+{
+  return offset % ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_SNAPSHOT_ALIGNMENT == 0 &&
+         offset <= snapshot_size && size <= snapshot_size - offset;
+}
+
+
+static const snapshot_entry_t *
+get_entry(const rosidl_dynamic_typesupport_type_snapshot_t * snapshot, size_t entry_index)
+{
+  return (const snapshot_entry_t *) (snapshot->data + sizeof(snapshot_header_t)) + entry_index;
+}
+
+
+// SNAPSHOT EXPORT =================================================================================
+rosidl_dynamic_typesupport_type_snapshot_t
+rosidl_dynamic_typesupport_get_zero_initialized_type_snapshot(void)
+{
+  rosidl_dynamic_typesupport_type_snapshot_t zero_type_snapshot;
+  memset(&zero_type_snapshot, 0, sizeof(zero_type_snapshot));
+  return zero_type_snapshot;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_type_snapshot_export(
+  const rosidl_dynamic_typesupport_dynamic_type_t * const * dynamic_types,
+  const rosidl_runtime_c__type_description__TypeDescription * const * descriptions,
+  size_t type_count,
+  rcutils_allocator_t * allocator,
+  rcutils_uint8_array_t * snapshot)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(dynamic_types, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(descriptions, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(allocator, RCUTILS_RET_INVALID_ARGUMENT);
+  if (!rcutils_allocator_is_valid(allocator)) {
+    RCUTILS_SET_ERROR_MSG("allocator is invalid");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(snapshot, RCUTILS_RET_INVALID_ARGUMENT);
+  if (type_count > UINT32_MAX) {
+    RCUTILS_SET_ERROR_MSG("Too many dynamic types for one snapshot");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+
+  for (size_t i = 0; i < type_count; i++) {
+    RCUTILS_CHECK_ARGUMENT_FOR_NULL(dynamic_types[i], RCUTILS_RET_INVALID_ARGUMENT);
+    RCUTILS_CHECK_ARGUMENT_FOR_NULL(descriptions[i], RCUTILS_RET_INVALID_ARGUMENT);
+    const rosidl_dynamic_typesupport_serialization_support_t * serialization_support =
+      dynamic_types[i]->serialization_support;
+    RCUTILS_CHECK_ARGUMENT_FOR_NULL(serialization_support, RCUTILS_RET_INVALID_ARGUMENT);
+    if (dynamic_types[i]->type_hash.version == ROSIDL_TYPE_HASH_VERSION_UNSET) {
+      RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+        "Dynamic type %zu has no type hash, so it can't be found in a snapshot", i);
+      return RCUTILS_RET_INVALID_ARGUMENT;
+    }
+    if (serialization_support->methods.dynamic_type_export_snapshot_blob == NULL) {
+      RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+        "Serialization library [%s] does not support type snapshots",
+        rosidl_dynamic_typesupport_serialization_support_get_library_identifier(
+          serialization_support));
+      return RCUTILS_RET_UNSUPPORTED;
+    }
+  }
+
+  rcutils_ret_t ret = RCUTILS_RET_ERROR;
+  rosidl_dynamic_typesupport_type_plan_t * plans = NULL;
+  rcutils_uint8_array_t * blobs = NULL;
+  size_t * names_sizes = NULL;
+  if (type_count > 0) {
+    plans = allocator->zero_allocate(
+      type_count, sizeof(rosidl_dynamic_typesupport_type_plan_t), allocator->state);
+    blobs = allocator->zero_allocate(type_count, sizeof(rcutils_uint8_array_t), allocator->state);
+    names_sizes = allocator->zero_allocate(type_count, sizeof(size_t), allocator->state);
+    if (plans == NULL || blobs == NULL || names_sizes == NULL) {
+      RCUTILS_SET_ERROR_MSG("Could not allocate snapshot export state");
+      ret = RCUTILS_RET_BAD_ALLOC;
+      goto end;
+    }
+  }
+  for (size_t i = 0; i < type_count; i++) {
+    plans[i] = rosidl_dynamic_typesupport_get_zero_initialized_type_plan();
+    blobs[i] = rcutils_get_zero_initialized_uint8_array();
+  }
+
+  // Compile and export everything first, so the snapshot can be allocated in one go
+  size_t snapshot_size =
+    sizeof(snapshot_header_t) + type_count * sizeof(snapshot_entry_t);
+  for (size_t i = 0; i < type_count; i++) {
+    const rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type = dynamic_types[i];
+    ret = rosidl_dynamic_typesupport_type_plan_init(descriptions[i], allocator, &plans[i]);
+    if (ret != RCUTILS_RET_OK) {
+      RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR("Could not compile type plan for snapshot");
+      goto end;
+    }
+    const rosidl_dynamic_typesupport_dynamic_type_impl_t * type_impl = NULL;
+    ret = deferred_dynamic_type_materialize(dynamic_type, &type_impl);
+    if (ret != RCUTILS_RET_OK) {
+      goto end;  // error already set
+    }
+    ret = (dynamic_type->serialization_support->methods.dynamic_type_export_snapshot_blob)(
+      &dynamic_type->serialization_support->impl, type_impl, allocator, &blobs[i]);
+    if (ret != RCUTILS_RET_OK) {
+      RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR("Could not export dynamic type to snapshot");
+      goto end;
+    }
+
+    plan_chunk_layout_t layout;
+    names_sizes[i] = get_plan_names_size(&plans[i]);
+    get_plan_chunk_layout(plans[i].type_count, plans[i].field_count, names_sizes[i], &layout);
+    const char * identifier =
+      rosidl_dynamic_typesupport_serialization_support_get_library_identifier(
+      dynamic_type->serialization_support);
+    snapshot_size = align_offset(snapshot_size, ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_SNAPSHOT_ALIGNMENT);
+    snapshot_size += strlen(identifier) + 1;
+    snapshot_size = align_offset(snapshot_size, ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_SNAPSHOT_ALIGNMENT);
+    snapshot_size += layout.size;
+    snapshot_size = align_offset(snapshot_size, ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_SNAPSHOT_ALIGNMENT);
+    snapshot_size += blobs[i].buffer_length;
+  }
+
+  ret = rcutils_uint8_array_init(snapshot, snapshot_size, allocator);
+  if (ret != RCUTILS_RET_OK) {
+    RCUTILS_SET_ERROR_MSG_AND_APPEND_PREV_ERROR("Could not allocate snapshot");
+    goto end;
+  }
+  uint8_t * data = snapshot->buffer;
+  memset(data, 0, snapshot_size);
+  snapshot->buffer_length = snapshot_size;
+
+  snapshot_header_t header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  header.format_version = ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_SNAPSHOT_FORMAT_VERSION;
+  header.byte_order_mark = SNAPSHOT_BYTE_ORDER_MARK;
+  header.size_t_size = sizeof(size_t);
+  header.entry_count = (uint32_t) type_count;
+  header.size = snapshot_size;
+  memcpy(data, &header, sizeof(header));
+
+  size_t offset = sizeof(snapshot_header_t) + type_count * sizeof(snapshot_entry_t);
+  for (size_t i = 0; i < type_count; i++) {
+    const rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type = dynamic_types[i];
+    snapshot_entry_t entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.type_hash_version = dynamic_type->type_hash.version;
+    memcpy(entry.type_hash_value, dynamic_type->type_hash.value, ROSIDL_TYPE_HASH_SIZE);
+
+    const char * identifier =
+      rosidl_dynamic_typesupport_serialization_support_get_library_identifier(
+      dynamic_type->serialization_support);
+    offset = align_offset(offset, ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_SNAPSHOT_ALIGNMENT);
+    entry.identifier_offset = offset;
+    entry.identifier_length = strlen(identifier);
+    memcpy(data + offset, identifier, entry.identifier_length + 1);
+    offset += entry.identifier_length + 1;
+
+    plan_chunk_layout_t layout;
+    get_plan_chunk_layout(plans[i].type_count, plans[i].field_count, names_sizes[i], &layout);
+    offset = align_offset(offset, ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_SNAPSHOT_ALIGNMENT);
+    entry.plan_offset = offset;
+    entry.plan_size = layout.size;
+    write_plan_chunk(&plans[i], &layout, names_sizes[i], data + offset);
+    offset += layout.size;
+
+    offset = align_offset(offset, ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_SNAPSHOT_ALIGNMENT);
+    entry.blob_offset = offset;
+    entry.blob_size = blobs[i].buffer_length;
+    if (entry.blob_size > 0) {
+      memcpy(data + offset, blobs[i].buffer, entry.blob_size);
+    }
+    offset += entry.blob_size;
+
+    memcpy(data + sizeof(snapshot_header_t) + i * sizeof(snapshot_entry_t), &entry, sizeof(entry));
+  }
+  ret = RCUTILS_RET_OK;
+
+end:
+  for (size_t i = 0; plans != NULL && blobs != NULL && i < type_count; i++) {
+    if (rosidl_dynamic_typesupport_type_plan_fini(&plans[i]) != RCUTILS_RET_OK) {
+      RCUTILS_SAFE_FWRITE_TO_STDERR("Could not finalize snapshot type plan");
+    }
+    if (blobs[i].buffer != NULL && rcutils_uint8_array_fini(&blobs[i]) != RCUTILS_RET_OK) {
+      RCUTILS_SAFE_FWRITE_TO_STDERR("Could not finalize snapshot blob");
+    }
+  }
+  allocator->deallocate(plans, allocator->state);
+  allocator->deallocate(blobs, allocator->state);
+  allocator->deallocate(names_sizes, allocator->state);
+  return ret;
+}
+
+
+// SNAPSHOT IMPORT =================================================================================
+rcutils_ret_t
+rosidl_dynamic_typesupport_type_snapshot_init(
+  const void * data,
+  size_t size,
+  rosidl_dynamic_typesupport_type_snapshot_t * snapshot)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(data, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(snapshot, RCUTILS_RET_INVALID_ARGUMENT);
+
+  if ((uintptr_t) data % ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_SNAPSHOT_ALIGNMENT != 0) {
+    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+      "Snapshot data must be aligned to %d bytes",
+      ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_SNAPSHOT_ALIGNMENT);
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  if (size < sizeof(snapshot_header_t)) {
+    RCUTILS_SET_ERROR_MSG("Snapshot is too small to be a snapshot");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+
+  const snapshot_header_t * header = (const snapshot_header_t *) data;
+  if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+    RCUTILS_SET_ERROR_MSG("Data is not a type snapshot");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  if (header->format_version != ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_SNAPSHOT_FORMAT_VERSION) {
+    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+      "Unsupported type snapshot format version %u (expected %d)",
+      (unsigned int) header->format_version,
+      ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_SNAPSHOT_FORMAT_VERSION);
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  if (header->byte_order_mark != SNAPSHOT_BYTE_ORDER_MARK ||
+    header->size_t_size != sizeof(size_t))
+  {
+    RCUTILS_SET_ERROR_MSG("Type snapshot was exported on an incompatible platform");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  if (header->size > size || header->size < sizeof(snapshot_header_t) ||
+    header->entry_count >
+    (header->size - sizeof(snapshot_header_t)) / sizeof(snapshot_entry_t))
+  {
+    RCUTILS_SET_ERROR_MSG("Type snapshot is truncated");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+
+  snapshot->data = (const uint8_t *) data;
+  snapshot->size = (size_t) header->size;
+  snapshot->entry_count = header->entry_count;
+
+  // Check every chunk once here, so loading entries only has to check what is inside them
+  for (size_t i = 0; i < snapshot->entry_count; i++) {
+    const snapshot_entry_t * entry = get_entry(snapshot, i);
+    if (entry->identifier_length >= snapshot->size ||
+      !is_chunk_valid(entry->identifier_offset, entry->identifier_length + 1, snapshot->size) ||
+      snapshot->data[entry->identifier_offset + entry->identifier_length] != '\0' ||
+      !is_chunk_valid(entry->plan_offset, entry->plan_size, snapshot->size) ||
+      entry->plan_size < sizeof(snapshot_plan_header_t) ||
+      !is_chunk_valid(entry->blob_offset, entry->blob_size, snapshot->size))
+    {
+      *snapshot = rosidl_dynamic_typesupport_get_zero_initialized_type_snapshot();
+      RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING("Type snapshot entry %zu is corrupt", i);
+      return RCUTILS_RET_INVALID_ARGUMENT;
+    }
+  }
+  return RCUTILS_RET_OK;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_type_snapshot_find(
+  const rosidl_dynamic_typesupport_type_snapshot_t * snapshot,
+  const char * serialization_library_identifier,
+  const rosidl_type_hash_t * type_hash,
+  size_t * entry_index)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(snapshot, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(serialization_library_identifier, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(type_hash, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(entry_index, RCUTILS_RET_INVALID_ARGUMENT);
+
+  // NOTE: Snapshots hold the handful of types a process starts with, so a linear scan
+  //       over the entry table is enough
+  size_t identifier_length = strlen(serialization_library_identifier);
+  for (size_t i = 0; i < snapshot->entry_count; i++) {
+    const snapshot_entry_t * entry = get_entry(snapshot, i);
+    if (entry->type_hash_version == type_hash->version &&
+      memcmp(entry->type_hash_value, type_hash->value, ROSIDL_TYPE_HASH_SIZE) == 0 &&
+      entry->identifier_length == identifier_length &&
+      memcmp(
+        snapshot->data + entry->identifier_offset, serialization_library_identifier,
+        identifier_length) == 0)
+    {
+      *entry_index = i;
+      return RCUTILS_RET_OK;
+    }
+  }
+  return RCUTILS_RET_NOT_FOUND;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_type_snapshot_load_dynamic_type(
+  const rosidl_dynamic_typesupport_type_snapshot_t * snapshot,
+  size_t entry_index,
+  rosidl_dynamic_typesupport_serialization_support_t * serialization_support,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(snapshot, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(serialization_support, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(allocator, RCUTILS_RET_INVALID_ARGUMENT);
+  if (!rcutils_allocator_is_valid(allocator)) {
+    RCUTILS_SET_ERROR_MSG("allocator is invalid");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(dynamic_type, RCUTILS_RET_INVALID_ARGUMENT);
+  if (entry_index >= snapshot->entry_count) {
+    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+      "Entry index %zu is out of range for a snapshot with %zu entries",
+      entry_index, snapshot->entry_count);
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+
+  const snapshot_entry_t * entry = get_entry(snapshot, entry_index);
+  const char * identifier =
+    rosidl_dynamic_typesupport_serialization_support_get_library_identifier(serialization_support);
+  if (identifier == NULL ||
+    strcmp(identifier, (const char *) (snapshot->data + entry->identifier_offset)) != 0)
+  {
+    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+      "Snapshot entry was exported by serialization library [%s], not [%s]",
+      (const char *) (snapshot->data + entry->identifier_offset),
+      identifier ? identifier : "<null>");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  if (serialization_support->methods.dynamic_type_init_from_snapshot_blob == NULL) {
+    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+      "Serialization library [%s] does not support type snapshots", identifier);
+    return RCUTILS_RET_UNSUPPORTED;
+  }
+
+  if (dynamic_type->impl.handle != NULL || dynamic_type->deferred != NULL) {
+    ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK(
+      rosidl_dynamic_typesupport_dynamic_type_fini(dynamic_type)
+    );
+  }
+
+  dynamic_type->serialization_support = serialization_support;
+  dynamic_type->allocator = *allocator;
+  dynamic_type->type_hash = rosidl_get_zero_initialized_type_hash();
+  dynamic_type->type_hash.version = entry->type_hash_version;
+  memcpy(dynamic_type->type_hash.value, entry->type_hash_value, ROSIDL_TYPE_HASH_SIZE);
+  // Snapshots are just data, the description was never compared to anything in this process
+  dynamic_type->type_hash_verification = 0;
+  ROSIDL_DYNAMIC_TYPESUPPORT_CHECK_RET_FOR_NOT_OK_WITH_CLEANUP(
+    (serialization_support->methods.dynamic_type_init_from_snapshot_blob)(
+      &serialization_support->impl,
+      snapshot->data + entry->blob_offset, (size_t) entry->blob_size,
+      allocator,
+      &dynamic_type->impl),
+    rosidl_dynamic_typesupport_dynamic_type_fini(dynamic_type) // Cleanup
+  );
+  return RCUTILS_RET_OK;
+}
+
+
+rcutils_ret_t
+rosidl_dynamic_typesupport_type_snapshot_load_type_plan(
+  const rosidl_dynamic_typesupport_type_snapshot_t * snapshot,
+  size_t entry_index,
+  rcutils_allocator_t * allocator,
+  rosidl_dynamic_typesupport_type_plan_t * plan)
+{
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(snapshot, RCUTILS_RET_INVALID_ARGUMENT);
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(allocator, RCUTILS_RET_INVALID_ARGUMENT);
+  if (!rcutils_allocator_is_valid(allocator)) {
+    RCUTILS_SET_ERROR_MSG("allocator is invalid");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  RCUTILS_CHECK_ARGUMENT_FOR_NULL(plan, RCUTILS_RET_INVALID_ARGUMENT);
+  if (entry_index >= snapshot->entry_count) {
+    RCUTILS_SET_ERROR_MSG_WITH_FORMAT_STRING(
+      "Entry index %zu is out of range for a snapshot with %zu entries",
+      entry_index, snapshot->entry_count);
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+
+  const snapshot_entry_t * entry = get_entry(snapshot, entry_index);
+  const uint8_t * chunk = snapshot->data + entry->plan_offset;
+  snapshot_plan_header_t plan_header;
+  memcpy(&plan_header, chunk, sizeof(plan_header));
+
+  // Counts are bounded by the chunk size before computing the layout, so it can't overflow
+  if (plan_header.type_count == 0 || plan_header.type_count > entry->plan_size ||
+    plan_header.field_count > entry->plan_size || plan_header.names_size > entry->plan_size)
+  {
+    RCUTILS_SET_ERROR_MSG("Snapshot type plan is corrupt");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+  size_t types = (size_t) plan_header.type_count;
+  size_t fields = (size_t) plan_header.field_count;
+  size_t names_size = (size_t) plan_header.names_size;
+  plan_chunk_layout_t layout;
+  get_plan_chunk_layout(types, fields, names_size, &layout);
+  if (layout.size > entry->plan_size) {
+    RCUTILS_SET_ERROR_MSG("Snapshot type plan is corrupt");
+    return RCUTILS_RET_INVALID_ARGUMENT;
+  }
+
+  rosidl_dynamic_typesupport_type_plan_t loaded_plan =
+    rosidl_dynamic_typesupport_get_zero_initialized_type_plan();
+  loaded_plan.allocator = *allocator;
+  loaded_plan.type_count = types;
+  loaded_plan.field_count = fields;
+
+  // NOTE: Plans are never modified, so casting away the const is fine
+#define LOAD_TABLE(NAME, TYPE) \
+  loaded_plan.NAME = (TYPE *) (chunk + layout.NAME)
+  LOAD_TABLE(type_name_lengths, size_t);
+  LOAD_TABLE(type_first_fields, size_t);
+  LOAD_TABLE(type_field_counts, size_t);
+  LOAD_TABLE(type_depths, size_t);
+  LOAD_TABLE(type_is_fixed_size, bool);
+  LOAD_TABLE(field_name_lengths, size_t);
+  LOAD_TABLE(field_member_ids, rosidl_dynamic_typesupport_member_id_t);
+  LOAD_TABLE(field_type_ids, uint8_t);
+  LOAD_TABLE(field_element_type_ids, uint8_t);
+  LOAD_TABLE(field_capacities, size_t);
+  LOAD_TABLE(field_string_capacities, size_t);
+  LOAD_TABLE(field_nested_types, size_t);
+  LOAD_TABLE(field_flags, uint8_t);
+#undef LOAD_TABLE
+
+  // Walking a plan trusts its indices, so check them all
+  for (size_t t = 0; t < types; t++) {
+    if (loaded_plan.type_first_fields[t] > fields ||
+      loaded_plan.type_field_counts[t] > fields - loaded_plan.type_first_fields[t])
+    {
+      RCUTILS_SET_ERROR_MSG("Snapshot type plan is corrupt");
+      return RCUTILS_RET_INVALID_ARGUMENT;
+    }
+  }
+  for (size_t f = 0; f < fields; f++) {
+    if (loaded_plan.field_nested_types[f] != ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_NO_NESTED_TYPE &&
+      loaded_plan.field_nested_types[f] >= types)
+    {
+      RCUTILS_SET_ERROR_MSG("Snapshot type plan is corrupt");
+      return RCUTILS_RET_INVALID_ARGUMENT;
+    }
+  }
+
+  // Only the name tables hold pointers, so they are the only thing that has to be allocated
+  const char ** names = allocator->allocate(
+    (types + fields) * sizeof(const char *), allocator->state);
+  if (names == NULL) {
+    RCUTILS_SET_ERROR_MSG("Could not allocate type plan name tables");
+    return RCUTILS_RET_BAD_ALLOC;
+  }
+  loaded_plan.storage = names;
+  loaded_plan.storage_size = (types + fields) * sizeof(const char *);
+  loaded_plan.type_names = names;
+  loaded_plan.field_names = names + types;
+
+  const char * name = (const char *) (chunk + layout.names);
+  const char * names_end = name + names_size;
+  for (size_t i = 0; i < types + fields; i++) {
+    size_t name_length = i < types ?
+      loaded_plan.type_name_lengths[i] : loaded_plan.field_name_lengths[i - types];
+    if (name_length >= (size_t) (names_end - name) || name[name_length] != '\0') {
+      allocator->deallocate(names, allocator->state);
+      RCUTILS_SET_ERROR_MSG("Snapshot type plan is corrupt");
+      return RCUTILS_RET_INVALID_ARGUMENT;
+    }
+    names[i] = name;
+    name += name_length + 1;
+  }
+
+  *plan = loaded_plan;
+  return RCUTILS_RET_OK;
+}
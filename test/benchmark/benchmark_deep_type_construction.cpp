@@ -0,0 +1,82 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include <rcutils/allocator.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__functions.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+
+#include "performance_test_fixture/performance_test_fixture.hpp"
+
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+using performance_test_fixture::PerformanceTest;
+
+// Builds a chain of as many nested types as the benchmark argument says, where every type has an
+// int32 field and a field of the next type in the chain
+BENCHMARK_DEFINE_F(PerformanceTest, init_from_deep_description)(benchmark::State & st)
+{
+  const size_t depth = static_cast<size_t>(st.range(0));
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support =
+    get_fake_serialization_support();
+
+  std::vector<std::string> names;
+  for (size_t i = 0; i <= depth; i++) {
+    names.push_back("test_msgs/msg/Level" + std::to_string(i));
+  }
+
+  rosidl_runtime_c__type_description__TypeDescription description;
+  if (!rosidl_runtime_c__type_description__TypeDescription__init(&description) ||
+    !rosidl_runtime_c__type_description__IndividualTypeDescription__Sequence__init(
+      &description.referenced_type_descriptions, depth))
+  {
+    st.SkipWithError("Could not initialize type description");
+    return;
+  }
+  for (size_t i = 0; i <= depth; i++) {
+    std::vector<FieldSpec> fields = {{"x", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr}};
+    if (i < depth) {
+      fields.push_back(
+        {"next", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, names[i + 1].c_str()});
+    }
+    fill_individual_type_description(
+      names[i].c_str(), fields,
+      i == 0 ? &description.type_description :
+      &description.referenced_type_descriptions.data[i - 1]);
+  }
+
+  reset_heap_counters();
+  for (auto _ : st) {
+    rosidl_dynamic_typesupport_dynamic_type_t dynamic_type =
+      rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+    if (rosidl_dynamic_typesupport_dynamic_type_init_from_description(
+        &serialization_support, &description, &allocator, &dynamic_type) != RCUTILS_RET_OK)
+    {
+      st.SkipWithError("Could not build dynamic type");
+      break;
+    }
+    rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type);
+  }
+
+  rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+  rosidl_dynamic_typesupport_serialization_support_fini(&serialization_support);
+}
+BENCHMARK_REGISTER_F(PerformanceTest, init_from_deep_description)->Arg(8)->Arg(64)->Arg(256);
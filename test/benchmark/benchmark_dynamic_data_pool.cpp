@@ -0,0 +1,108 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <rcutils/allocator.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+
+#include "performance_test_fixture/performance_test_fixture.hpp"
+
+#include "rosidl_dynamic_typesupport/api/dynamic_data.h"
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/dynamic_data_pool.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+// Each iteration stands for one received message, so heap_allocations is the count per message
+class DynamicDataPoolPerformanceTest : public performance_test_fixture::PerformanceTest
+{
+public:
+  void SetUp(benchmark::State & st) override
+  {
+    serialization_support = get_fake_serialization_support();
+
+    rosidl_runtime_c__type_description__TypeDescription description;
+    rosidl_runtime_c__type_description__TypeDescription__init(&description);
+    fill_individual_type_description(
+      "test_msgs/msg/A",
+      {{"a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr}},
+      &description.type_description);
+    dynamic_type = rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+    if (rosidl_dynamic_typesupport_dynamic_type_init_from_description(
+        &serialization_support, &description, &allocator, &dynamic_type) != RCUTILS_RET_OK)
+    {
+      st.SkipWithError("Could not build dynamic type");
+    }
+    rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+
+    performance_test_fixture::PerformanceTest::SetUp(st);
+  }
+
+  void TearDown(benchmark::State & st) override
+  {
+    performance_test_fixture::PerformanceTest::TearDown(st);
+    rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type);
+    rosidl_dynamic_typesupport_serialization_support_fini(&serialization_support);
+  }
+
+protected:
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support;
+  rosidl_dynamic_typesupport_dynamic_type_t dynamic_type;
+};
+
+BENCHMARK_F(DynamicDataPoolPerformanceTest, init_and_fini_per_message)(benchmark::State & st)
+{
+  reset_heap_counters();
+  for (auto _ : st) {
+    rosidl_dynamic_typesupport_dynamic_data_t dynamic_data =
+      rosidl_dynamic_typesupport_get_zero_initialized_dynamic_data();
+    if (rosidl_dynamic_typesupport_dynamic_data_init_from_dynamic_type(
+        &dynamic_type, &allocator, &dynamic_data) != RCUTILS_RET_OK)
+    {
+      st.SkipWithError("Could not initialize dynamic data");
+      break;
+    }
+    rosidl_dynamic_typesupport_dynamic_data_fini(&dynamic_data);
+  }
+}
+
+BENCHMARK_F(DynamicDataPoolPerformanceTest, acquire_and_release_per_message)(
+  benchmark::State & st)
+{
+  rosidl_dynamic_typesupport_dynamic_data_pool_t pool =
+    rosidl_dynamic_typesupport_get_zero_initialized_dynamic_data_pool();
+  if (rosidl_dynamic_typesupport_dynamic_data_pool_init(
+      &dynamic_type, 1, 4, &allocator, &pool) != RCUTILS_RET_OK)
+  {
+    st.SkipWithError("Could not initialize pool");
+    return;
+  }
+
+  reset_heap_counters();
+  for (auto _ : st) {
+    rosidl_dynamic_typesupport_dynamic_data_t * dynamic_data = nullptr;
+    if (rosidl_dynamic_typesupport_dynamic_data_pool_acquire(&pool, &dynamic_data) !=
+      RCUTILS_RET_OK)
+    {
+      st.SkipWithError("Could not acquire dynamic data");
+      break;
+    }
+    rosidl_dynamic_typesupport_dynamic_data_pool_release(&pool, dynamic_data);
+  }
+
+  set_are_allocation_measurements_active(false);
+  rosidl_dynamic_typesupport_dynamic_data_pool_fini(&pool);
+}
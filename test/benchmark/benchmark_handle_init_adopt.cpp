@@ -0,0 +1,205 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <rcutils/allocator.h>
+#include <rosidl_runtime_c/message_type_support_struct.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__functions.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+#include <rosidl_runtime_c/type_hash.h>
+
+#include "performance_test_fixture/performance_test_fixture.hpp"
+
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/dynamic_message_type_support_struct.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+// Allocations per handle when the caller built a description just to pass it in: copied into the
+// handle, or adopted by it. Building the caller's description (and finalizing it after a copy) is
+// not measured. The fake serialization library only has int32 members for numbers, so the types
+// below stand in for sensor_msgs/msg/Imu (argument 0) and sensor_msgs/msg/JointState (argument 1)
+// with the same layout, names, and nesting. One handle for the type is kept alive throughout, like
+// in a process that already has a subscription for it, so the dynamic type and the serialization
+// support are shared rather than built for every handle.
+class HandleInitAdoptPerformanceTest : public performance_test_fixture::PerformanceTest
+{
+public:
+  void SetUp(benchmark::State & st) override
+  {
+    rosidl_runtime_c__type_description__TypeDescription__init(&description);
+
+    const FieldSpec header{"header", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE,
+      "std_msgs/msg/Header"};
+    if (st.range(0) == 0) {
+      fill_individual_type_description(
+        "sensor_msgs/msg/Imu",
+        {
+          header,
+          {"orientation", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE,
+            "geometry_msgs/msg/Quaternion"},
+          {"orientation_covariance", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32_ARRAY, nullptr,
+            9},
+          {"angular_velocity", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE,
+            "geometry_msgs/msg/Vector3"},
+          {"angular_velocity_covariance", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32_ARRAY,
+            nullptr, 9},
+          {"linear_acceleration", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE,
+            "geometry_msgs/msg/Vector3"},
+          {"linear_acceleration_covariance", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32_ARRAY,
+            nullptr, 9},
+        },
+        &description.type_description);
+      rosidl_runtime_c__type_description__IndividualTypeDescription__Sequence__init(
+        &description.referenced_type_descriptions, 4);
+      fill_individual_type_description(
+        "geometry_msgs/msg/Quaternion",
+        {
+          {"x", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+          {"y", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+          {"z", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+          {"w", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+        },
+        &description.referenced_type_descriptions.data[0]);
+      fill_individual_type_description(
+        "geometry_msgs/msg/Vector3",
+        {
+          {"x", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+          {"y", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+          {"z", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+        },
+        &description.referenced_type_descriptions.data[1]);
+    } else {
+      fill_individual_type_description(
+        "sensor_msgs/msg/JointState",
+        {
+          header,
+          {"name", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_STRING_UNBOUNDED_SEQUENCE,
+            nullptr, 0, 64},
+          {"position", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32_UNBOUNDED_SEQUENCE, nullptr},
+          {"velocity", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32_UNBOUNDED_SEQUENCE, nullptr},
+          {"effort", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32_UNBOUNDED_SEQUENCE, nullptr},
+        },
+        &description.type_description);
+      rosidl_runtime_c__type_description__IndividualTypeDescription__Sequence__init(
+        &description.referenced_type_descriptions, 2);
+    }
+    const size_t referenced_count = description.referenced_type_descriptions.size;
+    fill_individual_type_description(
+      "builtin_interfaces/msg/Time",
+      {
+        {"sec", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+        {"nanosec", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+      },
+      &description.referenced_type_descriptions.data[referenced_count - 2]);
+    fill_individual_type_description(
+      "std_msgs/msg/Header",
+      {
+        {"stamp", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE,
+          "builtin_interfaces/msg/Time"},
+        {"frame_id", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_STRING, nullptr, 0, 64},
+      },
+      &description.referenced_type_descriptions.data[referenced_count - 1]);
+
+    type_hash = rosidl_get_zero_initialized_type_hash();
+    type_hash.version = 1;
+    type_hash.value[0] = static_cast<uint8_t>(st.range(0) + 1);
+
+    rosidl_dynamic_typesupport_serialization_support_t serialization_support =
+      get_fake_serialization_support();
+    if (rosidl_dynamic_message_type_support_handle_init(
+        &serialization_support, &type_hash, &description, nullptr, &allocator, &warm_ts) !=
+      RCUTILS_RET_OK)
+    {
+      st.SkipWithError("Could not init handle");
+    }
+
+    performance_test_fixture::PerformanceTest::SetUp(st);
+  }
+
+  void TearDown(benchmark::State & st) override
+  {
+    performance_test_fixture::PerformanceTest::TearDown(st);
+    rosidl_dynamic_message_type_support_handle_fini(&warm_ts);
+    rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+  }
+
+protected:
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_runtime_c__type_description__TypeDescription description;
+  rosidl_type_hash_t type_hash;
+  rosidl_message_type_support_t warm_ts;
+};
+
+BENCHMARK_DEFINE_F(HandleInitAdoptPerformanceTest, handle_init_copy)(benchmark::State & st)
+{
+  reset_heap_counters();
+  for (auto _ : st) {
+    st.PauseTiming();
+    set_are_allocation_measurements_active(false);
+    rosidl_runtime_c__type_description__TypeDescription passed;
+    rosidl_runtime_c__type_description__TypeDescription__init(&passed);
+    rosidl_runtime_c__type_description__TypeDescription__copy(&description, &passed);
+    rosidl_dynamic_typesupport_serialization_support_t handle_serialization_support =
+      get_fake_serialization_support();
+    set_are_allocation_measurements_active(true);
+    st.ResumeTiming();
+
+    rosidl_message_type_support_t ts;
+    if (rosidl_dynamic_message_type_support_handle_init(
+        &handle_serialization_support, &type_hash, &passed, nullptr, &allocator, &ts) !=
+      RCUTILS_RET_OK)
+    {
+      st.SkipWithError("Could not init handle");
+      break;
+    }
+
+    st.PauseTiming();
+    set_are_allocation_measurements_active(false);
+    rosidl_runtime_c__type_description__TypeDescription__fini(&passed);
+    set_are_allocation_measurements_active(true);
+    st.ResumeTiming();
+
+    rosidl_dynamic_message_type_support_handle_fini(&ts);
+  }
+}
+BENCHMARK_REGISTER_F(HandleInitAdoptPerformanceTest, handle_init_copy)->Arg(0)->Arg(1);
+
+BENCHMARK_DEFINE_F(HandleInitAdoptPerformanceTest, handle_init_adopt)(benchmark::State & st)
+{
+  reset_heap_counters();
+  for (auto _ : st) {
+    st.PauseTiming();
+    set_are_allocation_measurements_active(false);
+    rosidl_runtime_c__type_description__TypeDescription passed;
+    rosidl_runtime_c__type_description__TypeDescription__init(&passed);
+    rosidl_runtime_c__type_description__TypeDescription__copy(&description, &passed);
+    rosidl_dynamic_typesupport_serialization_support_t handle_serialization_support =
+      get_fake_serialization_support();
+    set_are_allocation_measurements_active(true);
+    st.ResumeTiming();
+
+    rosidl_message_type_support_t ts;
+    if (rosidl_dynamic_message_type_support_handle_init_adopt(
+        &handle_serialization_support, &type_hash, &passed, nullptr, &allocator, &ts) !=
+      RCUTILS_RET_OK)
+    {
+      st.SkipWithError("Could not init handle");
+      break;
+    }
+
+    rosidl_dynamic_message_type_support_handle_fini(&ts);
+  }
+}
+BENCHMARK_REGISTER_F(HandleInitAdoptPerformanceTest, handle_init_adopt)->Arg(0)->Arg(1);
@@ -0,0 +1,88 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include <rcutils/allocator.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__functions.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+
+#include "performance_test_fixture/performance_test_fixture.hpp"
+
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+using performance_test_fixture::PerformanceTest;
+
+// Builds a type with one nested field per referenced type, for as many referenced types as the
+// benchmark argument says. The time per field should not grow with the number of referenced types.
+BENCHMARK_DEFINE_F(PerformanceTest, init_from_description_with_many_referenced_types)(
+  benchmark::State & st)
+{
+  const size_t referenced_count = static_cast<size_t>(st.range(0));
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support =
+    get_fake_serialization_support();
+
+  std::vector<std::string> names;
+  std::vector<std::string> field_names;
+  for (size_t i = 0; i < referenced_count; i++) {
+    names.push_back("test_msgs/msg/Nested" + std::to_string(i));
+    field_names.push_back("n" + std::to_string(i));
+  }
+  std::vector<FieldSpec> fields;
+  for (size_t i = 0; i < referenced_count; i++) {
+    fields.push_back(
+      {field_names[i].c_str(), ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE,
+        names[i].c_str()});
+  }
+
+  rosidl_runtime_c__type_description__TypeDescription description;
+  if (!rosidl_runtime_c__type_description__TypeDescription__init(&description) ||
+    !rosidl_runtime_c__type_description__IndividualTypeDescription__Sequence__init(
+      &description.referenced_type_descriptions, referenced_count))
+  {
+    st.SkipWithError("Could not initialize type description");
+    return;
+  }
+  fill_individual_type_description("test_msgs/msg/Top", fields, &description.type_description);
+  for (size_t i = 0; i < referenced_count; i++) {
+    fill_individual_type_description(
+      names[i].c_str(), {{"x", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr}},
+      &description.referenced_type_descriptions.data[i]);
+  }
+
+  reset_heap_counters();
+  for (auto _ : st) {
+    rosidl_dynamic_typesupport_dynamic_type_t dynamic_type =
+      rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+    if (rosidl_dynamic_typesupport_dynamic_type_init_from_description(
+        &serialization_support, &description, &allocator, &dynamic_type) != RCUTILS_RET_OK)
+    {
+      st.SkipWithError("Could not build dynamic type");
+      break;
+    }
+    rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type);
+  }
+  st.SetItemsProcessed(static_cast<int64_t>(st.iterations() * referenced_count));
+
+  rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+  rosidl_dynamic_typesupport_serialization_support_fini(&serialization_support);
+}
+BENCHMARK_REGISTER_F(PerformanceTest, init_from_description_with_many_referenced_types)
+->Arg(8)->Arg(64)->Arg(512)->Arg(1024);
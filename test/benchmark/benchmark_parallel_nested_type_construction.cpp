@@ -0,0 +1,160 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <rcutils/allocator.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__functions.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+
+#include "performance_test_fixture/performance_test_fixture.hpp"
+
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+using performance_test_fixture::PerformanceTest;
+
+namespace
+{
+
+constexpr size_t kNestedTypeCount = 256;
+constexpr size_t kFieldsPerNestedType = 16;
+constexpr std::chrono::nanoseconds kMemberCost{1000};
+
+decltype(rosidl_dynamic_typesupport_serialization_support_interface_t::
+  dynamic_type_builder_add_int32_member) fake_add_int32_member = nullptr;
+
+// Real serialization libraries take a while to add a member, unlike the fake one
+rcutils_ret_t
+add_int32_member_slowly(
+  rosidl_dynamic_typesupport_serialization_support_impl_t * serialization_support,
+  rosidl_dynamic_typesupport_dynamic_type_builder_impl_t * dynamic_type_builder,
+  rosidl_dynamic_typesupport_member_id_t id,
+  const char * name, size_t name_length,
+  const char * default_value, size_t default_value_length)
+{
+  auto end = std::chrono::steady_clock::now() + kMemberCost;
+  while (std::chrono::steady_clock::now() < end) {
+  }
+  return fake_add_int32_member(
+    serialization_support, dynamic_type_builder, id, name, name_length,
+    default_value, default_value_length);
+}
+
+// Run the tasks on as many threads as `state` points to, started for every call
+void
+parallel_for_on_threads(
+  size_t task_count, void (* task)(size_t i, void * task_arg), void * task_arg, void * state)
+{
+  const size_t thread_count = *static_cast<size_t *>(state);
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+      for (size_t i = next++; i < task_count; i = next++) {
+        task(i, task_arg);
+      }
+    };
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < thread_count; t++) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread & thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace
+
+// Builds a type referencing 256 independent nested types of 16 fields each, on as many threads as
+// the benchmark argument says (0 for the serial path)
+BENCHMARK_DEFINE_F(PerformanceTest, init_from_description_in_parallel)(benchmark::State & st)
+{
+  size_t thread_count = static_cast<size_t>(st.range(0));
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support =
+    get_fake_serialization_support();
+  fake_add_int32_member = serialization_support.methods.dynamic_type_builder_add_int32_member;
+  serialization_support.methods.dynamic_type_builder_add_int32_member = add_int32_member_slowly;
+  serialization_support.methods.dynamic_type_construction_is_thread_safe = true;
+
+  std::vector<std::string> names;
+  std::vector<std::string> field_names;
+  for (size_t i = 0; i < kNestedTypeCount; i++) {
+    names.push_back("test_msgs/msg/Nested" + std::to_string(i));
+    field_names.push_back("n" + std::to_string(i));
+  }
+  std::vector<FieldSpec> fields;
+  for (size_t i = 0; i < kNestedTypeCount; i++) {
+    fields.push_back(
+      {field_names[i].c_str(), ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE,
+        names[i].c_str()});
+  }
+  std::vector<std::string> nested_field_names;
+  std::vector<FieldSpec> nested_fields;
+  for (size_t i = 0; i < kFieldsPerNestedType; i++) {
+    nested_field_names.push_back("f" + std::to_string(i));
+  }
+  for (size_t i = 0; i < kFieldsPerNestedType; i++) {
+    nested_fields.push_back(
+      {nested_field_names[i].c_str(), ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr});
+  }
+
+  rosidl_runtime_c__type_description__TypeDescription description;
+  if (!rosidl_runtime_c__type_description__TypeDescription__init(&description) ||
+    !rosidl_runtime_c__type_description__IndividualTypeDescription__Sequence__init(
+      &description.referenced_type_descriptions, kNestedTypeCount))
+  {
+    st.SkipWithError("Could not initialize type description");
+    return;
+  }
+  fill_individual_type_description("test_msgs/msg/Top", fields, &description.type_description);
+  for (size_t i = 0; i < kNestedTypeCount; i++) {
+    fill_individual_type_description(
+      names[i].c_str(), nested_fields, &description.referenced_type_descriptions.data[i]);
+  }
+
+  rosidl_dynamic_typesupport_dynamic_type_construction_options_t options =
+    rosidl_dynamic_typesupport_get_default_dynamic_type_construction_options();
+  if (thread_count > 0) {
+    options.parallel_for = parallel_for_on_threads;
+    options.parallel_for_state = &thread_count;
+  }
+
+  reset_heap_counters();
+  for (auto _ : st) {
+    rosidl_dynamic_typesupport_dynamic_type_t dynamic_type =
+      rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+    if (rosidl_dynamic_typesupport_dynamic_type_init_from_description_with_options(
+        &serialization_support, &description, &options, &allocator, &dynamic_type) !=
+      RCUTILS_RET_OK)
+    {
+      st.SkipWithError("Could not build dynamic type");
+      break;
+    }
+    rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type);
+  }
+
+  rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+  serialization_support.methods.dynamic_type_builder_add_int32_member = fake_add_int32_member;
+  rosidl_dynamic_typesupport_serialization_support_fini(&serialization_support);
+}
+BENCHMARK_REGISTER_F(PerformanceTest, init_from_description_in_parallel)
+->Arg(0)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime()->Unit(benchmark::kMillisecond);
@@ -0,0 +1,163 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include <rcutils/allocator.h>
+#include <rcutils/types/uint8_array.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__functions.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+#include <rosidl_runtime_c/type_hash.h>
+
+#include "performance_test_fixture/performance_test_fixture.hpp"
+
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/type_plan.h"
+#include "rosidl_dynamic_typesupport/type_snapshot.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+// Startup cost of getting a dynamic type and type plan for a type with as many nested types as the
+// benchmark argument says, each with 8 fields: built from the description (cold), or loaded from a
+// snapshot exported by an earlier process
+class TypeSnapshotPerformanceTest : public performance_test_fixture::PerformanceTest
+{
+public:
+  void SetUp(benchmark::State & st) override
+  {
+    serialization_support = get_fake_serialization_support();
+
+    const size_t nested_count = static_cast<size_t>(st.range(0));
+    std::vector<std::string> names;
+    std::vector<std::string> field_names;
+    for (size_t i = 0; i < nested_count; i++) {
+      names.push_back("test_msgs/msg/Nested" + std::to_string(i));
+      field_names.push_back("n" + std::to_string(i));
+    }
+    std::vector<FieldSpec> fields;
+    for (size_t i = 0; i < nested_count; i++) {
+      fields.push_back(
+        {field_names[i].c_str(), ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE,
+          names[i].c_str()});
+    }
+    std::vector<FieldSpec> nested_fields;
+    for (const char * name : {"a", "b", "c", "d", "e", "f", "g", "h"}) {
+      nested_fields.push_back({name, ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr});
+    }
+
+    rosidl_runtime_c__type_description__TypeDescription__init(&description);
+    rosidl_runtime_c__type_description__IndividualTypeDescription__Sequence__init(
+      &description.referenced_type_descriptions, nested_count);
+    fill_individual_type_description("test_msgs/msg/Top", fields, &description.type_description);
+    for (size_t i = 0; i < nested_count; i++) {
+      fill_individual_type_description(
+        names[i].c_str(), nested_fields, &description.referenced_type_descriptions.data[i]);
+    }
+
+    type_hash = rosidl_get_zero_initialized_type_hash();
+    type_hash.version = 1;
+    type_hash.value[0] = 7;
+    rosidl_dynamic_typesupport_dynamic_type_construction_options_t options =
+      rosidl_dynamic_typesupport_get_default_dynamic_type_construction_options();
+    options.type_hash = &type_hash;
+
+    rosidl_dynamic_typesupport_dynamic_type_t dynamic_type =
+      rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+    const rosidl_dynamic_typesupport_dynamic_type_t * dynamic_types[] = {&dynamic_type};
+    const rosidl_runtime_c__type_description__TypeDescription * descriptions[] = {&description};
+    snapshot_data = rcutils_get_zero_initialized_uint8_array();
+    if (rosidl_dynamic_typesupport_dynamic_type_init_from_description_with_options(
+        &serialization_support, &description, &options, &allocator, &dynamic_type) !=
+      RCUTILS_RET_OK ||
+      rosidl_dynamic_typesupport_type_snapshot_export(
+        dynamic_types, descriptions, 1, &allocator, &snapshot_data) != RCUTILS_RET_OK)
+    {
+      st.SkipWithError("Could not export snapshot");
+    }
+    rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type);
+
+    performance_test_fixture::PerformanceTest::SetUp(st);
+  }
+
+  void TearDown(benchmark::State & st) override
+  {
+    performance_test_fixture::PerformanceTest::TearDown(st);
+    rcutils_uint8_array_fini(&snapshot_data);
+    rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+    rosidl_dynamic_typesupport_serialization_support_fini(&serialization_support);
+  }
+
+protected:
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support;
+  rosidl_runtime_c__type_description__TypeDescription description;
+  rosidl_type_hash_t type_hash;
+  rcutils_uint8_array_t snapshot_data;
+};
+
+BENCHMARK_DEFINE_F(TypeSnapshotPerformanceTest, cold_start)(benchmark::State & st)
+{
+  reset_heap_counters();
+  for (auto _ : st) {
+    rosidl_dynamic_typesupport_dynamic_type_t dynamic_type =
+      rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+    rosidl_dynamic_typesupport_type_plan_t plan =
+      rosidl_dynamic_typesupport_get_zero_initialized_type_plan();
+    if (rosidl_dynamic_typesupport_dynamic_type_init_from_description(
+        &serialization_support, &description, &allocator, &dynamic_type) != RCUTILS_RET_OK ||
+      rosidl_dynamic_typesupport_type_plan_init(&description, &allocator, &plan) !=
+      RCUTILS_RET_OK)
+    {
+      st.SkipWithError("Could not build dynamic type");
+      break;
+    }
+    rosidl_dynamic_typesupport_type_plan_fini(&plan);
+    rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type);
+  }
+}
+BENCHMARK_REGISTER_F(TypeSnapshotPerformanceTest, cold_start)->Arg(8)->Arg(64)->Arg(256);
+
+BENCHMARK_DEFINE_F(TypeSnapshotPerformanceTest, snapshot_start)(benchmark::State & st)
+{
+  reset_heap_counters();
+  for (auto _ : st) {
+    rosidl_dynamic_typesupport_type_snapshot_t snapshot =
+      rosidl_dynamic_typesupport_get_zero_initialized_type_snapshot();
+    size_t entry_index = 0;
+    rosidl_dynamic_typesupport_dynamic_type_t dynamic_type =
+      rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+    rosidl_dynamic_typesupport_type_plan_t plan =
+      rosidl_dynamic_typesupport_get_zero_initialized_type_plan();
+    if (rosidl_dynamic_typesupport_type_snapshot_init(
+        snapshot_data.buffer, snapshot_data.buffer_length, &snapshot) != RCUTILS_RET_OK ||
+      rosidl_dynamic_typesupport_type_snapshot_find(
+        &snapshot, fake_serialization_library_identifier, &type_hash, &entry_index) !=
+      RCUTILS_RET_OK ||
+      rosidl_dynamic_typesupport_type_snapshot_load_dynamic_type(
+        &snapshot, entry_index, &serialization_support, &allocator, &dynamic_type) !=
+      RCUTILS_RET_OK ||
+      rosidl_dynamic_typesupport_type_snapshot_load_type_plan(
+        &snapshot, entry_index, &allocator, &plan) != RCUTILS_RET_OK)
+    {
+      st.SkipWithError("Could not load snapshot");
+      break;
+    }
+    rosidl_dynamic_typesupport_type_plan_fini(&plan);
+    rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type);
+  }
+}
+BENCHMARK_REGISTER_F(TypeSnapshotPerformanceTest, snapshot_start)->Arg(8)->Arg(64)->Arg(256);
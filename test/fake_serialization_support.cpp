@@ -0,0 +1,391 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "fake_serialization_support.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <rcutils/allocator.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rcutils/types/uint8_array.h>
+#include <rosidl_runtime_c/string_functions.h>
+#include <rosidl_runtime_c/type_description/field__functions.h>
+
+#include "rosidl_dynamic_typesupport/api/serialization_support_interface.h"
+
+const char * const fake_serialization_library_identifier = "fake";
+
+FakeSerializationSupportCounters fake_counters;
+std::function<void()> fake_builder_init_hook;
+
+namespace
+{
+
+using ss_impl_t = rosidl_dynamic_typesupport_serialization_support_impl_t;
+using builder_impl_t = rosidl_dynamic_typesupport_dynamic_type_builder_impl_t;
+using type_impl_t = rosidl_dynamic_typesupport_dynamic_type_impl_t;
+using data_impl_t = rosidl_dynamic_typesupport_dynamic_data_impl_t;
+
+std::string &
+as_string(void * handle)
+{
+  return *static_cast<std::string *>(handle);
+}
+
+type_impl_t
+new_type(const std::string & type, rcutils_allocator_t * allocator)
+{
+  fake_counters.live_types++;
+  type_impl_t type_impl;
+  type_impl.allocator = *allocator;
+  type_impl.handle = new std::string(type);
+  return type_impl;
+}
+
+
+// CORE ============================================================================================
+rcutils_ret_t
+serialization_support_impl_fini(ss_impl_t *)
+{
+  fake_counters.serialization_support_finis++;
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+serialization_support_interface_fini(rosidl_dynamic_typesupport_serialization_support_interface_t *)
+{
+  return RCUTILS_RET_OK;
+}
+
+
+// DYNAMIC TYPE ====================================================================================
+rcutils_ret_t
+builder_init(
+  ss_impl_t *, const char * name, size_t name_length, rcutils_allocator_t *,
+  builder_impl_t * builder)
+{
+  builder->handle = new std::string(std::string(name, name_length) + "{");
+  fake_counters.builder_inits++;
+  if (fake_builder_init_hook) {
+    fake_builder_init_hook();
+  }
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+builder_fini(ss_impl_t *, builder_impl_t * builder)
+{
+  delete static_cast<std::string *>(builder->handle);
+  builder->handle = nullptr;
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+add_int32_member(
+  ss_impl_t *, builder_impl_t * builder, rosidl_dynamic_typesupport_member_id_t,
+  const char * name, size_t name_length, const char *, size_t)
+{
+  as_string(builder->handle) += std::string(name, name_length) + ":int32;";
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+add_bool_member(
+  ss_impl_t *, builder_impl_t * builder, rosidl_dynamic_typesupport_member_id_t,
+  const char * name, size_t name_length, const char *, size_t)
+{
+  as_string(builder->handle) += std::string(name, name_length) + ":bool;";
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+add_wchar_member(
+  ss_impl_t *, builder_impl_t * builder, rosidl_dynamic_typesupport_member_id_t,
+  const char * name, size_t name_length, const char *, size_t)
+{
+  as_string(builder->handle) += std::string(name, name_length) + ":wchar;";
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+add_float128_member(
+  ss_impl_t *, builder_impl_t * builder, rosidl_dynamic_typesupport_member_id_t,
+  const char * name, size_t name_length, const char *, size_t)
+{
+  as_string(builder->handle) += std::string(name, name_length) + ":float128;";
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+add_int32_array_member(
+  ss_impl_t *, builder_impl_t * builder, rosidl_dynamic_typesupport_member_id_t,
+  const char * name, size_t name_length, const char *, size_t, size_t array_length)
+{
+  as_string(builder->handle) +=
+    std::string(name, name_length) + ":int32[" + std::to_string(array_length) + "];";
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+add_int32_unbounded_sequence_member(
+  ss_impl_t *, builder_impl_t * builder, rosidl_dynamic_typesupport_member_id_t,
+  const char * name, size_t name_length, const char *, size_t)
+{
+  as_string(builder->handle) += std::string(name, name_length) + ":int32[];";
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+add_int32_bounded_sequence_member(
+  ss_impl_t *, builder_impl_t * builder, rosidl_dynamic_typesupport_member_id_t,
+  const char * name, size_t name_length, const char *, size_t, size_t sequence_bound)
+{
+  as_string(builder->handle) +=
+    std::string(name, name_length) + ":int32[<=" + std::to_string(sequence_bound) + "];";
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+add_bounded_string_member(
+  ss_impl_t *, builder_impl_t * builder, rosidl_dynamic_typesupport_member_id_t,
+  const char * name, size_t name_length, const char *, size_t, size_t string_bound)
+{
+  as_string(builder->handle) +=
+    std::string(name, name_length) + ":string<=" + std::to_string(string_bound) + ";";
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+add_bounded_string_array_member(
+  ss_impl_t *, builder_impl_t * builder, rosidl_dynamic_typesupport_member_id_t,
+  const char * name, size_t name_length, const char *, size_t, size_t string_bound,
+  size_t array_length)
+{
+  as_string(builder->handle) += std::string(name, name_length) + ":string<=" +
+    std::to_string(string_bound) + "[" + std::to_string(array_length) + "];";
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+add_bounded_string_unbounded_sequence_member(
+  ss_impl_t *, builder_impl_t * builder, rosidl_dynamic_typesupport_member_id_t,
+  const char * name, size_t name_length, const char *, size_t, size_t string_bound)
+{
+  as_string(builder->handle) +=
+    std::string(name, name_length) + ":string<=" + std::to_string(string_bound) + "[];";
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+add_bounded_string_bounded_sequence_member(
+  ss_impl_t *, builder_impl_t * builder, rosidl_dynamic_typesupport_member_id_t,
+  const char * name, size_t name_length, const char *, size_t, size_t string_bound,
+  size_t sequence_bound)
+{
+  as_string(builder->handle) += std::string(name, name_length) + ":string<=" +
+    std::to_string(string_bound) + "[<=" + std::to_string(sequence_bound) + "];";
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+add_complex_member(
+  ss_impl_t *, builder_impl_t * builder, rosidl_dynamic_typesupport_member_id_t,
+  const char * name, size_t name_length, const char *, size_t, type_impl_t * nested_struct)
+{
+  as_string(builder->handle) +=
+    std::string(name, name_length) + ":" + as_string(nested_struct->handle) + ";";
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+type_init_from_builder(
+  ss_impl_t *, builder_impl_t * builder, rcutils_allocator_t * allocator, type_impl_t * type)
+{
+  *type = new_type(as_string(builder->handle) + "}", allocator);
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+type_clone(
+  ss_impl_t *, const type_impl_t * other, rcutils_allocator_t * allocator, type_impl_t * type)
+{
+  *type = new_type(as_string(other->handle), allocator);
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+type_fini(ss_impl_t *, type_impl_t * type)
+{
+  delete static_cast<std::string *>(type->handle);
+  type->handle = nullptr;
+  fake_counters.live_types--;
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+type_equals(ss_impl_t *, const type_impl_t * type, const type_impl_t * other, bool * equals)
+{
+  fake_counters.type_equals_calls++;
+  *equals = as_string(type->handle) == as_string(other->handle);
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+type_get_name(ss_impl_t *, const type_impl_t * type, const char ** name, size_t * name_length)
+{
+  const std::string & string = as_string(type->handle);
+  *name = string.c_str();
+  *name_length = string.find('{');
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+type_export_snapshot_blob(
+  ss_impl_t *, const type_impl_t * type, rcutils_allocator_t * allocator,
+  rcutils_uint8_array_t * blob)
+{
+  const std::string & string = as_string(type->handle);
+  rcutils_ret_t ret = rcutils_uint8_array_init(blob, string.size(), allocator);
+  if (ret != RCUTILS_RET_OK) {
+    return ret;
+  }
+  std::memcpy(blob->buffer, string.data(), string.size());
+  blob->buffer_length = string.size();
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+type_init_from_snapshot_blob(
+  ss_impl_t *, const uint8_t * blob, size_t blob_size, rcutils_allocator_t * allocator,
+  type_impl_t * type)
+{
+  *type = new_type(std::string(reinterpret_cast<const char *>(blob), blob_size), allocator);
+  fake_counters.snapshot_loads++;
+  return RCUTILS_RET_OK;
+}
+
+
+// DYNAMIC DATA ====================================================================================
+rcutils_ret_t
+data_init_from_type(ss_impl_t *, type_impl_t * type, rcutils_allocator_t *, data_impl_t * data)
+{
+  data->handle = new std::string(as_string(type->handle));
+  fake_counters.live_data++;
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+data_clear_all_values(ss_impl_t *, data_impl_t *)
+{
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+data_fini(ss_impl_t *, data_impl_t * data)
+{
+  delete static_cast<std::string *>(data->handle);
+  data->handle = nullptr;
+  fake_counters.live_data--;
+  return RCUTILS_RET_OK;
+}
+
+}  // namespace
+
+
+rosidl_dynamic_typesupport_serialization_support_t
+get_fake_serialization_support()
+{
+  rosidl_dynamic_typesupport_serialization_support_interface_t methods =
+    rosidl_dynamic_typesupport_get_zero_initialized_serialization_support_interface();
+  methods.serialization_library_identifier = fake_serialization_library_identifier;
+  methods.serialization_support_impl_fini = serialization_support_impl_fini;
+  methods.serialization_support_interface_fini = serialization_support_interface_fini;
+
+  methods.dynamic_type_builder_init = builder_init;
+  methods.dynamic_type_builder_fini = builder_fini;
+  methods.dynamic_type_builder_add_int32_member = add_int32_member;
+  methods.dynamic_type_builder_add_bool_member = add_bool_member;
+  methods.dynamic_type_builder_add_wchar_member = add_wchar_member;
+  methods.dynamic_type_builder_add_float128_member = add_float128_member;
+  methods.dynamic_type_builder_add_int32_array_member = add_int32_array_member;
+  methods.dynamic_type_builder_add_int32_unbounded_sequence_member =
+    add_int32_unbounded_sequence_member;
+  methods.dynamic_type_builder_add_int32_bounded_sequence_member =
+    add_int32_bounded_sequence_member;
+  methods.dynamic_type_builder_add_bounded_string_member = add_bounded_string_member;
+  methods.dynamic_type_builder_add_bounded_string_array_member = add_bounded_string_array_member;
+  methods.dynamic_type_builder_add_bounded_string_unbounded_sequence_member =
+    add_bounded_string_unbounded_sequence_member;
+  methods.dynamic_type_builder_add_bounded_string_bounded_sequence_member =
+    add_bounded_string_bounded_sequence_member;
+  methods.dynamic_type_builder_add_complex_member = add_complex_member;
+  methods.dynamic_type_init_from_dynamic_type_builder = type_init_from_builder;
+  methods.dynamic_type_clone = type_clone;
+  methods.dynamic_type_fini = type_fini;
+  methods.dynamic_type_equals = type_equals;
+  methods.dynamic_type_get_name = type_get_name;
+  methods.dynamic_type_export_snapshot_blob = type_export_snapshot_blob;
+  methods.dynamic_type_init_from_snapshot_blob = type_init_from_snapshot_blob;
+
+  methods.dynamic_data_init_from_dynamic_type = data_init_from_type;
+  methods.dynamic_data_clear_all_values = data_clear_all_values;
+  methods.dynamic_data_fini = data_fini;
+
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_dynamic_typesupport_serialization_support_impl_t impl =
+    rosidl_dynamic_typesupport_get_zero_initialized_serialization_support_impl();
+  impl.allocator = allocator;
+  impl.serialization_library_identifier = fake_serialization_library_identifier;
+
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support =
+    rosidl_dynamic_typesupport_get_zero_initialized_serialization_support();
+  if (rosidl_dynamic_typesupport_serialization_support_init(
+      &impl, &methods, &allocator, &serialization_support) != RCUTILS_RET_OK)
+  {
+    std::abort();
+  }
+  return serialization_support;
+}
+
+
+void
+fill_individual_type_description(
+  const char * type_name,
+  const std::vector<FieldSpec> & fields,
+  rosidl_runtime_c__type_description__IndividualTypeDescription * description)
+{
+  if (!rosidl_runtime_c__String__assign(&description->type_name, type_name) ||
+    !rosidl_runtime_c__type_description__Field__Sequence__init(
+      &description->fields, fields.size()))
+  {
+    std::abort();
+  }
+  for (size_t i = 0; i < fields.size(); i++) {
+    rosidl_runtime_c__type_description__Field * field = &description->fields.data[i];
+    field->type.type_id = fields[i].type_id;
+    field->type.capacity = fields[i].capacity;
+    field->type.string_capacity = fields[i].string_capacity;
+    if (!rosidl_runtime_c__String__assign(&field->name, fields[i].name) ||
+      !rosidl_runtime_c__String__assign(
+        &field->type.nested_type_name,
+        fields[i].nested_type_name != nullptr ? fields[i].nested_type_name : ""))
+    {
+      std::abort();
+    }
+  }
+}
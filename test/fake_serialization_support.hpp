@@ -0,0 +1,75 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FAKE_SERIALIZATION_SUPPORT_HPP_
+#define FAKE_SERIALIZATION_SUPPORT_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <rosidl_runtime_c/type_description/individual_type_description__struct.h>
+
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+
+// FAKE SERIALIZATION SUPPORT ======================================================================
+// Dynamic types of the fake serialization library are strings spelling out their members (e.g.
+// "pkg/msg/A{a:int32;n:pkg/msg/B{x:bool;};}"), so equal types compare equal as strings. Only the
+// slots needed to build types with int32, bool, and nested members (and data from them) are set,
+// along with the int32 and bounded string collections and a few others, which spell out the slot
+// and bounds they got (e.g. "a:int32[<=3];" for a bounded sequence of 3).
+
+extern const char * const fake_serialization_library_identifier;
+
+/// What the fake serialization library currently has alive, and what it was asked to do
+struct FakeSerializationSupportCounters
+{
+  std::atomic<int> live_types{0};
+  std::atomic<int> live_data{0};
+  std::atomic<int> builder_inits{0};
+  std::atomic<int> snapshot_loads{0};
+  std::atomic<int> serialization_support_finis{0};
+  std::atomic<int> type_equals_calls{0};
+};
+
+extern FakeSerializationSupportCounters fake_counters;
+
+/// Called whenever the fake serialization library initializes a type builder, if set
+extern std::function<void()> fake_builder_init_hook;
+
+/// Get a serialization support of the fake serialization library, which must be finalized
+rosidl_dynamic_typesupport_serialization_support_t
+get_fake_serialization_support();
+
+
+// TYPE DESCRIPTIONS ===============================================================================
+struct FieldSpec
+{
+  const char * name;
+  uint8_t type_id;
+  const char * nested_type_name;
+  size_t capacity = 0;
+  size_t string_capacity = 0;
+};
+
+/// Fill an initialized individual type description with the given name and fields
+void
+fill_individual_type_description(
+  const char * type_name,
+  const std::vector<FieldSpec> & fields,
+  rosidl_runtime_c__type_description__IndividualTypeDescription * description);  // OUT
+
+#endif  // FAKE_SERIALIZATION_SUPPORT_HPP_
@@ -0,0 +1,251 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/string_functions.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__functions.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/default_values.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+namespace
+{
+
+// What the default values slot below got, one entry per call, copied as they don't outlive it
+struct SetDefaultValuesCall
+{
+  std::string type;
+  std::vector<bool> is_parsed;
+  std::vector<int32_t> first_int32s;
+};
+std::vector<SetDefaultValuesCall> set_default_values_calls;
+rcutils_ret_t set_default_values_ret = RCUTILS_RET_OK;
+
+rcutils_ret_t
+set_default_values(
+  rosidl_dynamic_typesupport_serialization_support_impl_t *,
+  rosidl_dynamic_typesupport_dynamic_type_builder_impl_t * builder,
+  const rosidl_dynamic_typesupport_default_values_t * default_values)
+{
+  SetDefaultValuesCall call;
+  call.type = *static_cast<std::string *>(builder->handle);
+  for (size_t i = 0; i < default_values->member_count; i++) {
+    const rosidl_dynamic_typesupport_member_default_value_t * member = &default_values->members[i];
+    call.is_parsed.push_back(member->is_parsed);
+    call.first_int32s.push_back(
+      member->is_parsed && member->type_id == ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32 ?
+      static_cast<const int32_t *>(member->elements)[0] : 0);
+  }
+  set_default_values_calls.push_back(call);
+  return set_default_values_ret;
+}
+
+void
+set_default_value(rosidl_runtime_c__type_description__Field * field, const char * default_value)
+{
+  ASSERT_TRUE(rosidl_runtime_c__String__assign(&field->default_value, default_value));
+}
+
+}  // namespace
+
+class TestDefaultValues : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    set_default_values_calls.clear();
+    set_default_values_ret = RCUTILS_RET_OK;
+    ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&description));
+  }
+
+  void TearDown() override
+  {
+    rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+  }
+
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_runtime_c__type_description__TypeDescription description;
+};
+
+TEST_F(TestDefaultValues, parses_every_member_into_c_arrays)
+{
+  fill_individual_type_description(
+    "test_msgs/msg/A",
+    {
+      {"i", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+      {"b", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOOLEAN, nullptr},
+      {"d", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT64, nullptr},
+      {"arr", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT16_ARRAY, nullptr, 3},
+      {"s", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_STRING, nullptr},
+      {"ss", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_STRING_UNBOUNDED_SEQUENCE, nullptr},
+      {"none", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+    },
+    &description.type_description);
+  rosidl_runtime_c__type_description__Field * fields = description.type_description.fields.data;
+  set_default_value(&fields[0], " -42 ");
+  set_default_value(&fields[1], "True");
+  set_default_value(&fields[2], "1.5");
+  set_default_value(&fields[3], "[1, -2, 3]");
+  set_default_value(&fields[4], "'it\\'s\\n'");
+  set_default_value(&fields[5], "[\"a, b\", 'c']");
+
+  rosidl_dynamic_typesupport_default_values_t default_values =
+    rosidl_dynamic_typesupport_get_zero_initialized_default_values();
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_default_values_init(
+      &description.type_description, &allocator, &default_values)) <<
+    rcutils_get_error_string().str;
+
+  // Nothing is borrowed from the description
+  rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+  ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&description));
+
+  ASSERT_EQ(7u, default_values.member_count);
+  rosidl_dynamic_typesupport_member_default_value_t * members = default_values.members;
+  for (size_t i = 0; i < 6; i++) {
+    EXPECT_TRUE(members[i].is_parsed) << "member " << i;
+    EXPECT_EQ(i, members[i].member_id);
+  }
+
+  EXPECT_EQ(1u, members[0].element_count);
+  EXPECT_EQ(-42, *static_cast<int32_t *>(members[0].elements));
+  EXPECT_TRUE(*static_cast<bool *>(members[1].elements));
+  EXPECT_EQ(1.5, *static_cast<double *>(members[2].elements));
+
+  ASSERT_EQ(3u, members[3].element_count);
+  EXPECT_EQ(sizeof(int16_t), members[3].element_size);
+  auto arr = static_cast<int16_t *>(members[3].elements);
+  EXPECT_EQ((std::vector<int16_t>{1, -2, 3}), std::vector<int16_t>(arr, arr + 3));
+
+  // Strings are unquoted and unescaped, and commas in quotes don't split lists
+  auto s = static_cast<rosidl_dynamic_typesupport_default_string_t *>(members[4].elements);
+  EXPECT_EQ("it's\n", std::string(s->data, s->length));
+  ASSERT_EQ(2u, members[5].element_count);
+  auto ss = static_cast<rosidl_dynamic_typesupport_default_string_t *>(members[5].elements);
+  EXPECT_EQ("a, b", std::string(ss[0].data, ss[0].length));
+  EXPECT_STREQ("c", ss[1].data);
+
+  EXPECT_FALSE(members[6].is_parsed);
+  EXPECT_EQ(nullptr, members[6].elements);
+
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_default_values_fini(&default_values));
+  EXPECT_EQ(nullptr, default_values.members);
+}
+
+TEST_F(TestDefaultValues, values_that_do_not_parse_are_left_unparsed)
+{
+  fill_individual_type_description(
+    "test_msgs/msg/A",
+    {
+      {"junk", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+      {"too_big", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT8, nullptr},
+      {"negative", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT8, nullptr},
+      {"unbracketed", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32_ARRAY, nullptr, 2},
+      {"bad_element", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32_UNBOUNDED_SEQUENCE, nullptr},
+      {"n", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, "test_msgs/msg/B"},
+    },
+    &description.type_description);
+  rosidl_runtime_c__type_description__Field * fields = description.type_description.fields.data;
+  set_default_value(&fields[0], "12abc");
+  set_default_value(&fields[1], "128");
+  set_default_value(&fields[2], "-1");
+  set_default_value(&fields[3], "1, 2");
+  set_default_value(&fields[4], "[1, x]");
+  set_default_value(&fields[5], "{}");
+
+  rosidl_dynamic_typesupport_default_values_t default_values =
+    rosidl_dynamic_typesupport_get_zero_initialized_default_values();
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_default_values_init(
+      &description.type_description, &allocator, &default_values));
+  ASSERT_EQ(6u, default_values.member_count);
+  for (size_t i = 0; i < default_values.member_count; i++) {
+    EXPECT_FALSE(default_values.members[i].is_parsed) << "member " << i;
+    EXPECT_EQ(nullptr, default_values.members[i].elements) << "member " << i;
+  }
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_default_values_fini(&default_values));
+}
+
+TEST_F(TestDefaultValues, construction_passes_parsed_values_once_per_type)
+{
+  fill_individual_type_description(
+    "test_msgs/msg/Top",
+    {
+      {"a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+      {"n", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, "test_msgs/msg/B"},
+    },
+    &description.type_description);
+  set_default_value(&description.type_description.fields.data[0], "7");
+  ASSERT_TRUE(
+    rosidl_runtime_c__type_description__IndividualTypeDescription__Sequence__init(
+      &description.referenced_type_descriptions, 1));
+  fill_individual_type_description(
+    "test_msgs/msg/B", {{"x", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr}},
+    &description.referenced_type_descriptions.data[0]);
+  set_default_value(&description.referenced_type_descriptions.data[0].fields.data[0], "-3");
+
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support =
+    get_fake_serialization_support();
+  rosidl_dynamic_typesupport_dynamic_type_t dynamic_type =
+    rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+
+  // Without the slot, nothing is parsed
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_type_init_from_description(
+      &serialization_support, &description, &allocator, &dynamic_type));
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type));
+  EXPECT_TRUE(set_default_values_calls.empty());
+
+  // With it, each type gets the values of its own members, after they were all added
+  serialization_support.methods.dynamic_type_builder_set_default_values = set_default_values;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_type_init_from_description(
+      &serialization_support, &description, &allocator, &dynamic_type)) <<
+    rcutils_get_error_string().str;
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type));
+  ASSERT_EQ(2u, set_default_values_calls.size());
+  EXPECT_EQ("test_msgs/msg/B{x:int32;", set_default_values_calls[0].type);
+  EXPECT_EQ((std::vector<int32_t>{-3}), set_default_values_calls[0].first_int32s);
+  EXPECT_EQ(
+    "test_msgs/msg/Top{a:int32;n:test_msgs/msg/B{x:int32;};", set_default_values_calls[1].type);
+  EXPECT_EQ((std::vector<bool>{true, false}), set_default_values_calls[1].is_parsed);
+  EXPECT_EQ((std::vector<int32_t>{7, 0}), set_default_values_calls[1].first_int32s);
+
+  // Failing in the slot fails construction
+  set_default_values_ret = RCUTILS_RET_ERROR;
+  EXPECT_NE(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_type_init_from_description(
+      &serialization_support, &description, &allocator, &dynamic_type));
+  rcutils_reset_error();
+
+  EXPECT_EQ(
+    RCUTILS_RET_OK, rosidl_dynamic_typesupport_serialization_support_fini(&serialization_support));
+}
@@ -0,0 +1,251 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__functions.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+
+#include "rosidl_dynamic_typesupport/api/dynamic_data.h"
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+class TestDeferredDynamicType : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    serialization_support = get_fake_serialization_support();
+    options = rosidl_dynamic_typesupport_get_default_dynamic_type_construction_options();
+    options.defer_construction = true;
+
+    // Top{a:B, c:C}, C{b:B, y:bool}, B{x:int32}
+    ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&description));
+    fill_individual_type_description(
+      "test_msgs/msg/Top",
+      {
+        {"a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, "test_msgs/msg/B"},
+        {"c", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, "test_msgs/msg/C"},
+        {"z", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+      },
+      &description.type_description);
+    ASSERT_TRUE(
+      rosidl_runtime_c__type_description__IndividualTypeDescription__Sequence__init(
+        &description.referenced_type_descriptions, 2));
+    fill_individual_type_description(
+      "test_msgs/msg/B", {{"x", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr}},
+      &description.referenced_type_descriptions.data[0]);
+    fill_individual_type_description(
+      "test_msgs/msg/C",
+      {
+        {"b", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, "test_msgs/msg/B"},
+        {"y", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOOLEAN, nullptr},
+      },
+      &description.referenced_type_descriptions.data[1]);
+
+    dynamic_type = rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+    ASSERT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_dynamic_type_init_from_description_with_options(
+        &serialization_support, &description, &options, &allocator, &dynamic_type)) <<
+      rcutils_get_error_string().str;
+  }
+
+  void TearDown() override
+  {
+    fake_builder_init_hook = nullptr;
+    EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type));
+    rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+    EXPECT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_serialization_support_fini(&serialization_support));
+  }
+
+  // Initializes (and finalizes) dynamic data, which builds the type. The fake serialization library
+  // spells out the type in its data
+  std::string use(rosidl_dynamic_typesupport_dynamic_type_t * type)
+  {
+    rosidl_dynamic_typesupport_dynamic_data_t dynamic_data =
+      rosidl_dynamic_typesupport_get_zero_initialized_dynamic_data();
+    if (rosidl_dynamic_typesupport_dynamic_data_init_from_dynamic_type(
+        type, &allocator, &dynamic_data) != RCUTILS_RET_OK)
+    {
+      ADD_FAILURE() << rcutils_get_error_string().str;
+      rcutils_reset_error();
+      return "";
+    }
+    std::string spelled_out = *static_cast<std::string *>(dynamic_data.impl.handle);
+    EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_data_fini(&dynamic_data));
+    return spelled_out;
+  }
+
+  rosidl_dynamic_typesupport_dynamic_type_t * get_nested_member_type(
+    rosidl_dynamic_typesupport_dynamic_type_t * type, const std::string & member_name)
+  {
+    rosidl_dynamic_typesupport_dynamic_type_t * nested_type = nullptr;
+    EXPECT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_dynamic_type_get_nested_member_type(
+        type, member_name.c_str(), member_name.size(), &nested_type)) <<
+      rcutils_get_error_string().str;
+    return nested_type;
+  }
+
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support;
+  rosidl_dynamic_typesupport_dynamic_type_construction_options_t options;
+  rosidl_runtime_c__type_description__TypeDescription description;
+  rosidl_dynamic_typesupport_dynamic_type_t dynamic_type;
+};
+
+TEST_F(TestDeferredDynamicType, nested_member_types_are_built_on_their_own)
+{
+  int builder_inits = fake_counters.builder_inits;
+
+  // Only C and the B it references are built, and nothing else
+  rosidl_dynamic_typesupport_dynamic_type_t * c = get_nested_member_type(&dynamic_type, "c");
+  ASSERT_NE(nullptr, c);
+  EXPECT_EQ(builder_inits, fake_counters.builder_inits);
+  EXPECT_EQ("test_msgs/msg/C{b:test_msgs/msg/B{x:int32;};y:bool;}", use(c));
+  EXPECT_EQ(builder_inits + 2, fake_counters.builder_inits);
+
+  // B is the same type whichever member it is got through, and was already built
+  EXPECT_EQ(c, get_nested_member_type(&dynamic_type, "c"));
+  rosidl_dynamic_typesupport_dynamic_type_t * b = get_nested_member_type(&dynamic_type, "a");
+  EXPECT_EQ(b, get_nested_member_type(c, "b"));
+  EXPECT_EQ("test_msgs/msg/B{x:int32;}", use(b));
+  EXPECT_EQ(builder_inits + 2, fake_counters.builder_inits);
+
+  // The top level type reuses both
+  EXPECT_EQ(
+    "test_msgs/msg/Top{a:test_msgs/msg/B{x:int32;};"
+    "c:test_msgs/msg/C{b:test_msgs/msg/B{x:int32;};y:bool;};z:int32;}",
+    use(&dynamic_type));
+  EXPECT_EQ(builder_inits + 3, fake_counters.builder_inits);
+}
+
+TEST_F(TestDeferredDynamicType, building_the_top_level_type_builds_what_it_reaches)
+{
+  int live_types = fake_counters.live_types;
+  int builder_inits = fake_counters.builder_inits;
+  use(&dynamic_type);
+  EXPECT_EQ(builder_inits + 3, fake_counters.builder_inits);
+  EXPECT_EQ(live_types + 3, fake_counters.live_types);
+
+  // Nested member types got afterwards are already built
+  EXPECT_EQ("test_msgs/msg/B{x:int32;}", use(get_nested_member_type(&dynamic_type, "a")));
+  EXPECT_EQ(builder_inits + 3, fake_counters.builder_inits);
+}
+
+TEST_F(TestDeferredDynamicType, nested_member_type_errors)
+{
+  rosidl_dynamic_typesupport_dynamic_type_t * nested_type = nullptr;
+  EXPECT_EQ(
+    RCUTILS_RET_NOT_FOUND,
+    rosidl_dynamic_typesupport_dynamic_type_get_nested_member_type(
+      &dynamic_type, "missing", 7, &nested_type));
+  rcutils_reset_error();
+  EXPECT_EQ(
+    RCUTILS_RET_INVALID_ARGUMENT,
+    rosidl_dynamic_typesupport_dynamic_type_get_nested_member_type(
+      &dynamic_type, "z", 1, &nested_type));
+  rcutils_reset_error();
+
+  // Nested member types belong to the type they were got from
+  nested_type = get_nested_member_type(&dynamic_type, "a");
+  EXPECT_EQ(
+    RCUTILS_RET_INVALID_ARGUMENT, rosidl_dynamic_typesupport_dynamic_type_fini(nested_type));
+  rcutils_reset_error();
+
+  // Only deferred types have them
+  rosidl_dynamic_typesupport_dynamic_type_t built =
+    rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_type_init_from_description(
+      &serialization_support, &description, &allocator, &built));
+  EXPECT_EQ(
+    RCUTILS_RET_UNSUPPORTED,
+    rosidl_dynamic_typesupport_dynamic_type_get_nested_member_type(&built, "a", 1, &nested_type));
+  rcutils_reset_error();
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(&built));
+}
+
+// Threads racing to use the top level type and its nested types build each type exactly once
+TEST_F(TestDeferredDynamicType, concurrent_first_uses_build_each_type_once)
+{
+  rosidl_dynamic_typesupport_dynamic_type_t * b = get_nested_member_type(&dynamic_type, "a");
+  rosidl_dynamic_typesupport_dynamic_type_t * c = get_nested_member_type(&dynamic_type, "c");
+  rosidl_dynamic_typesupport_dynamic_type_t * types[] = {&dynamic_type, b, c};
+
+  // Slow the builds down, so the threads are more likely to overlap
+  fake_builder_init_hook = []() {std::this_thread::sleep_for(std::chrono::milliseconds(5));};
+
+  int builder_inits = fake_counters.builder_inits;
+  std::atomic<bool> go{false};
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < 6; i++) {
+    threads.emplace_back(
+      [this, &go, &types, i]() {
+        while (!go) {
+          std::this_thread::yield();
+        }
+        use(types[i % 3]);
+      });
+  }
+  go = true;
+  for (std::thread & thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(builder_inits + 3, fake_counters.builder_inits);
+}
+
+// Asking for the memory usage never waits for a build that is running
+TEST_F(TestDeferredDynamicType, memory_usage_does_not_wait_for_builds)
+{
+  rosidl_dynamic_typesupport_memory_usage_t unbuilt;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_type_get_memory_usage(&dynamic_type, &unbuilt));
+  EXPECT_GT(unbuilt.library_bytes, 0u);
+
+  // Queried from another thread while the top level type is being built by this one
+  int queries = 0;
+  fake_builder_init_hook = [this, &queries]() {
+      auto query = std::async(
+        std::launch::async, [this]() {
+          rosidl_dynamic_typesupport_memory_usage_t memory_usage;
+          return rosidl_dynamic_typesupport_dynamic_type_get_memory_usage(
+            &dynamic_type, &memory_usage);
+        });
+      ASSERT_EQ(std::future_status::ready, query.wait_for(std::chrono::seconds(10)));
+      EXPECT_EQ(RCUTILS_RET_OK, query.get());
+      queries++;
+    };
+  use(&dynamic_type);
+  EXPECT_EQ(3, queries);
+}
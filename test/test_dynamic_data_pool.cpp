@@ -0,0 +1,123 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/dynamic_data_pool.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+class TestDynamicDataPool : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    serialization_support = get_fake_serialization_support();
+
+    rosidl_runtime_c__type_description__TypeDescription description;
+    ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&description));
+    fill_individual_type_description(
+      "test_msgs/msg/A",
+      {{"a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr}},
+      &description.type_description);
+    dynamic_type = rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+    rcutils_ret_t ret = rosidl_dynamic_typesupport_dynamic_type_init_from_description(
+      &serialization_support, &description, &allocator, &dynamic_type);
+    rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+    ASSERT_EQ(RCUTILS_RET_OK, ret);
+
+    pool = rosidl_dynamic_typesupport_get_zero_initialized_dynamic_data_pool();
+  }
+
+  void TearDown() override
+  {
+    EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type));
+    EXPECT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_serialization_support_fini(&serialization_support));
+  }
+
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support;
+  rosidl_dynamic_typesupport_dynamic_type_t dynamic_type;
+  rosidl_dynamic_typesupport_dynamic_data_pool_t pool;
+};
+
+TEST_F(TestDynamicDataPool, init_checks_sizes)
+{
+  EXPECT_EQ(
+    RCUTILS_RET_INVALID_ARGUMENT,
+    rosidl_dynamic_typesupport_dynamic_data_pool_init(&dynamic_type, 0, 0, &allocator, &pool));
+  rcutils_reset_error();
+  EXPECT_EQ(
+    RCUTILS_RET_INVALID_ARGUMENT,
+    rosidl_dynamic_typesupport_dynamic_data_pool_init(&dynamic_type, 3, 2, &allocator, &pool));
+  rcutils_reset_error();
+}
+
+TEST_F(TestDynamicDataPool, acquire_and_release)
+{
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_data_pool_init(&dynamic_type, 1, 2, &allocator, &pool));
+  EXPECT_EQ(1, fake_counters.live_data);
+
+  // Released dynamic data are handed out again, instead of constructing new ones
+  rosidl_dynamic_typesupport_dynamic_data_t * first = nullptr;
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_data_pool_acquire(&pool, &first));
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_data_pool_release(&pool, first));
+  rosidl_dynamic_typesupport_dynamic_data_t * again = nullptr;
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_data_pool_acquire(&pool, &again));
+  EXPECT_EQ(first, again);
+  EXPECT_EQ(1, fake_counters.live_data);
+
+  // Past `max_size`, dynamic data are constructed on the spot, and finalized on release
+  rosidl_dynamic_typesupport_dynamic_data_t * second = nullptr;
+  rosidl_dynamic_typesupport_dynamic_data_t * overflow = nullptr;
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_data_pool_acquire(&pool, &second));
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_data_pool_acquire(&pool, &overflow));
+  EXPECT_NE(again, second);
+  EXPECT_NE(second, overflow);
+  EXPECT_EQ(3, fake_counters.live_data);
+
+  rosidl_dynamic_typesupport_dynamic_data_pool_stats_t stats;
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_data_pool_get_stats(&pool, &stats));
+  EXPECT_EQ(3u, stats.in_use_count);
+  EXPECT_EQ(3u, stats.high_water_mark);
+  EXPECT_EQ(2u, stats.constructed_count);
+  EXPECT_EQ(1u, stats.overflow_count);
+
+  // Pools can't be finalized while their dynamic data are in use
+  EXPECT_NE(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_data_pool_fini(&pool));
+  rcutils_reset_error();
+
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_data_pool_release(&pool, overflow));
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_data_pool_release(&pool, second));
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_data_pool_release(&pool, again));
+  EXPECT_EQ(2, fake_counters.live_data);
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_data_pool_get_stats(&pool, &stats));
+  EXPECT_EQ(0u, stats.in_use_count);
+  EXPECT_EQ(3u, stats.high_water_mark);
+
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_data_pool_fini(&pool));
+  EXPECT_EQ(0, fake_counters.live_data);
+}
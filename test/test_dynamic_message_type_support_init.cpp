@@ -0,0 +1,389 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/message_type_support_struct.h>
+#include <rosidl_runtime_c/string_functions.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__functions.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+#include <rosidl_runtime_c/type_hash.h>
+
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/dynamic_message_type_support_struct.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+namespace
+{
+
+// Fails every allocation once `allocations_left` runs out
+struct FailingAllocatorState
+{
+  size_t allocations_left;
+};
+
+void *
+failing_allocate(size_t size, void * state)
+{
+  auto failing_state = static_cast<FailingAllocatorState *>(state);
+  if (failing_state->allocations_left == 0) {
+    return nullptr;
+  }
+  failing_state->allocations_left--;
+  return std::malloc(size);
+}
+
+void *
+failing_reallocate(void * pointer, size_t size, void * state)
+{
+  auto failing_state = static_cast<FailingAllocatorState *>(state);
+  if (failing_state->allocations_left == 0) {
+    return nullptr;
+  }
+  failing_state->allocations_left--;
+  return std::realloc(pointer, size);
+}
+
+void *
+failing_zero_allocate(size_t count, size_t size, void * state)
+{
+  auto failing_state = static_cast<FailingAllocatorState *>(state);
+  if (failing_state->allocations_left == 0) {
+    return nullptr;
+  }
+  failing_state->allocations_left--;
+  return std::calloc(count, size);
+}
+
+void
+failing_deallocate(void * pointer, void *)
+{
+  std::free(pointer);
+}
+
+rcutils_allocator_t
+get_failing_allocator(FailingAllocatorState * state)
+{
+  rcutils_allocator_t allocator = rcutils_get_zero_initialized_allocator();
+  allocator.allocate = failing_allocate;
+  allocator.deallocate = failing_deallocate;
+  allocator.reallocate = failing_reallocate;
+  allocator.zero_allocate = failing_zero_allocate;
+  allocator.state = state;
+  return allocator;
+}
+
+// Counts the allocations that were not deallocated yet
+void *
+counting_allocate(size_t size, void * state)
+{
+  ++*static_cast<int *>(state);
+  return std::malloc(size);
+}
+
+void *
+counting_reallocate(void * pointer, size_t size, void * state)
+{
+  if (pointer == nullptr) {
+    ++*static_cast<int *>(state);
+  }
+  return std::realloc(pointer, size);
+}
+
+void *
+counting_zero_allocate(size_t count, size_t size, void * state)
+{
+  ++*static_cast<int *>(state);
+  return std::calloc(count, size);
+}
+
+void
+counting_deallocate(void * pointer, void * state)
+{
+  if (pointer != nullptr) {
+    --*static_cast<int *>(state);
+  }
+  std::free(pointer);
+}
+
+rcutils_allocator_t
+get_counting_allocator(int * live_allocations)
+{
+  rcutils_allocator_t allocator = rcutils_get_zero_initialized_allocator();
+  allocator.allocate = counting_allocate;
+  allocator.deallocate = counting_deallocate;
+  allocator.reallocate = counting_reallocate;
+  allocator.zero_allocate = counting_zero_allocate;
+  allocator.state = live_allocations;
+  return allocator;
+}
+
+}  // namespace
+
+class TestDynamicMessageTypeSupportInit : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    type_hash = rosidl_get_zero_initialized_type_hash();
+    make_description(&description);
+  }
+
+  void TearDown() override
+  {
+    rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+  }
+
+  static void make_description(rosidl_runtime_c__type_description__TypeDescription * out)
+  {
+    ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(out));
+    fill_individual_type_description(
+      "test_msgs/msg/A",
+      {
+        {"a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+        {"b", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, "test_msgs/msg/B"},
+      },
+      &out->type_description);
+    ASSERT_TRUE(
+      rosidl_runtime_c__type_description__IndividualTypeDescription__Sequence__init(
+        &out->referenced_type_descriptions, 1));
+    fill_individual_type_description(
+      "test_msgs/msg/B",
+      {{"x", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOOLEAN, nullptr}},
+      &out->referenced_type_descriptions.data[0]);
+  }
+
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_type_hash_t type_hash;
+  rosidl_runtime_c__type_description__TypeDescription description;
+};
+
+TEST_F(TestDynamicMessageTypeSupportInit, adopt_takes_description_over)
+{
+  int finis = fake_counters.serialization_support_finis;
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support =
+    get_fake_serialization_support();
+  rosidl_message_type_support_t ts;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_message_type_support_handle_init_adopt(
+      &serialization_support, &type_hash, &description, nullptr, &allocator, &ts)) <<
+    rcutils_get_error_string().str;
+
+  // The caller's description is left empty, and the handle has it now
+  EXPECT_EQ(nullptr, description.type_description.type_name.data);
+  EXPECT_EQ(0u, description.referenced_type_descriptions.size);
+  auto ts_impl = static_cast<const rosidl_dynamic_message_type_support_impl_t *>(ts.data);
+  EXPECT_STREQ("test_msgs/msg/A", ts_impl->type_description.type_description.type_name.data);
+  EXPECT_EQ(1u, ts_impl->type_description.referenced_type_descriptions.size);
+
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_fini(&ts));
+  EXPECT_EQ(finis + 1, fake_counters.serialization_support_finis);
+}
+
+TEST_F(TestDynamicMessageTypeSupportInit, failed_adopt_hands_description_back)
+{
+  rosidl_runtime_c__String__assign(
+    &description.type_description.fields.data[1].type.nested_type_name, "test_msgs/msg/Missing");
+
+  int finis = fake_counters.serialization_support_finis;
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support =
+    get_fake_serialization_support();
+  rosidl_message_type_support_t ts;
+  EXPECT_NE(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_message_type_support_handle_init_adopt(
+      &serialization_support, &type_hash, &description, nullptr, &allocator, &ts));
+  rcutils_reset_error();
+
+  // The description is left as it was passed in, and the serialization support was taken over
+  EXPECT_STREQ("test_msgs/msg/A", description.type_description.type_name.data);
+  ASSERT_EQ(2u, description.type_description.fields.size);
+  EXPECT_STREQ(
+    "test_msgs/msg/Missing",
+    description.type_description.fields.data[1].type.nested_type_name.data);
+  EXPECT_EQ(1u, description.referenced_type_descriptions.size);
+  EXPECT_EQ(finis + 1, fake_counters.serialization_support_finis);
+}
+
+// Fails each allocation in turn, until initialization gets through. Whichever one fails, the
+// serialization support must be finalized exactly once, and adopted descriptions handed back
+TEST_F(TestDynamicMessageTypeSupportInit, every_allocation_failure_finalizes_support_once)
+{
+  for (bool adopt : {false, true}) {
+    bool succeeded = false;
+    for (size_t allocations = 0; !succeeded && allocations < 1000; allocations++) {
+      rosidl_runtime_c__type_description__TypeDescription adopted;
+      make_description(&adopted);
+
+      FailingAllocatorState state{allocations};
+      rcutils_allocator_t failing_allocator = get_failing_allocator(&state);
+      int finis = fake_counters.serialization_support_finis;
+      rosidl_dynamic_typesupport_serialization_support_t serialization_support =
+        get_fake_serialization_support();
+      rosidl_message_type_support_t ts;
+      rcutils_ret_t ret = adopt ?
+        rosidl_dynamic_message_type_support_handle_init_adopt(
+        &serialization_support, &type_hash, &adopted, nullptr, &failing_allocator, &ts) :
+        rosidl_dynamic_message_type_support_handle_init(
+        &serialization_support, &type_hash, &description, nullptr, &failing_allocator, &ts);
+      if (ret == RCUTILS_RET_OK) {
+        succeeded = true;
+        EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_fini(&ts));
+      } else {
+        rcutils_reset_error();
+        if (adopt) {
+          EXPECT_STREQ("test_msgs/msg/A", adopted.type_description.type_name.data) <<
+            "after " << allocations << " allocations";
+        }
+      }
+      EXPECT_EQ(finis + 1, fake_counters.serialization_support_finis) <<
+        "after " << allocations << " allocations, adopt: " << adopt;
+
+      rosidl_runtime_c__type_description__TypeDescription__fini(&adopted);
+    }
+    EXPECT_TRUE(succeeded) << "adopt: " << adopt;
+  }
+}
+
+TEST_F(TestDynamicMessageTypeSupportInit, compact_handle_lives_in_one_allocation)
+{
+  int live_allocations = 0;
+  rcutils_allocator_t counting_allocator = get_counting_allocator(&live_allocations);
+
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support =
+    get_fake_serialization_support();
+  rosidl_message_type_support_t ts;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_message_type_support_handle_init(
+      &serialization_support, &type_hash, &description, nullptr, &counting_allocator, &ts));
+  int handle_allocations = live_allocations;
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_fini(&ts));
+  EXPECT_EQ(0, live_allocations);
+
+  serialization_support = get_fake_serialization_support();
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_message_type_support_handle_init_compact(
+      &serialization_support, &type_hash, &description, nullptr, &counting_allocator, &ts)) <<
+    rcutils_get_error_string().str;
+
+  // The impl, the dynamic type, and the description copy would otherwise take one each. What is
+  // left is the shared serialization support, which no other handle holds a reference to here
+  EXPECT_EQ(handle_allocations - 2, live_allocations);
+
+  auto ts_impl = static_cast<const rosidl_dynamic_message_type_support_impl_t *>(ts.data);
+  EXPECT_TRUE(ts_impl->is_compact);
+  EXPECT_EQ(nullptr, ts_impl->type_description_storage);
+  auto begin = reinterpret_cast<uintptr_t>(ts_impl);
+  auto dynamic_type = reinterpret_cast<uintptr_t>(ts_impl->dynamic_message_type);
+  auto type_name =
+    reinterpret_cast<uintptr_t>(ts_impl->type_description.type_description.type_name.data);
+  EXPECT_GT(dynamic_type, begin);
+  EXPECT_GT(type_name, dynamic_type);
+  EXPECT_TRUE(
+    rosidl_runtime_c__type_description__TypeDescription__are_equal(
+      &description, &ts_impl->type_description));
+
+  rosidl_dynamic_typesupport_dynamic_data_t * dynamic_message = nullptr;
+  EXPECT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_message_type_support_handle_get_dynamic_message(&ts, &dynamic_message));
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_fini(&ts));
+  EXPECT_EQ(0, live_allocations);
+}
+
+TEST_F(TestDynamicMessageTypeSupportInit, every_compact_allocation_failure_finalizes_support_once)
+{
+  bool succeeded = false;
+  for (size_t allocations = 0; !succeeded && allocations < 1000; allocations++) {
+    FailingAllocatorState state{allocations};
+    rcutils_allocator_t failing_allocator = get_failing_allocator(&state);
+    int finis = fake_counters.serialization_support_finis;
+    rosidl_dynamic_typesupport_serialization_support_t serialization_support =
+      get_fake_serialization_support();
+    rosidl_message_type_support_t ts;
+    if (rosidl_dynamic_message_type_support_handle_init_compact(
+        &serialization_support, &type_hash, &description, nullptr, &failing_allocator, &ts) ==
+      RCUTILS_RET_OK)
+    {
+      succeeded = true;
+      EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_fini(&ts));
+    } else {
+      rcutils_reset_error();
+    }
+    EXPECT_EQ(finis + 1, fake_counters.serialization_support_finis) <<
+      "after " << allocations << " allocations";
+  }
+  EXPECT_TRUE(succeeded);
+}
+
+TEST_F(TestDynamicMessageTypeSupportInit, copied_description_is_packed_into_one_block)
+{
+  int live_allocations = 0;
+  rcutils_allocator_t counting_allocator = get_counting_allocator(&live_allocations);
+
+  rosidl_runtime_c__type_description__TypeDescription adopted;
+  make_description(&adopted);
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support =
+    get_fake_serialization_support();
+  rosidl_message_type_support_t ts;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_message_type_support_handle_init_adopt(
+      &serialization_support, &type_hash, &adopted, nullptr, &counting_allocator, &ts));
+  int adopting_allocations = live_allocations;
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_fini(&ts));
+
+  serialization_support = get_fake_serialization_support();
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_message_type_support_handle_init(
+      &serialization_support, &type_hash, &description, nullptr, &counting_allocator, &ts)) <<
+    rcutils_get_error_string().str;
+
+  // Every string and sequence of the copy is in the one block
+  EXPECT_EQ(adopting_allocations + 1, live_allocations);
+  auto ts_impl = static_cast<const rosidl_dynamic_message_type_support_impl_t *>(ts.data);
+  ASSERT_NE(nullptr, ts_impl->type_description_storage);
+  EXPECT_FALSE(ts_impl->is_compact);
+  auto storage = static_cast<const void *>(ts_impl->type_description_storage);
+  const rosidl_runtime_c__type_description__TypeDescription * copy = &ts_impl->type_description;
+  EXPECT_LE(storage, static_cast<const void *>(copy->type_description.type_name.data));
+  EXPECT_LE(storage, static_cast<const void *>(copy->type_description.fields.data));
+  EXPECT_LE(storage, static_cast<const void *>(copy->referenced_type_descriptions.data));
+  EXPECT_TRUE(rosidl_runtime_c__type_description__TypeDescription__are_equal(&description, copy));
+
+  // The copy does not depend on the caller's description in any way
+  rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+  make_description(&description);
+  rosidl_runtime_c__String__assign(&description.type_description.type_name, "test_msgs/msg/C");
+  EXPECT_STREQ("test_msgs/msg/A", copy->type_description.type_name.data);
+  EXPECT_STREQ("test_msgs/msg/B", copy->referenced_type_descriptions.data[0].type_name.data);
+  ASSERT_EQ(2u, copy->type_description.fields.size);
+  EXPECT_STREQ("test_msgs/msg/B", copy->type_description.fields.data[1].type.nested_type_name.data);
+
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_fini(&ts));
+  EXPECT_EQ(0, live_allocations);
+}
@@ -0,0 +1,231 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__functions.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+namespace
+{
+
+// One entry per call of the batched slot below, with the members it got
+struct BatchedCall
+{
+  std::vector<rosidl_dynamic_typesupport_member_id_t> ids;
+  std::vector<std::string> names;
+  std::vector<bool> has_nested_type;
+};
+std::vector<BatchedCall> batched_calls;
+
+rcutils_ret_t
+add_members(
+  rosidl_dynamic_typesupport_serialization_support_impl_t *,
+  rosidl_dynamic_typesupport_dynamic_type_builder_impl_t * builder,
+  const rosidl_dynamic_typesupport_dynamic_type_member_spec_t * members, size_t member_count)
+{
+  BatchedCall call;
+  for (size_t i = 0; i < member_count; i++) {
+    call.ids.push_back(members[i].id);
+    call.names.push_back(std::string(members[i].name, members[i].name_length));
+    call.has_nested_type.push_back(members[i].nested_type != nullptr);
+    *static_cast<std::string *>(builder->handle) += call.names.back() + ";";
+  }
+  batched_calls.push_back(call);
+  return RCUTILS_RET_OK;
+}
+
+rosidl_dynamic_typesupport_dynamic_type_member_spec_t
+get_member_spec(rosidl_dynamic_typesupport_member_id_t id, const char * name, uint8_t type_id)
+{
+  rosidl_dynamic_typesupport_dynamic_type_member_spec_t member{};
+  member.id = id;
+  member.name = name;
+  member.name_length = std::string(name).size();
+  member.default_value = "";
+  member.default_value_length = 0;
+  member.type_id = type_id;
+  return member;
+}
+
+}  // namespace
+
+class TestDynamicTypeBuilderAddMembers : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    batched_calls.clear();
+    serialization_support = get_fake_serialization_support();
+    builder = rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type_builder();
+    ASSERT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_dynamic_type_builder_init(
+        &serialization_support, "test_msgs/msg/A", 15, &allocator, &builder));
+  }
+
+  void TearDown() override
+  {
+    EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_builder_fini(&builder));
+    EXPECT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_serialization_support_fini(&serialization_support));
+  }
+
+  std::string build()
+  {
+    rosidl_dynamic_typesupport_dynamic_type_t dynamic_type =
+      rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+    EXPECT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_dynamic_type_init_from_dynamic_type_builder(
+        &builder, &allocator, &dynamic_type));
+    std::string built = *static_cast<std::string *>(dynamic_type.impl.handle);
+    EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type));
+    return built;
+  }
+
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support;
+  rosidl_dynamic_typesupport_dynamic_type_builder_t builder;
+};
+
+TEST_F(TestDynamicTypeBuilderAddMembers, falls_back_to_one_slot_per_member)
+{
+  rosidl_dynamic_typesupport_dynamic_type_builder_t nested_builder =
+    rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type_builder();
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_type_builder_init(
+      &serialization_support, "test_msgs/msg/B", 15, &allocator, &nested_builder));
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_type_builder_add_bool_member(
+      &nested_builder, 0, "x", 1, "", 0));
+  rosidl_dynamic_typesupport_dynamic_type_t nested_type =
+    rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_type_init_from_dynamic_type_builder(
+      &nested_builder, &allocator, &nested_type));
+  EXPECT_EQ(
+    RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_builder_fini(&nested_builder));
+
+  std::vector<rosidl_dynamic_typesupport_dynamic_type_member_spec_t> members = {
+    get_member_spec(0, "a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32),
+    get_member_spec(1, "b", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOOLEAN),
+    get_member_spec(2, "s", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32_BOUNDED_SEQUENCE),
+    get_member_spec(3, "n", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE),
+  };
+  members[2].capacity = 3;
+  members[3].nested_type = &nested_type;
+
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_type_builder_add_members(
+      &builder, members.data(), members.size())) << rcutils_get_error_string().str;
+  EXPECT_EQ(
+    "test_msgs/msg/A{a:int32;b:bool;s:int32[<=3];n:test_msgs/msg/B{x:bool;};}", build());
+  EXPECT_TRUE(batched_calls.empty());
+
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(&nested_type));
+}
+
+TEST_F(TestDynamicTypeBuilderAddMembers, batched_slot_gets_every_member_at_once)
+{
+  serialization_support.methods.dynamic_type_builder_add_members = add_members;
+
+  std::vector<rosidl_dynamic_typesupport_dynamic_type_member_spec_t> members = {
+    get_member_spec(0, "a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32),
+    get_member_spec(1, "b", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOOLEAN),
+  };
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_type_builder_add_members(
+      &builder, members.data(), members.size()));
+  ASSERT_EQ(1u, batched_calls.size());
+  EXPECT_EQ((std::vector<std::string>{"a", "b"}), batched_calls[0].names);
+  EXPECT_EQ("test_msgs/msg/A{a;b;}", build());
+}
+
+TEST_F(TestDynamicTypeBuilderAddMembers, construction_from_descriptions_batches_each_type)
+{
+  serialization_support.methods.dynamic_type_builder_add_members = add_members;
+
+  rosidl_runtime_c__type_description__TypeDescription description;
+  ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&description));
+  fill_individual_type_description(
+    "test_msgs/msg/Top",
+    {
+      {"a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+      {"n", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, "test_msgs/msg/B"},
+      {"c", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOOLEAN, nullptr},
+    },
+    &description.type_description);
+  ASSERT_TRUE(
+    rosidl_runtime_c__type_description__IndividualTypeDescription__Sequence__init(
+      &description.referenced_type_descriptions, 1));
+  fill_individual_type_description(
+    "test_msgs/msg/B", {{"x", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOOLEAN, nullptr}},
+    &description.referenced_type_descriptions.data[0]);
+
+  rosidl_dynamic_typesupport_dynamic_type_t dynamic_type =
+    rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_type_init_from_description(
+      &serialization_support, &description, &allocator, &dynamic_type)) <<
+    rcutils_get_error_string().str;
+  rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+
+  // The nested type first, then the top level type, with members in order of their ids
+  ASSERT_EQ(2u, batched_calls.size());
+  EXPECT_EQ((std::vector<std::string>{"x"}), batched_calls[0].names);
+  EXPECT_EQ((std::vector<std::string>{"a", "n", "c"}), batched_calls[1].names);
+  EXPECT_EQ(
+    (std::vector<rosidl_dynamic_typesupport_member_id_t>{0, 1, 2}), batched_calls[1].ids);
+  EXPECT_EQ((std::vector<bool>{false, true, false}), batched_calls[1].has_nested_type);
+  EXPECT_EQ("test_msgs/msg/Top{a;n;c;}", *static_cast<std::string *>(dynamic_type.impl.handle));
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type));
+}
+
+TEST_F(TestDynamicTypeBuilderAddMembers, rejects_members_without_names)
+{
+  serialization_support.methods.dynamic_type_builder_add_members = add_members;
+
+  EXPECT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_type_builder_add_members(&builder, nullptr, 0));
+
+  rosidl_dynamic_typesupport_dynamic_type_member_spec_t member =
+    get_member_spec(0, "a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32);
+  member.name = nullptr;
+  EXPECT_EQ(
+    RCUTILS_RET_INVALID_ARGUMENT,
+    rosidl_dynamic_typesupport_dynamic_type_builder_add_members(&builder, &member, 1));
+  rcutils_reset_error();
+  EXPECT_TRUE(batched_calls.empty());
+}
@@ -0,0 +1,154 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+#include <rosidl_runtime_c/type_hash.h>
+
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+class TestDynamicTypeEquals : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    serialization_support = get_fake_serialization_support();
+    ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_clear_type_description_validation_cache());
+
+    ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&a));
+    fill_individual_type_description(
+      "test_msgs/msg/A",
+      {{"a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr}},
+      &a.type_description);
+    ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&b));
+    fill_individual_type_description(
+      "test_msgs/msg/A",
+      {{"b", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOOLEAN, nullptr}},
+      &b.type_description);
+
+    first_hash = rosidl_get_zero_initialized_type_hash();
+    first_hash.version = 1;
+    first_hash.value[0] = 1;
+    second_hash = first_hash;
+    second_hash.value[0] = 2;
+  }
+
+  void TearDown() override
+  {
+    for (auto * dynamic_type : {&first, &second}) {
+      if (dynamic_type->impl.handle != nullptr) {
+        EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(dynamic_type));
+      }
+    }
+    rosidl_runtime_c__type_description__TypeDescription__fini(&a);
+    rosidl_runtime_c__type_description__TypeDescription__fini(&b);
+    EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_clear_type_description_validation_cache());
+    EXPECT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_serialization_support_fini(&serialization_support));
+  }
+
+  void init(
+    const rosidl_runtime_c__type_description__TypeDescription * description,
+    const rosidl_type_hash_t * type_hash,
+    rosidl_dynamic_typesupport_dynamic_type_t * dynamic_type)
+  {
+    rosidl_dynamic_typesupport_dynamic_type_construction_options_t options =
+      rosidl_dynamic_typesupport_get_default_dynamic_type_construction_options();
+    options.type_hash = type_hash;
+    *dynamic_type = rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+    ASSERT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_dynamic_type_init_from_description_with_options(
+        &serialization_support, description, &options, &allocator, dynamic_type)) <<
+      rcutils_get_error_string().str;
+  }
+
+  // Whether the types are equal, and whether the serialization library had to compare them
+  void expect_equals(bool expected_equals, bool expected_structural)
+  {
+    int type_equals_calls = fake_counters.type_equals_calls;
+    bool equals = !expected_equals;
+    ASSERT_EQ(
+      RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_equals(&first, &second, &equals));
+    EXPECT_EQ(expected_equals, equals);
+    EXPECT_EQ(expected_structural ? 1 : 0, fake_counters.type_equals_calls - type_equals_calls);
+  }
+
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support;
+  rosidl_runtime_c__type_description__TypeDescription a;
+  rosidl_runtime_c__type_description__TypeDescription b;
+  rosidl_type_hash_t first_hash;
+  rosidl_type_hash_t second_hash;
+  rosidl_dynamic_typesupport_dynamic_type_t first =
+    rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+  rosidl_dynamic_typesupport_dynamic_type_t second =
+    rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+};
+
+TEST_F(TestDynamicTypeEquals, verified_hashes_skip_the_structural_comparison)
+{
+  init(&a, &first_hash, &first);
+  init(&a, &first_hash, &second);
+  EXPECT_NE(0u, first.type_hash_verification);
+  EXPECT_EQ(first.type_hash_verification, second.type_hash_verification);
+  expect_equals(true, false);
+}
+
+TEST_F(TestDynamicTypeEquals, hash_claimed_for_another_description_is_not_trusted)
+{
+  init(&a, &first_hash, &first);
+  init(&b, &first_hash, &second);
+  EXPECT_EQ(0u, second.type_hash_verification);
+  expect_equals(false, true);
+}
+
+TEST_F(TestDynamicTypeEquals, different_hashes_are_compared_structurally)
+{
+  init(&a, &first_hash, &first);
+  init(&a, &second_hash, &second);
+  expect_equals(true, true);
+
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(&second));
+  init(&b, &second_hash, &second);
+  expect_equals(false, true);
+}
+
+TEST_F(TestDynamicTypeEquals, types_without_hashes_are_compared_structurally)
+{
+  init(&a, nullptr, &first);
+  init(&a, nullptr, &second);
+  EXPECT_EQ(0u, first.type_hash_verification);
+  expect_equals(true, true);
+}
+
+TEST_F(TestDynamicTypeEquals, clearing_the_validation_cache_starts_over)
+{
+  // After clearing, the type hash may be taken by another description, so types verified before
+  // and after can't vouch for each other
+  init(&a, &first_hash, &first);
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_clear_type_description_validation_cache());
+  init(&b, &first_hash, &second);
+  EXPECT_NE(0u, second.type_hash_verification);
+  expect_equals(false, true);
+}
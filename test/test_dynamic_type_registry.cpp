@@ -0,0 +1,181 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/string_functions.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+#include <rosidl_runtime_c/type_hash.h>
+
+#include "rosidl_dynamic_typesupport/dynamic_message_type_support_struct.h"
+#include "rosidl_dynamic_typesupport/dynamic_type_registry.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+class TestDynamicTypeRegistry : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&description));
+    fill_individual_type_description(
+      "test_msgs/msg/A",
+      {{"a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr}},
+      &description.type_description);
+
+    type_hash = rosidl_get_zero_initialized_type_hash();
+    type_hash.version = 1;
+    type_hash.value[0] = 42;
+  }
+
+  void TearDown() override
+  {
+    rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+  }
+
+  rosidl_runtime_c__type_description__TypeDescription description;
+  rosidl_type_hash_t type_hash;
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+};
+
+TEST_F(TestDynamicTypeRegistry, shares_types_across_handles)
+{
+  int live_types = fake_counters.live_types;
+  int serialization_support_finis = fake_counters.serialization_support_finis;
+
+  rosidl_dynamic_typesupport_serialization_support_t first = get_fake_serialization_support();
+  rosidl_dynamic_typesupport_serialization_support_t second = get_fake_serialization_support();
+  rosidl_message_type_support_t first_ts;
+  rosidl_message_type_support_t second_ts;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_message_type_support_handle_init(
+      &first, &type_hash, &description, nullptr, &allocator, &first_ts));
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_message_type_support_handle_init(
+      &second, &type_hash, &description, nullptr, &allocator, &second_ts));
+
+  // Serialization supports of the same serialization library are shared, so the second one was
+  // finalized right away
+  EXPECT_EQ(serialization_support_finis + 1, fake_counters.serialization_support_finis);
+
+  // Both handles use the one dynamic type held by the registry
+  auto first_impl = static_cast<const rosidl_dynamic_message_type_support_impl_t *>(first_ts.data);
+  auto second_impl =
+    static_cast<const rosidl_dynamic_message_type_support_impl_t *>(second_ts.data);
+  EXPECT_EQ(first_impl->dynamic_message_type, second_impl->dynamic_message_type);
+  EXPECT_EQ(live_types + 1, fake_counters.live_types);
+
+  // The registry entry still references the shared serialization support, so it outlives the
+  // handle that built it
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_fini(&first_ts));
+  EXPECT_EQ(serialization_support_finis + 1, fake_counters.serialization_support_finis);
+  EXPECT_EQ(live_types + 1, fake_counters.live_types);
+
+  rosidl_dynamic_typesupport_dynamic_data_t * dynamic_message = nullptr;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_message_type_support_handle_get_dynamic_message(&second_ts, &dynamic_message));
+  EXPECT_NE(nullptr, dynamic_message);
+
+  // Releasing the last handle releases the type, and with it the shared serialization support
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_fini(&second_ts));
+  EXPECT_EQ(serialization_support_finis + 2, fake_counters.serialization_support_finis);
+  EXPECT_EQ(live_types, fake_counters.live_types);
+  EXPECT_EQ(0, fake_counters.live_data);
+}
+
+TEST_F(TestDynamicTypeRegistry, acquire_and_release)
+{
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support =
+    get_fake_serialization_support();
+  rosidl_dynamic_typesupport_serialization_support_t * shared = nullptr;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_serialization_support_init_shared(
+      &serialization_support, &allocator, &shared));
+
+  int builder_inits = fake_counters.builder_inits;
+  rosidl_dynamic_typesupport_dynamic_type_t * first = nullptr;
+  rosidl_dynamic_typesupport_dynamic_type_t * second = nullptr;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_type_registry_acquire(
+      shared, &type_hash, &description, &allocator, &first));
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_type_registry_acquire(
+      shared, &type_hash, &description, &allocator, &second));
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(builder_inits + 1, fake_counters.builder_inits);
+
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_registry_release(first));
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_registry_release(second));
+
+  // Once released for good, the type is built again on the next acquire
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_type_registry_acquire(
+      shared, &type_hash, &description, &allocator, &first));
+  EXPECT_EQ(builder_inits + 2, fake_counters.builder_inits);
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_registry_release(first));
+
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_serialization_support_release(shared));
+}
+
+TEST_F(TestDynamicTypeRegistry, different_description_under_the_same_hash_is_refused)
+{
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support =
+    get_fake_serialization_support();
+  rosidl_dynamic_typesupport_serialization_support_t * shared = nullptr;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_serialization_support_init_shared(
+      &serialization_support, &allocator, &shared));
+
+  rosidl_dynamic_typesupport_dynamic_type_t * registered = nullptr;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_type_registry_acquire(
+      shared, &type_hash, &description, &allocator, &registered));
+
+  // Same type hash, but a member was renamed
+  rosidl_runtime_c__type_description__TypeDescription other;
+  ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&other));
+  ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__copy(&description, &other));
+  ASSERT_TRUE(rosidl_runtime_c__String__assign(&other.type_description.fields.data[0].name, "b"));
+
+  int builder_inits = fake_counters.builder_inits;
+  rosidl_dynamic_typesupport_dynamic_type_t * mismatched = nullptr;
+  EXPECT_EQ(
+    RCUTILS_RET_INVALID_ARGUMENT,
+    rosidl_dynamic_typesupport_dynamic_type_registry_acquire(
+      shared, &type_hash, &other, &allocator, &mismatched));
+  rcutils_reset_error();
+  EXPECT_EQ(nullptr, mismatched);
+  EXPECT_EQ(builder_inits, fake_counters.builder_inits);
+
+  // The refused acquire did not keep a reference, so one release is enough to unregister the type
+  int live_types = fake_counters.live_types;
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_registry_release(registered));
+  EXPECT_EQ(live_types - 1, fake_counters.live_types);
+
+  rosidl_runtime_c__type_description__TypeDescription__fini(&other);
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_serialization_support_release(shared));
+}
@@ -0,0 +1,131 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+class TestFieldMemberDispatch : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    serialization_support = get_fake_serialization_support();
+  }
+
+  void TearDown() override
+  {
+    EXPECT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_serialization_support_fini(&serialization_support));
+  }
+
+  // Build a type with the given fields, and return what the fake serialization library got
+  rcutils_ret_t build(const std::vector<FieldSpec> & fields, std::string * built)
+  {
+    rosidl_runtime_c__type_description__TypeDescription description;
+    EXPECT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&description));
+    fill_individual_type_description("test_msgs/msg/A", fields, &description.type_description);
+
+    rosidl_dynamic_typesupport_dynamic_type_t dynamic_type =
+      rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+    rcutils_ret_t ret = rosidl_dynamic_typesupport_dynamic_type_init_from_description(
+      &serialization_support, &description, &allocator, &dynamic_type);
+    rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+    if (ret == RCUTILS_RET_OK) {
+      *built = *static_cast<std::string *>(dynamic_type.impl.handle);
+      EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type));
+    }
+    return ret;
+  }
+
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support;
+};
+
+TEST_F(TestFieldMemberDispatch, collections_get_their_own_slots)
+{
+  std::string built;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    build(
+      {
+        {"a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32_ARRAY, nullptr, 3},
+        {"b", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32_BOUNDED_SEQUENCE, nullptr, 4},
+        {"c", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32_UNBOUNDED_SEQUENCE, nullptr},
+      }, &built)) << rcutils_get_error_string().str;
+  EXPECT_EQ("test_msgs/msg/A{a:int32[3];b:int32[<=4];c:int32[];}", built);
+}
+
+TEST_F(TestFieldMemberDispatch, strings_get_their_string_bound)
+{
+  std::string built;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    build(
+      {
+        {"a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_STRING, nullptr, 0, 5},
+        {"b", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_STRING_ARRAY, nullptr, 2, 5},
+        {"c", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_STRING_BOUNDED_SEQUENCE, nullptr, 3,
+          5},
+        {"d", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_STRING_UNBOUNDED_SEQUENCE, nullptr, 0,
+          5},
+      }, &built)) << rcutils_get_error_string().str;
+  EXPECT_EQ(
+    "test_msgs/msg/A{a:string<=5;b:string<=5[2];c:string<=5[<=3];d:string<=5[];}", built);
+}
+
+TEST_F(TestFieldMemberDispatch, wchar_and_float128_are_dispatched)
+{
+  std::string built;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    build(
+      {
+        {"a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_WCHAR, nullptr},
+        {"b", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_FLOAT128, nullptr},
+      }, &built)) << rcutils_get_error_string().str;
+  EXPECT_EQ("test_msgs/msg/A{a:wchar;b:float128;}", built);
+}
+
+TEST_F(TestFieldMemberDispatch, rejects_unsupported_fields)
+{
+  int live_types = fake_counters.live_types;
+  std::string built;
+
+  // The fake serialization library has no slot for uint8 members
+  EXPECT_NE(
+    RCUTILS_RET_OK,
+    build({{"a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_UINT8, nullptr}}, &built));
+  rcutils_reset_error();
+
+  EXPECT_NE(
+    RCUTILS_RET_OK,
+    build({{"a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NOT_SET, nullptr}}, &built));
+  rcutils_reset_error();
+
+  EXPECT_EQ(live_types, fake_counters.live_types);
+}
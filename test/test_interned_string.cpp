@@ -0,0 +1,191 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__functions.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/interned_string.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+namespace
+{
+
+// What the member slots below saw during the last construction
+std::vector<const rosidl_dynamic_typesupport_interned_string_t *> seen_interned_names;
+size_t interned_string_count_in_slot = 0;
+
+rcutils_ret_t
+add_members(
+  rosidl_dynamic_typesupport_serialization_support_impl_t *,
+  rosidl_dynamic_typesupport_dynamic_type_builder_impl_t * builder,
+  const rosidl_dynamic_typesupport_dynamic_type_member_spec_t * members, size_t member_count)
+{
+  interned_string_count_in_slot = rosidl_dynamic_typesupport_get_interned_string_count();
+  for (size_t i = 0; i < member_count; i++) {
+    seen_interned_names.push_back(members[i].interned_name);
+    *static_cast<std::string *>(builder->handle) +=
+      std::string(members[i].name, members[i].name_length) + ":int32;";
+  }
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+add_int32_member(
+  rosidl_dynamic_typesupport_serialization_support_impl_t *,
+  rosidl_dynamic_typesupport_dynamic_type_builder_impl_t * builder,
+  rosidl_dynamic_typesupport_member_id_t, const char * name, size_t name_length, const char *,
+  size_t)
+{
+  interned_string_count_in_slot = rosidl_dynamic_typesupport_get_interned_string_count();
+  *static_cast<std::string *>(builder->handle) += std::string(name, name_length) + ":int32;";
+  return RCUTILS_RET_OK;
+}
+
+}  // namespace
+
+TEST(TestInternedString, equal_strings_share_one_interned_string)
+{
+  size_t count = rosidl_dynamic_typesupport_get_interned_string_count();
+
+  const rosidl_dynamic_typesupport_interned_string_t * a = nullptr;
+  const rosidl_dynamic_typesupport_interned_string_t * same_a = nullptr;
+  const rosidl_dynamic_typesupport_interned_string_t * with_null = nullptr;
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_intern_string("interned_a", 10, &a));
+  // Not null terminated where the length ends
+  ASSERT_EQ(
+    RCUTILS_RET_OK, rosidl_dynamic_typesupport_intern_string("interned_a_b", 10, &same_a));
+  ASSERT_EQ(
+    RCUTILS_RET_OK, rosidl_dynamic_typesupport_intern_string("interned_a\0b", 12, &with_null));
+
+  EXPECT_EQ(a, same_a);
+  EXPECT_NE(a, with_null);
+  EXPECT_STREQ("interned_a", a->data);
+  EXPECT_EQ(10u, a->length);
+  EXPECT_EQ(12u, with_null->length);
+  EXPECT_EQ(std::string("interned_a\0b", 12), std::string(with_null->data, with_null->length));
+  EXPECT_NE(a->hash, with_null->hash);
+  EXPECT_EQ(count + 2, rosidl_dynamic_typesupport_get_interned_string_count());
+
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_interned_string_release(a));
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_interned_string_release(same_a));
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_interned_string_release(with_null));
+  EXPECT_EQ(count, rosidl_dynamic_typesupport_get_interned_string_count());
+}
+
+TEST(TestInternedString, strings_are_freed_with_their_last_reference)
+{
+  size_t count = rosidl_dynamic_typesupport_get_interned_string_count();
+
+  const rosidl_dynamic_typesupport_interned_string_t * name = nullptr;
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_intern_string("interned_b", 10, &name));
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_interned_string_retain(name));
+  EXPECT_EQ(count + 1, rosidl_dynamic_typesupport_get_interned_string_count());
+
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_interned_string_release(name));
+  EXPECT_EQ(count + 1, rosidl_dynamic_typesupport_get_interned_string_count());
+  EXPECT_STREQ("interned_b", name->data);
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_interned_string_release(name));
+  EXPECT_EQ(count, rosidl_dynamic_typesupport_get_interned_string_count());
+
+  EXPECT_EQ(
+    RCUTILS_RET_INVALID_ARGUMENT, rosidl_dynamic_typesupport_interned_string_release(nullptr));
+  rcutils_reset_error();
+}
+
+class TestInternedMemberNames : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    seen_interned_names.clear();
+    serialization_support = get_fake_serialization_support();
+    ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&description));
+    fill_individual_type_description(
+      "test_msgs/msg/A",
+      {
+        {"interned_x", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+        {"interned_y", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+      },
+      &description.type_description);
+  }
+
+  void TearDown() override
+  {
+    rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+    EXPECT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_serialization_support_fini(&serialization_support));
+  }
+
+  void build()
+  {
+    rosidl_dynamic_typesupport_dynamic_type_t dynamic_type =
+      rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+    ASSERT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_dynamic_type_init_from_description(
+        &serialization_support, &description, &allocator, &dynamic_type)) <<
+      rcutils_get_error_string().str;
+    EXPECT_EQ(
+      std::string("test_msgs/msg/A{interned_x:int32;interned_y:int32;}"),
+      *static_cast<std::string *>(dynamic_type.impl.handle));
+    EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type));
+  }
+
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support;
+  rosidl_runtime_c__type_description__TypeDescription description;
+};
+
+TEST_F(TestInternedMemberNames, batched_members_get_interned_names_for_the_call)
+{
+  serialization_support.methods.dynamic_type_builder_add_members = add_members;
+  size_t count = rosidl_dynamic_typesupport_get_interned_string_count();
+
+  build();
+
+  ASSERT_EQ(2u, seen_interned_names.size());
+  EXPECT_NE(nullptr, seen_interned_names[0]);
+  EXPECT_NE(nullptr, seen_interned_names[1]);
+  EXPECT_EQ(count + 2, interned_string_count_in_slot);
+  // Released once the type is built
+  EXPECT_EQ(count, rosidl_dynamic_typesupport_get_interned_string_count());
+
+  // Building it again interns the same names again
+  build();
+  EXPECT_EQ(count, rosidl_dynamic_typesupport_get_interned_string_count());
+}
+
+TEST_F(TestInternedMemberNames, names_are_not_interned_for_members_added_one_by_one)
+{
+  serialization_support.methods.dynamic_type_builder_add_int32_member = add_int32_member;
+  size_t count = rosidl_dynamic_typesupport_get_interned_string_count();
+
+  build();
+
+  EXPECT_EQ(count, interned_string_count_in_slot);
+  EXPECT_EQ(count, rosidl_dynamic_typesupport_get_interned_string_count());
+}
@@ -0,0 +1,263 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/message_type_support_struct.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__functions.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+#include <rosidl_runtime_c/type_hash.h>
+
+#include "rosidl_dynamic_typesupport/api/dynamic_data.h"
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/dynamic_message_type_support_struct.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+namespace
+{
+
+// Every dynamic data of the fake serialization library claims to hold this many bytes
+constexpr size_t data_bytes = 100;
+
+// Types and builders hold as many bytes as it takes to spell them out
+rcutils_ret_t
+type_get_memory_usage(
+  rosidl_dynamic_typesupport_serialization_support_impl_t *,
+  const rosidl_dynamic_typesupport_dynamic_type_impl_t * dynamic_type, size_t * bytes)
+{
+  *bytes = static_cast<const std::string *>(dynamic_type->handle)->size();
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+builder_get_memory_usage(
+  rosidl_dynamic_typesupport_serialization_support_impl_t *,
+  const rosidl_dynamic_typesupport_dynamic_type_builder_impl_t * builder, size_t * bytes)
+{
+  *bytes = static_cast<const std::string *>(builder->handle)->size();
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+data_get_memory_usage(
+  rosidl_dynamic_typesupport_serialization_support_impl_t *,
+  const rosidl_dynamic_typesupport_dynamic_data_impl_t *, size_t * bytes)
+{
+  *bytes = data_bytes;
+  return RCUTILS_RET_OK;
+}
+
+}  // namespace
+
+class TestMemoryUsage : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    type_hash = rosidl_get_zero_initialized_type_hash();
+    ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&description));
+    fill_individual_type_description(
+      "test_msgs/msg/A",
+      {{"a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr}},
+      &description.type_description);
+  }
+
+  void TearDown() override
+  {
+    rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+  }
+
+  // The fake serialization library, reporting its memory usage if `reported` is set
+  static rosidl_dynamic_typesupport_serialization_support_t
+  get_serialization_support(bool reported)
+  {
+    rosidl_dynamic_typesupport_serialization_support_t serialization_support =
+      get_fake_serialization_support();
+    if (reported) {
+      serialization_support.methods.dynamic_type_get_memory_usage = type_get_memory_usage;
+      serialization_support.methods.dynamic_type_builder_get_memory_usage =
+        builder_get_memory_usage;
+      serialization_support.methods.dynamic_data_get_memory_usage = data_get_memory_usage;
+    }
+    return serialization_support;
+  }
+
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_type_hash_t type_hash;
+  rosidl_runtime_c__type_description__TypeDescription description;
+};
+
+TEST_F(TestMemoryUsage, types_builders_and_data_report_what_the_library_reports)
+{
+  const std::string type_string = "test_msgs/msg/A{a:int32;}";
+  for (bool reported : {false, true}) {
+    rosidl_dynamic_typesupport_serialization_support_t serialization_support =
+      get_serialization_support(reported);
+    rosidl_dynamic_typesupport_memory_usage_t memory_usage;
+
+    rosidl_dynamic_typesupport_dynamic_type_builder_t builder =
+      rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type_builder();
+    ASSERT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_dynamic_type_builder_init(
+        &serialization_support, "test_msgs/msg/A", 15, &allocator, &builder));
+    ASSERT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_dynamic_type_builder_get_memory_usage(&builder, &memory_usage));
+    EXPECT_EQ(0u, memory_usage.library_bytes);
+    EXPECT_EQ(reported, memory_usage.serialization_library_bytes_reported);
+    EXPECT_EQ(reported ? 16u : 0u, memory_usage.serialization_library_bytes);
+    EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_builder_fini(&builder));
+
+    rosidl_dynamic_typesupport_dynamic_type_t dynamic_type =
+      rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+    ASSERT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_dynamic_type_init_from_description(
+        &serialization_support, &description, &allocator, &dynamic_type));
+    ASSERT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_dynamic_type_get_memory_usage(&dynamic_type, &memory_usage));
+    EXPECT_EQ(0u, memory_usage.library_bytes);
+    EXPECT_EQ(reported, memory_usage.serialization_library_bytes_reported);
+    EXPECT_EQ(reported ? type_string.size() : 0u, memory_usage.serialization_library_bytes);
+
+    rosidl_dynamic_typesupport_dynamic_data_t dynamic_data =
+      rosidl_dynamic_typesupport_get_zero_initialized_dynamic_data();
+    ASSERT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_dynamic_data_init_from_dynamic_type(
+        &dynamic_type, &allocator, &dynamic_data));
+    ASSERT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_dynamic_data_get_memory_usage(&dynamic_data, &memory_usage));
+    EXPECT_EQ(0u, memory_usage.library_bytes);
+    EXPECT_EQ(reported, memory_usage.serialization_library_bytes_reported);
+    EXPECT_EQ(reported ? data_bytes : 0u, memory_usage.serialization_library_bytes);
+
+    EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_data_fini(&dynamic_data));
+    EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type));
+    EXPECT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_serialization_support_fini(&serialization_support));
+  }
+}
+
+TEST_F(TestMemoryUsage, handles_add_up_whatever_they_constructed)
+{
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support =
+    get_serialization_support(true);
+  rosidl_message_type_support_t ts;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_message_type_support_handle_init(
+      &serialization_support, &type_hash, &description, nullptr, &allocator, &ts)) <<
+    rcutils_get_error_string().str;
+
+  // The impl, its packed description, and its dynamic type
+  rosidl_dynamic_typesupport_memory_usage_t initial;
+  ASSERT_EQ(
+    RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_get_memory_usage(&ts, &initial));
+  EXPECT_GT(
+    initial.library_bytes,
+    sizeof(rosidl_dynamic_message_type_support_impl_t) +
+    sizeof(rosidl_dynamic_typesupport_dynamic_type_t));
+  EXPECT_TRUE(initial.serialization_library_bytes_reported);
+  EXPECT_EQ(std::string("test_msgs/msg/A{a:int32;}").size(), initial.serialization_library_bytes);
+
+  // Constructing the dynamic message adds it
+  rosidl_dynamic_typesupport_dynamic_data_t * dynamic_message = nullptr;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_message_type_support_handle_get_dynamic_message(&ts, &dynamic_message));
+  rosidl_dynamic_typesupport_memory_usage_t with_message;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_message_type_support_handle_get_memory_usage(&ts, &with_message));
+  EXPECT_EQ(
+    initial.library_bytes + sizeof(rosidl_dynamic_typesupport_dynamic_data_t),
+    with_message.library_bytes);
+  EXPECT_EQ(
+    initial.serialization_library_bytes + data_bytes, with_message.serialization_library_bytes);
+
+  // And so do the pooled dynamic data and the type plan
+  ASSERT_EQ(
+    RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_init_dynamic_data_pool(&ts, 2, 4));
+  rosidl_dynamic_typesupport_memory_usage_t with_pool;
+  ASSERT_EQ(
+    RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_get_memory_usage(&ts, &with_pool));
+  EXPECT_GT(with_pool.library_bytes, with_message.library_bytes);
+  EXPECT_EQ(
+    with_message.serialization_library_bytes + 2 * data_bytes,
+    with_pool.serialization_library_bytes);
+
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_init_type_plan(&ts));
+  rosidl_dynamic_typesupport_memory_usage_t with_plan;
+  ASSERT_EQ(
+    RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_get_memory_usage(&ts, &with_plan));
+  EXPECT_GT(with_plan.library_bytes, with_pool.library_bytes);
+  EXPECT_EQ(with_pool.serialization_library_bytes, with_plan.serialization_library_bytes);
+
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_fini(&ts));
+}
+
+TEST_F(TestMemoryUsage, compact_handles_count_their_one_allocation)
+{
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support =
+    get_serialization_support(false);
+  rosidl_message_type_support_t ts;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_message_type_support_handle_init(
+      &serialization_support, &type_hash, &description, nullptr, &allocator, &ts));
+  rosidl_dynamic_typesupport_memory_usage_t copied;
+  ASSERT_EQ(
+    RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_get_memory_usage(&ts, &copied));
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_fini(&ts));
+
+  serialization_support = get_serialization_support(false);
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_message_type_support_handle_init_compact(
+      &serialization_support, &type_hash, &description, nullptr, &allocator, &ts));
+  rosidl_dynamic_typesupport_memory_usage_t compact;
+  ASSERT_EQ(
+    RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_get_memory_usage(&ts, &compact));
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_fini(&ts));
+
+  // The same parts, only laid out together (give or take the padding between them)
+  EXPECT_FALSE(compact.serialization_library_bytes_reported);
+  EXPECT_EQ(0u, compact.serialization_library_bytes);
+  EXPECT_GE(compact.library_bytes, copied.library_bytes);
+  EXPECT_LT(compact.library_bytes, copied.library_bytes + 64);
+}
+
+TEST_F(TestMemoryUsage, rejects_type_supports_of_other_implementations)
+{
+  rosidl_message_type_support_t ts{};
+  ts.typesupport_identifier = "other";
+  rosidl_dynamic_typesupport_memory_usage_t memory_usage;
+  EXPECT_EQ(
+    RCUTILS_RET_INVALID_ARGUMENT,
+    rosidl_dynamic_message_type_support_handle_get_memory_usage(&ts, &memory_usage));
+  rcutils_reset_error();
+}
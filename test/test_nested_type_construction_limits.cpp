@@ -0,0 +1,143 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__functions.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+class TestNestedTypeConstructionLimits : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    serialization_support = get_fake_serialization_support();
+    ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&description));
+    options = rosidl_dynamic_typesupport_get_default_dynamic_type_construction_options();
+  }
+
+  void TearDown() override
+  {
+    rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+    EXPECT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_serialization_support_fini(&serialization_support));
+  }
+
+  // A chain of `depth` nested types below the top level type, where every type has an int32 field
+  // and a field of the next type in the chain
+  void make_chain(size_t depth)
+  {
+    std::vector<std::string> names;
+    for (size_t i = 0; i <= depth; i++) {
+      names.push_back("test_msgs/msg/Level" + std::to_string(i));
+    }
+    ASSERT_TRUE(
+      rosidl_runtime_c__type_description__IndividualTypeDescription__Sequence__init(
+        &description.referenced_type_descriptions, depth));
+    for (size_t i = 0; i <= depth; i++) {
+      std::vector<FieldSpec> fields = {{"x", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr}};
+      if (i < depth) {
+        fields.push_back(
+          {"next", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, names[i + 1].c_str()});
+      }
+      fill_individual_type_description(
+        names[i].c_str(), fields,
+        i == 0 ? &description.type_description :
+        &description.referenced_type_descriptions.data[i - 1]);
+    }
+  }
+
+  rcutils_ret_t build()
+  {
+    rosidl_dynamic_typesupport_dynamic_type_t dynamic_type =
+      rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+    rcutils_ret_t ret = rosidl_dynamic_typesupport_dynamic_type_init_from_description_with_options(
+      &serialization_support, &description, &options, &allocator, &dynamic_type);
+    if (ret == RCUTILS_RET_OK) {
+      EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type));
+    } else {
+      rcutils_reset_error();
+    }
+    return ret;
+  }
+
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support;
+  rosidl_runtime_c__type_description__TypeDescription description;
+  rosidl_dynamic_typesupport_dynamic_type_construction_options_t options;
+};
+
+TEST_F(TestNestedTypeConstructionLimits, max_depth)
+{
+  make_chain(8);
+
+  options.max_depth = 8;
+  EXPECT_EQ(RCUTILS_RET_OK, build());
+
+  // Too deep descriptions fail before anything is built
+  int builder_inits = fake_counters.builder_inits;
+  options.max_depth = 7;
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, build());
+  EXPECT_EQ(builder_inits, fake_counters.builder_inits);
+}
+
+TEST_F(TestNestedTypeConstructionLimits, max_total_fields)
+{
+  make_chain(8);
+
+  // Two fields in each of the 8 types with a next one, and one in the last type
+  options.max_total_fields = 17;
+  EXPECT_EQ(RCUTILS_RET_OK, build());
+
+  int builder_inits = fake_counters.builder_inits;
+  options.max_total_fields = 16;
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, build());
+  EXPECT_EQ(builder_inits, fake_counters.builder_inits);
+}
+
+TEST_F(TestNestedTypeConstructionLimits, rejects_cycles)
+{
+  fill_individual_type_description(
+    "test_msgs/msg/A",
+    {{"b", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, "test_msgs/msg/B"}},
+    &description.type_description);
+  ASSERT_TRUE(
+    rosidl_runtime_c__type_description__IndividualTypeDescription__Sequence__init(
+      &description.referenced_type_descriptions, 2));
+  fill_individual_type_description(
+    "test_msgs/msg/B",
+    {{"c", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, "test_msgs/msg/C"}},
+    &description.referenced_type_descriptions.data[0]);
+  fill_individual_type_description(
+    "test_msgs/msg/C",
+    {{"b", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_ARRAY, "test_msgs/msg/B", 2}},
+    &description.referenced_type_descriptions.data[1]);
+
+  int builder_inits = fake_counters.builder_inits;
+  EXPECT_EQ(RCUTILS_RET_INVALID_ARGUMENT, build());
+  EXPECT_EQ(builder_inits, fake_counters.builder_inits);
+}
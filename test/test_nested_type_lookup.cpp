@@ -0,0 +1,290 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/string_functions.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__functions.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+namespace
+{
+
+// Counts the allocations made through it
+void *
+counting_allocate(size_t size, void * state)
+{
+  ++*static_cast<size_t *>(state);
+  return std::malloc(size);
+}
+
+void *
+counting_reallocate(void * pointer, size_t size, void * state)
+{
+  ++*static_cast<size_t *>(state);
+  return std::realloc(pointer, size);
+}
+
+void *
+counting_zero_allocate(size_t count, size_t size, void * state)
+{
+  ++*static_cast<size_t *>(state);
+  return std::calloc(count, size);
+}
+
+void
+counting_deallocate(void * pointer, void *)
+{
+  std::free(pointer);
+}
+
+rcutils_allocator_t
+get_counting_allocator(size_t * allocations)
+{
+  rcutils_allocator_t allocator = rcutils_get_zero_initialized_allocator();
+  allocator.allocate = counting_allocate;
+  allocator.deallocate = counting_deallocate;
+  allocator.reallocate = counting_reallocate;
+  allocator.zero_allocate = counting_zero_allocate;
+  allocator.state = allocations;
+  return allocator;
+}
+
+}  // namespace
+
+class TestNestedTypeLookup : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    serialization_support = get_fake_serialization_support();
+    ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&description));
+  }
+
+  void TearDown() override
+  {
+    rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+    EXPECT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_serialization_support_fini(&serialization_support));
+  }
+
+  // The top level type gets one nested field per referenced type, in the order given, and the
+  // referenced types are listed in reverse
+  void make_description(const std::vector<std::string> & nested_type_names)
+  {
+    std::vector<std::string> field_names;
+    for (size_t i = 0; i < nested_type_names.size(); i++) {
+      field_names.push_back("n" + std::to_string(i));
+    }
+    std::vector<FieldSpec> fields;
+    for (size_t i = 0; i < nested_type_names.size(); i++) {
+      fields.push_back(
+        {field_names[i].c_str(), ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE,
+          nested_type_names[i].c_str()});
+    }
+    fill_individual_type_description("test_msgs/msg/Top", fields, &description.type_description);
+
+    ASSERT_TRUE(
+      rosidl_runtime_c__type_description__IndividualTypeDescription__Sequence__init(
+        &description.referenced_type_descriptions, nested_type_names.size()));
+    for (size_t i = 0; i < nested_type_names.size(); i++) {
+      fill_individual_type_description(
+        nested_type_names[nested_type_names.size() - 1 - i].c_str(),
+        {{"x", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr}},
+        &description.referenced_type_descriptions.data[i]);
+    }
+  }
+
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support;
+  rosidl_runtime_c__type_description__TypeDescription description;
+};
+
+TEST_F(TestNestedTypeLookup, resolves_many_referenced_types_in_any_order)
+{
+  std::vector<std::string> nested_type_names;
+  for (size_t i = 0; i < 200; i++) {
+    nested_type_names.push_back("test_msgs/msg/Nested" + std::to_string(i));
+  }
+  make_description(nested_type_names);
+
+  rosidl_dynamic_typesupport_dynamic_type_t dynamic_type =
+    rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_type_init_from_description(
+      &serialization_support, &description, &allocator, &dynamic_type)) <<
+    rcutils_get_error_string().str;
+
+  // Every field got the type with its own name
+  std::string expected = "test_msgs/msg/Top{";
+  for (size_t i = 0; i < nested_type_names.size(); i++) {
+    expected += "n" + std::to_string(i) + ":" + nested_type_names[i] + "{x:int32;};";
+  }
+  expected += "}";
+  EXPECT_EQ(expected, *static_cast<std::string *>(dynamic_type.impl.handle));
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type));
+}
+
+TEST_F(TestNestedTypeLookup, duplicate_names_resolve_to_the_first_entry)
+{
+  fill_individual_type_description(
+    "test_msgs/msg/Top",
+    {{"n0", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, "test_msgs/msg/B"}},
+    &description.type_description);
+  ASSERT_TRUE(
+    rosidl_runtime_c__type_description__IndividualTypeDescription__Sequence__init(
+      &description.referenced_type_descriptions, 2));
+  fill_individual_type_description(
+    "test_msgs/msg/B", {{"first", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOOLEAN, nullptr}},
+    &description.referenced_type_descriptions.data[0]);
+  fill_individual_type_description(
+    "test_msgs/msg/B", {{"second", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr}},
+    &description.referenced_type_descriptions.data[1]);
+
+  rosidl_dynamic_typesupport_dynamic_type_t dynamic_type =
+    rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_type_init_from_description(
+      &serialization_support, &description, &allocator, &dynamic_type)) <<
+    rcutils_get_error_string().str;
+  EXPECT_EQ(
+    std::string("test_msgs/msg/Top{n0:test_msgs/msg/B{first:bool;};}"),
+    *static_cast<std::string *>(dynamic_type.impl.handle));
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type));
+}
+
+TEST_F(TestNestedTypeLookup, missing_referenced_type_fails)
+{
+  make_description({"test_msgs/msg/B", "test_msgs/msg/C"});
+  rosidl_runtime_c__String__assign(
+    &description.type_description.fields.data[1].type.nested_type_name, "test_msgs/msg/Missing");
+
+  int live_types = fake_counters.live_types;
+  rosidl_dynamic_typesupport_dynamic_type_t dynamic_type =
+    rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+  EXPECT_NE(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_type_init_from_description(
+      &serialization_support, &description, &allocator, &dynamic_type));
+  rcutils_reset_error();
+
+  // Nested types built before the failure were released
+  EXPECT_EQ(live_types, fake_counters.live_types);
+}
+
+TEST_F(TestNestedTypeLookup, nested_types_are_built_once_however_often_they_are_used)
+{
+  fill_individual_type_description(
+    "test_msgs/msg/Top",
+    {
+      {"b0", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, "test_msgs/msg/B"},
+      {"c", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, "test_msgs/msg/C"},
+      {"b1", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, "test_msgs/msg/B"},
+    },
+    &description.type_description);
+  ASSERT_TRUE(
+    rosidl_runtime_c__type_description__IndividualTypeDescription__Sequence__init(
+      &description.referenced_type_descriptions, 2));
+  fill_individual_type_description(
+    "test_msgs/msg/B", {{"x", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr}},
+    &description.referenced_type_descriptions.data[0]);
+  fill_individual_type_description(
+    "test_msgs/msg/C",
+    {
+      {"b0", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, "test_msgs/msg/B"},
+      {"b1", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, "test_msgs/msg/B"},
+    },
+    &description.referenced_type_descriptions.data[1]);
+
+  int builder_inits = fake_counters.builder_inits;
+  int live_types = fake_counters.live_types;
+  rosidl_dynamic_typesupport_dynamic_type_t dynamic_type =
+    rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_type_init_from_description(
+      &serialization_support, &description, &allocator, &dynamic_type)) <<
+    rcutils_get_error_string().str;
+
+  // One builder each for Top, B, and C, even though B is used four times
+  EXPECT_EQ(builder_inits + 3, fake_counters.builder_inits);
+  const std::string b = "test_msgs/msg/B{x:int32;}";
+  EXPECT_EQ(
+    "test_msgs/msg/Top{b0:" + b + ";c:test_msgs/msg/C{b0:" + b + ";b1:" + b + ";};b1:" + b + ";}",
+    *static_cast<std::string *>(dynamic_type.impl.handle));
+
+  // Nested types only live as long as the call
+  EXPECT_EQ(live_types + 1, fake_counters.live_types);
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type));
+  EXPECT_EQ(live_types, fake_counters.live_types);
+}
+
+// Nested types are built from the referenced descriptions in place, so nothing about them is copied
+TEST_F(TestNestedTypeLookup, building_nested_types_does_not_copy_their_descriptions)
+{
+  std::vector<size_t> allocations;
+  for (size_t nested_field_count : {1, 64}) {
+    rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+    ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&description));
+    fill_individual_type_description(
+      "test_msgs/msg/Top",
+      {{"b", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, "test_msgs/msg/B"}},
+      &description.type_description);
+    ASSERT_TRUE(
+      rosidl_runtime_c__type_description__IndividualTypeDescription__Sequence__init(
+        &description.referenced_type_descriptions, 1));
+    std::vector<std::string> field_names;
+    std::vector<FieldSpec> fields;
+    for (size_t i = 0; i < nested_field_count; i++) {
+      field_names.push_back("x" + std::to_string(i));
+    }
+    for (size_t i = 0; i < nested_field_count; i++) {
+      fields.push_back(
+        {field_names[i].c_str(), ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr});
+    }
+    fill_individual_type_description(
+      "test_msgs/msg/B", fields, &description.referenced_type_descriptions.data[0]);
+
+    size_t count = 0;
+    rcutils_allocator_t counting_allocator = get_counting_allocator(&count);
+    rosidl_dynamic_typesupport_dynamic_type_t dynamic_type =
+      rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+    ASSERT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_dynamic_type_init_from_description(
+        &serialization_support, &description, &counting_allocator, &dynamic_type)) <<
+      rcutils_get_error_string().str;
+    EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type));
+    allocations.push_back(count);
+  }
+
+  // The number of allocations does not depend on how large the referenced description is
+  EXPECT_EQ(allocations[0], allocations[1]);
+}
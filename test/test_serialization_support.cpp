@@ -0,0 +1,86 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <rcutils/allocator.h>
+#include <rcutils/types/rcutils_ret.h>
+
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+
+#include "fake_serialization_support.hpp"
+
+TEST(TestSerializationSupport, shares_one_per_serialization_library)
+{
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  int serialization_support_finis = fake_counters.serialization_support_finis;
+
+  rosidl_dynamic_typesupport_serialization_support_t first = get_fake_serialization_support();
+  rosidl_dynamic_typesupport_serialization_support_t second = get_fake_serialization_support();
+  rosidl_dynamic_typesupport_serialization_support_t * first_shared = nullptr;
+  rosidl_dynamic_typesupport_serialization_support_t * second_shared = nullptr;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_serialization_support_init_shared(
+      &first, &allocator, &first_shared));
+  EXPECT_EQ(nullptr, first.serialization_library_identifier);
+  EXPECT_EQ(serialization_support_finis, fake_counters.serialization_support_finis);
+
+  // The second one is not needed, since there already is a shared one for the fake library
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_serialization_support_init_shared(
+      &second, &allocator, &second_shared));
+  EXPECT_EQ(first_shared, second_shared);
+  EXPECT_EQ(nullptr, second.serialization_library_identifier);
+  EXPECT_EQ(serialization_support_finis + 1, fake_counters.serialization_support_finis);
+  EXPECT_STREQ(
+    fake_serialization_library_identifier,
+    rosidl_dynamic_typesupport_serialization_support_get_library_identifier(first_shared));
+
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_serialization_support_release(first_shared));
+  EXPECT_EQ(serialization_support_finis + 1, fake_counters.serialization_support_finis);
+  ASSERT_EQ(
+    RCUTILS_RET_OK, rosidl_dynamic_typesupport_serialization_support_release(second_shared));
+  EXPECT_EQ(serialization_support_finis + 2, fake_counters.serialization_support_finis);
+}
+
+TEST(TestSerializationSupport, releasing_the_last_reference_unshares)
+{
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  int serialization_support_finis = fake_counters.serialization_support_finis;
+
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support =
+    get_fake_serialization_support();
+  rosidl_dynamic_typesupport_serialization_support_t * shared = nullptr;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_serialization_support_init_shared(
+      &serialization_support, &allocator, &shared));
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_serialization_support_acquire(shared));
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_serialization_support_release(shared));
+  EXPECT_EQ(serialization_support_finis, fake_counters.serialization_support_finis);
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_serialization_support_release(shared));
+  EXPECT_EQ(serialization_support_finis + 1, fake_counters.serialization_support_finis);
+
+  // A serialization support moved in afterwards becomes the shared one, instead of being finalized
+  serialization_support = get_fake_serialization_support();
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_serialization_support_init_shared(
+      &serialization_support, &allocator, &shared));
+  EXPECT_EQ(serialization_support_finis + 1, fake_counters.serialization_support_finis);
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_serialization_support_release(shared));
+  EXPECT_EQ(serialization_support_finis + 2, fake_counters.serialization_support_finis);
+}
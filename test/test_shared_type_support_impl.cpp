@@ -0,0 +1,263 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/message_type_support_struct.h>
+#include <rosidl_runtime_c/string_functions.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__functions.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+#include <rosidl_runtime_c/type_hash.h>
+
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/dynamic_message_type_support_struct.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+namespace
+{
+
+// Fails every allocation once `allocations_left` runs out
+struct FailingAllocatorState
+{
+  size_t allocations_left;
+};
+
+void *
+failing_allocate(size_t size, void * state)
+{
+  auto failing_state = static_cast<FailingAllocatorState *>(state);
+  if (failing_state->allocations_left == 0) {
+    return nullptr;
+  }
+  failing_state->allocations_left--;
+  return std::malloc(size);
+}
+
+void *
+failing_reallocate(void * pointer, size_t size, void * state)
+{
+  auto failing_state = static_cast<FailingAllocatorState *>(state);
+  if (failing_state->allocations_left == 0) {
+    return nullptr;
+  }
+  failing_state->allocations_left--;
+  return std::realloc(pointer, size);
+}
+
+void *
+failing_zero_allocate(size_t count, size_t size, void * state)
+{
+  auto failing_state = static_cast<FailingAllocatorState *>(state);
+  if (failing_state->allocations_left == 0) {
+    return nullptr;
+  }
+  failing_state->allocations_left--;
+  return std::calloc(count, size);
+}
+
+void
+failing_deallocate(void * pointer, void *)
+{
+  std::free(pointer);
+}
+
+rcutils_allocator_t
+get_failing_allocator(FailingAllocatorState * state)
+{
+  rcutils_allocator_t allocator = rcutils_get_zero_initialized_allocator();
+  allocator.allocate = failing_allocate;
+  allocator.deallocate = failing_deallocate;
+  allocator.reallocate = failing_reallocate;
+  allocator.zero_allocate = failing_zero_allocate;
+  allocator.state = state;
+  return allocator;
+}
+
+const rosidl_dynamic_message_type_support_impl_t *
+get_impl(const rosidl_message_type_support_t * ts)
+{
+  return static_cast<const rosidl_dynamic_message_type_support_impl_t *>(ts->data);
+}
+
+}  // namespace
+
+class TestSharedTypeSupportImpl : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    // Every test gets its own type hash, so impls shared by earlier tests are never found
+    static uint8_t test_count = 0;
+    type_hash = rosidl_get_zero_initialized_type_hash();
+    type_hash.version = 1;
+    type_hash.value[0] = 0x18;
+    type_hash.value[1] = ++test_count;
+
+    ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&description));
+    fill_individual_type_description(
+      "test_msgs/msg/A",
+      {
+        {"a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+        {"b", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, "test_msgs/msg/B"},
+      },
+      &description.type_description);
+    ASSERT_TRUE(
+      rosidl_runtime_c__type_description__IndividualTypeDescription__Sequence__init(
+        &description.referenced_type_descriptions, 1));
+    fill_individual_type_description(
+      "test_msgs/msg/B",
+      {{"x", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOOLEAN, nullptr}},
+      &description.referenced_type_descriptions.data[0]);
+  }
+
+  void TearDown() override
+  {
+    rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+  }
+
+  rcutils_ret_t init_shared(rosidl_message_type_support_t * ts, rcutils_allocator_t * with)
+  {
+    rosidl_dynamic_typesupport_serialization_support_t serialization_support =
+      get_fake_serialization_support();
+    return rosidl_dynamic_message_type_support_handle_init_shared(
+      &serialization_support, &type_hash, &description, nullptr, with, ts);
+  }
+
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_type_hash_t type_hash;
+  rosidl_runtime_c__type_description__TypeDescription description;
+};
+
+TEST_F(TestSharedTypeSupportImpl, handles_share_one_impl_until_the_last_is_finalized)
+{
+  int finis = fake_counters.serialization_support_finis;
+  int live_types = fake_counters.live_types;
+
+  rosidl_message_type_support_t first;
+  rosidl_message_type_support_t second;
+  ASSERT_EQ(RCUTILS_RET_OK, init_shared(&first, &allocator)) << rcutils_get_error_string().str;
+  int builder_inits = fake_counters.builder_inits;
+  ASSERT_EQ(RCUTILS_RET_OK, init_shared(&second, &allocator)) << rcutils_get_error_string().str;
+
+  // The second handle borrows everything from the first one's impl, and built nothing
+  EXPECT_EQ(builder_inits, fake_counters.builder_inits);
+  EXPECT_NE(first.data, second.data);
+  EXPECT_EQ(get_impl(&first)->dynamic_message_type, get_impl(&second)->dynamic_message_type);
+  EXPECT_EQ(
+    get_impl(&first)->type_description.type_description.type_name.data,
+    get_impl(&second)->type_description.type_description.type_name.data);
+
+  // But each gets a dynamic message of its own
+  rosidl_dynamic_typesupport_dynamic_data_t * first_message = nullptr;
+  rosidl_dynamic_typesupport_dynamic_data_t * second_message = nullptr;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_message_type_support_handle_get_dynamic_message(&first, &first_message));
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_message_type_support_handle_get_dynamic_message(&second, &second_message));
+  EXPECT_NE(first_message, second_message);
+
+  // The second handle's serialization support was not needed, so it went right away
+  EXPECT_EQ(finis + 1, fake_counters.serialization_support_finis);
+
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_fini(&first));
+  EXPECT_NE(live_types, fake_counters.live_types);
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_fini(&second));
+  EXPECT_EQ(live_types, fake_counters.live_types);
+  EXPECT_EQ(finis + 2, fake_counters.serialization_support_finis);
+}
+
+TEST_F(TestSharedTypeSupportImpl, failed_init_takes_serialization_support_over)
+{
+  rosidl_runtime_c__String__assign(
+    &description.type_description.fields.data[1].type.nested_type_name, "test_msgs/msg/Missing");
+
+  int finis = fake_counters.serialization_support_finis;
+  rosidl_message_type_support_t ts;
+  EXPECT_NE(RCUTILS_RET_OK, init_shared(&ts, &allocator));
+  rcutils_reset_error();
+  EXPECT_EQ(finis + 1, fake_counters.serialization_support_finis);
+}
+
+// Fails each allocation in turn, for the handle building the impl and for one finding it shared.
+// Whichever one fails, the serialization support must be finalized exactly once
+TEST_F(TestSharedTypeSupportImpl, every_allocation_failure_finalizes_support_once)
+{
+  for (bool already_shared : {false, true}) {
+    rosidl_message_type_support_t sharing;
+    if (already_shared) {
+      ASSERT_EQ(RCUTILS_RET_OK, init_shared(&sharing, &allocator));
+    }
+
+    bool succeeded = false;
+    for (size_t allocations = 0; !succeeded && allocations < 1000; allocations++) {
+      FailingAllocatorState state{allocations};
+      rcutils_allocator_t failing_allocator = get_failing_allocator(&state);
+      int finis = fake_counters.serialization_support_finis;
+      rosidl_message_type_support_t ts;
+      if (init_shared(&ts, &failing_allocator) == RCUTILS_RET_OK) {
+        succeeded = true;
+        EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_fini(&ts));
+      } else {
+        rcutils_reset_error();
+      }
+      EXPECT_EQ(finis + 1, fake_counters.serialization_support_finis) <<
+        "after " << allocations << " allocations, already shared: " << already_shared;
+    }
+    EXPECT_TRUE(succeeded) << "already shared: " << already_shared;
+
+    if (already_shared) {
+      EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_fini(&sharing));
+    }
+  }
+}
+
+TEST_F(TestSharedTypeSupportImpl, concurrent_inits_end_up_sharing_one_impl)
+{
+  constexpr size_t thread_count = 8;
+  int finis = fake_counters.serialization_support_finis;
+  int live_types = fake_counters.live_types;
+
+  std::vector<rosidl_message_type_support_t> handles(thread_count);
+  std::vector<rcutils_ret_t> rets(thread_count, RCUTILS_RET_ERROR);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < thread_count; i++) {
+    threads.emplace_back([&, i]() {rets[i] = init_shared(&handles[i], &allocator);});
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  for (size_t i = 0; i < thread_count; i++) {
+    ASSERT_EQ(RCUTILS_RET_OK, rets[i]);
+    EXPECT_EQ(
+      get_impl(&handles[0])->type_description.type_description.type_name.data,
+      get_impl(&handles[i])->type_description.type_description.type_name.data);
+  }
+  for (size_t i = 0; i < thread_count; i++) {
+    EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_fini(&handles[i]));
+  }
+  EXPECT_EQ(live_types, fake_counters.live_types);
+  EXPECT_EQ(finis + static_cast<int>(thread_count), fake_counters.serialization_support_finis);
+}
@@ -0,0 +1,155 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/message_type_support_struct.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+#include <rosidl_runtime_c/type_hash.h>
+
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/dynamic_message_type_support_struct.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+class TestSpareDynamicMessage : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    type_hash = rosidl_get_zero_initialized_type_hash();
+    ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&description));
+    fill_individual_type_description(
+      "test_msgs/msg/A",
+      {{"a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr}},
+      &description.type_description);
+  }
+
+  void TearDown() override
+  {
+    rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+  }
+
+  void init_handle(rosidl_message_type_support_t * ts)
+  {
+    rosidl_dynamic_typesupport_serialization_support_t serialization_support =
+      get_fake_serialization_support();
+    ASSERT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_message_type_support_handle_init(
+        &serialization_support, &type_hash, &description, nullptr, &allocator, ts)) <<
+      rcutils_get_error_string().str;
+  }
+
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_type_hash_t type_hash;
+  rosidl_runtime_c__type_description__TypeDescription description;
+};
+
+TEST_F(TestSpareDynamicMessage, constructed_on_first_request_only)
+{
+  int live_data = fake_counters.live_data;
+  rosidl_message_type_support_t ts;
+  init_handle(&ts);
+  EXPECT_EQ(live_data, fake_counters.live_data);
+
+  rosidl_dynamic_typesupport_dynamic_data_t * first = nullptr;
+  rosidl_dynamic_typesupport_dynamic_data_t * second = nullptr;
+  ASSERT_EQ(
+    RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_get_dynamic_message(&ts, &first));
+  ASSERT_EQ(
+    RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_get_dynamic_message(&ts, &second));
+  EXPECT_NE(nullptr, first);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(live_data + 1, fake_counters.live_data);
+
+  // Too late to skip it now
+  EXPECT_EQ(
+    RCUTILS_RET_ERROR, rosidl_dynamic_message_type_support_handle_skip_dynamic_message(&ts));
+  rcutils_reset_error();
+
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_fini(&ts));
+  EXPECT_EQ(live_data, fake_counters.live_data);
+}
+
+TEST_F(TestSpareDynamicMessage, skipped_messages_are_never_constructed)
+{
+  int live_data = fake_counters.live_data;
+  rosidl_message_type_support_t ts;
+  init_handle(&ts);
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_skip_dynamic_message(&ts));
+
+  rosidl_dynamic_typesupport_dynamic_data_t * dynamic_message = nullptr;
+  EXPECT_EQ(
+    RCUTILS_RET_ERROR,
+    rosidl_dynamic_message_type_support_handle_get_dynamic_message(&ts, &dynamic_message));
+  rcutils_reset_error();
+  EXPECT_EQ(live_data, fake_counters.live_data);
+
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_fini(&ts));
+}
+
+// Every thread gets the same dynamic message, and any built by threads that lost the race are gone
+TEST_F(TestSpareDynamicMessage, concurrent_first_requests_share_one_message)
+{
+  constexpr size_t handle_count = 4;
+  constexpr size_t thread_count = 8;
+  int live_data = fake_counters.live_data;
+
+  rosidl_message_type_support_t handles[handle_count];
+  for (size_t i = 0; i < handle_count; i++) {
+    init_handle(&handles[i]);
+  }
+
+  std::vector<rosidl_dynamic_typesupport_dynamic_data_t *> got(handle_count * thread_count);
+  std::vector<rcutils_ret_t> rets(handle_count * thread_count, RCUTILS_RET_ERROR);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < thread_count; t++) {
+    threads.emplace_back(
+      [&, t]() {
+        for (size_t i = 0; i < handle_count; i++) {
+          size_t slot = t * handle_count + i;
+          rets[slot] = rosidl_dynamic_message_type_support_handle_get_dynamic_message(
+            &handles[i], &got[slot]);
+        }
+      });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  for (size_t i = 0; i < handle_count; i++) {
+    for (size_t t = 0; t < thread_count; t++) {
+      ASSERT_EQ(RCUTILS_RET_OK, rets[t * handle_count + i]);
+      EXPECT_EQ(got[i], got[t * handle_count + i]) << "handle " << i << ", thread " << t;
+    }
+    for (size_t j = 0; j < i; j++) {
+      EXPECT_NE(got[i], got[j]);
+    }
+  }
+  EXPECT_EQ(live_data + static_cast<int>(handle_count), fake_counters.live_data);
+
+  for (size_t i = 0; i < handle_count; i++) {
+    EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_message_type_support_handle_fini(&handles[i]));
+  }
+  EXPECT_EQ(live_data, fake_counters.live_data);
+}
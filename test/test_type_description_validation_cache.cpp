@@ -0,0 +1,182 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__functions.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+#include <rosidl_runtime_c/type_hash.h>
+
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+// Validation results are remembered process-wide, so these only check what callers can observe:
+// descriptions that are not valid must keep failing, whatever was found valid before them.
+class TestTypeDescriptionValidationCache : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    serialization_support = get_fake_serialization_support();
+    ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_clear_type_description_validation_cache());
+
+    ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&valid));
+    fill_individual_type_description(
+      "test_msgs/msg/A",
+      {{"a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr}},
+      &valid.type_description);
+
+    // Same top level type, plus a referenced type it never uses
+    ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&unused_reference));
+    fill_individual_type_description(
+      "test_msgs/msg/A",
+      {{"a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr}},
+      &unused_reference.type_description);
+    ASSERT_TRUE(
+      rosidl_runtime_c__type_description__IndividualTypeDescription__Sequence__init(
+        &unused_reference.referenced_type_descriptions, 1));
+    fill_individual_type_description(
+      "test_msgs/msg/Unused",
+      {{"x", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOOLEAN, nullptr}},
+      &unused_reference.referenced_type_descriptions.data[0]);
+
+    // Same top level type name, with a nested type that is never described
+    ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&missing_reference));
+    fill_individual_type_description(
+      "test_msgs/msg/A",
+      {{"b", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, "test_msgs/msg/Missing"}},
+      &missing_reference.type_description);
+
+    type_hash = rosidl_get_zero_initialized_type_hash();
+    type_hash.version = 1;
+    type_hash.value[0] = 3;
+    options = rosidl_dynamic_typesupport_get_default_dynamic_type_construction_options();
+  }
+
+  void TearDown() override
+  {
+    rosidl_runtime_c__type_description__TypeDescription__fini(&valid);
+    rosidl_runtime_c__type_description__TypeDescription__fini(&unused_reference);
+    rosidl_runtime_c__type_description__TypeDescription__fini(&missing_reference);
+    EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_clear_type_description_validation_cache());
+    EXPECT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_serialization_support_fini(&serialization_support));
+  }
+
+  rcutils_ret_t construct(const rosidl_runtime_c__type_description__TypeDescription * description)
+  {
+    rosidl_dynamic_typesupport_dynamic_type_t dynamic_type =
+      rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+    rcutils_ret_t ret = rosidl_dynamic_typesupport_dynamic_type_init_from_description_with_options(
+      &serialization_support, description, &options, &allocator, &dynamic_type);
+    if (ret != RCUTILS_RET_OK) {
+      rcutils_reset_error();
+      return ret;
+    }
+    EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type));
+    return ret;
+  }
+
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support;
+  rosidl_runtime_c__type_description__TypeDescription valid;
+  rosidl_runtime_c__type_description__TypeDescription unused_reference;
+  rosidl_runtime_c__type_description__TypeDescription missing_reference;
+  rosidl_type_hash_t type_hash;
+  rosidl_dynamic_typesupport_dynamic_type_construction_options_t options;
+};
+
+TEST_F(TestTypeDescriptionValidationCache, invalid_descriptions_are_not_remembered)
+{
+  EXPECT_NE(RCUTILS_RET_OK, construct(&unused_reference));
+  EXPECT_NE(RCUTILS_RET_OK, construct(&unused_reference));
+  EXPECT_NE(RCUTILS_RET_OK, construct(&missing_reference));
+  EXPECT_NE(RCUTILS_RET_OK, construct(&missing_reference));
+  EXPECT_EQ(RCUTILS_RET_OK, construct(&valid));
+}
+
+TEST_F(TestTypeDescriptionValidationCache, type_hash_does_not_vouch_for_other_descriptions)
+{
+  options.type_hash = &type_hash;
+  ASSERT_EQ(RCUTILS_RET_OK, construct(&valid));
+  ASSERT_EQ(RCUTILS_RET_OK, construct(&valid));
+
+  // A valid description was remembered under this hash, but these are not equal to it
+  EXPECT_NE(RCUTILS_RET_OK, construct(&unused_reference));
+  EXPECT_NE(RCUTILS_RET_OK, construct(&missing_reference));
+  EXPECT_EQ(RCUTILS_RET_OK, construct(&valid));
+}
+
+TEST_F(TestTypeDescriptionValidationCache, digest_does_not_vouch_for_other_descriptions)
+{
+  ASSERT_EQ(RCUTILS_RET_OK, construct(&valid));
+  EXPECT_NE(RCUTILS_RET_OK, construct(&unused_reference));
+  EXPECT_NE(RCUTILS_RET_OK, construct(&missing_reference));
+}
+
+TEST_F(TestTypeDescriptionValidationCache, clear)
+{
+  options.type_hash = &type_hash;
+  ASSERT_EQ(RCUTILS_RET_OK, construct(&valid));
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_clear_type_description_validation_cache());
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_clear_type_description_validation_cache());
+  EXPECT_NE(RCUTILS_RET_OK, construct(&unused_reference));
+  EXPECT_EQ(RCUTILS_RET_OK, construct(&valid));
+}
+
+// Lookups compare against stored descriptions outside the lock, so clearing the cache meanwhile
+// must not pull the description out from under them
+TEST_F(TestTypeDescriptionValidationCache, clear_while_looking_up)
+{
+  options.type_hash = &type_hash;
+  std::atomic<bool> done{false};
+  std::thread clearer([&done]() {
+      while (!done) {
+        EXPECT_EQ(
+          RCUTILS_RET_OK, rosidl_dynamic_typesupport_clear_type_description_validation_cache());
+      }
+    });
+
+  std::vector<std::thread> constructors;
+  for (size_t i = 0; i < 4; i++) {
+    constructors.emplace_back(
+      [this]() {
+        for (size_t j = 0; j < 200; j++) {
+          rosidl_dynamic_typesupport_dynamic_type_t dynamic_type =
+            rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+          EXPECT_EQ(
+            RCUTILS_RET_OK,
+            rosidl_dynamic_typesupport_dynamic_type_init_from_description_with_options(
+              &serialization_support, &valid, &options, &allocator, &dynamic_type));
+          EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type));
+        }
+      });
+  }
+  for (auto & constructor : constructors) {
+    constructor.join();
+  }
+  done = true;
+  clearer.join();
+}
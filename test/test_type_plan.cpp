@@ -0,0 +1,213 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rosidl_runtime_c/string_functions.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__functions.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+
+#include "rosidl_dynamic_typesupport/type_plan.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+namespace
+{
+
+// Records the walk as "<depth>:<field name>" for visits and "<depth>:/<field name>" for leaving
+struct WalkState
+{
+  std::vector<std::string> steps;
+  std::string skipped;
+};
+
+rcutils_ret_t
+visit_field(
+  const rosidl_dynamic_typesupport_type_plan_t * plan, size_t field_index, size_t depth,
+  bool * descend, void * state)
+{
+  auto walk_state = static_cast<WalkState *>(state);
+  std::string name(plan->field_names[field_index], plan->field_name_lengths[field_index]);
+  walk_state->steps.push_back(std::to_string(depth) + ":" + name);
+  if (name == walk_state->skipped) {
+    *descend = false;
+  }
+  return RCUTILS_RET_OK;
+}
+
+rcutils_ret_t
+leave_nested_field(
+  const rosidl_dynamic_typesupport_type_plan_t * plan, size_t field_index, size_t depth,
+  void * state)
+{
+  auto walk_state = static_cast<WalkState *>(state);
+  walk_state->steps.push_back(
+    std::to_string(depth) + ":/" +
+    std::string(plan->field_names[field_index], plan->field_name_lengths[field_index]));
+  return RCUTILS_RET_OK;
+}
+
+}  // namespace
+
+class TestTypePlan : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&description));
+    fill_individual_type_description(
+      "test_msgs/msg/Top",
+      {
+        {"a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+        {"s", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOUNDED_STRING, nullptr, 0, 8},
+        {"arr", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32_ARRAY, nullptr, 3},
+        {"n", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, "test_msgs/msg/B"},
+        {"seq", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE_UNBOUNDED_SEQUENCE,
+          "test_msgs/msg/B"},
+      },
+      &description.type_description);
+    ASSERT_TRUE(
+      rosidl_runtime_c__type_description__IndividualTypeDescription__Sequence__init(
+        &description.referenced_type_descriptions, 1));
+    fill_individual_type_description(
+      "test_msgs/msg/B",
+      {
+        {"x", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOOLEAN, nullptr},
+        {"y", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+      },
+      &description.referenced_type_descriptions.data[0]);
+  }
+
+  void TearDown() override
+  {
+    rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+  }
+
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_runtime_c__type_description__TypeDescription description;
+};
+
+TEST_F(TestTypePlan, tables_describe_every_type_and_field)
+{
+  rosidl_dynamic_typesupport_type_plan_t plan =
+    rosidl_dynamic_typesupport_get_zero_initialized_type_plan();
+  ASSERT_EQ(
+    RCUTILS_RET_OK, rosidl_dynamic_typesupport_type_plan_init(&description, &allocator, &plan)) <<
+    rcutils_get_error_string().str;
+
+  // The plan borrows nothing from the description
+  rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+  ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&description));
+
+  ASSERT_EQ(2u, plan.type_count);
+  EXPECT_EQ("test_msgs/msg/Top", std::string(plan.type_names[0], plan.type_name_lengths[0]));
+  EXPECT_EQ("test_msgs/msg/B", std::string(plan.type_names[1], plan.type_name_lengths[1]));
+  EXPECT_EQ(0u, plan.type_first_fields[0]);
+  EXPECT_EQ(5u, plan.type_field_counts[0]);
+  EXPECT_EQ(5u, plan.type_first_fields[1]);
+  EXPECT_EQ(2u, plan.type_field_counts[1]);
+  EXPECT_EQ(1u, plan.type_depths[0]);
+  EXPECT_EQ(0u, plan.type_depths[1]);
+  EXPECT_FALSE(plan.type_is_fixed_size[0]);
+  EXPECT_TRUE(plan.type_is_fixed_size[1]);
+
+  ASSERT_EQ(7u, plan.field_count);
+  EXPECT_EQ("arr", std::string(plan.field_names[2], plan.field_name_lengths[2]));
+  EXPECT_EQ(0u, plan.field_member_ids[0]);
+  EXPECT_EQ(4u, plan.field_member_ids[4]);
+  EXPECT_EQ(1u, plan.field_member_ids[6]);
+  EXPECT_EQ(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32_ARRAY, plan.field_type_ids[2]);
+  EXPECT_EQ(ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, plan.field_element_type_ids[2]);
+  EXPECT_EQ(
+    ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, plan.field_element_type_ids[4]);
+  EXPECT_EQ(3u, plan.field_capacities[2]);
+  EXPECT_EQ(8u, plan.field_string_capacities[1]);
+  EXPECT_EQ(ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_NO_NESTED_TYPE, plan.field_nested_types[0]);
+  EXPECT_EQ(1u, plan.field_nested_types[3]);
+  EXPECT_EQ(1u, plan.field_nested_types[4]);
+
+  const uint8_t pod_fixed_size = ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_POD |
+    ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_FIXED_SIZE;
+  EXPECT_EQ(pod_fixed_size, plan.field_flags[0]);
+  EXPECT_EQ(ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_STRING, plan.field_flags[1]);
+  EXPECT_EQ(ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_ARRAY | pod_fixed_size, plan.field_flags[2]);
+  EXPECT_EQ(
+    ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_NESTED | pod_fixed_size, plan.field_flags[3]);
+  // Sequences of fixed size nested types can be copied in bulk, but their size varies
+  EXPECT_EQ(
+    ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_NESTED |
+    ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_UNBOUNDED_SEQUENCE |
+    ROSIDL_DYNAMIC_TYPESUPPORT_TYPE_PLAN_FIELD_POD,
+    plan.field_flags[4]);
+
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_type_plan_fini(&plan));
+}
+
+TEST_F(TestTypePlan, walk_visits_nested_fields_depth_first)
+{
+  rosidl_dynamic_typesupport_type_plan_t plan =
+    rosidl_dynamic_typesupport_get_zero_initialized_type_plan();
+  ASSERT_EQ(
+    RCUTILS_RET_OK, rosidl_dynamic_typesupport_type_plan_init(&description, &allocator, &plan));
+
+  WalkState state;
+  state.skipped = "seq";
+  rosidl_dynamic_typesupport_type_plan_visitor_t visitor;
+  visitor.visit_field = visit_field;
+  visitor.leave_nested_field = leave_nested_field;
+  visitor.state = &state;
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_type_plan_walk(&plan, 0, &visitor));
+  // Skipped nested fields are never left, as they were never entered
+  EXPECT_EQ(
+    (std::vector<std::string>{"0:a", "0:s", "0:arr", "0:n", "1:x", "1:y", "0:/n", "0:seq"}),
+    state.steps);
+
+  // Walks can start from any type
+  state.steps.clear();
+  visitor.leave_nested_field = nullptr;
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_type_plan_walk(&plan, 1, &visitor));
+  EXPECT_EQ((std::vector<std::string>{"0:x", "0:y"}), state.steps);
+
+  EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_type_plan_fini(&plan));
+}
+
+TEST_F(TestTypePlan, missing_and_cyclic_types_fail)
+{
+  rosidl_dynamic_typesupport_type_plan_t plan =
+    rosidl_dynamic_typesupport_get_zero_initialized_type_plan();
+
+  rosidl_runtime_c__String__assign(
+    &description.type_description.fields.data[3].type.nested_type_name, "test_msgs/msg/Missing");
+  EXPECT_NE(
+    RCUTILS_RET_OK, rosidl_dynamic_typesupport_type_plan_init(&description, &allocator, &plan));
+  rcutils_reset_error();
+  rosidl_runtime_c__String__assign(
+    &description.type_description.fields.data[3].type.nested_type_name, "test_msgs/msg/B");
+
+  // B refers back to itself
+  rosidl_runtime_c__type_description__Field * x =
+    &description.referenced_type_descriptions.data[0].fields.data[0];
+  x->type.type_id = ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE;
+  rosidl_runtime_c__String__assign(&x->type.nested_type_name, "test_msgs/msg/B");
+  EXPECT_NE(
+    RCUTILS_RET_OK, rosidl_dynamic_typesupport_type_plan_init(&description, &allocator, &plan));
+  rcutils_reset_error();
+}
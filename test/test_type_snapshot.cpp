@@ -0,0 +1,175 @@
+// Copyright 2022 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include <rcutils/allocator.h>
+#include <rcutils/error_handling.h>
+#include <rcutils/types/rcutils_ret.h>
+#include <rcutils/types/uint8_array.h>
+#include <rosidl_runtime_c/type_description/individual_type_description__functions.h>
+#include <rosidl_runtime_c/type_description/type_description__functions.h>
+#include <rosidl_runtime_c/type_hash.h>
+
+#include "rosidl_dynamic_typesupport/api/dynamic_type.h"
+#include "rosidl_dynamic_typesupport/api/serialization_support.h"
+#include "rosidl_dynamic_typesupport/type_plan.h"
+#include "rosidl_dynamic_typesupport/type_snapshot.h"
+#include "rosidl_dynamic_typesupport/types.h"
+
+#include "fake_serialization_support.hpp"
+
+class TestTypeSnapshot : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    serialization_support = get_fake_serialization_support();
+
+    ASSERT_TRUE(rosidl_runtime_c__type_description__TypeDescription__init(&description));
+    fill_individual_type_description(
+      "test_msgs/msg/A",
+      {
+        {"a", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_INT32, nullptr},
+        {"b", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_NESTED_TYPE, "test_msgs/msg/B"},
+      },
+      &description.type_description);
+    ASSERT_TRUE(
+      rosidl_runtime_c__type_description__IndividualTypeDescription__Sequence__init(
+        &description.referenced_type_descriptions, 1));
+    fill_individual_type_description(
+      "test_msgs/msg/B",
+      {{"x", ROSIDL_DYNAMIC_TYPESUPPORT_FIELD_TYPE_BOOLEAN, nullptr}},
+      &description.referenced_type_descriptions.data[0]);
+
+    type_hash = rosidl_get_zero_initialized_type_hash();
+    type_hash.version = 1;
+    type_hash.value[0] = 7;
+
+    rosidl_dynamic_typesupport_dynamic_type_construction_options_t options =
+      rosidl_dynamic_typesupport_get_default_dynamic_type_construction_options();
+    options.type_hash = &type_hash;
+    dynamic_type = rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+    ASSERT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_dynamic_type_init_from_description_with_options(
+        &serialization_support, &description, &options, &allocator, &dynamic_type));
+
+    const rosidl_dynamic_typesupport_dynamic_type_t * dynamic_types[] = {&dynamic_type};
+    const rosidl_runtime_c__type_description__TypeDescription * descriptions[] = {&description};
+    snapshot_data = rcutils_get_zero_initialized_uint8_array();
+    ASSERT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_type_snapshot_export(
+        dynamic_types, descriptions, 1, &allocator, &snapshot_data));
+  }
+
+  void TearDown() override
+  {
+    EXPECT_EQ(RCUTILS_RET_OK, rcutils_uint8_array_fini(&snapshot_data));
+    EXPECT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(&dynamic_type));
+    rosidl_runtime_c__type_description__TypeDescription__fini(&description);
+    EXPECT_EQ(
+      RCUTILS_RET_OK,
+      rosidl_dynamic_typesupport_serialization_support_fini(&serialization_support));
+  }
+
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rosidl_dynamic_typesupport_serialization_support_t serialization_support;
+  rosidl_runtime_c__type_description__TypeDescription description;
+  rosidl_type_hash_t type_hash;
+  rosidl_dynamic_typesupport_dynamic_type_t dynamic_type;
+  rcutils_uint8_array_t snapshot_data;
+};
+
+TEST_F(TestTypeSnapshot, round_trip)
+{
+  rosidl_dynamic_typesupport_type_snapshot_t snapshot =
+    rosidl_dynamic_typesupport_get_zero_initialized_type_snapshot();
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_type_snapshot_init(
+      snapshot_data.buffer, snapshot_data.buffer_length, &snapshot));
+
+  size_t entry_index = 0;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_type_snapshot_find(
+      &snapshot, fake_serialization_library_identifier, &type_hash, &entry_index));
+  rosidl_type_hash_t other_hash = type_hash;
+  other_hash.value[1] = 1;
+  size_t other_index = 0;
+  EXPECT_EQ(
+    RCUTILS_RET_NOT_FOUND,
+    rosidl_dynamic_typesupport_type_snapshot_find(
+      &snapshot, fake_serialization_library_identifier, &other_hash, &other_index));
+
+  // Loading the dynamic type does not build it again, and keeps its type hash
+  int builder_inits = fake_counters.builder_inits;
+  rosidl_dynamic_typesupport_dynamic_type_t loaded =
+    rosidl_dynamic_typesupport_get_zero_initialized_dynamic_type();
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_type_snapshot_load_dynamic_type(
+      &snapshot, entry_index, &serialization_support, &allocator, &loaded));
+  EXPECT_EQ(builder_inits, fake_counters.builder_inits);
+  EXPECT_EQ(type_hash.version, loaded.type_hash.version);
+  EXPECT_EQ(0, memcmp(type_hash.value, loaded.type_hash.value, sizeof(type_hash.value)));
+  bool equals = false;
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_dynamic_type_equals(&dynamic_type, &loaded, &equals));
+  EXPECT_TRUE(equals);
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_dynamic_type_fini(&loaded));
+
+  rosidl_dynamic_typesupport_type_plan_t plan =
+    rosidl_dynamic_typesupport_get_zero_initialized_type_plan();
+  ASSERT_EQ(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_type_snapshot_load_type_plan(
+      &snapshot, entry_index, &allocator, &plan));
+  ASSERT_EQ(2u, plan.type_count);
+  ASSERT_EQ(3u, plan.field_count);
+  EXPECT_EQ(std::string("test_msgs/msg/A"), plan.type_names[0]);
+  EXPECT_EQ(std::string("test_msgs/msg/B"), plan.type_names[1]);
+  EXPECT_EQ(std::string("b"), plan.field_names[1]);
+  EXPECT_EQ(1u, plan.field_nested_types[1]);
+  ASSERT_EQ(RCUTILS_RET_OK, rosidl_dynamic_typesupport_type_plan_fini(&plan));
+}
+
+TEST_F(TestTypeSnapshot, rejects_bad_data)
+{
+  rosidl_dynamic_typesupport_type_snapshot_t snapshot =
+    rosidl_dynamic_typesupport_get_zero_initialized_type_snapshot();
+  EXPECT_NE(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_type_snapshot_init(
+      snapshot_data.buffer, snapshot_data.buffer_length - 1, &snapshot));
+  rcutils_reset_error();
+  EXPECT_NE(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_type_snapshot_init(
+      snapshot_data.buffer + 1, snapshot_data.buffer_length - 1, &snapshot));
+  rcutils_reset_error();
+
+  snapshot_data.buffer[0] ^= 0xff;
+  EXPECT_NE(
+    RCUTILS_RET_OK,
+    rosidl_dynamic_typesupport_type_snapshot_init(
+      snapshot_data.buffer, snapshot_data.buffer_length, &snapshot));
+  rcutils_reset_error();
+}